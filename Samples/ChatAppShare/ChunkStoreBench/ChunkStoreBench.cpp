@@ -0,0 +1,251 @@
+// ChunkStoreBench.cpp : Ingest throughput and dedup ratio of the shared-file store.
+//
+// Builds a file of incompressible bytes and a series of versions of it, each
+// with a few small edits (insertions, deletions and overwrites) at random
+// places, the way a document that is shared again after editing changes.
+// Every version is written to disk and ingested into a fresh ChunkStore, from
+// several threads if asked. Reports raw FastCDC chunking speed, ingest speed,
+// the chunk sizes that came out and the store's dedup ratio. Content-defined
+// cuts keep the ratio close to the number of versions; fixed-size blocks would
+// lose nearly everything after the first insertion.
+
+#include "../SampleChatAppWithShare/ChunkStore.h"
+#include "../SampleChatAppWithShare/FastCdc.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchOptions
+{
+    size_t sizeMegabytes = 64;      // of the first version
+    size_t versions = 8;
+    size_t editsPerVersion = 16;
+    size_t maxEditBytes = 4096;
+    size_t threads = 1;
+    std::string directory;          // default: a new folder under the temp directory
+    bool keep = false;
+    double minDedupRatio = 0;       // non-zero: fail the run below this
+};
+
+static void PrintUsage()
+{
+    printf("Usage: ChunkStoreBench [options]\n"
+        "  --size MB          size of the first version (default 64)\n"
+        "  --versions N       versions to ingest, the first one included (default 8)\n"
+        "  --edits N          edits between one version and the next (default 16)\n"
+        "  --edit-bytes N     largest single edit (default 4096)\n"
+        "  --threads N        versions ingested at once (default 1)\n"
+        "  --dir PATH         where to put the files and the store\n"
+        "  --keep             leave them there afterwards\n"
+        "  --min-dedup R      exit with failure if the dedup ratio is below this\n");
+}
+
+static bool ParseOptions(int argc, char* argv[], BenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string name = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (name == "--keep")
+            options.keep = true;
+        else if (name == "--size" && hasValue)
+            options.sizeMegabytes = (size_t)strtoul(argv[++i], nullptr, 10);
+        else if (name == "--versions" && hasValue)
+            options.versions = (size_t)strtoul(argv[++i], nullptr, 10);
+        else if (name == "--edits" && hasValue)
+            options.editsPerVersion = (size_t)strtoul(argv[++i], nullptr, 10);
+        else if (name == "--edit-bytes" && hasValue)
+            options.maxEditBytes = (size_t)strtoul(argv[++i], nullptr, 10);
+        else if (name == "--threads" && hasValue)
+            options.threads = (size_t)strtoul(argv[++i], nullptr, 10);
+        else if (name == "--dir" && hasValue)
+            options.directory = argv[++i];
+        else if (name == "--min-dedup" && hasValue)
+            options.minDedupRatio = atof(argv[++i]);
+        else
+            return false;
+    }
+    return options.sizeMegabytes > 0 && options.versions > 0 && options.maxEditBytes > 0 && options.threads > 0;
+}
+
+// xorshift64*: repeatable, and fast enough not to show up in the timings
+class Random
+{
+public:
+    explicit Random(uint64_t seed) : m_state(seed ? seed : 1) {}
+
+    uint64_t Next()
+    {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return m_state * 2685821657736338717ull;
+    }
+
+    size_t Below(size_t bound) { return bound ? (size_t)(Next() % bound) : 0; }
+
+    void Fill(uint8_t* data, size_t length)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            data[i] = (uint8_t)(Next() >> 56);
+        }
+    }
+
+private:
+    uint64_t m_state;
+};
+
+static void Edit(std::vector<uint8_t>& data, Random& random, size_t maxEditBytes)
+{
+    size_t length = 1 + random.Below(maxEditBytes);
+    size_t at = random.Below(data.size());
+    switch (random.Below(3))
+    {
+    case 0:
+    {
+        std::vector<uint8_t> inserted(length);
+        random.Fill(inserted.data(), length);
+        data.insert(data.begin() + at, inserted.begin(), inserted.end());
+        break;
+    }
+    case 1:
+        data.erase(data.begin() + at, data.begin() + std::min(at + length, data.size()));
+        break;
+    default:
+        random.Fill(data.data() + at, std::min(length, data.size() - at));
+        break;
+    }
+}
+
+static double Megabytes(uint64_t bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+static double SecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    namespace fs = std::filesystem;
+    fs::path directory = options.directory.empty()
+        ? fs::temp_directory_path() / ("ChunkStoreBench-" + std::to_string(Clock::now().time_since_epoch().count()))
+        : fs::path(options.directory);
+    std::error_code error;
+    fs::create_directories(directory / "versions", error);
+    if (error)
+    {
+        fprintf(stderr, "Could not create %s: %s\n", directory.string().c_str(), error.message().c_str());
+        return 1;
+    }
+
+    // Write out every version first so the timings only cover ingesting them
+    Random random(0x5eed);
+    std::vector<uint8_t> data(options.sizeMegabytes * 1024 * 1024);
+    random.Fill(data.data(), data.size());
+    std::vector<fs::path> files;
+    uint64_t totalBytes = 0;
+    for (size_t version = 0; version < options.versions; version++)
+    {
+        if (version > 0)
+        {
+            for (size_t edit = 0; edit < options.editsPerVersion; edit++)
+            {
+                Edit(data, random, options.maxEditBytes);
+            }
+        }
+
+        files.push_back(directory / "versions" / ("v" + std::to_string(version)));
+        std::ofstream output(files.back(), std::ios::binary | std::ios::trunc);
+        output.write((const char*)data.data(), (std::streamsize)data.size());
+        if (!output)
+        {
+            fprintf(stderr, "Could not write %s\n", files.back().string().c_str());
+            return 1;
+        }
+        totalBytes += data.size();
+    }
+
+    printf("%zu versions of %.1f MB, %zu edits of up to %zu bytes between versions, %zu thread(s)\n",
+        options.versions, Megabytes(data.size()), options.editsPerVersion, options.maxEditBytes, options.threads);
+
+    // Chunking alone, from memory
+    FastCdcChunker chunker;
+    Clock::time_point start = Clock::now();
+    size_t cuts = 0;
+    for (size_t offset = 0; offset < data.size(); cuts++)
+    {
+        offset += chunker.NextCut(data.data() + offset, data.size() - offset);
+    }
+    double chunkSeconds = SecondsSince(start);
+    printf("chunking  %8.1f MB/s  (%zu chunks, average %.1f KB)\n",
+        Megabytes(data.size()) / chunkSeconds, cuts, data.size() / 1024.0 / cuts);
+
+    // Hashing, chunking, and writing the new chunks and a manifest per file
+    ChunkStore store(directory / "store");
+    std::atomic<size_t> next{ 0 };
+    std::atomic<size_t> failures{ 0 };
+    std::vector<std::thread> threads;
+    start = Clock::now();
+    for (size_t i = 0; i < options.threads; i++)
+    {
+        threads.emplace_back([&]() {
+            for (size_t version = next++; version < files.size(); version = next++)
+            {
+                ChunkManifest manifest;
+                if (!store.Ingest(files[version], manifest))
+                    failures++;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    double ingestSeconds = SecondsSince(start);
+
+    ChunkStoreStats stats = store.Stats();
+    printf("ingest    %8.1f MB/s  (%.1f MB in %.2f s)\n",
+        Megabytes(totalBytes) / ingestSeconds, Megabytes(totalBytes), ingestSeconds);
+    printf("chunks    %llu ingested, %llu stored, average %.1f KB\n",
+        (unsigned long long)stats.chunksIngested, (unsigned long long)stats.chunksStored,
+        stats.chunksIngested ? stats.bytesIngested / 1024.0 / stats.chunksIngested : 0.0);
+    printf("dedup     %.2fx  (%.1f MB stored for %.1f MB ingested; %zu versions is the ceiling)\n",
+        stats.DedupRatio(), Megabytes(stats.bytesStored), Megabytes(stats.bytesIngested), options.versions);
+
+    if (!options.keep)
+    {
+        fs::remove_all(directory, error);
+    }
+
+    if (failures != 0)
+    {
+        fprintf(stderr, "%zu ingest(s) failed\n", failures.load());
+        return 1;
+    }
+    if (options.minDedupRatio > 0 && stats.DedupRatio() < options.minDedupRatio)
+    {
+        fprintf(stderr, "dedup ratio %.2f is below %.2f\n", stats.DedupRatio(), options.minDedupRatio);
+        return 1;
+    }
+    return 0;
+}
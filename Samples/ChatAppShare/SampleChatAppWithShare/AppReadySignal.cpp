@@ -0,0 +1,153 @@
+#include "AppReadySignal.h"
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <climits>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+AppReadySignal::AppReadySignal()
+    : m_event(nullptr)
+{
+}
+
+bool AppReadySignal::Open(const std::string& name)
+{
+    if (m_event)
+        return true;
+
+    // Manual-reset, so every waiter sees it raised until the owner lowers it
+    std::wstring eventName = L"Local\\" + std::wstring(name.begin(), name.end()) + L".Ready";
+    m_event = CreateEventW(nullptr, TRUE, FALSE, eventName.c_str());
+    return m_event != nullptr;
+}
+
+void AppReadySignal::Close()
+{
+    if (m_event)
+        CloseHandle((HANDLE)m_event);
+    m_event = nullptr;
+}
+
+bool AppReadySignal::IsOpen() const
+{
+    return m_event != nullptr;
+}
+
+void AppReadySignal::Set()
+{
+    if (m_event)
+        SetEvent((HANDLE)m_event);
+}
+
+void AppReadySignal::Reset()
+{
+    if (m_event)
+        ResetEvent((HANDLE)m_event);
+}
+
+bool AppReadySignal::Wait(int timeoutMs)
+{
+    if (!m_event)
+        return false;
+    return WaitForSingleObject((HANDLE)m_event, timeoutMs < 0 ? INFINITE : (DWORD)timeoutMs) == WAIT_OBJECT_0;
+}
+
+#else
+
+AppReadySignal::AppReadySignal()
+    : m_word(nullptr)
+{
+}
+
+bool AppReadySignal::Open(const std::string& name)
+{
+    if (m_word)
+        return true;
+
+    // Never unlinked: a waiter that opened it early must see the owner raise the same word
+    std::string path = "/" + name + ".Ready";
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, sizeof(uint32_t)) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, sizeof(uint32_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+
+    m_word = static_cast<std::atomic<uint32_t>*>(view);
+    return true;
+}
+
+void AppReadySignal::Close()
+{
+    if (m_word)
+        munmap(m_word, sizeof(uint32_t));
+    m_word = nullptr;
+}
+
+bool AppReadySignal::IsOpen() const
+{
+    return m_word != nullptr;
+}
+
+void AppReadySignal::Set()
+{
+    if (!m_word)
+        return;
+
+    m_word->store(1, std::memory_order_release);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(m_word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void AppReadySignal::Reset()
+{
+    if (m_word)
+        m_word->store(0, std::memory_order_release);
+}
+
+bool AppReadySignal::Wait(int timeoutMs)
+{
+    if (!m_word)
+        return false;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+    while (m_word->load(std::memory_order_acquire) == 0)
+    {
+        timespec timeout = {};
+        if (timeoutMs >= 0)
+        {
+            auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0)
+                return false;
+            timeout.tv_sec = (time_t)(remaining / 1000000000);
+            timeout.tv_nsec = (long)(remaining % 1000000000);
+        }
+        // Returns at once if the word was raised since it was read
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(m_word), FUTEX_WAIT, 0,
+            timeoutMs < 0 ? nullptr : &timeout, nullptr, 0);
+    }
+    return true;
+}
+
+#endif
+
+AppReadySignal::~AppReadySignal()
+{
+    Close();
+}
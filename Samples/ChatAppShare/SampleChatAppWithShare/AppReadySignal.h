@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// A named flag one process raises to tell others it is ready, which they can
+// block on instead of polling for it.
+//
+// Every party opens the signal by name, and whichever comes first creates it
+// lowered, so a waiter may open it before the announcing process exists. On
+// Windows it is a session-local manual-reset event; elsewhere a word in a
+// shared-memory segment that waiters sleep on with a futex. The announcing
+// process lowers it again before it goes away.
+class AppReadySignal
+{
+public:
+    AppReadySignal();
+    ~AppReadySignal();
+
+    AppReadySignal(const AppReadySignal&) = delete;
+    AppReadySignal& operator=(const AppReadySignal&) = delete;
+
+    bool Open(const std::string& name);
+    void Close();
+    bool IsOpen() const;
+
+    void Set();
+    void Reset();
+
+    // True once the signal is raised; false if timeoutMs passes first (a
+    // negative timeout waits for ever, zero only looks)
+    bool Wait(int timeoutMs);
+
+private:
+#ifdef _WIN32
+    void* m_event;
+#else
+    std::atomic<uint32_t>* m_word;
+#endif
+};
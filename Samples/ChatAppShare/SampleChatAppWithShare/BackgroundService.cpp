@@ -1,100 +1,73 @@
 #include "BackgroundService.h"
 #include <iostream>
 
-// Global constants definition
+// Global constants definition. Off Windows the service listens on a Unix-domain
+// socket, which is how it is exercised under load.
+#ifdef _WIN32
 const std::string PIPE_NAME = "\\\\.\\pipe\\HelloWorldService";
+#else
+const std::string PIPE_NAME = "/tmp/HelloWorldService.sock";
+#endif
+const std::string HELLO_WORLD_REQUEST = "GET_HELLO_WORLD";
 const std::string HELLO_WORLD_RESPONSE = "Hello world";
-
-HelloWorldService::HelloWorldService() : m_running(false) {}
+const std::string SERVICE_METRICS_REQUEST = "GET_SERVICE_METRICS";
+const std::string CONTACTS_REQUEST = "GET_CONTACTS";
+const std::string UNKNOWN_REQUEST_RESPONSE = "UNKNOWN_REQUEST";
+
+HelloWorldService::HelloWorldService() {
+    m_server = std::make_unique<ServiceServer>(PIPE_NAME, [this](const std::string& request, std::string& response) {
+        HandleRequest(request, response);
+    });
+
+    m_handlers.Register(HELLO_WORLD_REQUEST, [](const std::string&, std::string& response) {
+        response = HELLO_WORLD_RESPONSE;
+    });
+    m_handlers.Register(SERVICE_METRICS_REQUEST, [this](const std::string&, std::string& response) {
+        ServiceResponseCache::Stats cache = m_cache.GetStats();
+        response = FormatServiceMetrics(GetMetrics()) +
+            " cache_hits=" + std::to_string(cache.hits) +
+            " cache_misses=" + std::to_string(cache.misses) +
+            " coalesced=" + std::to_string(cache.coalesced);
+    });
+}
 
 HelloWorldService::~HelloWorldService() {
     Stop();
 }
 
 bool HelloWorldService::Start() {
-    if (m_running) {
+    if (!m_server->Start(SERVICE_PIPE_INSTANCES, SERVICE_THREADS, SERVICE_WORKERS, SERVICE_QUEUE_CAPACITY)) {
+        // Also the answer when it is already running, or another Start won the race
+        if (!IsRunning()) {
+            std::cerr << "Failed to start Hello World Service on pipe: " << PIPE_NAME << std::endl;
+        }
         return false;
     }
 
-    m_running = true;
-    m_serviceThread = std::thread(&HelloWorldService::ServiceLoop, this);
-
     std::cout << "Hello World Service started. Listening on pipe: " << PIPE_NAME << std::endl;
     return true;
 }
 
 void HelloWorldService::Stop() {
-    if (m_running) {
-        m_running = false;
-        if (m_serviceThread.joinable()) {
-            m_serviceThread.join();
-        }
-        std::cout << "Hello World Service stopped." << std::endl;
+    if (IsRunning()) {
+        m_server->Stop();
+        std::cout << "Hello World Service stopped. " << FormatServiceMetrics(GetMetrics()) << std::endl;
     }
 }
 
 bool HelloWorldService::IsRunning() const {
-    return m_running;
+    return m_server->IsRunning();
 }
 
-void HelloWorldService::ServiceLoop() {
-    while (m_running) {
-        // Create named pipe
-        HANDLE hPipe = CreateNamedPipeA(
-            PIPE_NAME.c_str(),
-            PIPE_ACCESS_DUPLEX,
-            PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
-            1, // Max instances
-            1024, // Output buffer size
-            1024, // Input buffer size
-            0, // Default timeout
-            nullptr // Security attributes
-        );
-
-        if (hPipe == INVALID_HANDLE_VALUE) {
-            std::cerr << "Failed to create named pipe. Error: " << GetLastError() << std::endl;
-            continue;
-        }
-
-        // Wait for client connection
-        std::cout << "Waiting for client connection..." << std::endl;
-
-        if (ConnectNamedPipe(hPipe, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED) {
-            std::cout << "Client connected!" << std::endl;
-            HandleClient(hPipe);
-        }
-        else {
-            std::cerr << "Failed to connect to client. Error: " << GetLastError() << std::endl;
-        }
-
-        CloseHandle(hPipe);
-    }
+ServiceMetrics HelloWorldService::GetMetrics() const {
+    return m_server->GetMetrics();
 }
 
-void HelloWorldService::HandleClient(HANDLE hPipe) {
-    char buffer[1024];
-    DWORD bytesRead;
-    DWORD bytesWritten;
-
-    // Read request from client
-    if (ReadFile(hPipe, buffer, sizeof(buffer) - 1, &bytesRead, nullptr)) {
-        buffer[bytesRead] = '\0';
-        std::cout << "Received request: " << buffer << std::endl;
-
-        // Send "Hello world" response
-        const char* response = HELLO_WORLD_RESPONSE.c_str();
-        if (WriteFile(hPipe, response, static_cast<DWORD>(HELLO_WORLD_RESPONSE.length()), &bytesWritten, nullptr)) {
-            std::cout << "Sent response: " << response << std::endl;
+void HelloWorldService::HandleRequest(const std::string& request, std::string& response) {
+    // Runs on the worker threads, once per request: no logging here
+    m_cache.Get(request, response, [this, &request](std::string& computed) {
+        if (!m_handlers.Dispatch(request, computed)) {
+            computed = UNKNOWN_REQUEST_RESPONSE;
         }
-        else {
-            std::cerr << "Failed to send response. Error: " << GetLastError() << std::endl;
-        }
-    }
-    else {
-        std::cerr << "Failed to read from client. Error: " << GetLastError() << std::endl;
-    }
-
-    // Flush the pipe to allow the client to read the pipe's contents before disconnecting
-    FlushFileBuffers(hPipe);
-    DisconnectNamedPipe(hPipe);
-}
\ No newline at end of file
+    });
+}
@@ -1,17 +1,32 @@
 #pragma once
 
-#include <windows.h>
+#include <memory>
 #include <string>
-#include <thread>
+#include "ServiceHandlerRegistry.h"
+#include "ServiceResponseCache.h"
+#include "ServiceServer.h"
+#include "ServiceTopics.h"
 
 // Forward declarations and constants
 extern const std::string PIPE_NAME;
+extern const std::string HELLO_WORLD_REQUEST;
 extern const std::string HELLO_WORLD_RESPONSE;
+extern const std::string SERVICE_METRICS_REQUEST;
+extern const std::string CONTACTS_REQUEST;
+extern const std::string UNKNOWN_REQUEST_RESPONSE;
+
+// Pipe instances kept listening, threads doing their I/O, and the workers
+// that run handlers behind a queue of at most SERVICE_QUEUE_CAPACITY requests
+static const size_t SERVICE_PIPE_INSTANCES = 8;
+static const size_t SERVICE_THREADS = 2;
+static const size_t SERVICE_WORKERS = 4;
+static const size_t SERVICE_QUEUE_CAPACITY = 1024;
 
 class HelloWorldService {
 private:
-    bool m_running;
-    std::thread m_serviceThread;
+    ServiceHandlerRegistry m_handlers;
+    ServiceResponseCache m_cache;
+    std::unique_ptr<ServiceServer> m_server;    // lives as long as the service; Start and Stop are atomic on it
 
 public:
     HelloWorldService();
@@ -21,7 +36,20 @@ public:
     void Stop();
     bool IsRunning() const;
 
-private:
-    void ServiceLoop();
-    void HandleClient(HANDLE hPipe);
+    /**
+     * Handlers by request verb. GET_HELLO_WORLD and GET_SERVICE_METRICS are
+     * built in; more can be added at any time.
+     */
+    ServiceHandlerRegistry& Handlers() { return m_handlers; }
+
+    /**
+     * Replies worth keeping: give a verb a policy here to cache its replies
+     * and coalesce identical requests in flight
+     */
+    ServiceResponseCache& Cache() { return m_cache; }
+
+    ServiceMetrics GetMetrics() const;
+
+    // The service itself, independent of how requests arrive
+    void HandleRequest(const std::string& request, std::string& response);
 };
@@ -0,0 +1,41 @@
+#include "BufferPool.h"
+
+BufferPool::BufferPool(size_t maxPooled, size_t maxRetainedCapacity)
+    : m_maxPooled(maxPooled), m_maxRetainedCapacity(maxRetainedCapacity)
+{
+    m_free.reserve(maxPooled);
+}
+
+std::string BufferPool::Acquire()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_free.empty())
+        return std::string();
+
+    std::string buffer = std::move(m_free.back());
+    m_free.pop_back();
+    return buffer;
+}
+
+void BufferPool::Release(std::string&& buffer)
+{
+    if (buffer.capacity() > m_maxRetainedCapacity)
+        return;
+
+    buffer.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_free.size() < m_maxPooled)
+        m_free.push_back(std::move(buffer));
+}
+
+size_t BufferPool::Pooled() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_free.size();
+}
+
+BufferPool& BufferPool::Shared()
+{
+    static BufferPool pool(256, 256 * 1024);
+    return pool;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Recycles message buffers so the service and its clients stop allocating one
+// per request. Acquire hands out an empty string that keeps the capacity it had
+// when it was released; buffers that grew past maxRetainedCapacity are freed
+// rather than pooled, so one huge message does not pin its memory forever.
+class BufferPool
+{
+public:
+    BufferPool(size_t maxPooled, size_t maxRetainedCapacity);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    std::string Acquire();
+    void Release(std::string&& buffer);
+
+    size_t Pooled() const;
+
+    // Pool shared by the service and client message paths
+    static BufferPool& Shared();
+
+private:
+    size_t m_maxPooled;
+    size_t m_maxRetainedCapacity;
+
+    mutable std::mutex m_mutex;
+    std::vector<std::string> m_free;
+};
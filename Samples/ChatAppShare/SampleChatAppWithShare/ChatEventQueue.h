@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include "FileMetadata.h"
+
+// Kinds of events that background threads feed into the chat model
+enum class ChatEventType
+{
+    NewMessage,         // text = message body
+    PresenceChanged,    // text = status line, isOnline = presence
+    FileShared,         // text = full path, fileName = display name
+    FileStored          // text = full path, metadata = size, type, hash and thumbnail
+};
+
+struct ChatEvent
+{
+    ChatEventType type;
+    int contactIndex;
+    std::wstring text;
+    std::wstring fileName;
+    bool isOutgoing;
+    bool isOnline;
+    std::shared_ptr<const FileMetadata> metadata;
+};
+
+// Lock-free multi-producer / single-consumer queue (Vyukov's intrusive design).
+//
+// Any thread may Push; producers never block each other and never take a lock.
+// Exactly one thread (the UI thread) may call Drain. The wake callback is run by
+// the producer that moves the queue from idle to pending, so a burst of pushes
+// costs a single wakeup until the consumer drains again. A callback that could
+// not deliver its wakeup returns false, and the next push tries again.
+template <typename T>
+class MpscQueue
+{
+public:
+    typedef std::function<bool()> WakeCallback;
+
+    MpscQueue()
+        : m_head(&m_stub)
+        , m_tail(&m_stub)
+        , m_wakePending(false)
+    {
+        m_stub.next.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~MpscQueue()
+    {
+        Drain([](T&&) {});
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Set before any producer starts; not synchronized with Push
+    void SetWakeCallback(WakeCallback wake)
+    {
+        m_wake = std::move(wake);
+    }
+
+    // Safe to call from any thread
+    void Push(T value)
+    {
+        Node* node = new Node();
+        node->value = std::move(value);
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Enqueue(node);
+
+        if (!m_wakePending.exchange(true, std::memory_order_acq_rel) && m_wake)
+        {
+            // Nobody is coming to drain, so do not let later pushes assume otherwise
+            if (!m_wake())
+                m_wakePending.store(false, std::memory_order_release);
+        }
+    }
+
+    // Consumer thread only. Hands every available item to 'handler' in FIFO
+    // order per producer and returns how many were delivered.
+    template <typename Handler>
+    size_t Drain(Handler handler)
+    {
+        // Re-arm the wakeup first so a push racing with this drain still signals.
+        // Acquire pairs with the exchange of the push that set the flag.
+        m_wakePending.exchange(false, std::memory_order_acq_rel);
+
+        size_t drained = 0;
+        T value;
+        while (TryPop(value))
+        {
+            handler(std::move(value));
+            drained++;
+        }
+        return drained;
+    }
+
+    // Consumer thread only
+    bool IsEmpty() const
+    {
+        Node* tail = m_tail;
+        return tail == &m_stub ? m_stub.next.load(std::memory_order_acquire) == nullptr
+                               : false;
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> next;
+        T value;
+    };
+
+    void Enqueue(Node* node)
+    {
+        Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    bool TryPop(T& value)
+    {
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &m_stub)
+        {
+            if (!next)
+                return false;
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next)
+        {
+            m_tail = next;
+            value = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+
+        // 'tail' is the last linked node. If a producer has already swapped the
+        // head but not linked yet, report empty and pick it up on the next drain.
+        if (tail != m_head.load(std::memory_order_acquire))
+            return false;
+
+        // Re-insert the stub behind the last node so it can be released
+        m_stub.next.store(nullptr, std::memory_order_relaxed);
+        Enqueue(&m_stub);
+
+        next = tail->next.load(std::memory_order_acquire);
+        if (next)
+        {
+            m_tail = next;
+            value = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+        return false;
+    }
+
+    std::atomic<Node*> m_head;      // producers swap here
+    Node* m_tail;                   // consumer-owned
+    Node m_stub;
+    std::atomic<bool> m_wakePending;
+    WakeCallback m_wake;
+};
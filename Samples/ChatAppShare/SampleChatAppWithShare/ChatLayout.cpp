@@ -0,0 +1,54 @@
+#include "ChatLayout.h"
+
+// Contacts on the left, shared files on the right, conversation in between
+static const LayoutRule CHAT_LAYOUT_RULES[] =
+{
+    //  slot                         left                 top                  right                bottom
+    { LAYOUT_CONTACTS_LIST,       { ANCHOR_START, 20 },  { ANCHOR_START, 20 }, { ANCHOR_START, 300 }, { ANCHOR_END, -20 } },
+    { LAYOUT_CONTACT_NAME,        { ANCHOR_START, 320 }, { ANCHOR_START, 20 }, { ANCHOR_START, 620 }, { ANCHOR_START, 50 } },
+    { LAYOUT_CHAT_DISPLAY,        { ANCHOR_START, 320 }, { ANCHOR_START, 60 }, { ANCHOR_END, -280 },  { ANCHOR_END, -220 } },
+    { LAYOUT_SHARED_FILES_HEADER, { ANCHOR_END, -260 },  { ANCHOR_START, 20 }, { ANCHOR_END, -140 },  { ANCHOR_START, 50 } },
+    { LAYOUT_SHARED_FILES_LIST,   { ANCHOR_END, -260 },  { ANCHOR_START, 60 }, { ANCHOR_END, -20 },   { ANCHOR_END, -220 } },
+    { LAYOUT_MESSAGE_INPUT,       { ANCHOR_START, 320 }, { ANCHOR_END, -200 }, { ANCHOR_END, -280 },  { ANCHOR_END, -140 } },
+    { LAYOUT_SEND_BUTTON,         { ANCHOR_START, 320 }, { ANCHOR_END, -130 }, { ANCHOR_START, 420 }, { ANCHOR_END, -85 } },
+    { LAYOUT_SHARE_FILE_BUTTON,   { ANCHOR_START, 440 }, { ANCHOR_END, -130 }, { ANCHOR_START, 560 }, { ANCHOR_END, -85 } },
+};
+
+static_assert(sizeof(CHAT_LAYOUT_RULES) / sizeof(CHAT_LAYOUT_RULES[0]) == LAYOUT_SLOT_COUNT,
+    "every layout slot needs a rule");
+
+static int ResolveEdge(const LayoutEdge& edge, int extent)
+{
+    return (edge.anchor == ANCHOR_END ? extent : 0) + edge.offset;
+}
+
+void SolveChatLayout(int clientWidth, int clientHeight, ChatLayoutRects& rects)
+{
+    for (const LayoutRule& rule : CHAT_LAYOUT_RULES)
+    {
+        int left = ResolveEdge(rule.left, clientWidth);
+        int top = ResolveEdge(rule.top, clientHeight);
+        int right = ResolveEdge(rule.right, clientWidth);
+        int bottom = ResolveEdge(rule.bottom, clientHeight);
+
+        rects[rule.slot] = LayoutRect{ left, top, right > left ? right - left : 0, bottom > top ? bottom - top : 0 };
+    }
+}
+
+const ChatLayoutRects& ChatLayoutCache::Get(int clientWidth, int clientHeight)
+{
+    uint64_t key = ((uint64_t)(uint32_t)clientWidth << 32) | (uint32_t)clientHeight;
+
+    auto it = m_layouts.find(key);
+    if (it != m_layouts.end())
+        return it->second;
+
+    if (m_layouts.size() >= m_maxEntries)
+    {
+        m_layouts.clear();
+    }
+
+    ChatLayoutRects& rects = m_layouts[key];
+    SolveChatLayout(clientWidth, clientHeight, rects);
+    return rects;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// Controls placed by the chat window layout
+enum ChatLayoutSlot
+{
+    LAYOUT_CONTACTS_LIST,
+    LAYOUT_CONTACT_NAME,
+    LAYOUT_CHAT_DISPLAY,
+    LAYOUT_SHARED_FILES_HEADER,
+    LAYOUT_SHARED_FILES_LIST,
+    LAYOUT_MESSAGE_INPUT,
+    LAYOUT_SEND_BUTTON,
+    LAYOUT_SHARE_FILE_BUTTON,
+    LAYOUT_SLOT_COUNT
+};
+
+struct LayoutRect
+{
+    int x;
+    int y;
+    int width;
+    int height;
+
+    bool operator==(const LayoutRect& other) const
+    {
+        return x == other.x && y == other.y && width == other.width && height == other.height;
+    }
+    bool operator!=(const LayoutRect& other) const { return !(*this == other); }
+};
+
+typedef std::array<LayoutRect, LAYOUT_SLOT_COUNT> ChatLayoutRects;
+
+// Which client edge a control edge follows
+enum LayoutAnchor : uint8_t
+{
+    ANCHOR_START,   // left or top of the client area
+    ANCHOR_END      // right or bottom of the client area
+};
+
+struct LayoutEdge
+{
+    LayoutAnchor anchor;
+    int offset;
+};
+
+// One control's four edges, each pinned to a client edge plus an offset
+struct LayoutRule
+{
+    ChatLayoutSlot slot;
+    LayoutEdge left;
+    LayoutEdge top;
+    LayoutEdge right;
+    LayoutEdge bottom;
+};
+
+// Pure function from client size to child rectangles. Sizes never go negative
+// when the window is smaller than the layout's fixed parts.
+void SolveChatLayout(int clientWidth, int clientHeight, ChatLayoutRects& rects);
+
+// Remembers solved layouts per client size, so live resize back and forth
+// over the same sizes does not solve again.
+class ChatLayoutCache
+{
+public:
+    explicit ChatLayoutCache(size_t maxEntries = 256) : m_maxEntries(maxEntries) {}
+
+    const ChatLayoutRects& Get(int clientWidth, int clientHeight);
+
+    size_t Count() const { return m_layouts.size(); }
+
+private:
+    std::unordered_map<uint64_t, ChatLayoutRects> m_layouts;
+    size_t m_maxEntries;
+};
@@ -2,14 +2,77 @@
 #include "ChatModels.h"
 #include "FileManager.h"
 #include "UIManager.h"
+#include "UIConstants.h"
+#include "ContactListView.h"
+#include "TimerWheel.h"
+#include "PresenceEngine.h"
+#include "ShareHandoff.h"
+#include "AppReadySignal.h"
 #include <vector>
 #include <algorithm>
 #include <random>
 
+// Pending auto-replies and other delayed chat events, keyed by contact index
+static TimerWheel s_chatScheduler(GetTickCount64(), CHAT_SCHEDULER_TICK_MS);
+static HWND s_schedulerWindow = nullptr;
+static bool s_schedulerTimerActive = false;
+
+// Messages, presence changes and files arriving from network and service threads
+static MpscQueue<ChatEvent> s_chatEvents;
+
+// Content handed over by the share-target process while this window is up
+static ShareHandoffInbox s_shareInbox;
+static AppReadySignal s_readySignal;
+
+// Presence reports are coalesced here and committed from the scheduler tick
+static PresenceEngine s_presence(PRESENCE_COALESCE_MS);
+static bool s_presenceFlushScheduled = false;
+static const uint64_t PRESENCE_TIMER_KEY = UINT64_MAX;
+static const uint32_t CHAT_TIMER_PRESENCE_FLUSH = 0x100;
+static bool s_firingChatTimers = false;
+
+static void ArmSchedulerTimer()
+{
+    if (s_schedulerTimerActive) return;
+    
+    if (!s_schedulerWindow) {
+        s_schedulerWindow = GetParent(hMessageInput);
+    }
+    if (SetTimer(s_schedulerWindow, IDT_CHAT_SCHEDULER, CHAT_SCHEDULER_TICK_MS, NULL)) {
+        s_schedulerTimerActive = true;
+    }
+}
+
+static void AdvanceChatScheduler()
+{
+    s_firingChatTimers = true;
+    s_chatScheduler.Advance(GetTickCount64(), [](uint64_t key, uint32_t payload) {
+        if (payload == CHAT_TIMER_PRESENCE_FLUSH) {
+            FlushPresenceUpdates();
+        } else {
+            ProcessAutoReply((int)key, (int)payload);
+        }
+    });
+    s_firingChatTimers = false;
+}
+
+static void ScheduleChatTimer(uint64_t key, uint32_t delayMs, uint32_t payload)
+{
+    // The wheel's clock only moves when it is advanced, and the tick timer is off
+    // while nothing is pending, so catch it up before measuring a delay from it.
+    // Callbacks run with the clock already current.
+    if (!s_firingChatTimers) {
+        AdvanceChatScheduler();
+    }
+    s_chatScheduler.Schedule(key, delayMs, payload);
+    ArmSchedulerTimer();
+}
+
 void LoadContactChat(int contactIndex)
 {
     if (!IsValidContactIndex(contactIndex)) return;
     
+    int previousIndex = selectedContactIndex;
     selectedContactIndex = contactIndex;
     const Contact& contact = contacts[contactIndex];
     
@@ -20,20 +83,11 @@ void LoadContactChat(int contactIndex)
     // Clear and populate chat display with better formatting
     SetWindowText(hChatDisplay, L"");
     
+    // Each message caches its own display line, so this is just a concatenation
     std::wstring chatText;
     for (const auto& message : contact.messages) {
-        // Add timestamps and better message formatting
-        SYSTEMTIME st;
-        GetLocalTime(&st);
-        WCHAR timeStr[50];
-        swprintf_s(timeStr, 50, L"[%02d:%02d] ", st.wHour, st.wMinute);
-        
-        if (message.find(L"You:") == 0) {
-            chatText += L"                                           ";  // Right align for your messages
-            chatText += timeStr + message + L"\r\n\r\n";
-        } else {
-            chatText += timeStr + message + L"\r\n\r\n";
-        }
+        chatText += message.Rendered();
+        chatText += L"\r\n\r\n";
     }
     
     SetWindowText(hChatDisplay, chatText.c_str());
@@ -45,36 +99,39 @@ void LoadContactChat(int contactIndex)
     // Update shared files list
     UpdateSharedFilesList();
     
-    // Refresh contact list to show selection
-    InvalidateRect(hContactsList, NULL, TRUE);
+    // Refresh the rows whose selection state changed
+    if (previousIndex != contactIndex) {
+        InvalidateContactRow(previousIndex);
+    }
+    InvalidateContactRow(contactIndex);
 }
 
 void AddMessageToChat(const std::wstring& message, bool isOutgoing)
 {
-    Contact* contact = GetSelectedContact();
-    if (!contact) return;
-    
-    // Add timestamp to message
-    SYSTEMTIME st;
-    GetLocalTime(&st);
-    WCHAR timeStr[50];
-    swprintf_s(timeStr, 50, L"[%02d:%02d] ", st.wHour, st.wMinute);
+    AddMessageToContact(selectedContactIndex, message, isOutgoing);
+}
+
+void AddMessageToContact(int contactIndex, const std::wstring& message, bool isOutgoing)
+{
+    if (!IsValidContactIndex(contactIndex)) return;
+    Contact* contact = &contacts[contactIndex];
     
-    std::wstring formattedMessage;
     if (isOutgoing) {
-        formattedMessage = L"You: " + message + L" ??";
+        contact->messages.push_back(MakeChatMessage(SENDER_SELF, message + L" ??", MESSAGE_FLAG_OUTGOING));
     } else {
-        formattedMessage = contact->name + L": " + message;
+        contact->messages.push_back(MakeChatMessage(contact->senderId, message, MESSAGE_FLAG_NONE));
     }
+    contact->lastMessage = message;     // the list truncates to pixel width when drawing
+    MarkContactChanged(contactIndex);
+    PublishContactSnapshot();
     
-    contact->messages.push_back(formattedMessage);
-    contact->lastMessage = message.length() > 50 ? message.substr(0, 47) + L"..." : message;
-    
-    // Update chat display
-    LoadContactChat(selectedContactIndex);
+    // Update chat display if this conversation is on screen
+    if (contactIndex == selectedContactIndex) {
+        LoadContactChat(selectedContactIndex);
+    }
     
-    // Refresh contacts list to update last message preview
-    InvalidateRect(hContactsList, NULL, TRUE);
+    // Refresh this contact's row to update the last message preview
+    InvalidateContactRow(contactIndex);
 }
 
 void SendChatMessage()
@@ -90,18 +147,36 @@ void SendChatMessage()
         SetWindowText(hMessageInput, L"");
         
         // Simulate auto-reply after a short delay
-        SetTimer(GetParent(hMessageInput), 1, 2000, NULL);
+        ScheduleAutoReply(selectedContactIndex, AUTO_REPLY_MESSAGE);
     }
 }
 
-void ProcessAutoReply(HWND hWnd, int timerType)
+void ScheduleAutoReply(int contactIndex, AutoReplyType replyType)
 {
-    if (selectedContactIndex < 0) return;
+    if (!IsValidContactIndex(contactIndex)) return;
+    
+    // Every pending reply gets its own wheel entry, so back-to-back sends no longer
+    // overwrite each other the way reusing one SetTimer ID did
+    ScheduleChatTimer((uint64_t)contactIndex, AUTO_REPLY_DELAY_MS, (uint32_t)replyType);
+}
+
+void ProcessChatTimer(HWND hWnd)
+{
+    AdvanceChatScheduler();
     
-    KillTimer(hWnd, timerType);
+    // Only keep the tick source alive while something is pending
+    if (s_chatScheduler.PendingCount() == 0) {
+        KillTimer(hWnd, IDT_CHAT_SCHEDULER);
+        s_schedulerTimerActive = false;
+    }
+}
+
+void ProcessAutoReply(int contactIndex, int replyType)
+{
+    if (!IsValidContactIndex(contactIndex)) return;
     
-    if (timerType == 1) {
-        // Auto-reply from the selected contact with more variety
+    if (replyType == AUTO_REPLY_MESSAGE) {
+        // Auto-reply from the contact with more variety
         std::vector<std::wstring> autoReplies = {
             L"Got it!",
             L"Thanks for letting me know!",
@@ -114,9 +189,9 @@ void ProcessAutoReply(HWND hWnd, int timerType)
         };
         
         int replyIndex = rand() % autoReplies.size();
-        AddMessageToChat(autoReplies[replyIndex], false);
+        AddMessageToContact(contactIndex, autoReplies[replyIndex], false);
     }
-    else if (timerType == 2) {
+    else if (replyType == AUTO_REPLY_FILE) {
         // Auto-reply acknowledging the shared file
         std::vector<std::wstring> fileReplies = {
             L"Thanks for sharing the file!",
@@ -127,6 +202,179 @@ void ProcessAutoReply(HWND hWnd, int timerType)
         };
         
         int replyIndex = rand() % fileReplies.size();
-        AddMessageToChat(fileReplies[replyIndex], false);
+        AddMessageToContact(contactIndex, fileReplies[replyIndex], false);
+    }
+}
+
+void InitializeChatEventBus(HWND hWnd)
+{
+    s_schedulerWindow = hWnd;
+    
+    // Seed the presence engine with what the contact list currently shows
+    s_presence.Reset(contacts.size());
+    for (size_t i = 0; i < contacts.size(); i++) {
+        s_presence.Track((int)i, contacts[i].isOnline, contacts[i].status);
+    }
+    
+    // PostMessage fails when the message queue is full; the next event posts again
+    s_chatEvents.SetWakeCallback([hWnd]() {
+        return PostMessage(hWnd, WM_APP_CHAT_EVENTS, 0, 0) != FALSE;
+    });
+    
+    // Shared items become ordinary chat events; a second instance simply has no inbox
+    bool inboxStarted = s_shareInbox.Start(SHARE_HANDOFF_RING_NAME, SHARE_HANDOFF_RING_CAPACITY, [](ShareHandoffItem&& item) {
+        ChatEvent event{};
+        event.type = item.type == ShareHandoffType::File ? ChatEventType::FileShared : ChatEventType::NewMessage;
+        event.contactIndex = item.contactIndex;
+        event.text = std::move(item.text);
+        event.fileName = std::move(item.fileName);
+        event.isOutgoing = item.isOutgoing;
+        PostChatEvent(std::move(event));
+    });
+    
+    // Only the instance that owns the inbox may tell ShareApp it is ready for hand-offs
+    // A raised flag left by an instance that crashed is stale until the window is shown.
+    if (inboxStarted && s_readySignal.Open(SHARE_HANDOFF_RING_NAME)) {
+        s_readySignal.Reset();
+    }
+}
+
+void AnnounceChatAppReady()
+{
+    s_readySignal.Set();
+}
+
+void ShutdownChatEventBus()
+{
+    s_readySignal.Reset();
+    s_readySignal.Close();
+    s_shareInbox.Stop();
+}
+
+void PostChatEvent(ChatEvent event)
+{
+    s_chatEvents.Push(std::move(event));
+}
+
+void DrainChatEvents()
+{
+    bool selectedChanged = false;
+    std::vector<int> changedContacts;
+    
+    // Apply everything that is queued to the model first, then refresh the UI once
+    s_chatEvents.Drain([&](ChatEvent&& event) {
+        if (!IsValidContactIndex(event.contactIndex)) return;
+        Contact& contact = contacts[event.contactIndex];
+        
+        switch (event.type) {
+        case ChatEventType::NewMessage:
+            if (event.isOutgoing) {
+                contact.messages.push_back(MakeChatMessage(SENDER_SELF, event.text, MESSAGE_FLAG_OUTGOING));
+            } else {
+                contact.messages.push_back(MakeChatMessage(contact.senderId, event.text, MESSAGE_FLAG_NONE));
+            }
+            contact.lastMessage = event.text;
+            break;
+            
+        case ChatEventType::PresenceChanged:
+            // Buffered; the model and the visible rows change when the window closes
+            s_presence.Update(event.contactIndex, event.isOnline, event.text, GetTickCount64());
+            if (!s_presenceFlushScheduled) {
+                ScheduleChatTimer(PRESENCE_TIMER_KEY, PRESENCE_COALESCE_MS, CHAT_TIMER_PRESENCE_FLUSH);
+                s_presenceFlushScheduled = true;
+            }
+            return;
+            
+        case ChatEventType::FileStored:
+            // A worker is free again
+            SubmitSharedFileBacklog();
+            
+            // Only the shared-files panel shows metadata
+            {
+                SharedFileUpdate update = contact.sharedFiles.SetMetadata(event.text, event.metadata);
+                if (event.contactIndex != selectedContactIndex) {
+                    return;
+                }
+                if (update == SharedFileUpdate::Merged) {
+                    UpdateSharedFilesList();    // a duplicate left, so the row count changed
+                } else if (update == SharedFileUpdate::Updated) {
+                    InvalidateRect(hSharedFilesList, NULL, FALSE);
+                }
+            }
+            return;
+            
+        case ChatEventType::FileShared:
+            {
+                SharedFile file;
+                file.fileName = event.fileName;
+                file.filePath = event.text;
+                file.sharedBy = event.isOutgoing ? L"You" : contact.name;
+                file.timeShared = CurrentSharedFileTime();
+                file.contentHash = 0;
+                if (!contact.sharedFiles.Add(file)) {
+                    return;     // already shared, nothing new to show
+                }
+                ProcessSharedFileAsync(event.contactIndex, file.filePath);
+                
+                uint32_t flags = MESSAGE_FLAG_SHARE_NOTICE | (event.isOutgoing ? MESSAGE_FLAG_OUTGOING : MESSAGE_FLAG_NONE);
+                contact.messages.push_back(MakeChatMessage(event.isOutgoing ? SENDER_SELF : contact.senderId, file.fileName, flags));
+                contact.lastMessage = L"?? " + file.fileName;
+            }
+            break;
+        }
+        
+        MarkContactChanged(event.contactIndex);
+        changedContacts.push_back(event.contactIndex);
+        if (event.contactIndex == selectedContactIndex) {
+            selectedChanged = true;
+        }
+    });
+    
+    PublishContactSnapshot();
+    
+    if (selectedChanged) {
+        LoadContactChat(selectedContactIndex);
+    }
+    for (int contactIndex : changedContacts) {
+        InvalidateContactRow(contactIndex);
+    }
+}
+
+void FlushPresenceUpdates()
+{
+    s_presenceFlushScheduled = false;
+    
+    std::vector<PresenceDelta> deltas;
+    s_presence.Flush(GetTickCount64(), deltas);
+    
+    for (const auto& delta : deltas) {
+        Contact& contact = contacts[delta.contactIndex];
+        if (delta.changedFields & PRESENCE_FIELD_ONLINE) {
+            contact.isOnline = delta.isOnline;
+        }
+        if (delta.changedFields & PRESENCE_FIELD_STATUS) {
+            contact.status = delta.status;
+        }
+        MarkContactChanged(delta.contactIndex);
+        
+        if (delta.contactIndex == selectedContactIndex) {
+            std::wstring headerText = contact.name + L" " + L" (" + contact.status + L")";
+            SetWindowText(hContactName, headerText.c_str());
+        }
+    }
+    
+    if (!deltas.empty()) {
+        PublishContactSnapshot();
+        
+        // Repaint only the rows that changed; off-screen contacts are skipped
+        for (const auto& delta : deltas) {
+            InvalidateContactRow(delta.contactIndex);
+        }
+    }
+    
+    // Contacts still inside their window get another pass
+    if (s_presence.HasPending()) {
+        ScheduleChatTimer(PRESENCE_TIMER_KEY, PRESENCE_COALESCE_MS, CHAT_TIMER_PRESENCE_FLUSH);
+        s_presenceFlushScheduled = true;
     }
 }
\ No newline at end of file
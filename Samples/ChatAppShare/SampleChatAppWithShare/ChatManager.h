@@ -2,9 +2,29 @@
 
 #include <windows.h>
 #include <string>
+#include "ChatEventQueue.h"
 
 // Chat management functions
 void LoadContactChat(int contactIndex);
 void SendChatMessage();
 void AddMessageToChat(const std::wstring& message, bool isOutgoing);
-void ProcessAutoReply(HWND hWnd, int timerType);
\ No newline at end of file
+void AddMessageToContact(int contactIndex, const std::wstring& message, bool isOutgoing);
+
+// Delayed chat events, driven by a single timer on the main window
+enum AutoReplyType
+{
+    AUTO_REPLY_MESSAGE = 1,
+    AUTO_REPLY_FILE = 2
+};
+
+void ScheduleAutoReply(int contactIndex, AutoReplyType replyType);
+void ProcessChatTimer(HWND hWnd);
+void ProcessAutoReply(int contactIndex, int replyType);
+
+// Chat event bus: background threads post, the UI thread drains once per wakeup
+void InitializeChatEventBus(HWND hWnd);
+void AnnounceChatAppReady();     // once the window is shown
+void ShutdownChatEventBus();
+void PostChatEvent(ChatEvent event);
+void DrainChatEvents();
+void FlushPresenceUpdates();
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "ChatMessage.h"
+
+// Padding used to push outgoing messages to the right of the chat display
+static const wchar_t OUTGOING_PADDING[] = L"                                           ";
+
+std::vector<SenderTable::Entry>& SenderTable::Entries()
+{
+    static std::vector<Entry> entries = { { L"You", L"You: " } };
+    return entries;
+}
+
+std::unordered_map<std::wstring, uint32_t>& SenderTable::Lookup()
+{
+    static std::unordered_map<std::wstring, uint32_t> lookup = { { L"You", SENDER_SELF } };
+    return lookup;
+}
+
+uint32_t SenderTable::Intern(const std::wstring& displayName)
+{
+    auto& lookup = Lookup();
+    auto it = lookup.find(displayName);
+    if (it != lookup.end())
+        return it->second;
+
+    auto& entries = Entries();
+    uint32_t senderId = (uint32_t)entries.size();
+    entries.push_back({ displayName, displayName + L": " });
+    lookup.emplace(displayName, senderId);
+    return senderId;
+}
+
+const std::wstring& SenderTable::Name(uint32_t senderId)
+{
+    auto& entries = Entries();
+    return senderId < entries.size() ? entries[senderId].name : entries[SENDER_SELF].name;
+}
+
+const std::wstring& SenderTable::Prefix(uint32_t senderId)
+{
+    auto& entries = Entries();
+    return senderId < entries.size() ? entries[senderId].prefix : entries[SENDER_SELF].prefix;
+}
+
+ChatMessage::ChatMessage()
+    : m_senderId(SENDER_SELF)
+    , m_flags(MESSAGE_FLAG_NONE)
+    , m_hour(0)
+    , m_minute(0)
+    , m_renderedValid(false)
+{
+}
+
+ChatMessage::ChatMessage(uint32_t senderId, const std::wstring& body, uint32_t flags, uint16_t hour, uint16_t minute)
+    : m_senderId(senderId)
+    , m_flags(flags)
+    , m_body(body)
+    , m_hour(hour)
+    , m_minute(minute)
+    , m_renderedValid(false)
+{
+}
+
+void ChatMessage::SetBody(const std::wstring& body)
+{
+    m_body = body;
+    m_renderedValid = false;
+}
+
+const std::wstring& ChatMessage::Rendered() const
+{
+    if (m_renderedValid)
+        return m_rendered;
+
+    wchar_t timeStr[16] = { L'[',
+        (wchar_t)(L'0' + m_hour / 10 % 10), (wchar_t)(L'0' + m_hour % 10), L':',
+        (wchar_t)(L'0' + m_minute / 10 % 10), (wchar_t)(L'0' + m_minute % 10), L']', L' ', 0 };
+
+    m_rendered.clear();
+    if (IsOutgoing())
+    {
+        m_rendered += OUTGOING_PADDING;
+    }
+    m_rendered += timeStr;
+
+    if (m_flags & MESSAGE_FLAG_SHARE_NOTICE)
+    {
+        m_rendered += SenderTable::Name(m_senderId);
+        m_rendered += L" shared: ";
+    }
+    else
+    {
+        m_rendered += SenderTable::Prefix(m_senderId);
+    }
+    m_rendered += m_body;
+
+    m_renderedValid = true;
+    return m_rendered;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Message flag bits
+enum ChatMessageFlags : uint32_t
+{
+    MESSAGE_FLAG_NONE = 0,
+    MESSAGE_FLAG_OUTGOING = 1u << 0,      // Sent by the local user, drawn right-aligned
+    MESSAGE_FLAG_SHARE_NOTICE = 1u << 1   // "<sender> shared: <file>" notice
+};
+
+// Sender id reserved for the local user ("You")
+const uint32_t SENDER_SELF = 0;
+
+// Interned sender names. Each distinct sender is stored once and messages
+// reference it by id, so the "Name: " prefix is built once per sender instead
+// of being copied into every message string.
+class SenderTable
+{
+public:
+    static uint32_t Intern(const std::wstring& displayName);
+    static const std::wstring& Name(uint32_t senderId);
+    static const std::wstring& Prefix(uint32_t senderId);
+
+private:
+    struct Entry
+    {
+        std::wstring name;
+        std::wstring prefix;
+    };
+
+    static std::vector<Entry>& Entries();
+    static std::unordered_map<std::wstring, uint32_t>& Lookup();
+};
+
+// A single chat message: who sent it, what they said and how to show it.
+// The display line is rendered on first use and cached until the message is edited.
+class ChatMessage
+{
+public:
+    ChatMessage();
+    ChatMessage(uint32_t senderId, const std::wstring& body, uint32_t flags, uint16_t hour, uint16_t minute);
+
+    uint32_t SenderId() const { return m_senderId; }
+    uint32_t Flags() const { return m_flags; }
+    const std::wstring& Body() const { return m_body; }
+    bool IsOutgoing() const { return (m_flags & MESSAGE_FLAG_OUTGOING) != 0; }
+
+    // Replace the message text; drops the cached display line
+    void SetBody(const std::wstring& body);
+
+    // "[hh:mm] Sender: body" with right-alignment padding for outgoing messages
+    const std::wstring& Rendered() const;
+
+private:
+    uint32_t m_senderId;
+    uint32_t m_flags;
+    std::wstring m_body;
+    uint16_t m_hour;
+    uint16_t m_minute;
+
+    mutable std::wstring m_rendered;
+    mutable bool m_renderedValid;
+};
@@ -1,37 +1,62 @@
 #include "ChatModels.h"
+#include "ServiceResponseCache.h"
+#include "ServiceTopics.h"
 
 // Global data definitions
 std::vector<Contact> contacts;
 std::map<std::wstring, std::vector<std::wstring>> chatHistory;
 int selectedContactIndex = -1;
 
+// Published read-only views of 'contacts'
+static ContactSnapshotStore s_contactSnapshots;
+static uint64_t s_nextContactRevision = 0;
+static bool s_contactsDirty = false;
+
+// Build a seeded conversation from (sender, text) pairs
+static std::vector<ChatMessage> Seed(std::initializer_list<std::pair<const wchar_t*, const wchar_t*>> lines)
+{
+    std::vector<ChatMessage> messages;
+    for (const auto& line : lines) {
+        uint32_t senderId = SenderTable::Intern(line.first);
+        messages.push_back(MakeChatMessage(senderId, line.second, senderId == SENDER_SELF ? MESSAGE_FLAG_OUTGOING : MESSAGE_FLAG_NONE));
+    }
+    return messages;
+}
+
 void InitializeContacts()
 {
     contacts = {
-        {L"Alice Johnson", L"Hey, how are you?", {L"Alice: Hey, how are you?", L"You: I'm doing great, thanks!", L"Alice: That's wonderful to hear!"}, {}, L"Available", true},
-        {L"Bob Smith", L"See you tomorrow!", {L"Bob: Are we still meeting tomorrow?", L"You: Yes, see you at 3 PM", L"Bob: See you tomorrow!"}, {}, L"In a meeting", true},
-        {L"Carol Williams", L"Thanks for the help", {L"Carol: Could you help me with the project?", L"You: Of course! What do you need?", L"Carol: Thanks for the help"}, {}, L"Available", true},
-        {L"David Brown", L"Great presentation!", {L"David: Great presentation today!", L"You: Thank you! I'm glad you liked it"}, {}, L"Away", false},
-        {L"Emma Davis", L"Coffee later?", {L"Emma: Want to grab coffee later?", L"You: Sure! What time works for you?", L"Emma: Coffee later?"}, {}, L"Available", true},
-        {L"Frank Miller", L"Happy Birthday!", {L"Frank: Happy Birthday!", L"You: Thank you so much!"}, {}, L"Busy", true},
-        {L"Grace Wilson", L"Meeting rescheduled", {L"Grace: Meeting has been rescheduled to 4 PM", L"You: Got it, thanks for letting me know"}, {}, L"Available", true},
-        {L"Henry Taylor", L"Weekend plans?", {L"Henry: Any plans for the weekend?", L"You: Nothing concrete yet", L"Henry: Weekend plans?"}, {}, L"Offline", false},
-        {L"Ivy Anderson", L"Project update", {L"Ivy: Here's the project update you requested", L"You: Perfect, reviewing it now"}, {}, L"Available", true},
-        {L"Jack Thompson", L"Game night Friday", {L"Jack: Game night this Friday?", L"You: Count me in!", L"Jack: Game night Friday"}, {}, L"Gaming", true},
-        {L"Kate Garcia", L"Recipe sharing", {L"Kate: Loved that recipe you shared!", L"You: I'm so glad you enjoyed it!"}, {}, L"Cooking", true},
-        {L"Leo Martinez", L"Workout buddy", {L"Leo: Gym session tomorrow morning?", L"You: Absolutely! 7 AM as usual?"}, {}, L"At the gym", true},
-        {L"Mia Rodriguez", L"Book recommendation", {L"Mia: Any good book recommendations?", L"You: I just finished a great mystery novel"}, {}, L"Reading", true},
-        {L"Noah Lee", L"Tech discussion", {L"Noah: Thoughts on the new framework?", L"You: It looks promising! Want to discuss over lunch?"}, {}, L"Coding", true},
-        {L"Olivia Clark", L"Travel planning", {L"Olivia: Planning the vacation itinerary", L"You: Excited to see what you've planned!"}, {}, L"Traveling", false}
+        {L"Alice Johnson", L"Hey, how are you?", Seed({{L"Alice", L"Hey, how are you?"}, {L"You", L"I'm doing great, thanks!"}, {L"Alice", L"That's wonderful to hear!"}}), {}, L"Available", true},
+        {L"Bob Smith", L"See you tomorrow!", Seed({{L"Bob", L"Are we still meeting tomorrow?"}, {L"You", L"Yes, see you at 3 PM"}, {L"Bob", L"See you tomorrow!"}}), {}, L"In a meeting", true},
+        {L"Carol Williams", L"Thanks for the help", Seed({{L"Carol", L"Could you help me with the project?"}, {L"You", L"Of course! What do you need?"}, {L"Carol", L"Thanks for the help"}}), {}, L"Available", true},
+        {L"David Brown", L"Great presentation!", Seed({{L"David", L"Great presentation today!"}, {L"You", L"Thank you! I'm glad you liked it"}}), {}, L"Away", false},
+        {L"Emma Davis", L"Coffee later?", Seed({{L"Emma", L"Want to grab coffee later?"}, {L"You", L"Sure! What time works for you?"}, {L"Emma", L"Coffee later?"}}), {}, L"Available", true},
+        {L"Frank Miller", L"Happy Birthday!", Seed({{L"Frank", L"Happy Birthday!"}, {L"You", L"Thank you so much!"}}), {}, L"Busy", true},
+        {L"Grace Wilson", L"Meeting rescheduled", Seed({{L"Grace", L"Meeting has been rescheduled to 4 PM"}, {L"You", L"Got it, thanks for letting me know"}}), {}, L"Available", true},
+        {L"Henry Taylor", L"Weekend plans?", Seed({{L"Henry", L"Any plans for the weekend?"}, {L"You", L"Nothing concrete yet"}, {L"Henry", L"Weekend plans?"}}), {}, L"Offline", false},
+        {L"Ivy Anderson", L"Project update", Seed({{L"Ivy", L"Here's the project update you requested"}, {L"You", L"Perfect, reviewing it now"}}), {}, L"Available", true},
+        {L"Jack Thompson", L"Game night Friday", Seed({{L"Jack", L"Game night this Friday?"}, {L"You", L"Count me in!"}, {L"Jack", L"Game night Friday"}}), {}, L"Gaming", true},
+        {L"Kate Garcia", L"Recipe sharing", Seed({{L"Kate", L"Loved that recipe you shared!"}, {L"You", L"I'm so glad you enjoyed it!"}}), {}, L"Cooking", true},
+        {L"Leo Martinez", L"Workout buddy", Seed({{L"Leo", L"Gym session tomorrow morning?"}, {L"You", L"Absolutely! 7 AM as usual?"}}), {}, L"At the gym", true},
+        {L"Mia Rodriguez", L"Book recommendation", Seed({{L"Mia", L"Any good book recommendations?"}, {L"You", L"I just finished a great mystery novel"}}), {}, L"Reading", true},
+        {L"Noah Lee", L"Tech discussion", Seed({{L"Noah", L"Thoughts on the new framework?"}, {L"You", L"It looks promising! Want to discuss over lunch?"}}), {}, L"Coding", true},
+        {L"Olivia Clark", L"Travel planning", Seed({{L"Olivia", L"Planning the vacation itinerary"}, {L"You", L"Excited to see what you've planned!"}}), {}, L"Traveling", false}
     };
 
+    for (auto& contact : contacts) {
+        contact.senderId = SenderTable::Intern(contact.name);
+        contact.revision = ++s_nextContactRevision;
+    }
+
     // Add some sample shared files to demonstrate the feature
-    SYSTEMTIME st;
-    GetSystemTime(&st);
+    uint64_t now = CurrentSharedFileTime();
     
-    contacts[0].sharedFiles.push_back({L"Project_Proposal.docx", L"C:\\Documents\\Project_Proposal.docx", L"Alice", st});
-    contacts[1].sharedFiles.push_back({L"Meeting_Notes.pdf", L"C:\\Documents\\Meeting_Notes.pdf", L"Bob", st});
-    contacts[2].sharedFiles.push_back({L"Budget_Spreadsheet.xlsx", L"C:\\Documents\\Budget_Spreadsheet.xlsx", L"Carol", st});
+    contacts[0].sharedFiles.Add({L"Project_Proposal.docx", L"C:\\Documents\\Project_Proposal.docx", L"Alice", now, 0});
+    contacts[1].sharedFiles.Add({L"Meeting_Notes.pdf", L"C:\\Documents\\Meeting_Notes.pdf", L"Bob", now, 0});
+    contacts[2].sharedFiles.Add({L"Budget_Spreadsheet.xlsx", L"C:\\Documents\\Budget_Spreadsheet.xlsx", L"Carol", now, 0});
+
+    s_contactsDirty = true;
+    PublishContactSnapshot();
 }
 
 Contact* GetSelectedContact()
@@ -45,4 +70,59 @@ Contact* GetSelectedContact()
 bool IsValidContactIndex(int index)
 {
     return index >= 0 && index < (int)contacts.size();
-}
\ No newline at end of file
+}
+
+void MarkContactChanged(int contactIndex)
+{
+    if (IsValidContactIndex(contactIndex)) {
+        contacts[contactIndex].revision = ++s_nextContactRevision;
+        s_contactsDirty = true;
+    }
+}
+
+void PublishContactSnapshot()
+{
+    if (!s_contactsDirty) return;
+    s_contactsDirty = false;
+
+    std::shared_ptr<const ContactSnapshot> previous = s_contactSnapshots.Acquire();
+
+    std::vector<std::shared_ptr<const ContactView>> views;
+    views.reserve(contacts.size());
+
+    for (size_t i = 0; i < contacts.size(); i++) {
+        const Contact& contact = contacts[i];
+
+        // Contacts whose revision did not move are shared with the previous version
+        if (i < previous->Size() && previous->contacts[i]->revision == contact.revision) {
+            views.push_back(previous->contacts[i]);
+        } else {
+            views.push_back(std::make_shared<const ContactView>(ContactView{
+                contact.name, contact.status, contact.lastMessage, contact.isOnline, contact.revision }));
+        }
+    }
+
+    s_contactSnapshots.Publish(std::move(views));
+
+    // Service replies built from the old contacts must not outlive them
+    ServiceResponseCache::InvalidateTopic(SERVICE_TOPIC_CONTACTS);
+}
+
+std::shared_ptr<const ContactSnapshot> AcquireContactSnapshot()
+{
+    return s_contactSnapshots.Acquire();
+}
+
+ChatMessage MakeChatMessage(uint32_t senderId, const std::wstring& body, uint32_t flags)
+{
+    SYSTEMTIME st;
+    GetLocalTime(&st);
+    return ChatMessage(senderId, body, flags, st.wHour, st.wMinute);
+}
+
+uint64_t CurrentSharedFileTime()
+{
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    return ((uint64_t)now.dwHighDateTime << 32) | now.dwLowDateTime;
+}
@@ -4,21 +4,19 @@
 #include <vector>
 #include <map>
 #include <windows.h>
-
-struct SharedFile {
-    std::wstring fileName;
-    std::wstring filePath;
-    std::wstring sharedBy;
-    SYSTEMTIME timeShared;
-};
+#include "ChatMessage.h"
+#include "ContactSnapshot.h"
+#include "SharedFileIndex.h"
 
 struct Contact {
     std::wstring name;
     std::wstring lastMessage;
-    std::vector<std::wstring> messages;
-    std::vector<SharedFile> sharedFiles;
+    std::vector<ChatMessage> messages;
+    SharedFileIndex sharedFiles;
     std::wstring status;
     bool isOnline;
+    uint32_t senderId;  // Interned display name, see SenderTable
+    uint64_t revision;  // Bumped by MarkContactChanged, used to share unchanged snapshot views
 };
 
 // Global data
@@ -29,4 +27,16 @@ extern int selectedContactIndex;
 // Contact management functions
 void InitializeContacts();
 Contact* GetSelectedContact();
-bool IsValidContactIndex(int index);
\ No newline at end of file
+bool IsValidContactIndex(int index);
+
+// Contact snapshots for lock-free readers (painting, dialogs, search).
+// Writers mutate 'contacts' on the UI thread, mark what they touched and publish.
+void MarkContactChanged(int contactIndex);
+void PublishContactSnapshot();
+std::shared_ptr<const ContactSnapshot> AcquireContactSnapshot();
+
+// Message helpers
+ChatMessage MakeChatMessage(uint32_t senderId, const std::wstring& body, uint32_t flags);
+
+// Current UTC time in SharedFile::timeShared units
+uint64_t CurrentSharedFileTime();
\ No newline at end of file
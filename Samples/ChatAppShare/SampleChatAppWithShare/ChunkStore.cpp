@@ -0,0 +1,303 @@
+#include "ChunkStore.h"
+#include "ContentHash.h"
+#include <cstring>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static const uint32_t MANIFEST_MAGIC = 0x31464D43;     // "CMF1"
+
+static std::string HexName(uint64_t value)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string name(16, '0');
+    for (int i = 15; i >= 0; i--)
+    {
+        name[i] = digits[value & 0xF];
+        value >>= 4;
+    }
+    return name;
+}
+
+ChunkStore::ChunkStore(const fs::path& root)
+    : m_root(root), m_stats{ 0, 0, 0, 0 }, m_tempCounter(0)
+{
+    std::error_code error;
+    fs::create_directories(m_root / "chunks", error);
+    fs::create_directories(m_root / "manifests", error);
+}
+
+fs::path ChunkStore::ChunkPath(uint64_t hash) const
+{
+    std::string name = HexName(hash);
+    return m_root / "chunks" / name.substr(0, 2) / name;
+}
+
+fs::path ChunkStore::ManifestPath(uint64_t id) const
+{
+    return m_root / "manifests" / HexName(id);
+}
+
+bool ChunkStore::Ingest(const fs::path& filePath, ChunkManifest& manifest)
+{
+    std::ifstream input(filePath, std::ios::binary);
+    if (!input)
+        return false;
+    return Ingest(input, manifest);
+}
+
+bool ChunkStore::Ingest(std::istream& input, ChunkManifest& manifest)
+{
+    manifest.id = 0;
+    manifest.fileSize = 0;
+    manifest.chunks.clear();
+
+    std::vector<uint8_t> buffer(READ_BUFFER_SIZE);
+    size_t begin = 0;
+    size_t end = 0;
+    bool atEnd = false;
+    ContentHasher fileHasher;
+
+    while (true)
+    {
+        // Keep at least one maximum-size chunk buffered so cut points do not
+        // depend on how the file happened to be read
+        if (!atEnd && end - begin < m_chunker.MaxSize())
+        {
+            if (begin > 0)
+            {
+                memmove(buffer.data(), buffer.data() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+            }
+            input.read((char*)buffer.data() + end, (std::streamsize)(buffer.size() - end));
+            size_t got = (size_t)input.gcount();
+            fileHasher.Update(buffer.data() + end, got);
+            end += got;
+            if (input.bad())
+                return false;
+            if (!input)
+                atEnd = true;
+            continue;
+        }
+
+        if (begin == end)
+            break;
+
+        size_t cut = m_chunker.NextCut(buffer.data() + begin, end - begin);
+        ChunkRef chunk{ ContentHash64(buffer.data() + begin, cut), (uint32_t)cut };
+        if (!StoreChunk(buffer.data() + begin, chunk))
+            return false;
+
+        manifest.chunks.push_back(chunk);
+        manifest.fileSize += cut;
+        begin += cut;
+    }
+
+    manifest.id = fileHasher.Digest();
+    return HasManifest(manifest.id) || WriteManifest(manifest);
+}
+
+bool ChunkStore::StoreChunk(const uint8_t* data, const ChunkRef& chunk)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stats.bytesIngested += chunk.length;
+        m_stats.chunksIngested++;
+
+        // Similar files ingested side by side reach the same chunks at the same
+        // time; one of them writes each chunk and the others wait for it
+        m_chunkWritten.wait(lock, [&]() { return m_writingChunks.count(chunk.hash) == 0; });
+        if (m_knownChunks.count(chunk.hash))
+            return true;
+        m_writingChunks.insert(chunk.hash);
+    }
+
+    bool stored = true;
+    bool written = false;
+    std::error_code error;
+    fs::path path = ChunkPath(chunk.hash);
+    if (fs::file_size(path, error) != chunk.length || error)
+    {
+        fs::create_directories(path.parent_path(), error);
+        stored = written = WriteFileAtomically(path, data, chunk.length);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_writingChunks.erase(chunk.hash);
+        if (stored)
+            m_knownChunks.insert(chunk.hash);
+        if (written)
+        {
+            m_stats.bytesStored += chunk.length;
+            m_stats.chunksStored++;
+        }
+    }
+    m_chunkWritten.notify_all();
+    return stored;
+}
+
+bool ChunkStore::WriteFileAtomically(const fs::path& path, const void* data, size_t length)
+{
+    uint64_t counter;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        counter = ++m_tempCounter;
+    }
+
+    fs::path tempPath = path;
+    tempPath += ".tmp" + std::to_string(counter);
+    {
+        std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+        if (!output.write((const char*)data, (std::streamsize)length))
+        {
+            output.close();
+            std::error_code ignored;
+            fs::remove(tempPath, ignored);
+            return false;
+        }
+    }
+
+    // Another thread may have stored the same content meanwhile; either copy is fine
+    std::error_code error;
+    fs::rename(tempPath, path, error);
+    if (error)
+    {
+        fs::remove(tempPath, error);
+        return fs::exists(path, error);
+    }
+    return true;
+}
+
+bool ChunkStore::WriteManifest(const ChunkManifest& manifest)
+{
+    std::vector<uint8_t> bytes;
+    bytes.reserve(24 + manifest.chunks.size() * 12);
+
+    auto append = [&bytes](const void* value, size_t size) {
+        const uint8_t* p = (const uint8_t*)value;
+        bytes.insert(bytes.end(), p, p + size);
+    };
+
+    uint32_t count = (uint32_t)manifest.chunks.size();
+    append(&MANIFEST_MAGIC, sizeof(MANIFEST_MAGIC));
+    append(&manifest.id, sizeof(manifest.id));
+    append(&manifest.fileSize, sizeof(manifest.fileSize));
+    append(&count, sizeof(count));
+    for (const ChunkRef& chunk : manifest.chunks)
+    {
+        append(&chunk.hash, sizeof(chunk.hash));
+        append(&chunk.length, sizeof(chunk.length));
+    }
+
+    return WriteFileAtomically(ManifestPath(manifest.id), bytes.data(), bytes.size());
+}
+
+bool ChunkStore::HasManifest(uint64_t id) const
+{
+    std::error_code error;
+    return fs::exists(ManifestPath(id), error);
+}
+
+bool ChunkStore::LoadManifest(uint64_t id, ChunkManifest& manifest) const
+{
+    std::ifstream input(ManifestPath(id), std::ios::binary);
+    if (!input)
+        return false;
+
+    uint32_t magic = 0;
+    uint32_t count = 0;
+    input.read((char*)&magic, sizeof(magic));
+    input.read((char*)&manifest.id, sizeof(manifest.id));
+    input.read((char*)&manifest.fileSize, sizeof(manifest.fileSize));
+    input.read((char*)&count, sizeof(count));
+    if (!input || magic != MANIFEST_MAGIC || manifest.id != id)
+        return false;
+
+    manifest.chunks.resize(count);
+    uint64_t total = 0;
+    for (ChunkRef& chunk : manifest.chunks)
+    {
+        input.read((char*)&chunk.hash, sizeof(chunk.hash));
+        input.read((char*)&chunk.length, sizeof(chunk.length));
+        total += chunk.length;
+    }
+    return input && total == manifest.fileSize;
+}
+
+bool ChunkStore::ReadChunk(const ChunkRef& chunk, std::vector<uint8_t>& data) const
+{
+    std::ifstream input(ChunkPath(chunk.hash), std::ios::binary);
+    if (!input)
+        return false;
+
+    data.resize(chunk.length);
+    if (!input.read((char*)data.data(), chunk.length))
+        return false;
+    return ContentHash64(data.data(), data.size()) == chunk.hash;
+}
+
+bool ChunkStore::HasChunk(const ChunkRef& chunk) const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_knownChunks.count(chunk.hash))
+            return true;
+    }
+
+    std::error_code error;
+    uint64_t size = fs::file_size(ChunkPath(chunk.hash), error);
+    return !error && size == chunk.length;
+}
+
+bool ChunkStore::PutChunk(const uint8_t* data, const ChunkRef& chunk)
+{
+    if (ContentHash64(data, chunk.length) != chunk.hash)
+        return false;
+    return StoreChunk(data, chunk);
+}
+
+bool ChunkStore::PutManifest(const ChunkManifest& manifest)
+{
+    // The id comes from the other side and names the file's content, so it is
+    // checked against what the chunks actually restore to; reading them back
+    // also proves every one is present and intact
+    ContentHasher fileHasher;
+    uint64_t total = 0;
+    std::vector<uint8_t> data;
+    for (const ChunkRef& chunk : manifest.chunks)
+    {
+        if (!ReadChunk(chunk, data))
+            return false;
+        fileHasher.Update(data.data(), data.size());
+        total += chunk.length;
+    }
+    if (total != manifest.fileSize || fileHasher.Digest() != manifest.id)
+        return false;
+
+    return HasManifest(manifest.id) || WriteManifest(manifest);
+}
+
+bool ChunkStore::Restore(const ChunkManifest& manifest, const fs::path& outputPath) const
+{
+    std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+    if (!output)
+        return false;
+
+    std::vector<uint8_t> data;
+    for (const ChunkRef& chunk : manifest.chunks)
+    {
+        if (!ReadChunk(chunk, data))
+            return false;
+        if (!output.write((const char*)data.data(), (std::streamsize)data.size()))
+            return false;
+    }
+    return true;
+}
+
+ChunkStoreStats ChunkStore::Stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "FastCdc.h"
+
+struct ChunkRef
+{
+    uint64_t hash;      // ContentHash64 of the chunk bytes
+    uint32_t length;
+};
+
+// The recipe for one file: its chunks in order. 'id' is the content hash of the
+// whole file, so identical files share a manifest no matter where they came from.
+struct ChunkManifest
+{
+    uint64_t id;
+    uint64_t fileSize;
+    std::vector<ChunkRef> chunks;
+};
+
+struct ChunkStoreStats
+{
+    uint64_t bytesIngested;     // everything fed to Ingest
+    uint64_t bytesStored;       // bytes of chunks that were new
+    uint64_t chunksIngested;
+    uint64_t chunksStored;
+
+    // Logical bytes per physical byte written; 1.0 means nothing deduplicated
+    double DedupRatio() const { return bytesStored ? (double)bytesIngested / (double)bytesStored : 1.0; }
+};
+
+// Content-addressed store for shared files.
+//
+// Files are split with FastCDC and every distinct chunk is written once under
+// root/chunks/<first two hex digits>/<hash>. Each ingested file also gets a
+// manifest under root/manifests/<id>. Chunks are written to a temporary name
+// and renamed into place, so a crash never leaves a torn chunk behind.
+// Ingest may be called from several threads at once.
+class ChunkStore
+{
+public:
+    explicit ChunkStore(const std::filesystem::path& root);
+
+    bool Ingest(const std::filesystem::path& filePath, ChunkManifest& manifest);
+    bool Ingest(std::istream& input, ChunkManifest& manifest);
+
+    bool LoadManifest(uint64_t id, ChunkManifest& manifest) const;
+    bool HasManifest(uint64_t id) const;
+
+    // Chunk bytes, verified against the hash. False if missing or corrupt.
+    bool ReadChunk(const ChunkRef& chunk, std::vector<uint8_t>& data) const;
+
+    // Pieces of a file arriving from elsewhere. PutChunk rejects bytes that do
+    // not match the hash; PutManifest only succeeds once every chunk is present
+    // and together they hash to the manifest's id, so an interrupted transfer
+    // resumes with the chunks it already has and a wrong id is never recorded.
+    bool HasChunk(const ChunkRef& chunk) const;
+    bool PutChunk(const uint8_t* data, const ChunkRef& chunk);
+    bool PutManifest(const ChunkManifest& manifest);
+
+    // Rebuild the original file from its manifest
+    bool Restore(const ChunkManifest& manifest, const std::filesystem::path& outputPath) const;
+
+    ChunkStoreStats Stats() const;
+    const std::filesystem::path& Root() const { return m_root; }
+
+    static const size_t READ_BUFFER_SIZE = 1024 * 1024;
+
+private:
+    std::filesystem::path ChunkPath(uint64_t hash) const;
+    std::filesystem::path ManifestPath(uint64_t id) const;
+
+    bool StoreChunk(const uint8_t* data, const ChunkRef& chunk);
+    bool WriteManifest(const ChunkManifest& manifest);
+    bool WriteFileAtomically(const std::filesystem::path& path, const void* data, size_t length);
+
+    std::filesystem::path m_root;
+    FastCdcChunker m_chunker;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_chunkWritten;
+    std::unordered_set<uint64_t> m_knownChunks;     // written by this process or found on disk
+    std::unordered_set<uint64_t> m_writingChunks;   // being written by some thread right now
+    ChunkStoreStats m_stats;
+    uint64_t m_tempCounter;
+};
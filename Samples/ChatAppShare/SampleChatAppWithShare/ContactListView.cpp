@@ -0,0 +1,196 @@
+#include "ContactListView.h"
+#include "ChatModels.h"
+#include "ModernUI.h"
+#include "UIConstants.h"
+#include "UIManager.h"
+#include "DirtyRowTracker.h"
+#include "RowCache.h"
+
+// Back buffer holding one CONTACT_ITEM_HEIGHT row per visible slot
+static HDC s_backBufferDC = nullptr;
+static HBITMAP s_backBufferBitmap = nullptr;
+static HGDIOBJ s_oldBackBufferBitmap = nullptr;
+static int s_backBufferWidth = 0;
+static int s_backBufferSlots = 0;
+
+static DirtyRowTracker s_rowTracker;
+
+// Fully rendered rows keyed by content, so a row that scrolls back into view or
+// toggles back to a previous state is a single BitBlt
+static RowCache s_rowCache(ROW_CACHE_BUDGET_BYTES, [](void* image) {
+    DeleteObject((HBITMAP)image);
+});
+static HDC s_rowDC = nullptr;
+
+static void ReleaseBackBuffer()
+{
+    if (s_backBufferDC)
+    {
+        SelectObject(s_backBufferDC, s_oldBackBufferBitmap);
+        DeleteDC(s_backBufferDC);
+        s_backBufferDC = nullptr;
+    }
+    if (s_backBufferBitmap)
+    {
+        DeleteObject(s_backBufferBitmap);
+        s_backBufferBitmap = nullptr;
+    }
+    s_oldBackBufferBitmap = nullptr;
+    s_backBufferWidth = 0;
+    s_backBufferSlots = 0;
+    s_rowTracker.Resize(0);
+}
+
+static bool EnsureBackBuffer(HDC hdc, int width, int slotCount)
+{
+    if (s_backBufferDC && s_backBufferWidth == width && s_backBufferSlots == slotCount)
+        return true;
+
+    // Cached rows keep their size, so only the back buffer is rebuilt
+    ReleaseBackBuffer();
+
+    s_backBufferDC = CreateCompatibleDC(hdc);
+    if (!s_backBufferDC)
+        return false;
+
+    s_backBufferBitmap = CreateCompatibleBitmap(hdc, width, slotCount * CONTACT_ITEM_HEIGHT);
+    if (!s_backBufferBitmap)
+    {
+        DeleteDC(s_backBufferDC);
+        s_backBufferDC = nullptr;
+        return false;
+    }
+
+    s_oldBackBufferBitmap = SelectObject(s_backBufferDC, s_backBufferBitmap);
+    s_backBufferWidth = width;
+    s_backBufferSlots = slotCount;
+    s_rowTracker.Resize(slotCount);
+    return true;
+}
+
+static void DrawCachedContactRow(HDC hdc, const RECT& rowRect, const ContactView& contact, bool isSelected)
+{
+    int width = rowRect.right - rowRect.left;
+    int height = rowRect.bottom - rowRect.top;
+
+    if (!s_rowDC)
+        s_rowDC = CreateCompatibleDC(hdc);
+
+    uint64_t key = HashContactRow(contact.name, contact.status, contact.lastMessage, isSelected, contact.isOnline, width, height);
+    HBITMAP rowBitmap = (HBITMAP)s_rowCache.Find(key);
+    if (!rowBitmap)
+    {
+        rowBitmap = s_rowDC ? CreateCompatibleBitmap(hdc, width, height) : nullptr;
+        if (!rowBitmap)
+        {
+            // Out of GDI resources: draw straight into the target instead
+            DrawContactItem(hdc, rowRect, contact, isSelected);
+            return;
+        }
+
+        HGDIOBJ oldBitmap = SelectObject(s_rowDC, rowBitmap);
+        RECT localRect = { 0, 0, width, height };
+        DrawContactItem(s_rowDC, localRect, contact, isSelected);
+        SelectObject(s_rowDC, oldBitmap);
+
+        s_rowCache.Insert(key, rowBitmap, (size_t)width * height * 4);
+    }
+
+    HGDIOBJ oldBitmap = SelectObject(s_rowDC, rowBitmap);
+    BitBlt(hdc, rowRect.left, rowRect.top, width, height, s_rowDC, 0, 0, SRCCOPY);
+    SelectObject(s_rowDC, oldBitmap);
+}
+
+void PaintContactList(HWND hWnd)
+{
+    PAINTSTRUCT ps;
+    HDC hdc = BeginPaint(hWnd, &ps);
+
+    RECT clientRect;
+    GetClientRect(hWnd, &clientRect);
+    int slotCount = (clientRect.bottom / CONTACT_ITEM_HEIGHT) + 1;
+
+    if (clientRect.right <= 0 || !EnsureBackBuffer(hdc, clientRect.right, slotCount))
+    {
+        FillRect(hdc, &ps.rcPaint, hBrushSurface);
+        EndPaint(hWnd, &ps);
+        return;
+    }
+
+    // Rows that are still on screen after a scroll are moved, not redrawn
+    int topIndex = (int)::SendMessage(hWnd, LB_GETTOPINDEX, 0, 0);
+    int shift = s_rowTracker.Scroll(topIndex);
+    if (shift != 0)
+    {
+        ScrollDC(s_backBufferDC, 0, -shift * CONTACT_ITEM_HEIGHT, NULL, NULL, NULL, NULL);
+    }
+
+    // Paint from one consistent snapshot; writers may publish a new one meanwhile
+    std::shared_ptr<const ContactSnapshot> snapshot = AcquireContactSnapshot();
+    int itemCount = (int)snapshot->Size();
+    int selectedIndex = (int)::SendMessage(hWnd, LB_GETCURSEL, 0, 0);
+
+    for (int slot = 0; slot < slotCount; slot++)
+    {
+        RECT rowRect = { 0, slot * CONTACT_ITEM_HEIGHT, clientRect.right, (slot + 1) * CONTACT_ITEM_HEIGHT };
+
+        // Rows outside the update region stay dirty until they are actually shown,
+        // so the back buffer never gets ahead of the screen
+        RECT dirtyRect;
+        if (!IntersectRect(&dirtyRect, &rowRect, &ps.rcPaint)) continue;
+
+        int itemIndex = topIndex + slot;
+        if (itemIndex >= itemCount)
+        {
+            if (s_rowTracker.NeedsRepaint(slot, DirtyRowTracker::NO_ITEM, 0, false))
+            {
+                FillRect(s_backBufferDC, &rowRect, hBrushSurface);
+                s_rowTracker.MarkPainted(slot, DirtyRowTracker::NO_ITEM, 0, false);
+            }
+            continue;
+        }
+
+        const ContactView& contact = snapshot->At(itemIndex);
+        bool isSelected = itemIndex == selectedIndex;
+        if (s_rowTracker.NeedsRepaint(slot, itemIndex, contact.revision, isSelected))
+        {
+            DrawCachedContactRow(s_backBufferDC, rowRect, contact, isSelected);
+            s_rowTracker.MarkPainted(slot, itemIndex, contact.revision, isSelected);
+        }
+    }
+
+    BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top,
+        ps.rcPaint.right - ps.rcPaint.left, ps.rcPaint.bottom - ps.rcPaint.top,
+        s_backBufferDC, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
+
+    EndPaint(hWnd, &ps);
+}
+
+void InvalidateContactRow(int contactIndex)
+{
+    if (!hContactsList || contactIndex < 0) return;
+
+    RECT clientRect;
+    GetClientRect(hContactsList, &clientRect);
+    int topIndex = (int)::SendMessage(hContactsList, LB_GETTOPINDEX, 0, 0);
+    int visibleCount = (clientRect.bottom / CONTACT_ITEM_HEIGHT) + 1;
+
+    int row = contactIndex - topIndex;
+    if (row < 0 || row >= visibleCount) return;
+
+    s_rowTracker.Invalidate(contactIndex);
+
+    RECT rowRect = { 0, row * CONTACT_ITEM_HEIGHT, clientRect.right, (row + 1) * CONTACT_ITEM_HEIGHT };
+    InvalidateRect(hContactsList, &rowRect, FALSE);
+}
+
+void ReleaseContactListView()
+{
+    ReleaseBackBuffer();
+    s_rowCache.Clear();
+    if (s_rowDC)
+    {
+        DeleteDC(s_rowDC);
+        s_rowDC = nullptr;
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <windows.h>
+
+// Retained, double-buffered painting for the contacts list.
+//
+// Rows are rendered into a back buffer that outlives WM_PAINT; a paint only
+// re-renders rows whose contact revision, selection or position changed and
+// then copies the update region to the screen.
+void PaintContactList(HWND hWnd);
+
+// Repaint the row for one contact if it is on screen
+void InvalidateContactRow(int contactIndex);
+
+// Throw away the back buffer and cached rows when the list is destroyed
+void ReleaseContactListView();
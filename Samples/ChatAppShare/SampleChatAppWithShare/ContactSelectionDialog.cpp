@@ -7,6 +7,7 @@
 ContactSelectionDialog::SelectionResult ContactSelectionDialog::s_dialogResult;
 std::wstring ContactSelectionDialog::s_currentFilePath;
 std::wstring ContactSelectionDialog::s_currentFileName;
+std::shared_ptr<const ContactSnapshot> ContactSelectionDialog::s_contactSnapshot;
 
 ContactSelectionDialog::SelectionResult ContactSelectionDialog::ShowContactSelectionDialog(HWND hParent, const std::wstring& filePath, const std::wstring& fileName)
 {
@@ -20,6 +21,9 @@ ContactSelectionDialog::SelectionResult ContactSelectionDialog::ShowContactSelec
     // Show the modal dialog
     INT_PTR result = DialogBox(GetModuleHandle(NULL), MAKEINTRESOURCE(IDD_CONTACT_SELECTION), hParent, ContactSelectionDlgProc);
     
+    // Let go of the snapshot so the old version can be reclaimed
+    s_contactSnapshot.reset();
+    
     if (result == IDOK)
     {
         s_dialogResult.wasSelected = true;
@@ -139,13 +143,17 @@ void ContactSelectionDialog::PopulateContactList(HWND hListBox)
         InitializeContacts();
     }
     
+    // Read from a snapshot so a concurrent share or incoming message cannot reshuffle the list under us
+    s_contactSnapshot = AcquireContactSnapshot();
+    const ContactSnapshot& snapshot = *s_contactSnapshot;
+    
     // Debug logging
-    OutputDebugStringW((L"ContactSelectionDialog: Populating list with " + std::to_wstring(contacts.size()) + L" contacts\n").c_str());
+    OutputDebugStringW((L"ContactSelectionDialog: Populating list with " + std::to_wstring(snapshot.Size()) + L" contacts\n").c_str());
     
     // Add all contacts to the list
-    for (size_t i = 0; i < contacts.size(); ++i)
+    for (size_t i = 0; i < snapshot.Size(); ++i)
     {
-        const Contact& contact = contacts[i];
+        const ContactView& contact = snapshot.At(i);
         
         // Create display text with contact name and status
         std::wstring displayText = contact.name + L" - " + contact.status;
@@ -164,14 +172,14 @@ void ContactSelectionDialog::PopulateContactList(HWND hListBox)
     }
     
     // If no contacts were added, add a placeholder
-    if (contacts.empty())
+    if (snapshot.Size() == 0)
     {
         SendMessage(hListBox, LB_ADDSTRING, 0, (LPARAM)L"No contacts available");
         OutputDebugStringW(L"ContactSelectionDialog: No contacts available - added placeholder\n");
     }
     else
     {
-        OutputDebugStringW((L"ContactSelectionDialog: Successfully populated " + std::to_wstring(contacts.size()) + L" contacts\n").c_str());
+        OutputDebugStringW((L"ContactSelectionDialog: Successfully populated " + std::to_wstring(snapshot.Size()) + L" contacts\n").c_str());
     }
 }
 
@@ -186,10 +194,10 @@ void ContactSelectionDialog::HandleContactSelection(HWND hDlg, int selectedIndex
         HWND hListBox = GetDlgItem(hDlg, IDC_CONTACT_SELECTION_LIST);
         int contactIndex = (int)SendMessage(hListBox, LB_GETITEMDATA, selectedIndex, 0);
         
-        if (contactIndex >= 0 && contactIndex < (int)contacts.size())
+        if (s_contactSnapshot && s_contactSnapshot->IsValidIndex(contactIndex))
         {
             // Update the share message with the selected contact's name
-            const Contact& contact = contacts[contactIndex];
+            const ContactView& contact = s_contactSnapshot->At(contactIndex);
             std::wstring personalizedMessage = L"Hey " + contact.name + L"! I'm sharing \"" + s_currentFileName + L"\" with you.";
             
             HWND hMessageEdit = GetDlgItem(hDlg, IDC_SHARE_MESSAGE_EDIT);
@@ -218,7 +226,7 @@ void ContactSelectionDialog::OnSelectContact(HWND hDlg)
     }
     
     // Check if contacts are available
-    if (contacts.empty())
+    if (!s_contactSnapshot || s_contactSnapshot->Size() == 0)
     {
         MessageBox(hDlg, L"No contacts are available. Please ensure the application is properly initialized.", L"No Contacts Available", MB_OK | MB_ICONWARNING);
         return;
@@ -228,9 +236,9 @@ void ContactSelectionDialog::OnSelectContact(HWND hDlg)
     int contactIndex = (int)SendMessage(hListBox, LB_GETITEMDATA, selectedIndex, 0);
     
     // Debug logging
-    OutputDebugStringW((L"ContactSelectionDialog: Selected contact index: " + std::to_wstring(contactIndex) + L", total contacts: " + std::to_wstring(contacts.size()) + L"\n").c_str());
+    OutputDebugStringW((L"ContactSelectionDialog: Selected contact index: " + std::to_wstring(contactIndex) + L", total contacts: " + std::to_wstring(s_contactSnapshot->Size()) + L"\n").c_str());
     
-    if (contactIndex >= 0 && contactIndex < (int)contacts.size())
+    if (s_contactSnapshot->IsValidIndex(contactIndex))
     {
         // Get the share message
         HWND hMessageEdit = GetDlgItem(hDlg, IDC_SHARE_MESSAGE_EDIT);
@@ -245,7 +253,7 @@ void ContactSelectionDialog::OnSelectContact(HWND hDlg)
         s_dialogResult.shareMessage = messageBuffer;
         
         // Debug logging
-        OutputDebugStringW((L"ContactSelectionDialog: Contact selected - " + contacts[contactIndex].name + L"\n").c_str());
+        OutputDebugStringW((L"ContactSelectionDialog: Contact selected - " + s_contactSnapshot->At(contactIndex).name + L"\n").c_str());
         
         // Close dialog with success
         EndDialog(hDlg, IDOK);
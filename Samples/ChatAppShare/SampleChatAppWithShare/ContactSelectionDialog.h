@@ -42,4 +42,7 @@ private:
     static SelectionResult s_dialogResult;
     static std::wstring s_currentFilePath;
     static std::wstring s_currentFileName;
+    
+    // Contacts as they were when the dialog opened, held for the dialog's lifetime
+    static std::shared_ptr<const ContactSnapshot> s_contactSnapshot;
 };
\ No newline at end of file
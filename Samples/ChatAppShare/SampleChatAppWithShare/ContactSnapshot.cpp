@@ -0,0 +1,24 @@
+#include "ContactSnapshot.h"
+#include <atomic>
+
+ContactSnapshotStore::ContactSnapshotStore()
+    : m_current(std::make_shared<ContactSnapshot>(ContactSnapshot{ 0, {} }))
+{
+}
+
+std::shared_ptr<const ContactSnapshot> ContactSnapshotStore::Acquire() const
+{
+    return std::atomic_load_explicit(&m_current, std::memory_order_acquire);
+}
+
+void ContactSnapshotStore::Publish(std::vector<std::shared_ptr<const ContactView>> views)
+{
+    // Only the writer stores, so reading the current version here cannot race another publish
+    uint64_t nextVersion = std::atomic_load_explicit(&m_current, std::memory_order_relaxed)->version + 1;
+
+    auto next = std::make_shared<ContactSnapshot>();
+    next->version = nextVersion;
+    next->contacts = std::move(views);
+
+    std::atomic_store_explicit(&m_current, std::shared_ptr<const ContactSnapshot>(std::move(next)), std::memory_order_release);
+}
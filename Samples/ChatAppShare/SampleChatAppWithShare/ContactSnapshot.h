@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Immutable copy of the parts of a contact that readers display
+struct ContactView
+{
+    std::wstring name;
+    std::wstring status;
+    std::wstring lastMessage;
+    bool isOnline;
+    uint64_t revision;      // Contact::revision this view was built from
+};
+
+// One consistent version of the whole contact list. Views that did not change
+// between versions are the same shared objects in both snapshots.
+struct ContactSnapshot
+{
+    uint64_t version;
+    std::vector<std::shared_ptr<const ContactView>> contacts;
+
+    size_t Size() const { return contacts.size(); }
+    bool IsValidIndex(int index) const { return index >= 0 && index < (int)contacts.size(); }
+    const ContactView& At(size_t index) const { return *contacts[index]; }
+};
+
+// Publishes contact snapshots RCU-style.
+//
+// Readers call Acquire() and keep the returned pointer for as long as they need a
+// stable view (a paint pass, a dialog, a search) without taking any lock. The single
+// writer builds the next version off to the side and swaps it in with Publish().
+// An old version is reclaimed when the last reader holding it lets go.
+class ContactSnapshotStore
+{
+public:
+    ContactSnapshotStore();
+
+    std::shared_ptr<const ContactSnapshot> Acquire() const;
+
+    // Writer only. 'views' becomes the next version.
+    void Publish(std::vector<std::shared_ptr<const ContactView>> views);
+
+private:
+    std::shared_ptr<const ContactSnapshot> m_current;
+};
@@ -0,0 +1,149 @@
+#include "ContentHash.h"
+#include <cstring>
+
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ull;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t RotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Unaligned little-endian loads; every target this app builds for is little-endian
+static inline uint64_t Read64(const uint8_t* p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t Read32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint64_t Round(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * PRIME64_2;
+    accumulator = RotateLeft(accumulator, 31);
+    return accumulator * PRIME64_1;
+}
+
+static inline uint64_t MergeRound(uint64_t accumulator, uint64_t value)
+{
+    accumulator ^= Round(0, value);
+    return accumulator * PRIME64_1 + PRIME64_4;
+}
+
+static uint64_t Finalize(uint64_t hash, const uint8_t* p, size_t length)
+{
+    while (length >= 8)
+    {
+        hash ^= Round(0, Read64(p));
+        hash = RotateLeft(hash, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+        length -= 8;
+    }
+    if (length >= 4)
+    {
+        hash ^= (uint64_t)Read32(p) * PRIME64_1;
+        hash = RotateLeft(hash, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+        length -= 4;
+    }
+    while (length > 0)
+    {
+        hash ^= (*p) * PRIME64_5;
+        hash = RotateLeft(hash, 11) * PRIME64_1;
+        p++;
+        length--;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+static uint64_t MergeLanes(const uint64_t v[4])
+{
+    uint64_t hash = RotateLeft(v[0], 1) + RotateLeft(v[1], 7) + RotateLeft(v[2], 12) + RotateLeft(v[3], 18);
+    hash = MergeRound(hash, v[0]);
+    hash = MergeRound(hash, v[1]);
+    hash = MergeRound(hash, v[2]);
+    return MergeRound(hash, v[3]);
+}
+
+uint64_t ContentHash64(const void* data, size_t length, uint64_t seed)
+{
+    ContentHasher hasher(seed);
+    hasher.Update(data, length);
+    return hasher.Digest();
+}
+
+ContentHasher::ContentHasher(uint64_t seed)
+    : m_totalLength(0), m_seed(seed), m_bufferSize(0)
+{
+    m_v[0] = seed + PRIME64_1 + PRIME64_2;
+    m_v[1] = seed + PRIME64_2;
+    m_v[2] = seed;
+    m_v[3] = seed - PRIME64_1;
+}
+
+void ContentHasher::Update(const void* data, size_t length)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    m_totalLength += length;
+
+    // Top up a partial stripe from the previous call first
+    if (m_bufferSize > 0)
+    {
+        size_t take = sizeof(m_buffer) - m_bufferSize;
+        if (take > length)
+            take = length;
+        memcpy(m_buffer + m_bufferSize, p, take);
+        m_bufferSize += take;
+        p += take;
+        length -= take;
+
+        if (m_bufferSize < sizeof(m_buffer))
+            return;
+
+        for (int lane = 0; lane < 4; lane++)
+        {
+            m_v[lane] = Round(m_v[lane], Read64(m_buffer + lane * 8));
+        }
+        m_bufferSize = 0;
+    }
+
+    // Four independent lanes over 32-byte stripes
+    while (length >= 32)
+    {
+        m_v[0] = Round(m_v[0], Read64(p));
+        m_v[1] = Round(m_v[1], Read64(p + 8));
+        m_v[2] = Round(m_v[2], Read64(p + 16));
+        m_v[3] = Round(m_v[3], Read64(p + 24));
+        p += 32;
+        length -= 32;
+    }
+
+    if (length > 0)
+    {
+        memcpy(m_buffer, p, length);
+        m_bufferSize = length;
+    }
+}
+
+uint64_t ContentHasher::Digest() const
+{
+    uint64_t hash = m_totalLength >= 32 ? MergeLanes(m_v) : m_seed + PRIME64_5;
+    hash += m_totalLength;
+    return Finalize(hash, m_buffer, m_bufferSize);
+}
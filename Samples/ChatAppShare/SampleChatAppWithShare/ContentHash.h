@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit non-cryptographic content hash (XXH64 algorithm).
+// Fast enough to run over every byte of a shared file; not meant to resist
+// deliberate collisions.
+uint64_t ContentHash64(const void* data, size_t length, uint64_t seed = 0);
+
+// Incremental form for data that arrives in pieces. Produces the same value as
+// ContentHash64 over the concatenated input.
+class ContentHasher
+{
+public:
+    explicit ContentHasher(uint64_t seed = 0);
+
+    void Update(const void* data, size_t length);
+    uint64_t Digest() const;
+
+private:
+    uint64_t m_totalLength;
+    uint64_t m_seed;
+    uint64_t m_v[4];
+    uint8_t m_buffer[32];
+    size_t m_bufferSize;
+};
@@ -0,0 +1,76 @@
+#include "DirtyRowTracker.h"
+#include <algorithm>
+
+void DirtyRowTracker::Resize(int slotCount)
+{
+    m_slots.assign(slotCount > 0 ? slotCount : 0, EmptySlot());
+}
+
+int DirtyRowTracker::Scroll(int topIndex)
+{
+    int shift = topIndex - m_topIndex;
+    m_topIndex = topIndex;
+    if (shift == 0)
+        return 0;
+
+    int count = (int)m_slots.size();
+    if (shift >= count || -shift >= count)
+    {
+        InvalidateAll();
+        return 0;
+    }
+
+    if (shift > 0)
+    {
+        // Content moves up: slot i now shows what slot i + shift showed
+        std::move(m_slots.begin() + shift, m_slots.end(), m_slots.begin());
+        std::fill(m_slots.end() - shift, m_slots.end(), EmptySlot());
+    }
+    else
+    {
+        std::move_backward(m_slots.begin(), m_slots.end() + shift, m_slots.end());
+        std::fill(m_slots.begin(), m_slots.begin() - shift, EmptySlot());
+    }
+    return shift;
+}
+
+void DirtyRowTracker::Invalidate(int itemIndex)
+{
+    int slot = SlotForItem(itemIndex);
+    if (slot >= 0)
+    {
+        m_slots[slot].isValid = false;
+    }
+}
+
+void DirtyRowTracker::InvalidateAll()
+{
+    std::fill(m_slots.begin(), m_slots.end(), EmptySlot());
+}
+
+bool DirtyRowTracker::NeedsRepaint(int slot, int itemIndex, uint64_t revision, bool isSelected) const
+{
+    if (slot < 0 || slot >= (int)m_slots.size())
+        return false;
+
+    const SlotState& state = m_slots[slot];
+    if (!state.isValid || state.itemIndex != itemIndex)
+        return true;
+    if (itemIndex == NO_ITEM)
+        return false;
+    return state.revision != revision || state.isSelected != isSelected;
+}
+
+void DirtyRowTracker::MarkPainted(int slot, int itemIndex, uint64_t revision, bool isSelected)
+{
+    if (slot < 0 || slot >= (int)m_slots.size())
+        return;
+
+    m_slots[slot] = SlotState{ itemIndex, revision, isSelected, true };
+}
+
+int DirtyRowTracker::SlotForItem(int itemIndex) const
+{
+    int slot = itemIndex - m_topIndex;
+    return (slot >= 0 && slot < (int)m_slots.size()) ? slot : -1;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Decides which rows of a retained, double-buffered list need to be re-rendered.
+//
+// The tracker remembers what each visible slot of the back buffer last showed:
+// which item, at which model revision, and whether it was drawn selected. A row
+// is dirty when any of those differ from what should be shown now, or when it
+// was explicitly invalidated. Scrolling shifts the remembered slots so rows that
+// stay on screen can be moved instead of redrawn.
+class DirtyRowTracker
+{
+public:
+    static const int NO_ITEM = -1;
+
+    // Forget everything and size the buffer for 'slotCount' visible rows
+    void Resize(int slotCount);
+
+    // Scroll so 'topIndex' is in slot 0. Returns how many slots the existing
+    // content moved up (negative: down). The caller moves its back buffer by the
+    // same amount; slots scrolled into view come back dirty. Returns 0 and marks
+    // everything dirty when nothing on screen survives the scroll.
+    int Scroll(int topIndex);
+
+    // Force the row showing 'itemIndex' to be redrawn if it is visible
+    void Invalidate(int itemIndex);
+    void InvalidateAll();
+
+    // True if 'slot' must be redrawn to show 'itemIndex' (NO_ITEM for an empty slot)
+    bool NeedsRepaint(int slot, int itemIndex, uint64_t revision, bool isSelected) const;
+
+    // Record what 'slot' now shows in the back buffer
+    void MarkPainted(int slot, int itemIndex, uint64_t revision, bool isSelected);
+
+    // Slot currently showing 'itemIndex', or -1 when it is scrolled out of view
+    int SlotForItem(int itemIndex) const;
+
+    int TopIndex() const { return m_topIndex; }
+    int SlotCount() const { return (int)m_slots.size(); }
+
+private:
+    struct SlotState
+    {
+        int itemIndex;
+        uint64_t revision;
+        bool isSelected;
+        bool isValid;       // false until painted, or after an invalidation
+    };
+
+    static SlotState EmptySlot() { return SlotState{ NO_ITEM, 0, false, false }; }
+
+    std::vector<SlotState> m_slots;
+    int m_topIndex = 0;
+};
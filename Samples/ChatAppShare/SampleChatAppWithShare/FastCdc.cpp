@@ -0,0 +1,74 @@
+#include "FastCdc.h"
+#include <array>
+
+// Gear table from a fixed splitmix64 sequence so every build cuts identically
+static constexpr std::array<uint64_t, 256> MakeGearTable()
+{
+    std::array<uint64_t, 256> table = {};
+    uint64_t state = 0x5EED5EED5EED5EEDull;
+    for (size_t i = 0; i < table.size(); i++)
+    {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        table[i] = z ^ (z >> 31);
+    }
+    return table;
+}
+
+static constexpr std::array<uint64_t, 256> GEAR = MakeGearTable();
+
+// 'bits' ones in the top of the word; the gear hash shifts left, so the high
+// bits depend on the most recent bytes
+static uint64_t HighMask(int bits)
+{
+    if (bits <= 0)
+        return 0;
+    if (bits >= 64)
+        return ~0ull;
+    return ((1ull << bits) - 1) << (64 - bits);
+}
+
+FastCdcChunker::FastCdcChunker(size_t minSize, size_t averageSize, size_t maxSize)
+{
+    int bits = 0;
+    while (((size_t)2 << bits) <= averageSize)
+    {
+        bits++;
+    }
+
+    m_averageSize = (size_t)1 << bits;
+    m_minSize = minSize < m_averageSize ? minSize : m_averageSize / 2;
+    m_maxSize = maxSize > m_averageSize ? maxSize : m_averageSize * 2;
+
+    // Normalization level 2
+    m_maskSmall = HighMask(bits + 2);
+    m_maskLarge = HighMask(bits - 2);
+}
+
+size_t FastCdcChunker::NextCut(const uint8_t* data, size_t length) const
+{
+    if (length <= m_minSize)
+        return length;
+    if (length > m_maxSize)
+        length = m_maxSize;
+
+    size_t normalSize = length < m_averageSize ? length : m_averageSize;
+    uint64_t hash = 0;
+    size_t i = m_minSize;
+
+    for (; i < normalSize; i++)
+    {
+        hash = (hash << 1) + GEAR[data[i]];
+        if ((hash & m_maskSmall) == 0)
+            return i + 1;
+    }
+    for (; i < length; i++)
+    {
+        hash = (hash << 1) + GEAR[data[i]];
+        if ((hash & m_maskLarge) == 0)
+            return i + 1;
+    }
+    return length;
+}
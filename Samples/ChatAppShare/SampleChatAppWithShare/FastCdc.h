@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Content-defined chunking (FastCDC with normalized chunking).
+//
+// Cut points depend only on nearby bytes, so inserting or deleting data in one
+// part of a file leaves the chunks elsewhere unchanged and they deduplicate
+// against earlier versions. The gear table is fixed: changing it, or the sizes
+// of an existing store, changes every chunk boundary.
+class FastCdcChunker
+{
+public:
+    static const size_t DEFAULT_MIN_SIZE = 2 * 1024;
+    static const size_t DEFAULT_AVERAGE_SIZE = 8 * 1024;
+    static const size_t DEFAULT_MAX_SIZE = 64 * 1024;
+
+    // averageSize is rounded down to a power of two
+    FastCdcChunker(size_t minSize = DEFAULT_MIN_SIZE, size_t averageSize = DEFAULT_AVERAGE_SIZE, size_t maxSize = DEFAULT_MAX_SIZE);
+
+    // Length of the next chunk at the start of 'data'. Pass at least MaxSize()
+    // bytes unless 'data' is the end of the input; otherwise the cut may land
+    // where a later call with more data would not have put it.
+    size_t NextCut(const uint8_t* data, size_t length) const;
+
+    size_t MinSize() const { return m_minSize; }
+    size_t AverageSize() const { return m_averageSize; }
+    size_t MaxSize() const { return m_maxSize; }
+
+private:
+    size_t m_minSize;
+    size_t m_averageSize;
+    size_t m_maxSize;
+    uint64_t m_maskSmall;   // more bits: harder to cut before the average size
+    uint64_t m_maskLarge;   // fewer bits: easier to cut after it
+};
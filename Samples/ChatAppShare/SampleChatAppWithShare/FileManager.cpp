@@ -2,15 +2,38 @@
 #include "ChatModels.h"
 #include "ChatManager.h"
 #include "UIManager.h"
+#include "ContactListView.h"
+#include "ModernUI.h"
+#include "UIConstants.h"
+#include "ChunkStore.h"
+#include "FileMetadata.h"
+#include "WorkerPool.h"
 #include <commdlg.h>
+#include <shobjidl.h>
+#include <wincodec.h>
 #include <algorithm>
+#include <deque>
+#include <fstream>
+#include <thread>
 
 #pragma comment(lib, "comdlg32.lib")
+#pragma comment(lib, "windowscodecs.lib")
 
 // External declarations for UI window handles
 extern HWND hSharedFilesList;
 extern HWND hContactsList;
 
+// Top-level window that owns the share dialogs
+static HWND GetMainWindow()
+{
+    HWND hMainWindow = GetParent(hSharedFilesList);
+    while (GetParent(hMainWindow))
+    {
+        hMainWindow = GetParent(hMainWindow);
+    }
+    return hMainWindow;
+}
+
 void ShareFile()
 {
     // Check if a contact is selected first
@@ -19,111 +42,187 @@ void ShareFile()
         return;
     }
     
-    // Get the main window handle (parent of the share file button)
-    HWND hMainWindow = GetParent(hSharedFilesList);
-    while (GetParent(hMainWindow))
-    {
-        hMainWindow = GetParent(hMainWindow);
-    }
+    HWND hMainWindow = GetMainWindow();
     
     OPENFILENAME ofn;
-    WCHAR szFile[260] = {0};
+    // With several files selected the dialog returns the folder, then each name, all NUL-separated
+    std::vector<WCHAR> fileBuffer(SHARE_DIALOG_BUFFER_CHARS, 0);
     
     ZeroMemory(&ofn, sizeof(ofn));
     ofn.lStructSize = sizeof(ofn);
     ofn.hwndOwner = hMainWindow;  // Set the main window as owner
-    ofn.lpstrFile = szFile;
-    ofn.nMaxFile = sizeof(szFile);
+    ofn.lpstrFile = fileBuffer.data();
+    ofn.nMaxFile = (DWORD)fileBuffer.size();
     ofn.lpstrFilter = L"All Files\0*.*\0?? Text Files\0*.TXT\0?? Document Files\0*.DOC;*.DOCX\0??? Image Files\0*.BMP;*.JPG;*.PNG;*.GIF\0?? PDF Files\0*.PDF\0?? Excel Files\0*.XLS;*.XLSX\0";
     ofn.nFilterIndex = 1;
     ofn.lpstrFileTitle = NULL;
     ofn.nMaxFileTitle = 0;
     ofn.lpstrInitialDir = NULL;
-    ofn.lpstrTitle = L"Select File to Share";
-    ofn.Flags = OFN_PATHMUSTEXIST | OFN_FILEMUSTEXIST | OFN_EXPLORER;
+    ofn.lpstrTitle = L"Select Files to Share";
+    ofn.Flags = OFN_PATHMUSTEXIST | OFN_FILEMUSTEXIST | OFN_EXPLORER | OFN_ALLOWMULTISELECT;
+    
+    if (!GetOpenFileName(&ofn))
+    {
+        if (CommDlgExtendedError() == FNERR_BUFFERTOOSMALL) {
+            MessageBox(hMainWindow, L"Too many files were selected at once. Try sharing their folder instead.", L"Share Files", MB_OK | MB_ICONWARNING);
+        }
+        return;
+    }
     
-    if (GetOpenFileName(&ofn))
+    std::vector<std::wstring> paths;
+    const WCHAR* first = fileBuffer.data();
+    const WCHAR* name = first + wcslen(first) + 1;
+    if (*name == L'\0')
+    {
+        // A single file comes back as one full path
+        paths.push_back(first);
+    }
+    else
     {
-        // Extract file name from full path
-        std::wstring fullPath(szFile);
-        size_t lastSlash = fullPath.find_last_of(L"\\");
-        std::wstring fileName;
-        if (lastSlash != std::wstring::npos)
+        std::wstring directory(first);
+        if (directory.back() != L'\\') directory += L'\\';
+        for (; *name != L'\0'; name += wcslen(name) + 1)
         {
-            fileName = fullPath.substr(lastSlash + 1);
+            paths.push_back(directory + name);
         }
-        else
+    }
+    
+    ShareFiles(paths, false);
+}
+
+void ShareFolder()
+{
+    if (selectedContactIndex < 0) {
+        MessageBox(NULL, L"Please select a contact to share files with.", L"No Contact Selected", MB_OK | MB_ICONWARNING);
+        return;
+    }
+    
+    winrt::com_ptr<IFileOpenDialog> dialog;
+    if (FAILED(CoCreateInstance(CLSID_FileOpenDialog, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(dialog.put())))) return;
+    
+    FILEOPENDIALOGOPTIONS options = 0;
+    dialog->GetOptions(&options);
+    dialog->SetOptions(options | FOS_PICKFOLDERS | FOS_FORCEFILESYSTEM | FOS_ALLOWMULTISELECT);
+    dialog->SetTitle(L"Select Folders to Share");
+    if (FAILED(dialog->Show(GetMainWindow()))) return;    // also when cancelled
+    
+    winrt::com_ptr<IShellItemArray> results;
+    DWORD count = 0;
+    if (FAILED(dialog->GetResults(results.put())) || FAILED(results->GetCount(&count))) return;
+    
+    std::vector<std::wstring> paths;
+    for (DWORD i = 0; i < count; i++)
+    {
+        winrt::com_ptr<IShellItem> item;
+        PWSTR path = nullptr;
+        if (SUCCEEDED(results->GetItemAt(i, item.put())) && SUCCEEDED(item->GetDisplayName(SIGDN_FILESYSPATH, &path)))
         {
-            fileName = fullPath;
+            paths.push_back(path);
+            CoTaskMemFree(path);
         }
-        
-        // Create shared file entry
-        SharedFile newFile;
-        newFile.fileName = fileName;
-        newFile.filePath = fullPath;
-        newFile.sharedBy = L"You";
-        GetSystemTime(&newFile.timeShared);
-        
-        // Add file to the currently selected contact's shared files
-        if (selectedContactIndex >= 0 && selectedContactIndex < (int)contacts.size())
+    }
+    
+    ShareFiles(paths, true);
+}
+
+size_t ShareFiles(const std::vector<std::wstring>& paths, bool expandDirectories)
+{
+    if (!IsValidContactIndex(selectedContactIndex) || paths.empty()) return 0;
+    
+    // Every file in one batch carries the same time, so they keep their order
+    uint64_t timeShared = CurrentSharedFileTime();
+    std::vector<SharedFile> files;
+    bool truncated = false;
+    
+    auto addPath = [&](const std::filesystem::path& path) {
+        if (files.size() >= SHARE_BATCH_MAX_FILES) {
+            truncated = true;
+            return;
+        }
+        SharedFile file;
+        file.fileName = path.filename().wstring();
+        file.filePath = path.wstring();
+        file.sharedBy = L"You";
+        file.timeShared = timeShared;
+        file.contentHash = 0;
+        files.push_back(std::move(file));
+    };
+    
+    for (const auto& entry : paths)
+    {
+        std::filesystem::path path(entry);
+        std::error_code error;
+        if (expandDirectories && std::filesystem::is_directory(path, error))
         {
-            contacts[selectedContactIndex].sharedFiles.push_back(newFile);
-            
-            // Add file sharing notification to chat
-            std::wstring fileShareMsg = L"?? Shared file: " + fileName;
-            AddMessageToChat(fileShareMsg, true);
-            
-            // Update UI
-            AddSharedFileToChat(newFile, true);
-            
-            // Update contacts list display to show the shared activity
-            InvalidateRect(hContactsList, NULL, TRUE);
-            
-            // Show success message with current contact
-            std::wstring successMsg = L"File \"" + fileName + L"\" has been shared with " + contacts[selectedContactIndex].name + L"!";
-            MessageBox(hMainWindow, successMsg.c_str(), L"File Shared Successfully", MB_OK | MB_ICONINFORMATION);
-            
-            // Simulate auto-reply from contact acknowledging the file
-            SetTimer(hMainWindow, 2, 2000, NULL);
+            auto options = std::filesystem::directory_options::skip_permission_denied;
+            for (std::filesystem::recursive_directory_iterator it(path, options, error), end; !error && it != end && !truncated; it.increment(error))
+            {
+                if (it->is_regular_file(error)) addPath(it->path());
+            }
         }
+        else
+        {
+            addPath(path);
+        }
+    }
+    
+    size_t added = AddSharedFilesToChat(files, true);
+    if (added > 0) {
+        // Simulate auto-reply from contact acknowledging the files
+        ScheduleAutoReply(selectedContactIndex, AUTO_REPLY_FILE);
+    }
+    
+    if (truncated) {
+        std::wstring message = L"Only the first " + std::to_wstring(SHARE_BATCH_MAX_FILES) + L" files were shared.";
+        MessageBox(GetMainWindow(), message.c_str(), L"Share Files", MB_OK | MB_ICONINFORMATION);
     }
+    return added;
 }
 
-void AddSharedFileToChat(const SharedFile& file, bool isOutgoing)
+size_t AddSharedFilesToChat(const std::vector<SharedFile>& files, bool isOutgoing)
 {
     Contact* contact = GetSelectedContact();
-    if (!contact) return;
+    if (!contact) return 0;
     
-    std::wstring sharer = isOutgoing ? L"You" : contact->name;
-    
-    // Format file sharing message with timestamp
-    SYSTEMTIME st;
-    GetLocalTime(&st);
-    WCHAR timeStr[50];
-    swprintf_s(timeStr, 50, L"[%02d:%02d] ", st.wHour, st.wMinute);
+    // Record the whole batch first; sharing the same file again is not news
+    size_t added = 0;
+    const SharedFile* firstAdded = nullptr;
+    for (const auto& file : files)
+    {
+        if (!contact->sharedFiles.Add(file)) continue;
+        
+        ProcessSharedFileAsync(selectedContactIndex, file.filePath);
+        if (!firstAdded) firstAdded = &file;
+        added++;
+    }
+    if (added == 0) return 0;
     
-    std::wstring shareMessage = sharer + L" shared: " + file.fileName + L" ??";
-    contact->messages.push_back(shareMessage);
+    // One notice for the batch rather than one per file
+    std::wstring notice = added == 1 ? firstAdded->fileName : std::to_wstring(added) + L" files";
+    uint32_t sharerId = isOutgoing ? SENDER_SELF : contact->senderId;
+    uint32_t flags = MESSAGE_FLAG_SHARE_NOTICE | (isOutgoing ? MESSAGE_FLAG_OUTGOING : MESSAGE_FLAG_NONE);
+    contact->messages.push_back(MakeChatMessage(sharerId, notice + L" ??", flags));
     
     // Update last message preview
-    contact->lastMessage = L"?? " + file.fileName;
+    contact->lastMessage = L"?? " + notice;
+    MarkContactChanged(selectedContactIndex);
+    PublishContactSnapshot();
     
-    // Add to shared files list
-    contact->sharedFiles.push_back(file);
-    
-    // Refresh UI
+    // Refresh UI once for the whole batch
     LoadContactChat(selectedContactIndex);
     UpdateSharedFilesList();
+    InvalidateContactRow(selectedContactIndex);
+    return added;
 }
 
 void OpenSharedFile(int fileIndex)
 {
     Contact* contact = GetSelectedContact();
-    if (!contact || fileIndex < 0 || fileIndex >= (int)contact->sharedFiles.size()) {
+    if (!contact || fileIndex < 0 || fileIndex >= (int)contact->sharedFiles.Size()) {
         return;
     }
     
-    const SharedFile& file = contact->sharedFiles[fileIndex];
+    const SharedFile& file = contact->sharedFiles.At(fileIndex);
     
     // Try to open the file with the default application
     HINSTANCE result = ShellExecute(NULL, L"open", file.filePath.c_str(), NULL, NULL, SW_SHOWNORMAL);
@@ -135,20 +234,269 @@ void OpenSharedFile(int fileIndex)
     }
 }
 
+// Shared files are kept under %LOCALAPPDATA%, falling back to the temp directory
+static ChunkStore& SharedFileStore()
+{
+    static ChunkStore* store = nullptr;
+    if (!store) {
+        WCHAR base[MAX_PATH] = {};
+        DWORD length = GetEnvironmentVariable(L"LOCALAPPDATA", base, MAX_PATH);
+        if (length == 0 || length >= MAX_PATH) {
+            GetTempPath(MAX_PATH, base);
+        }
+        store = new ChunkStore(std::filesystem::path(base) / L"SampleChatAppWithShare" / L"SharedFiles");
+    }
+    return *store;
+}
+
+// Metadata work runs here; the UI thread only queues paths and applies results
+static WorkerPool* s_fileWorkers = nullptr;
+static FileMetadataCache s_metadataCache;
+
+static WorkerPool& FileWorkers()
+{
+    if (!s_fileWorkers) {
+        // Leave a core for the UI; hashing and decoding are CPU and disk bound
+        unsigned int cores = std::thread::hardware_concurrency();
+        size_t threadCount = cores > 2 ? cores - 1 : 2;
+        s_fileWorkers = new WorkerPool(threadCount, FILE_PIPELINE_QUEUE_CAPACITY);
+        
+        // Create the store up front so workers never race to construct it
+        SharedFileStore();
+    }
+    return *s_fileWorkers;
+}
+
+// Decode with WIC and box-filter down to a thumbnail one band of rows at a time,
+// so a large photo never has to be held in memory at full size
+static bool LoadImageThumbnail(const std::wstring& filePath, FileMetadata& metadata)
+{
+    // Each worker joins the MTA once and stays in it
+    static thread_local bool comReady = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+    if (!comReady) return false;
+    
+    winrt::com_ptr<IWICImagingFactory> factory;
+    winrt::com_ptr<IWICBitmapDecoder> decoder;
+    winrt::com_ptr<IWICBitmapFrameDecode> frame;
+    winrt::com_ptr<IWICFormatConverter> converter;
+    
+    if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(factory.put())))) return false;
+    if (FAILED(factory->CreateDecoderFromFilename(filePath.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, decoder.put()))) return false;
+    if (FAILED(decoder->GetFrame(0, frame.put()))) return false;
+    if (FAILED(factory->CreateFormatConverter(converter.put()))) return false;
+    if (FAILED(converter->Initialize(frame.get(), GUID_WICPixelFormat32bppPBGRA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom))) return false;
+    
+    UINT width = 0;
+    UINT height = 0;
+    if (FAILED(converter->GetSize(&width, &height)) || width == 0 || height == 0) return false;
+    
+    int thumbnailWidth;
+    int thumbnailHeight;
+    FitThumbnailSize((int)width, (int)height, SHARED_FILE_THUMBNAIL_SIZE, thumbnailWidth, thumbnailHeight);
+    
+    std::vector<uint32_t> thumbnail((size_t)thumbnailWidth * thumbnailHeight);
+    std::vector<uint32_t> band;
+    for (int row = 0; row < thumbnailHeight; row++) {
+        INT y0 = (INT)((int64_t)row * height / thumbnailHeight);
+        INT y1 = (INT)((int64_t)(row + 1) * height / thumbnailHeight);
+        if (y1 <= y0) y1 = y0 + 1;
+        
+        WICRect bandRect = { 0, y0, (INT)width, y1 - y0 };
+        band.resize((size_t)width * bandRect.Height);
+        if (FAILED(converter->CopyPixels(&bandRect, width * 4, (UINT)(band.size() * 4), (BYTE*)band.data()))) return false;
+        
+        DownscaleBgra(band.data(), (int)width, bandRect.Height, width, &thumbnail[(size_t)row * thumbnailWidth], thumbnailWidth, 1);
+    }
+    
+    // Premultiplied pixels composited over the white list background
+    for (auto& pixel : thumbnail) {
+        uint32_t cover = 255 - (pixel >> 24);
+        uint32_t b = (pixel & 0xFF) + cover;
+        uint32_t g = ((pixel >> 8) & 0xFF) + cover;
+        uint32_t r = ((pixel >> 16) & 0xFF) + cover;
+        pixel = 0xFF000000 | (std::min(r, 255u) << 16) | (std::min(g, 255u) << 8) | std::min(b, 255u);
+    }
+    
+    metadata.thumbnailWidth = thumbnailWidth;
+    metadata.thumbnailHeight = thumbnailHeight;
+    metadata.thumbnail = std::move(thumbnail);
+    return true;
+}
+
+static std::shared_ptr<const FileMetadata> ExtractFileMetadata(const std::wstring& filePath)
+{
+    std::filesystem::path path(filePath);
+    
+    // An unchanged file that was shared before costs two stat calls
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(path, error);
+    if (error) return nullptr;
+    auto writeTime = std::filesystem::last_write_time(path, error);
+    if (error) return nullptr;
+    
+    std::wstring sourceKey = filePath + L"|" + std::to_wstring(size) + L"|" + std::to_wstring(writeTime.time_since_epoch().count());
+    if (auto cached = s_metadataCache.FindBySource(sourceKey)) {
+        return cached;
+    }
+    
+    ChunkManifest manifest;
+    if (!SharedFileStore().Ingest(path, manifest)) return nullptr;
+    
+    // Same content shared from somewhere else
+    if (auto cached = s_metadataCache.Find(manifest.id)) {
+        s_metadataCache.Insert(cached, sourceKey);
+        return cached;
+    }
+    
+    auto metadata = std::make_shared<FileMetadata>();
+    metadata->size = manifest.fileSize;
+    metadata->contentHash = manifest.id;
+    metadata->thumbnailWidth = 0;
+    metadata->thumbnailHeight = 0;
+    
+    uint8_t header[MIME_SNIFF_LENGTH] = {};
+    std::ifstream input(path, std::ios::binary);
+    input.read((char*)header, sizeof(header));
+    metadata->mimeType = SniffMimeType(header, (size_t)input.gcount());
+    
+    if (IsImageMimeType(metadata->mimeType)) {
+        LoadImageThumbnail(filePath, *metadata);
+    }
+    
+    s_metadataCache.Insert(metadata, sourceKey);
+    return metadata;
+}
+
+// Files the full worker queue could not take yet. Only the UI thread touches it,
+// and it is refilled as finished files come back through the chat event queue.
+struct PendingSharedFile
+{
+    int contactIndex;
+    std::wstring filePath;
+};
+static std::deque<PendingSharedFile> s_fileBacklog;
+
+static bool TrySubmitSharedFile(int contactIndex, const std::wstring& filePath)
+{
+    return FileWorkers().TrySubmit([contactIndex, filePath]() {
+        // Posted even on failure: every finished file frees a queue slot for the backlog
+        ChatEvent event = {};
+        event.type = ChatEventType::FileStored;
+        event.contactIndex = contactIndex;
+        event.text = filePath;
+        event.metadata = ExtractFileMetadata(filePath);
+        PostChatEvent(std::move(event));
+    });
+}
+
+void ProcessSharedFileAsync(int contactIndex, const std::wstring& filePath)
+{
+    if (filePath.empty()) return;
+    
+    // Runs on the UI thread, so never wait for room; queue behind the backlog to keep order
+    if (!s_fileBacklog.empty() || !TrySubmitSharedFile(contactIndex, filePath)) {
+        s_fileBacklog.push_back({ contactIndex, filePath });
+    }
+}
+
+void SubmitSharedFileBacklog()
+{
+    while (!s_fileBacklog.empty()) {
+        const PendingSharedFile& file = s_fileBacklog.front();
+        if (!TrySubmitSharedFile(file.contactIndex, file.filePath)) break;
+        s_fileBacklog.pop_front();
+    }
+}
+
+void ShutdownSharedFilePipeline()
+{
+    if (!s_fileWorkers) return;
+    
+    // Files still waiting are picked up again the next time they are shared
+    s_fileBacklog.clear();
+    s_fileWorkers->CancelPending();
+    s_fileWorkers->Shutdown();
+    delete s_fileWorkers;
+    s_fileWorkers = nullptr;
+}
+
+std::wstring FormatFileSize(uint64_t fileSize)
+{
+    static const wchar_t* units[] = { L"B", L"KB", L"MB", L"GB", L"TB" };
+    
+    double size = (double)fileSize;
+    int unit = 0;
+    while (size >= 1024.0 && unit < 4) {
+        size /= 1024.0;
+        unit++;
+    }
+    
+    WCHAR buffer[32];
+    if (unit == 0) {
+        swprintf_s(buffer, L"%llu %s", (unsigned long long)fileSize, units[unit]);
+    } else {
+        swprintf_s(buffer, L"%.1f %s", size, units[unit]);
+    }
+    return buffer;
+}
+
 void UpdateSharedFilesList()
 {
     if (!hSharedFilesList) return;
     
     Contact* contact = GetSelectedContact();
     
-    // Clear the list
-    SendMessage(hSharedFilesList, LB_RESETCONTENT, 0, 0);
+    // The list is virtual (LBS_NODATA): only the count is handed over and rows are
+    // drawn from the index on demand, so this costs the same for 5 or 50k files
+    size_t count = contact ? contact->sharedFiles.Size() : 0;
+    SendMessage(hSharedFilesList, LB_SETCOUNT, (WPARAM)count, 0);
+    InvalidateRect(hSharedFilesList, NULL, TRUE);
+}
+
+void DrawSharedFileItem(const DRAWITEMSTRUCT* drawItem)
+{
+    if (drawItem->itemID == (UINT)-1) return;
     
-    if (!contact) return;
+    HDC hdc = drawItem->hDC;
+    RECT rect = drawItem->rcItem;
+    bool isSelected = (drawItem->itemState & ODS_SELECTED) != 0;
     
-    // Add shared files to the list
-    for (const auto& file : contact->sharedFiles) {
-        std::wstring displayText = file.fileName + L" (shared by " + file.sharedBy + L")";
-        SendMessage(hSharedFilesList, LB_ADDSTRING, 0, (LPARAM)displayText.c_str());
+    FillRect(hdc, &rect, isSelected ? GetSysColorBrush(COLOR_HIGHLIGHT) : hBrushSurface);
+    
+    Contact* contact = GetSelectedContact();
+    if (!contact || drawItem->itemID >= contact->sharedFiles.Size()) return;
+    
+    const SharedFile& file = contact->sharedFiles.At(drawItem->itemID);
+    std::wstring displayText = file.fileName;
+    if (file.metadata) {
+        displayText += L" - " + FormatFileSize(file.metadata->size);
+    }
+    displayText += L" (shared by " + file.sharedBy + L")";
+    
+    // Thumbnail column, filled in once the metadata pipeline has run
+    int thumbnailLeft = rect.left + 2;
+    if (file.metadata && file.metadata->thumbnailWidth > 0) {
+        const FileMetadata& metadata = *file.metadata;
+        BITMAPINFO info = {};
+        info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        info.bmiHeader.biWidth = metadata.thumbnailWidth;
+        info.bmiHeader.biHeight = -metadata.thumbnailHeight;    // top-down
+        info.bmiHeader.biPlanes = 1;
+        info.bmiHeader.biBitCount = 32;
+        info.bmiHeader.biCompression = BI_RGB;
+        
+        int x = thumbnailLeft + (SHARED_FILE_THUMBNAIL_SIZE - metadata.thumbnailWidth) / 2;
+        int y = rect.top + (rect.bottom - rect.top - metadata.thumbnailHeight) / 2;
+        SetDIBitsToDevice(hdc, x, y, metadata.thumbnailWidth, metadata.thumbnailHeight,
+            0, 0, 0, metadata.thumbnailHeight, metadata.thumbnail.data(), &info, DIB_RGB_COLORS);
     }
-}
\ No newline at end of file
+    
+    SetBkMode(hdc, TRANSPARENT);
+    SetTextColor(hdc, isSelected ? GetSysColor(COLOR_HIGHLIGHTTEXT) : COLOR_TEXT_PRIMARY);
+    HGDIOBJ oldFont = SelectObject(hdc, hFontRegular);
+    
+    rect.left = thumbnailLeft + SHARED_FILE_THUMBNAIL_SIZE + 4;
+    DrawText(hdc, displayText.c_str(), -1, &rect, DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX | DT_END_ELLIPSIS);
+    
+    SelectObject(hdc, oldFont);
+}
@@ -2,12 +2,29 @@
 
 #include <windows.h>
 #include <string>
+#include <vector>
 #include "ChatModels.h"
 
 // File management functions
 void ShareFile();
-void AddSharedFileToChat(const SharedFile& file, bool isOutgoing);
+void ShareFolder();
+
+// Share a batch of paths with the selected contact. Directories are replaced by
+// the files under them when expandDirectories is set. Returns how many were new.
+size_t ShareFiles(const std::vector<std::wstring>& paths, bool expandDirectories);
+
+// Add files to the selected contact in one update: one chat notice, one refresh
+size_t AddSharedFilesToChat(const std::vector<SharedFile>& files, bool isOutgoing);
 void UpdateSharedFilesList();
+void DrawSharedFileItem(const DRAWITEMSTRUCT* drawItem);
 void OpenSharedFile(int fileIndex);
+
+// Store a shared file and gather its metadata (size, MIME type, hash, thumbnail)
+// on the file worker pool. Posts a FileStored chat event when done, with null
+// metadata if the file could not be read. UI thread only; files the worker queue
+// has no room for wait in a backlog that SubmitSharedFileBacklog feeds in.
+void ProcessSharedFileAsync(int contactIndex, const std::wstring& filePath);
+void SubmitSharedFileBacklog();
+void ShutdownSharedFilePipeline();
 std::wstring GetFileExtensionIcon(const std::wstring& filePath);
-std::wstring FormatFileSize(DWORD fileSize);
\ No newline at end of file
+std::wstring FormatFileSize(uint64_t fileSize);
\ No newline at end of file
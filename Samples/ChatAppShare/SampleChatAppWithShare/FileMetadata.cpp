@@ -0,0 +1,183 @@
+#include "FileMetadata.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FILE_METADATA_USE_SSE2 1
+#endif
+
+struct MagicSignature
+{
+    size_t offset;
+    const char* bytes;
+    size_t length;
+    const char* mimeType;
+};
+
+static const MagicSignature MAGIC_SIGNATURES[] =
+{
+    { 0, "\x89PNG\r\n\x1a\n", 8, "image/png" },
+    { 0, "\xFF\xD8\xFF", 3, "image/jpeg" },
+    { 0, "GIF87a", 6, "image/gif" },
+    { 0, "GIF89a", 6, "image/gif" },
+    { 0, "BM", 2, "image/bmp" },
+    { 0, "II*\0", 4, "image/tiff" },
+    { 0, "MM\0*", 4, "image/tiff" },
+    { 8, "WEBP", 4, "image/webp" },
+    { 0, "%PDF-", 5, "application/pdf" },
+    { 0, "PK\x03\x04", 4, "application/zip" },     // also docx, xlsx, pptx
+    { 0, "\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1", 8, "application/x-ole-storage" },   // doc, xls
+    { 0, "\x1F\x8B", 2, "application/gzip" },
+    { 0, "7z\xBC\xAF\x27\x1C", 6, "application/x-7z-compressed" },
+    { 0, "MZ", 2, "application/vnd.microsoft.portable-executable" },
+    { 4, "ftyp", 4, "video/mp4" },
+    { 0, "ID3", 3, "audio/mpeg" },
+    { 0, "\xEF\xBB\xBF", 3, "text/plain" },
+    { 0, "\xFF\xFE", 2, "text/plain" },
+};
+
+const char* SniffMimeType(const uint8_t* header, size_t length)
+{
+    for (const MagicSignature& signature : MAGIC_SIGNATURES)
+    {
+        if (signature.offset + signature.length <= length &&
+            memcmp(header + signature.offset, signature.bytes, signature.length) == 0)
+        {
+            // "BM" is two common letters; a bitmap also has its header size at offset 14
+            if (strcmp(signature.mimeType, "image/bmp") == 0 && length >= 15 && header[14] < 12)
+                continue;
+            return signature.mimeType;
+        }
+    }
+    return "application/octet-stream";
+}
+
+bool IsImageMimeType(const char* mimeType)
+{
+    return strncmp(mimeType, "image/", 6) == 0;
+}
+
+void FitThumbnailSize(int width, int height, int maxSize, int& thumbnailWidth, int& thumbnailHeight)
+{
+    if (width <= 0 || height <= 0 || maxSize <= 0)
+    {
+        thumbnailWidth = 0;
+        thumbnailHeight = 0;
+        return;
+    }
+
+    if (width <= maxSize && height <= maxSize)
+    {
+        thumbnailWidth = width;
+        thumbnailHeight = height;
+    }
+    else if (width >= height)
+    {
+        thumbnailWidth = maxSize;
+        thumbnailHeight = (int)((int64_t)height * maxSize / width);
+    }
+    else
+    {
+        thumbnailHeight = maxSize;
+        thumbnailWidth = (int)((int64_t)width * maxSize / height);
+    }
+
+    if (thumbnailWidth < 1) thumbnailWidth = 1;
+    if (thumbnailHeight < 1) thumbnailHeight = 1;
+}
+
+void DownscaleBgra(const uint32_t* source, int sourceWidth, int sourceHeight, size_t sourceStride,
+    uint32_t* destination, int destinationWidth, int destinationHeight)
+{
+    for (int dy = 0; dy < destinationHeight; dy++)
+    {
+        int y0 = (int)((int64_t)dy * sourceHeight / destinationHeight);
+        int y1 = (int)((int64_t)(dy + 1) * sourceHeight / destinationHeight);
+        if (y1 <= y0) y1 = y0 + 1;
+
+        for (int dx = 0; dx < destinationWidth; dx++)
+        {
+            int x0 = (int)((int64_t)dx * sourceWidth / destinationWidth);
+            int x1 = (int)((int64_t)(dx + 1) * sourceWidth / destinationWidth);
+            if (x1 <= x0) x1 = x0 + 1;
+
+            uint32_t count = (uint32_t)((x1 - x0) * (y1 - y0));
+
+#ifdef FILE_METADATA_USE_SSE2
+            // All four channels of a pixel are summed at once in 32-bit lanes
+            __m128i zero = _mm_setzero_si128();
+            __m128i sum = zero;
+            for (int y = y0; y < y1; y++)
+            {
+                const uint32_t* row = source + (size_t)y * sourceStride;
+                int x = x0;
+                for (; x + 2 <= x1; x += 2)
+                {
+                    __m128i pixels = _mm_loadl_epi64((const __m128i*)(row + x));
+                    __m128i words = _mm_unpacklo_epi8(pixels, zero);
+                    sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(words, zero));
+                    sum = _mm_add_epi32(sum, _mm_unpackhi_epi16(words, zero));
+                }
+                if (x < x1)
+                {
+                    __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)row[x]), zero);
+                    sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(words, zero));
+                }
+            }
+            uint32_t channels[4];
+            _mm_storeu_si128((__m128i*)channels, sum);
+#else
+            uint32_t channels[4] = { 0, 0, 0, 0 };
+            for (int y = y0; y < y1; y++)
+            {
+                const uint32_t* row = source + (size_t)y * sourceStride;
+                for (int x = x0; x < x1; x++)
+                {
+                    uint32_t pixel = row[x];
+                    channels[0] += pixel & 0xFF;
+                    channels[1] += (pixel >> 8) & 0xFF;
+                    channels[2] += (pixel >> 16) & 0xFF;
+                    channels[3] += pixel >> 24;
+                }
+            }
+#endif
+
+            uint32_t half = count / 2;
+            destination[(size_t)dy * destinationWidth + dx] =
+                ((channels[0] + half) / count) |
+                (((channels[1] + half) / count) << 8) |
+                (((channels[2] + half) / count) << 16) |
+                (((channels[3] + half) / count) << 24);
+        }
+    }
+}
+
+std::shared_ptr<const FileMetadata> FileMetadataCache::Find(uint64_t contentHash) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_byHash.find(contentHash);
+    return it != m_byHash.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<const FileMetadata> FileMetadataCache::FindBySource(const std::wstring& sourceKey) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_bySource.find(sourceKey);
+    return it != m_bySource.end() ? it->second : nullptr;
+}
+
+void FileMetadataCache::Insert(const std::shared_ptr<const FileMetadata>& metadata, const std::wstring& sourceKey)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_byHash[metadata->contentHash] = metadata;
+    if (!sourceKey.empty())
+    {
+        m_bySource[sourceKey] = metadata;
+    }
+}
+
+size_t FileMetadataCache::Count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_byHash.size();
+}
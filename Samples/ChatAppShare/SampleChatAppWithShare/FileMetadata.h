@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// What the shared-files panel knows about a file beyond its name
+struct FileMetadata
+{
+    uint64_t size;
+    uint64_t contentHash;       // also the id of its ChunkStore manifest
+    const char* mimeType;       // static string from SniffMimeType
+    int thumbnailWidth;         // 0 when there is no thumbnail
+    int thumbnailHeight;
+    std::vector<uint32_t> thumbnail;    // top-down 32-bit BGRA pixels
+};
+
+// Bytes of file header SniffMimeType looks at
+static const size_t MIME_SNIFF_LENGTH = 16;
+
+// MIME type from the file's leading bytes; "application/octet-stream" if unknown
+const char* SniffMimeType(const uint8_t* header, size_t length);
+bool IsImageMimeType(const char* mimeType);
+
+// Fit a width x height image inside a maxSize square, keeping its aspect ratio
+void FitThumbnailSize(int width, int height, int maxSize, int& thumbnailWidth, int& thumbnailHeight);
+
+// Box-filter downscale of 32-bit BGRA pixels: each destination pixel is the
+// average of the source pixels it covers. Uses SSE2 where available.
+void DownscaleBgra(const uint32_t* source, int sourceWidth, int sourceHeight, size_t sourceStride,
+    uint32_t* destination, int destinationWidth, int destinationHeight);
+
+// Metadata already computed, shared by every worker thread.
+//
+// Entries are found by content hash, or by a source key (path, size and write
+// time) that lets an unchanged file skip even the hashing on a re-share.
+class FileMetadataCache
+{
+public:
+    std::shared_ptr<const FileMetadata> Find(uint64_t contentHash) const;
+    std::shared_ptr<const FileMetadata> FindBySource(const std::wstring& sourceKey) const;
+
+    void Insert(const std::shared_ptr<const FileMetadata>& metadata, const std::wstring& sourceKey);
+    size_t Count() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<const FileMetadata>> m_byHash;
+    std::unordered_map<std::wstring, std::shared_ptr<const FileMetadata>> m_bySource;
+};
@@ -0,0 +1,340 @@
+#include "FileTransfer.h"
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <mswsock.h>
+#include <windows.h>
+
+#pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "mswsock.lib")
+#else
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static const uint32_t OFFER_MAGIC = 0x31524658;         // "XFR1"
+static const uint32_t MAX_OFFER_CHUNKS = 1 << 24;
+
+// Receiver to sender: a count of acknowledged chunks, or one of these
+static const uint32_t TRANSFER_COMPLETE = 0xFFFFFFFF;
+static const uint32_t TRANSFER_FAILED = 0xFFFFFFFE;
+
+// Precedes each chunk on the wire; the bytes follow directly
+struct ChunkHeader
+{
+    uint32_t index;
+    uint32_t length;
+};
+
+static bool SendAll(TransferSocket socket, const void* data, size_t length)
+{
+    const char* p = (const char*)data;
+    while (length > 0)
+    {
+        int chunk = length > 0x40000000 ? 0x40000000 : (int)length;
+#ifdef _WIN32
+        int sent = send((SOCKET)socket, p, chunk, 0);
+#else
+        int sent = (int)send(socket, p, (size_t)chunk, MSG_NOSIGNAL);
+#endif
+        if (sent <= 0)
+            return false;
+        p += sent;
+        length -= (size_t)sent;
+    }
+    return true;
+}
+
+static bool ReceiveAll(TransferSocket socket, void* data, size_t length)
+{
+    char* p = (char*)data;
+    while (length > 0)
+    {
+        int chunk = length > 0x40000000 ? 0x40000000 : (int)length;
+#ifdef _WIN32
+        int got = recv((SOCKET)socket, p, chunk, 0);
+#else
+        int got = (int)recv(socket, p, (size_t)chunk, 0);
+#endif
+        if (got <= 0)
+            return false;
+        p += got;
+        length -= (size_t)got;
+    }
+    return true;
+}
+
+static bool SendValue(TransferSocket socket, uint32_t value)
+{
+    return SendAll(socket, &value, sizeof(value));
+}
+
+static bool ReceiveValue(TransferSocket socket, uint32_t& value)
+{
+    return ReceiveAll(socket, &value, sizeof(value));
+}
+
+// The file a transfer streams from, sent by the kernel without a user-mode copy
+class TransferSource
+{
+public:
+    ~TransferSource()
+    {
+#ifdef _WIN32
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+#else
+        if (m_file >= 0)
+            close(m_file);
+#endif
+    }
+
+    bool Open(const fs::path& path)
+    {
+#ifdef _WIN32
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        return m_file != INVALID_HANDLE_VALUE;
+#else
+        m_file = open(path.c_str(), O_RDONLY);
+        return m_file >= 0;
+#endif
+    }
+
+    // Send 'head' followed by 'length' bytes of the file starting at 'offset'
+    bool SendRange(TransferSocket socket, const void* head, uint32_t headLength, uint64_t offset, uint32_t length)
+    {
+#ifdef _WIN32
+        LARGE_INTEGER position;
+        position.QuadPart = (LONGLONG)offset;
+        if (!SetFilePointerEx(m_file, position, nullptr, FILE_BEGIN))
+            return false;
+
+        TRANSMIT_FILE_BUFFERS buffers = {};
+        buffers.Head = (void*)head;
+        buffers.HeadLength = headLength;
+        return TransmitFile((SOCKET)socket, m_file, length, 0, nullptr, &buffers, 0) != FALSE;
+#else
+        if (!SendAll(socket, head, headLength))
+            return false;
+
+        off_t position = (off_t)offset;
+        while (length > 0)
+        {
+            ssize_t sent = sendfile(socket, m_file, &position, length);
+            if (sent <= 0)
+                return false;
+            length -= (uint32_t)sent;
+        }
+        return true;
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+#else
+    int m_file = -1;
+#endif
+};
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+FileTransferEngine::FileTransferEngine(ChunkStore& store)
+    : m_store(store)
+{
+}
+
+bool FileTransferEngine::Send(TransferSocket socket, const fs::path& filePath, const ChunkManifest& manifest,
+    TransferStats& stats, const TransferProgress& progress)
+{
+    auto start = std::chrono::steady_clock::now();
+    stats = TransferStats{ 0, 0, 0, 0, 0.0 };
+
+    TransferSource source;
+    if (!source.Open(filePath))
+        return false;
+
+    // Offer: the manifest, so the receiver can work out what it is missing
+    uint32_t count = (uint32_t)manifest.chunks.size();
+    std::vector<uint8_t> offer;
+    offer.reserve(24 + (size_t)count * 12);
+    auto append = [&offer](const void* value, size_t size) {
+        const uint8_t* p = (const uint8_t*)value;
+        offer.insert(offer.end(), p, p + size);
+    };
+    append(&OFFER_MAGIC, sizeof(OFFER_MAGIC));
+    append(&manifest.id, sizeof(manifest.id));
+    append(&manifest.fileSize, sizeof(manifest.fileSize));
+    append(&count, sizeof(count));
+    for (const ChunkRef& chunk : manifest.chunks)
+    {
+        append(&chunk.hash, sizeof(chunk.hash));
+        append(&chunk.length, sizeof(chunk.length));
+    }
+    if (!SendAll(socket, offer.data(), offer.size()))
+        return false;
+
+    // Answer: one bit per chunk, set where the receiver needs it
+    uint32_t answerCount = 0;
+    if (!ReceiveValue(socket, answerCount) || answerCount != count)
+        return false;
+    std::vector<uint8_t> needed(((size_t)count + 7) / 8);
+    if (!ReceiveAll(socket, needed.data(), needed.size()))
+        return false;
+
+    uint32_t credits = WINDOW_CHUNKS;
+    uint64_t offset = 0;
+    for (uint32_t index = 0; index < count; index++)
+    {
+        const ChunkRef& chunk = manifest.chunks[index];
+        if (!(needed[index / 8] & (1 << (index % 8))))
+        {
+            stats.bytesSkipped += chunk.length;
+            stats.chunksSkipped++;
+            offset += chunk.length;
+            continue;
+        }
+
+        // Out of window: wait for the receiver to catch up
+        while (credits == 0)
+        {
+            uint32_t message = 0;
+            if (!ReceiveValue(socket, message) || message > WINDOW_CHUNKS)
+                return false;
+            credits += message;
+        }
+
+        ChunkHeader header{ index, chunk.length };
+        if (!source.SendRange(socket, &header, sizeof(header), offset, chunk.length))
+            return false;
+
+        credits--;
+        offset += chunk.length;
+        stats.bytesSent += chunk.length;
+        stats.chunksSent++;
+        if (progress)
+        {
+            stats.seconds = SecondsSince(start);
+            progress(stats);
+        }
+    }
+
+    // Acknowledgements still in flight come ahead of the verdict
+    while (true)
+    {
+        uint32_t message = 0;
+        if (!ReceiveValue(socket, message) || message == TRANSFER_FAILED)
+            return false;
+        if (message == TRANSFER_COMPLETE)
+            break;
+    }
+
+    stats.seconds = SecondsSince(start);
+    return true;
+}
+
+bool FileTransferEngine::Receive(TransferSocket socket, ChunkManifest& manifest,
+    TransferStats& stats, const TransferProgress& progress)
+{
+    auto start = std::chrono::steady_clock::now();
+    stats = TransferStats{ 0, 0, 0, 0, 0.0 };
+
+    uint32_t magic = 0;
+    uint32_t count = 0;
+    if (!ReceiveValue(socket, magic) || magic != OFFER_MAGIC)
+        return false;
+    if (!ReceiveAll(socket, &manifest.id, sizeof(manifest.id)) ||
+        !ReceiveAll(socket, &manifest.fileSize, sizeof(manifest.fileSize)) ||
+        !ReceiveValue(socket, count) || count > MAX_OFFER_CHUNKS)
+        return false;
+
+    uint64_t total = 0;
+    manifest.chunks.resize(count);
+    for (ChunkRef& chunk : manifest.chunks)
+    {
+        if (!ReceiveAll(socket, &chunk.hash, sizeof(chunk.hash)) ||
+            !ReceiveAll(socket, &chunk.length, sizeof(chunk.length)) ||
+            chunk.length == 0 || chunk.length > MAX_CHUNK_LENGTH)
+            return false;
+        total += chunk.length;
+    }
+    if (total != manifest.fileSize)
+        return false;
+
+    // Whatever is already here, from an earlier attempt or another file, stays
+    std::vector<uint8_t> needed(((size_t)count + 7) / 8);
+    uint32_t missing = 0;
+    for (uint32_t index = 0; index < count; index++)
+    {
+        const ChunkRef& chunk = manifest.chunks[index];
+        if (m_store.HasChunk(chunk))
+        {
+            stats.bytesSkipped += chunk.length;
+            stats.chunksSkipped++;
+        }
+        else
+        {
+            needed[index / 8] |= (uint8_t)(1 << (index % 8));
+            missing++;
+        }
+    }
+    if (!SendValue(socket, count) || !SendAll(socket, needed.data(), needed.size()))
+        return false;
+
+    std::vector<uint8_t> buffer;
+    uint32_t unacknowledged = 0;
+    for (uint32_t received = 0; received < missing; received++)
+    {
+        ChunkHeader header;
+        if (!ReceiveAll(socket, &header, sizeof(header)))
+            return false;
+
+        // Each chunk must be one that was asked for, exactly once
+        if (header.index >= count || !(needed[header.index / 8] & (1 << (header.index % 8))) ||
+            header.length != manifest.chunks[header.index].length)
+        {
+            SendValue(socket, TRANSFER_FAILED);
+            return false;
+        }
+        needed[header.index / 8] &= (uint8_t)~(1 << (header.index % 8));
+
+        buffer.resize(header.length);
+        if (!ReceiveAll(socket, buffer.data(), buffer.size()))
+            return false;
+        if (!m_store.PutChunk(buffer.data(), manifest.chunks[header.index]))
+        {
+            SendValue(socket, TRANSFER_FAILED);
+            return false;
+        }
+
+        stats.bytesSent += header.length;
+        stats.chunksSent++;
+        if (progress)
+        {
+            stats.seconds = SecondsSince(start);
+            progress(stats);
+        }
+
+        // Acknowledge in half windows so the sender never stalls on a full one
+        if (++unacknowledged == WINDOW_CHUNKS / 2)
+        {
+            if (!SendValue(socket, unacknowledged))
+                return false;
+            unacknowledged = 0;
+        }
+    }
+
+    bool stored = m_store.PutManifest(manifest);
+    stats.seconds = SecondsSince(start);
+    return SendValue(socket, stored ? TRANSFER_COMPLETE : TRANSFER_FAILED) && stored;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+#include "ChunkStore.h"
+
+// Connected stream socket: a SOCKET on Windows, a file descriptor elsewhere
+#ifdef _WIN32
+typedef uintptr_t TransferSocket;
+#else
+typedef int TransferSocket;
+#endif
+
+struct TransferStats
+{
+    uint64_t bytesSent;         // chunk bytes that crossed the socket
+    uint64_t bytesSkipped;      // chunk bytes the receiver already had
+    uint32_t chunksSent;
+    uint32_t chunksSkipped;
+    double seconds;
+
+    double BytesPerSecond() const { return seconds > 0.0 ? (double)bytesSent / seconds : 0.0; }
+};
+
+// Called after each chunk with the transfer's running totals
+typedef std::function<void(const TransferStats&)> TransferProgress;
+
+// Moves a file between two ChunkStores over a connected socket.
+//
+// The sender offers the file's manifest and the receiver answers with the
+// chunks it is missing, so a transfer that was cut off resumes where it
+// stopped and content the receiver already has is never resent. Missing
+// chunks are streamed straight from the source file with TransmitFile
+// (sendfile elsewhere) so they do not pass through user-mode buffers. The
+// sender may run at most WINDOW_CHUNKS ahead of what the receiver has stored
+// and acknowledged, which keeps a slow disk on the far end from being buried.
+//
+// Both calls block until the transfer finishes or fails. On Windows the caller
+// owns WSAStartup.
+class FileTransferEngine
+{
+public:
+    explicit FileTransferEngine(ChunkStore& store);
+
+    // 'manifest' must describe 'filePath' as it is now, e.g. from ChunkStore::Ingest
+    bool Send(TransferSocket socket, const std::filesystem::path& filePath, const ChunkManifest& manifest,
+        TransferStats& stats, const TransferProgress& progress = nullptr);
+
+    // Stores the incoming chunks and, once all are present and restore to the
+    // offered id, the manifest
+    bool Receive(TransferSocket socket, ChunkManifest& manifest,
+        TransferStats& stats, const TransferProgress& progress = nullptr);
+
+    static const uint32_t WINDOW_CHUNKS = 16;
+    static const uint32_t MAX_CHUNK_LENGTH = 16 * 1024 * 1024;
+
+private:
+    ChunkStore& m_store;
+};
@@ -0,0 +1,177 @@
+#include "FrameCodec.h"
+#include <algorithm>
+
+static void PutLittleEndian(uint8_t* out, uint64_t value, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t GetLittleEndian(const uint8_t* in, size_t size)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        value |= (uint64_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+void EncodeFrameHeader(const FrameHeader& header, uint8_t* out)
+{
+    PutLittleEndian(out, header.length, 4);
+    out[4] = header.version;
+    out[5] = (uint8_t)header.type;
+    PutLittleEndian(out + 6, header.flags, 2);
+    PutLittleEndian(out + 8, header.requestId, 8);
+}
+
+bool DecodeFrameHeader(const uint8_t* data, FrameHeader& header)
+{
+    header.length = (uint32_t)GetLittleEndian(data, 4);
+    header.version = data[4];
+    header.type = (FrameType)data[5];
+    header.flags = (uint16_t)GetLittleEndian(data + 6, 2);
+    header.requestId = GetLittleEndian(data + 8, 8);
+
+    return header.version == FRAME_VERSION &&
+        header.length <= MAX_FRAME_PAYLOAD &&
+        header.type >= FrameType::Request && header.type <= FrameType::Error &&
+        (header.flags & ~FRAME_FLAG_MORE) == 0;
+}
+
+void EncodeMessage(FrameType type, uint64_t requestId, size_t payloadLength, std::vector<EncodedFrame>& frames)
+{
+    frames.clear();
+    size_t offset = 0;
+    do
+    {
+        size_t length = std::min(payloadLength - offset, MAX_FRAME_PAYLOAD);
+        bool more = offset + length < payloadLength;
+
+        EncodedFrame frame;
+        FrameHeader header{ (uint32_t)length, FRAME_VERSION, type, (uint16_t)(more ? FRAME_FLAG_MORE : 0), requestId };
+        EncodeFrameHeader(header, frame.header);
+        frame.payloadOffset = offset;
+        frame.payloadLength = length;
+        frames.push_back(frame);
+
+        offset += length;
+    } while (offset < payloadLength);
+}
+
+void AppendFrame(const EncodedFrame& frame, const std::string& payload, std::string& out)
+{
+    out.append((const char*)frame.header, FRAME_HEADER_SIZE);
+    out.append(payload, frame.payloadOffset, frame.payloadLength);
+}
+
+FrameDecoder::FrameDecoder(BufferPool& pool)
+    : m_pool(pool), m_message{ FrameType::Request, 0, std::string() }, m_inMessage(false), m_failed(false)
+{
+}
+
+void FrameDecoder::Reset()
+{
+    m_partialFrame.clear();
+    m_message.payload.clear();
+    m_inMessage = false;
+    m_failed = false;
+}
+
+bool FrameDecoder::Feed(const void* data, size_t length, std::vector<FrameMessage>& messages)
+{
+    if (m_failed)
+        return false;
+
+    const uint8_t* input = (const uint8_t*)data;
+    FrameHeader header;
+
+    // Finish a frame split across earlier reads first
+    if (!m_partialFrame.empty())
+    {
+        size_t need = FRAME_HEADER_SIZE;
+        if (m_partialFrame.size() < FRAME_HEADER_SIZE)
+        {
+            size_t take = std::min(length, FRAME_HEADER_SIZE - m_partialFrame.size());
+            m_partialFrame.append((const char*)input, take);
+            input += take;
+            length -= take;
+            if (m_partialFrame.size() < FRAME_HEADER_SIZE)
+                return true;
+        }
+
+        if (!DecodeFrameHeader((const uint8_t*)m_partialFrame.data(), header))
+        {
+            m_failed = true;
+            return false;
+        }
+        need += header.length;
+
+        size_t take = std::min(length, need - m_partialFrame.size());
+        m_partialFrame.append((const char*)input, take);
+        input += take;
+        length -= take;
+        if (m_partialFrame.size() < need)
+            return true;
+
+        bool accepted = OnFrame(header, (const uint8_t*)m_partialFrame.data() + FRAME_HEADER_SIZE, messages);
+        m_partialFrame.clear();
+        if (!accepted)
+            return false;
+    }
+
+    // Whole frames are taken straight from the input without another copy
+    while (length >= FRAME_HEADER_SIZE)
+    {
+        if (!DecodeFrameHeader(input, header))
+        {
+            m_failed = true;
+            return false;
+        }
+        if (length < FRAME_HEADER_SIZE + header.length)
+            break;
+
+        if (!OnFrame(header, input + FRAME_HEADER_SIZE, messages))
+            return false;
+        input += FRAME_HEADER_SIZE + header.length;
+        length -= FRAME_HEADER_SIZE + header.length;
+    }
+
+    m_partialFrame.append((const char*)input, length);
+    return true;
+}
+
+bool FrameDecoder::OnFrame(const FrameHeader& header, const uint8_t* payload, std::vector<FrameMessage>& messages)
+{
+    if (!m_inMessage)
+    {
+        m_message.type = header.type;
+        m_message.requestId = header.requestId;
+        m_message.payload = m_pool.Acquire();
+        m_inMessage = true;
+    }
+    else if (header.type != m_message.type || header.requestId != m_message.requestId)
+    {
+        // A continuation has to belong to the message it continues
+        m_failed = true;
+        return false;
+    }
+
+    if (m_message.payload.size() + header.length > MAX_MESSAGE_PAYLOAD)
+    {
+        m_failed = true;
+        return false;
+    }
+    m_message.payload.append((const char*)payload, header.length);
+
+    if (!(header.flags & FRAME_FLAG_MORE))
+    {
+        messages.push_back(std::move(m_message));
+        m_message.payload = std::string();
+        m_inMessage = false;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BufferPool.h"
+
+// Framing for the background service protocol.
+//
+// Every frame is a 16-byte little-endian header followed by its payload:
+//
+//   u32 payload length | u8 version | u8 type | u16 flags | u64 request id
+//
+// A message longer than MAX_FRAME_PAYLOAD is sent as several frames with the
+// same type and request id, all but the last flagged FRAME_FLAG_MORE. Frames
+// of different messages are never interleaved on one connection.
+
+static const uint8_t FRAME_VERSION = 1;
+static const size_t FRAME_HEADER_SIZE = 16;
+static const size_t MAX_FRAME_PAYLOAD = 32 * 1024;
+static const size_t MAX_MESSAGE_PAYLOAD = 16 * 1024 * 1024;
+
+static const uint16_t FRAME_FLAG_MORE = 1 << 0;     // payload continues in the next frame
+
+enum class FrameType : uint8_t
+{
+    Request = 1,
+    Response = 2,
+    Error = 3,      // payload is a description of what went wrong
+};
+
+struct FrameHeader
+{
+    uint32_t length;
+    uint8_t version;
+    FrameType type;
+    uint16_t flags;
+    uint64_t requestId;
+};
+
+void EncodeFrameHeader(const FrameHeader& header, uint8_t* out);
+
+// False if the header is from another protocol version or is otherwise invalid
+bool DecodeFrameHeader(const uint8_t* data, FrameHeader& header);
+
+// One frame of an encoded message, ready for a gather write: its header, and
+// where its payload lies within the message payload
+struct EncodedFrame
+{
+    uint8_t header[FRAME_HEADER_SIZE];
+    size_t payloadOffset;
+    size_t payloadLength;
+};
+
+void EncodeMessage(FrameType type, uint64_t requestId, size_t payloadLength, std::vector<EncodedFrame>& frames);
+
+// Header and payload of one frame copied together, for transports without gather writes
+void AppendFrame(const EncodedFrame& frame, const std::string& payload, std::string& out);
+
+struct FrameMessage
+{
+    FrameType type;
+    uint64_t requestId;
+    std::string payload;    // from the decoder's pool; hand it back when done
+};
+
+// Reassembles messages from bytes however they were split on the way. After a
+// protocol error Feed keeps returning false and the connection should be dropped.
+class FrameDecoder
+{
+public:
+    explicit FrameDecoder(BufferPool& pool = BufferPool::Shared());
+
+    bool Feed(const void* data, size_t length, std::vector<FrameMessage>& messages);
+    void Reset();
+
+    // Bytes held back waiting for the rest of a frame or message
+    size_t Buffered() const { return m_partialFrame.size() + m_message.payload.size(); }
+
+private:
+    bool OnFrame(const FrameHeader& header, const uint8_t* payload, std::vector<FrameMessage>& messages);
+
+    BufferPool& m_pool;
+    std::string m_partialFrame;
+    FrameMessage m_message;     // being reassembled while m_inMessage
+    bool m_inMessage;
+    bool m_failed;
+};
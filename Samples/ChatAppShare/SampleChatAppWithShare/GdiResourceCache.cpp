@@ -0,0 +1,66 @@
+#include "GdiResourceCache.h"
+#include <unordered_map>
+
+static std::unordered_map<GdiResourceKey, HGDIOBJ, GdiResourceKeyHash> s_gdiResources;
+
+static HGDIOBJ CreateGdiResource(const GdiResourceKey& key)
+{
+    switch (key.Kind())
+    {
+    case GDI_RESOURCE_SOLID_BRUSH:
+        return CreateSolidBrush(key.Color());
+    case GDI_RESOURCE_PEN:
+        return CreatePen(key.PenStyle(), key.PenWidth(), key.Color());
+    case GDI_RESOURCE_ROUND_RECT_REGION:
+        return CreateRoundRectRgn(0, 0, key.RegionWidth(), key.RegionHeight(),
+            key.RegionEllipseWidth(), key.RegionEllipseHeight());
+    default:
+        return nullptr;
+    }
+}
+
+static HGDIOBJ LookupGdiResource(const GdiResourceKey& key)
+{
+    if (!key.IsValid())
+        return nullptr;
+
+    auto it = s_gdiResources.find(key);
+    if (it != s_gdiResources.end())
+        return it->second;
+
+    HGDIOBJ resource = CreateGdiResource(key);
+    if (resource)
+    {
+        s_gdiResources.emplace(key, resource);
+    }
+    return resource;
+}
+
+HBRUSH GetCachedSolidBrush(COLORREF color)
+{
+    return (HBRUSH)LookupGdiResource(GdiResourceKey::SolidBrush(color));
+}
+
+HPEN GetCachedPen(int style, int width, COLORREF color)
+{
+    return (HPEN)LookupGdiResource(GdiResourceKey::Pen(style, width, color));
+}
+
+HRGN GetCachedRoundRectRegion(int width, int height, int ellipseWidth, int ellipseHeight)
+{
+    return (HRGN)LookupGdiResource(GdiResourceKey::RoundRectRegion(width, height, ellipseWidth, ellipseHeight));
+}
+
+size_t GetGdiResourceCacheSize()
+{
+    return s_gdiResources.size();
+}
+
+void ReleaseGdiResourceCache()
+{
+    for (auto& entry : s_gdiResources)
+    {
+        DeleteObject(entry.second);
+    }
+    s_gdiResources.clear();
+}
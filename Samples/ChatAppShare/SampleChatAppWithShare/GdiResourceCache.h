@@ -0,0 +1,17 @@
+#pragma once
+
+#include <windows.h>
+#include "GdiResourceKeys.h"
+
+// Process-wide cache of GDI brushes, pens and regions.
+// Objects are created the first time a key is requested and live until
+// ReleaseGdiResourceCache(), so paint code never creates or deletes them.
+// Callers must not DeleteObject what they get back.
+HBRUSH GetCachedSolidBrush(COLORREF color);
+HPEN GetCachedPen(int style, int width, COLORREF color);
+HRGN GetCachedRoundRectRegion(int width, int height, int ellipseWidth, int ellipseHeight);
+
+// Number of live cached objects (for diagnostics)
+size_t GetGdiResourceCacheSize();
+
+void ReleaseGdiResourceCache();
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Lookup keys for cached GDI objects.
+//
+// Everything that identifies a brush, pen or region is packed into one 64-bit
+// value: the kind in the top byte, the parameters below it. Keeping this layer
+// free of Windows types lets the key packing be checked anywhere.
+enum GdiResourceKind : uint8_t
+{
+    GDI_RESOURCE_INVALID = 0,
+    GDI_RESOURCE_SOLID_BRUSH = 1,
+    GDI_RESOURCE_PEN = 2,
+    GDI_RESOURCE_ROUND_RECT_REGION = 3
+};
+
+struct GdiResourceKey
+{
+    uint64_t value;
+
+    GdiResourceKind Kind() const { return (GdiResourceKind)(value >> 56); }
+    bool IsValid() const { return Kind() != GDI_RESOURCE_INVALID; }
+
+    bool operator==(const GdiResourceKey& other) const { return value == other.value; }
+    bool operator!=(const GdiResourceKey& other) const { return value != other.value; }
+
+    // color is a COLORREF (0x00BBGGRR)
+    static GdiResourceKey SolidBrush(uint32_t color)
+    {
+        return Make(GDI_RESOURCE_SOLID_BRUSH, color & 0xFFFFFFu);
+    }
+
+    // style is a PS_* value; widths above 255 are not cacheable
+    static GdiResourceKey Pen(int style, int width, uint32_t color)
+    {
+        if (style < 0 || style > 0xFF || width < 0 || width > 0xFF)
+            return GdiResourceKey{ 0 };
+        return Make(GDI_RESOURCE_PEN, ((uint64_t)style << 32) | ((uint64_t)width << 24) | (color & 0xFFFFFFu));
+    }
+
+    // Rounded rectangle anchored at the origin; callers offset it to where it is drawn
+    static GdiResourceKey RoundRectRegion(int width, int height, int ellipseWidth, int ellipseHeight)
+    {
+        if (width < 0 || width > 0xFFFF || height < 0 || height > 0xFFFF ||
+            ellipseWidth < 0 || ellipseWidth > 0xFF || ellipseHeight < 0 || ellipseHeight > 0xFF)
+            return GdiResourceKey{ 0 };
+        return Make(GDI_RESOURCE_ROUND_RECT_REGION,
+            ((uint64_t)width << 32) | ((uint64_t)height << 16) | ((uint64_t)ellipseWidth << 8) | (uint64_t)ellipseHeight);
+    }
+
+    // Parameter accessors for whoever turns a key back into a GDI object
+    uint32_t Color() const { return (uint32_t)(value & 0xFFFFFFu); }
+    int PenStyle() const { return (int)((value >> 32) & 0xFF); }
+    int PenWidth() const { return (int)((value >> 24) & 0xFF); }
+    int RegionWidth() const { return (int)((value >> 32) & 0xFFFF); }
+    int RegionHeight() const { return (int)((value >> 16) & 0xFFFF); }
+    int RegionEllipseWidth() const { return (int)((value >> 8) & 0xFF); }
+    int RegionEllipseHeight() const { return (int)(value & 0xFF); }
+
+private:
+    static GdiResourceKey Make(GdiResourceKind kind, uint64_t params)
+    {
+        return GdiResourceKey{ ((uint64_t)kind << 56) | (params & 0x00FFFFFFFFFFFFFFull) };
+    }
+};
+
+struct GdiResourceKeyHash
+{
+    size_t operator()(const GdiResourceKey& key) const
+    {
+        // 64-bit mix so keys that differ only in high bits spread across buckets
+        uint64_t x = key.value;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        return (size_t)x;
+    }
+};
@@ -1,5 +1,8 @@
 #include "ModernUI.h"
 #include "UIConstants.h"
+#include "GdiResourceCache.h"
+#include "TextLayout.h"
+#include <memory>
 #include <gdiplus.h>
 
 #pragma comment(lib, "gdiplus.lib")
@@ -14,13 +17,24 @@ HFONT hFontBold = nullptr;
 HFONT hFontTitle = nullptr;
 HPEN hPenBorder = nullptr;
 
+// Glyph widths and truncated previews for hFontRegular, measured once per string
+static HDC s_measureDC = nullptr;
+static HGDIOBJ s_oldMeasureFont = nullptr;
+static std::unique_ptr<TextLayoutCache> s_previewLayouts;
+
 void InitializeModernUI()
 {
-    // Create brushes for modern color scheme
-    hBrushBackground = CreateSolidBrush(COLOR_APP_BACKGROUND);
-    hBrushSurface = CreateSolidBrush(COLOR_SURFACE);
-    hBrushPrimary = CreateSolidBrush(COLOR_PRIMARY);
-    hBrushHover = CreateSolidBrush(COLOR_HOVER);
+    // Brushes for the modern color scheme come from the resource cache
+    hBrushBackground = GetCachedSolidBrush(COLOR_APP_BACKGROUND);
+    hBrushSurface = GetCachedSolidBrush(COLOR_SURFACE);
+    hBrushPrimary = GetCachedSolidBrush(COLOR_PRIMARY);
+    hBrushHover = GetCachedSolidBrush(COLOR_HOVER);
+
+    // Warm up everything the paint paths ask for so WM_PAINT never creates GDI objects
+    GetCachedSolidBrush(COLOR_PRIMARY_DARK);
+    GetCachedSolidBrush(COLOR_BORDER);
+    GetCachedPen(PS_SOLID, 2, COLOR_PRESENCE_ONLINE);
+    GetCachedPen(PS_SOLID, 2, COLOR_PRESENCE_OFFLINE);
     
     // Create modern fonts
     hFontRegular = CreateFont(16, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
@@ -35,8 +49,21 @@ void InitializeModernUI()
         DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
         CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI");
     
-    // Create pen for borders
-    hPenBorder = CreatePen(PS_SOLID, 1, COLOR_BORDER);
+    // Measure preview text off-screen so truncation never goes back to GDI per paint
+    s_measureDC = CreateCompatibleDC(NULL);
+    if (s_measureDC)
+    {
+        s_oldMeasureFont = SelectObject(s_measureDC, hFontRegular);
+        s_previewLayouts.reset(new TextLayoutCache([](wchar_t first, wchar_t last, int* advances) {
+            if (!GetCharWidth32W(s_measureDC, first, last, advances))
+            {
+                ZeroMemory(advances, (last - first + 1) * sizeof(int));
+            }
+        }));
+    }
+    
+    // Pen for borders
+    hPenBorder = GetCachedPen(PS_SOLID, 1, COLOR_BORDER);
     
     // Initialize GDI+
     Gdiplus::GdiplusStartupInput gdiplusStartupInput;
@@ -46,15 +73,24 @@ void InitializeModernUI()
 
 void CleanupModernUI()
 {
-    // Cleanup GDI objects
-    if (hBrushBackground) DeleteObject(hBrushBackground);
-    if (hBrushSurface) DeleteObject(hBrushSurface);
-    if (hBrushPrimary) DeleteObject(hBrushPrimary);
-    if (hBrushHover) DeleteObject(hBrushHover);
+    s_previewLayouts.reset();
+    if (s_measureDC)
+    {
+        SelectObject(s_measureDC, s_oldMeasureFont);
+        DeleteDC(s_measureDC);
+        s_measureDC = nullptr;
+    }
+    
+    // Cleanup GDI objects; brushes and pens are owned by the resource cache
     if (hFontRegular) DeleteObject(hFontRegular);
     if (hFontBold) DeleteObject(hFontBold);
     if (hFontTitle) DeleteObject(hFontTitle);
-    if (hPenBorder) DeleteObject(hPenBorder);
+    ReleaseGdiResourceCache();
+    hBrushBackground = nullptr;
+    hBrushSurface = nullptr;
+    hBrushPrimary = nullptr;
+    hBrushHover = nullptr;
+    hPenBorder = nullptr;
     
     // Shutdown GDI+
     Gdiplus::GdiplusShutdown(NULL);
@@ -62,20 +98,24 @@ void CleanupModernUI()
 
 void DrawModernButton(HDC hdc, RECT rect, const std::wstring& text, bool isHovered, bool isPressed)
 {
-    // Create rounded rectangle region
-    HRGN hRgn = CreateRoundRectRgn(rect.left, rect.top, rect.right, rect.bottom, 8, 8);
-    
-    // Fill background
-    HBRUSH hBrush = CreateSolidBrush(isPressed ? COLOR_PRIMARY_DARK : 
-                                    isHovered ? COLOR_PRIMARY : COLOR_PRIMARY);
-    FillRgn(hdc, hRgn, hBrush);
-    DeleteObject(hBrush);
-    
-    // Draw border with a brush instead of pen
-    HBRUSH borderBrush = CreateSolidBrush(COLOR_BORDER);
-    FrameRgn(hdc, hRgn, borderBrush, 1, 1);
-    DeleteObject(borderBrush);
-    DeleteObject(hRgn);
+    // Rounded rectangle region, cached per button size at the origin
+    HRGN hRgn = GetCachedRoundRectRegion(rect.right - rect.left, rect.bottom - rect.top, 8, 8);
+    if (hRgn)
+    {
+        if (rect.left != 0 || rect.top != 0)
+            OffsetRgn(hRgn, rect.left, rect.top);
+
+        // Fill background
+        FillRgn(hdc, hRgn, GetCachedSolidBrush(isPressed ? COLOR_PRIMARY_DARK :
+                                               isHovered ? COLOR_PRIMARY : COLOR_PRIMARY));
+
+        // Draw border with a brush instead of pen
+        FrameRgn(hdc, hRgn, GetCachedSolidBrush(COLOR_BORDER), 1, 1);
+
+        // Put the shared region back where the next caller expects it
+        if (rect.left != 0 || rect.top != 0)
+            OffsetRgn(hRgn, -rect.left, -rect.top);
+    }
     
     // Draw text
     SetBkMode(hdc, TRANSPARENT);
@@ -85,27 +125,25 @@ void DrawModernButton(HDC hdc, RECT rect, const std::wstring& text, bool isHover
     DrawText(hdc, text.c_str(), -1, &rect, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
 }
 
-void DrawContactItem(HDC hdc, RECT rect, const Contact& contact, bool isSelected)
+void DrawContactItem(HDC hdc, RECT rect, const ContactView& contact, bool isSelected)
 {
     // Fill background
-    HBRUSH bgBrush = CreateSolidBrush(isSelected ? COLOR_HOVER : COLOR_SURFACE);
-    FillRect(hdc, &rect, bgBrush);
-    DeleteObject(bgBrush);
+    FillRect(hdc, &rect, isSelected ? hBrushHover : hBrushSurface);
     
     // Draw avatar circle
     int avatarX = rect.left + 12;
     int avatarY = rect.top + (rect.bottom - rect.top - AVATAR_SIZE) / 2;
     
-    HBRUSH avatarBrush = CreateSolidBrush(COLOR_PRIMARY);
-    HPEN avatarPen = CreatePen(PS_SOLID, 2, contact.isOnline ? RGB(34, 197, 94) : RGB(156, 163, 175));
+    HPEN avatarPen = GetCachedPen(PS_SOLID, 2, contact.isOnline ? COLOR_PRESENCE_ONLINE : COLOR_PRESENCE_OFFLINE);
     
-    SelectObject(hdc, avatarBrush);
-    SelectObject(hdc, avatarPen);
+    // Restore the DC's objects afterwards so cached ones are never left selected
+    HGDIOBJ oldBrush = SelectObject(hdc, hBrushPrimary);
+    HGDIOBJ oldPen = SelectObject(hdc, avatarPen);
     
     Ellipse(hdc, avatarX, avatarY, avatarX + AVATAR_SIZE, avatarY + AVATAR_SIZE);
     
-    DeleteObject(avatarBrush);
-    DeleteObject(avatarPen);
+    SelectObject(hdc, oldPen);
+    SelectObject(hdc, oldBrush);
     
     // Draw contact name
     SetBkMode(hdc, TRANSPARENT);
@@ -122,7 +160,9 @@ void DrawContactItem(HDC hdc, RECT rect, const Contact& contact, bool isSelected
     RECT statusRect = {avatarX + AVATAR_SIZE + 12, rect.top + 30, rect.right - 8, rect.top + 48};
     DrawText(hdc, contact.status.c_str(), -1, &statusRect, DT_LEFT | DT_VCENTER | DT_SINGLELINE);
     
-    // Draw last message preview
+    // Draw last message preview, truncated to the row width with a cached layout
     RECT msgRect = {avatarX + AVATAR_SIZE + 12, rect.top + 50, rect.right - 8, rect.bottom - 8};
-    DrawText(hdc, contact.lastMessage.c_str(), -1, &msgRect, DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_END_ELLIPSIS);
+    const std::wstring& preview = s_previewLayouts ?
+        s_previewLayouts->Ellipsize(contact.lastMessage, msgRect.right - msgRect.left) : contact.lastMessage;
+    DrawText(hdc, preview.c_str(), -1, &msgRect, DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX);
 }
\ No newline at end of file
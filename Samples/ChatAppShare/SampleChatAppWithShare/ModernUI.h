@@ -18,4 +18,4 @@ extern HPEN hPenBorder;
 void InitializeModernUI();
 void CleanupModernUI();
 void DrawModernButton(HDC hdc, RECT rect, const std::wstring& text, bool isHovered, bool isPressed);
-void DrawContactItem(HDC hdc, RECT rect, const Contact& contact, bool isSelected);
\ No newline at end of file
+void DrawContactItem(HDC hdc, RECT rect, const ContactView& contact, bool isSelected);
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "PresenceEngine.h"
+
+PresenceEngine::PresenceEngine(uint32_t coalesceWindowMs)
+    : m_coalesceWindowMs(coalesceWindowMs)
+{
+}
+
+void PresenceEngine::Reset(size_t contactCount)
+{
+    m_slots.assign(contactCount, Slot{ { false, std::wstring() }, { false, std::wstring() }, 0, false });
+    m_pendingIndices.clear();
+}
+
+void PresenceEngine::Track(int contactIndex, bool isOnline, const std::wstring& status)
+{
+    if (!IsValidIndex(contactIndex))
+        return;
+
+    Slot& slot = m_slots[contactIndex];
+    slot.committed.isOnline = isOnline;
+    slot.committed.status = status;
+}
+
+void PresenceEngine::Update(int contactIndex, bool isOnline, const std::wstring& status, uint64_t nowMs)
+{
+    if (!IsValidIndex(contactIndex))
+        return;
+
+    Slot& slot = m_slots[contactIndex];
+    if (!slot.isPending)
+    {
+        // Nothing to do for a report that matches what is already on screen
+        if (slot.committed.isOnline == isOnline && slot.committed.status == status)
+            return;
+
+        slot.isPending = true;
+        slot.firstUpdateMs = nowMs;
+        m_pendingIndices.push_back(contactIndex);
+    }
+
+    // Latest report inside the window wins
+    slot.pending.isOnline = isOnline;
+    slot.pending.status = status;
+}
+
+size_t PresenceEngine::Flush(uint64_t nowMs, std::vector<PresenceDelta>& deltas)
+{
+    size_t added = 0;
+    size_t kept = 0;
+
+    for (size_t i = 0; i < m_pendingIndices.size(); i++)
+    {
+        int contactIndex = m_pendingIndices[i];
+        Slot& slot = m_slots[contactIndex];
+
+        // The window is measured from the first report, so a contact that keeps
+        // flapping still gets committed once per window instead of never
+        if (nowMs - slot.firstUpdateMs < m_coalesceWindowMs)
+        {
+            m_pendingIndices[kept++] = contactIndex;
+            continue;
+        }
+
+        slot.isPending = false;
+
+        uint8_t changed = 0;
+        if (slot.pending.isOnline != slot.committed.isOnline)
+            changed |= PRESENCE_FIELD_ONLINE;
+        if (slot.pending.status != slot.committed.status)
+            changed |= PRESENCE_FIELD_STATUS;
+
+        if (changed == 0)
+            continue;   // flapped back to where it started
+
+        slot.committed = slot.pending;
+
+        PresenceDelta delta;
+        delta.contactIndex = contactIndex;
+        delta.changedFields = changed;
+        delta.isOnline = slot.committed.isOnline;
+        if (changed & PRESENCE_FIELD_STATUS)
+            delta.status = slot.committed.status;
+        deltas.push_back(std::move(delta));
+        added++;
+    }
+
+    m_pendingIndices.resize(kept);
+    return added;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Bits in PresenceDelta::changedFields
+enum PresenceField : uint8_t
+{
+    PRESENCE_FIELD_ONLINE = 1u << 0,
+    PRESENCE_FIELD_STATUS = 1u << 1
+};
+
+// A committed presence change for one contact
+struct PresenceDelta
+{
+    int contactIndex;
+    uint8_t changedFields;
+    bool isOnline;
+    std::wstring status;
+};
+
+// Coalesces presence churn into compact deltas.
+//
+// Updates are buffered per contact for a short window. Repeated updates inside
+// the window overwrite each other, and a contact that flaps back to its committed
+// state produces no delta at all. Flush() emits at most one delta per contact,
+// listing only the fields that actually changed.
+class PresenceEngine
+{
+public:
+    explicit PresenceEngine(uint32_t coalesceWindowMs = 250);
+
+    // Start tracking 'contactCount' contacts; call Track for each committed state
+    void Reset(size_t contactCount);
+    void Track(int contactIndex, bool isOnline, const std::wstring& status);
+
+    // Record a presence report received at 'nowMs'
+    void Update(int contactIndex, bool isOnline, const std::wstring& status, uint64_t nowMs);
+
+    // Append deltas for contacts whose window has elapsed by 'nowMs'. Returns how many were added.
+    size_t Flush(uint64_t nowMs, std::vector<PresenceDelta>& deltas);
+
+    bool HasPending() const { return !m_pendingIndices.empty(); }
+    uint32_t CoalesceWindowMs() const { return m_coalesceWindowMs; }
+
+private:
+    struct PresenceState
+    {
+        bool isOnline;
+        std::wstring status;
+    };
+
+    struct Slot
+    {
+        PresenceState committed;
+        PresenceState pending;
+        uint64_t firstUpdateMs;     // start of the coalescing window
+        bool isPending;
+    };
+
+    bool IsValidIndex(int contactIndex) const { return contactIndex >= 0 && contactIndex < (int)m_slots.size(); }
+
+    uint32_t m_coalesceWindowMs;
+    std::vector<Slot> m_slots;
+    std::vector<int> m_pendingIndices;
+};
@@ -0,0 +1,295 @@
+#include "ProcessIdentityCache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <tlhelp32.h>
+#include <appmodel.h>
+#else
+#include <cerrno>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#endif
+
+ProcessIdentityCache::ProcessIdentityCache(std::unique_ptr<ProcessIdentitySource> source, std::chrono::milliseconds maxAge)
+    : m_source(std::move(source))
+    , m_maxAge(maxAge)
+    , m_familyResolved(false)
+    , m_listed(false)
+    , m_refreshes(0)
+    , m_queries(0)
+{
+}
+
+std::wstring ProcessIdentityCache::CurrentFamily()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ResolveCurrentFamily();
+    return m_currentFamily;
+}
+
+bool ProcessIdentityCache::IsInCurrentFamily(uint32_t pid)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ResolveCurrentFamily();
+    if (m_currentFamily.empty())
+        return false;
+
+    // A PID missing from a fresh listing may simply have started since
+    auto found = m_entries.find(pid);
+    if (found == m_entries.end() || IsStale(Clock::now()))
+    {
+        RefreshLocked();
+        found = m_entries.find(pid);
+    }
+    return found != m_entries.end() && InCurrentFamily(found->second);
+}
+
+std::vector<uint32_t> ProcessIdentityCache::ProcessesInCurrentFamily()
+{
+    std::vector<uint32_t> pids;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ResolveCurrentFamily();
+    if (m_currentFamily.empty())
+        return pids;
+
+    RefreshLocked();
+    for (const auto& entry : m_entries)
+    {
+        if (InCurrentFamily(entry.second))
+            pids.push_back(entry.first);
+    }
+    return pids;
+}
+
+void ProcessIdentityCache::Refresh()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    RefreshLocked();
+}
+
+ProcessIdentityCache::Stats ProcessIdentityCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return Stats{ m_refreshes, m_queries, m_entries.size() };
+}
+
+bool ProcessIdentityCache::InCurrentFamily(const Entry& entry) const
+{
+    return entry.identity == ProcessIdentitySource::Identity::Packaged && entry.family == m_currentFamily;
+}
+
+void ProcessIdentityCache::ResolveCurrentFamily()
+{
+    if (m_familyResolved)
+        return;
+
+    if (!m_source->CurrentFamily(m_currentFamily))
+        m_currentFamily.clear();
+    m_familyResolved = true;
+}
+
+bool ProcessIdentityCache::IsStale(Clock::time_point now) const
+{
+    return !m_listed || now - m_listedAt >= m_maxAge;
+}
+
+void ProcessIdentityCache::RefreshLocked()
+{
+    std::vector<ProcessIdentitySource::ProcessEntry> processes;
+    if (!m_source->ListProcesses(processes))
+        return;
+
+    uint64_t refresh = ++m_refreshes;
+    for (const auto& process : processes)
+    {
+        auto found = m_entries.find(process.pid);
+        if (found != m_entries.end() && found->second.instance == process.instance)
+        {
+            found->second.seen = refresh;
+            continue;
+        }
+
+        Entry entry;
+        entry.instance = process.instance;
+        entry.identity = m_source->QueryFamily(process.pid, entry.family);
+        entry.seen = refresh;
+        m_queries++;
+        m_entries[process.pid] = std::move(entry);
+    }
+
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        if (it->second.seen != refresh)
+            it = m_entries.erase(it);
+        else
+            ++it;
+    }
+
+    m_listedAt = Clock::now();
+    m_listed = true;
+}
+
+#ifdef _WIN32
+
+class WindowsProcessIdentitySource : public ProcessIdentitySource
+{
+public:
+    bool CurrentFamily(std::wstring& family) override
+    {
+        wchar_t name[PACKAGE_FAMILY_NAME_MAX_LENGTH + 1];
+        UINT32 length = ARRAYSIZE(name);
+        if (GetCurrentPackageFamilyName(&length, name) != ERROR_SUCCESS)
+            return false;
+        family.assign(name, length > 0 ? length - 1 : 0);
+        return true;
+    }
+
+    bool ListProcesses(std::vector<ProcessEntry>& processes) override
+    {
+        HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+        if (snapshot == INVALID_HANDLE_VALUE)
+            return false;
+
+        PROCESSENTRY32W entry = {};
+        entry.dwSize = sizeof(entry);
+        if (Process32FirstW(snapshot, &entry))
+        {
+            do
+            {
+                processes.push_back(ProcessEntry{ entry.th32ProcessID, Fingerprint(entry) });
+            } while (Process32NextW(snapshot, &entry));
+        }
+
+        CloseHandle(snapshot);
+        return true;
+    }
+
+    Identity QueryFamily(uint32_t pid, std::wstring& family) override
+    {
+        HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+        if (!process)
+            return Identity::Inaccessible;
+
+        // Family names have a fixed maximum length, so one call is enough
+        wchar_t name[PACKAGE_FAMILY_NAME_MAX_LENGTH + 1];
+        UINT32 length = ARRAYSIZE(name);
+        LONG result = GetPackageFamilyName(process, &length, name);
+        CloseHandle(process);
+
+        if (result == APPMODEL_ERROR_NO_PACKAGE)
+            return Identity::Unpackaged;
+        if (result != ERROR_SUCCESS)
+            return Identity::Inaccessible;
+
+        family.assign(name, length > 0 ? length - 1 : 0);
+        return Identity::Packaged;
+    }
+
+private:
+    // A reused PID almost always comes with another parent or image
+    static uint64_t Fingerprint(const PROCESSENTRY32W& entry)
+    {
+        uint32_t hash = 2166136261u;
+        for (const wchar_t* c = entry.szExeFile; *c; c++)
+        {
+            hash = (hash ^ (uint32_t)*c) * 16777619u;
+        }
+        return ((uint64_t)entry.th32ParentProcessID << 32) | hash;
+    }
+};
+
+std::unique_ptr<ProcessIdentitySource> CreateProcessIdentitySource()
+{
+    return std::make_unique<WindowsProcessIdentitySource>();
+}
+
+#else
+
+class ProcProcessIdentitySource : public ProcessIdentitySource
+{
+public:
+    bool CurrentFamily(std::wstring& family) override
+    {
+        return ExecutableDirectory("/proc/self/exe", family);
+    }
+
+    bool ListProcesses(std::vector<ProcessEntry>& processes) override
+    {
+        DIR* proc = opendir("/proc");
+        if (!proc)
+            return false;
+
+        while (dirent* entry = readdir(proc))
+        {
+            char* end;
+            unsigned long pid = strtoul(entry->d_name, &end, 10);
+            if (*end != '\0' || pid == 0)
+                continue;
+
+            uint64_t startTime;
+            if (StartTime((uint32_t)pid, startTime))
+                processes.push_back(ProcessEntry{ (uint32_t)pid, startTime });
+        }
+
+        closedir(proc);
+        return true;
+    }
+
+    Identity QueryFamily(uint32_t pid, std::wstring& family) override
+    {
+        std::string exe = "/proc/" + std::to_string(pid) + "/exe";
+        if (ExecutableDirectory(exe.c_str(), family))
+            return Identity::Packaged;
+
+        // Kernel threads have no executable; anything else we may not look at
+        return errno == ENOENT ? Identity::Unpackaged : Identity::Inaccessible;
+    }
+
+private:
+    static bool ExecutableDirectory(const char* link, std::wstring& directory)
+    {
+        char path[4096];
+        ssize_t length = readlink(link, path, sizeof(path) - 1);
+        if (length <= 0)
+            return false;
+
+        std::string target(path, (size_t)length);
+        size_t slash = target.rfind('/');
+        target.resize(slash == std::string::npos ? 0 : slash);
+        directory.assign(target.begin(), target.end());
+        return true;
+    }
+
+    // Field 22 of /proc/<pid>/stat, in clock ticks since boot
+    static bool StartTime(uint32_t pid, uint64_t& startTime)
+    {
+        std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+        std::string line;
+        if (!std::getline(stat, line))
+            return false;
+
+        // The command name may hold spaces and parentheses, so count from the last ')'
+        size_t close = line.rfind(')');
+        if (close == std::string::npos)
+            return false;
+
+        std::istringstream fields(line.substr(close + 1));
+        std::string skipped;
+        for (int field = 3; field < 22; field++)
+        {
+            fields >> skipped;
+        }
+        return static_cast<bool>(fields >> startTime);
+    }
+};
+
+std::unique_ptr<ProcessIdentitySource> CreateProcessIdentitySource()
+{
+    return std::make_unique<ProcProcessIdentitySource>();
+}
+
+#endif
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Where ProcessIdentityCache learns about processes; one implementation per
+// platform, made by CreateProcessIdentitySource.
+class ProcessIdentitySource
+{
+public:
+    struct ProcessEntry
+    {
+        uint32_t pid;
+        uint64_t instance;      // differs when a PID is reused; see CreateProcessIdentitySource
+    };
+
+    enum class Identity
+    {
+        Packaged,
+        Unpackaged,
+        Inaccessible,           // gone, or not ours to look at
+    };
+
+    virtual ~ProcessIdentitySource() = default;
+
+    // The calling process's package family; false if it has none
+    virtual bool CurrentFamily(std::wstring& family) = 0;
+
+    // Every running process, without opening any of them where the platform allows
+    virtual bool ListProcesses(std::vector<ProcessEntry>& processes) = 0;
+
+    // family is set only for Packaged
+    virtual Identity QueryFamily(uint32_t pid, std::wstring& family) = 0;
+};
+
+// On Windows a Toolhelp snapshot, with the parent PID and image name standing
+// in for the start time (which would take opening every process to read), and
+// GetPackageFamilyName for the family. Elsewhere /proc, with the start time
+// from /proc/<pid>/stat and the directory of the executable as the family.
+std::unique_ptr<ProcessIdentitySource> CreateProcessIdentitySource();
+
+// Package family of every process, so finding the processes of our own
+// package does not ask the system about each one every time.
+//
+// The caller's own family is resolved once. Each refresh lists the processes
+// and asks for the family only of those that are new or whose PID now belongs
+// to a different instance; entries of processes that are gone are dropped.
+// Processes without a package, or that cannot be opened, are remembered as
+// such and not asked about again while they run.
+class ProcessIdentityCache
+{
+public:
+    struct Stats
+    {
+        uint64_t refreshes;
+        uint64_t queries;       // families asked of the source
+        size_t entries;
+    };
+
+    // A listing younger than maxAge is trusted for single-process lookups
+    explicit ProcessIdentityCache(std::unique_ptr<ProcessIdentitySource> source,
+        std::chrono::milliseconds maxAge = std::chrono::milliseconds(1000));
+
+    ProcessIdentityCache(const ProcessIdentityCache&) = delete;
+    ProcessIdentityCache& operator=(const ProcessIdentityCache&) = delete;
+
+    // Empty if the calling process has no package
+    std::wstring CurrentFamily();
+
+    bool IsInCurrentFamily(uint32_t pid);
+    std::vector<uint32_t> ProcessesInCurrentFamily();
+
+    // Lists the processes now, however recent the last listing is
+    void Refresh();
+
+    Stats GetStats() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry
+    {
+        uint64_t instance;
+        ProcessIdentitySource::Identity identity;
+        std::wstring family;
+        uint64_t seen;          // refresh that last listed it
+    };
+
+    bool InCurrentFamily(const Entry& entry) const;
+
+    void ResolveCurrentFamily();
+    void RefreshLocked();
+    bool IsStale(Clock::time_point now) const;
+
+    std::unique_ptr<ProcessIdentitySource> m_source;
+    std::chrono::milliseconds m_maxAge;
+
+    mutable std::mutex m_mutex;
+    bool m_familyResolved;
+    std::wstring m_currentFamily;
+    std::unordered_map<uint32_t, Entry> m_entries;
+    Clock::time_point m_listedAt;
+    bool m_listed;
+    uint64_t m_refreshes;
+    uint64_t m_queries;
+};
@@ -10,6 +10,7 @@
 #define IDD_CONTACT_SELECTION   104
 #define IDM_ABOUT				105
 #define IDM_EXIT				106
+#define IDM_SHARE_FOLDER		32771
 #define IDI_SAMPLECHATAPPWITHSHARE			107
 #define IDI_SMALL				108
 #define IDC_SAMPLECHATAPPWITHSHARE			109
@@ -41,7 +42,7 @@
 
 #define _APS_NO_MFC					130
 #define _APS_NEXT_RESOURCE_VALUE	129
-#define _APS_NEXT_COMMAND_VALUE		32771
+#define _APS_NEXT_COMMAND_VALUE		32772
 #define _APS_NEXT_CONTROL_VALUE		1013
 #define _APS_NEXT_SYMED_VALUE		110
 #endif
@@ -0,0 +1,108 @@
+#include "RowCache.h"
+
+static const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+static const uint64_t FNV_PRIME = 0x100000001b3ull;
+
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t length)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t HashString(uint64_t hash, const std::wstring& text)
+{
+    // Length first, so "ab"+"c" and "a"+"bc" hash differently
+    uint32_t length = (uint32_t)text.size();
+    hash = HashBytes(hash, &length, sizeof(length));
+    return HashBytes(hash, text.data(), text.size() * sizeof(wchar_t));
+}
+
+uint64_t HashContactRow(const std::wstring& name, const std::wstring& status, const std::wstring& preview,
+    bool isSelected, bool isOnline, int width, int height)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hash = HashString(hash, name);
+    hash = HashString(hash, status);
+    hash = HashString(hash, preview);
+
+    int32_t geometry[2] = { width, height };
+    uint8_t flags = (uint8_t)((isSelected ? 1 : 0) | (isOnline ? 2 : 0));
+    hash = HashBytes(hash, geometry, sizeof(geometry));
+    return HashBytes(hash, &flags, sizeof(flags));
+}
+
+RowCache::RowCache(size_t byteBudget, ReleaseFunction release)
+    : m_release(std::move(release)), m_byteBudget(byteBudget)
+{
+}
+
+RowCache::~RowCache()
+{
+    Clear();
+}
+
+void* RowCache::Find(uint64_t key)
+{
+    auto it = m_index.find(key);
+    if (it == m_index.end())
+    {
+        m_misses++;
+        return nullptr;
+    }
+
+    m_hits++;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->image;
+}
+
+void RowCache::Insert(uint64_t key, void* image, size_t bytes)
+{
+    auto it = m_index.find(key);
+    if (it != m_index.end())
+    {
+        // Same content rendered again; keep the newer image
+        m_bytes -= it->second->bytes;
+        if (m_release && it->second->image != image)
+            m_release(it->second->image);
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+
+    m_lru.push_front(Entry{ key, image, bytes });
+    m_index[key] = m_lru.begin();
+    m_bytes += bytes;
+
+    EvictToBudget();
+}
+
+void RowCache::Clear()
+{
+    if (m_release)
+    {
+        for (auto& entry : m_lru)
+        {
+            m_release(entry.image);
+        }
+    }
+    m_lru.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+void RowCache::EvictToBudget()
+{
+    while (m_bytes > m_byteBudget && m_lru.size() > 1)
+    {
+        Entry& victim = m_lru.back();
+        m_bytes -= victim.bytes;
+        if (m_release)
+            m_release(victim.image);
+        m_index.erase(victim.key);
+        m_lru.pop_back();
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+// Content hash of everything that affects how a contact row looks.
+// Two rows with the same hash render to identical pixels.
+uint64_t HashContactRow(const std::wstring& name, const std::wstring& status, const std::wstring& preview,
+    bool isSelected, bool isOnline, int width, int height);
+
+// LRU cache of pre-rendered rows under a byte budget.
+//
+// Images are opaque to the cache; whoever inserts them supplies their size and a
+// release function that runs when an entry is evicted or the cache is cleared.
+class RowCache
+{
+public:
+    typedef std::function<void(void* image)> ReleaseFunction;
+
+    RowCache(size_t byteBudget, ReleaseFunction release);
+    ~RowCache();
+
+    RowCache(const RowCache&) = delete;
+    RowCache& operator=(const RowCache&) = delete;
+
+    // Cached image for 'key', or nullptr. A hit makes the entry most recently used.
+    void* Find(uint64_t key);
+
+    // Take ownership of 'image' and evict least recently used entries until the
+    // cache fits its budget again. The new entry itself is never evicted, so an
+    // image larger than the whole budget still survives until the next insert.
+    void Insert(uint64_t key, void* image, size_t bytes);
+
+    void Clear();
+
+    size_t Count() const { return m_index.size(); }
+    size_t Bytes() const { return m_bytes; }
+    size_t ByteBudget() const { return m_byteBudget; }
+    uint64_t Hits() const { return m_hits; }
+    uint64_t Misses() const { return m_misses; }
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        void* image;
+        size_t bytes;
+    };
+
+    void EvictToBudget();
+
+    std::list<Entry> m_lru;     // front = most recently used
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+    ReleaseFunction m_release;
+    size_t m_byteBudget;
+    size_t m_bytes = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+};
@@ -48,6 +48,24 @@ BOOL                InitInstance(HINSTANCE, int);
 LRESULT CALLBACK    WndProc(HWND, UINT, WPARAM, LPARAM);
 INT_PTR CALLBACK    About(HWND, UINT, WPARAM, LPARAM);
 
+// Cached replies to GET_CONTACTS are dropped as soon as the contact list
+// changes; the time to live only bounds how long an idle one is kept
+static const std::chrono::milliseconds CONTACTS_CACHE_TTL(60000);
+
+// GET_CONTACTS answers with one "name\tstatus\tonline|offline" line per contact
+static void RegisterContactsRequest(HelloWorldService& service)
+{
+    service.Handlers().Register(CONTACTS_REQUEST, [](const std::string&, std::string& response) {
+        std::shared_ptr<const ContactSnapshot> snapshot = AcquireContactSnapshot();
+        std::wstring text;
+        for (const auto& view : snapshot->contacts) {
+            text += view->name + L"\t" + view->status + (view->isOnline ? L"\tonline\n" : L"\toffline\n");
+        }
+        response = winrt::to_string(text);
+    });
+    service.Cache().SetPolicy(CONTACTS_REQUEST, CONTACTS_CACHE_TTL, SERVICE_TOPIC_CONTACTS);
+}
+
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                      _In_opt_ HINSTANCE hPrevInstance,
                      _In_ LPWSTR    lpCmdLine,
@@ -120,8 +138,8 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     }
     else if (g_isRunningWithIdentity)
     {
-        HelloWorldService service;
-
+        // The service declared above keeps running until wWinMain returns
+        RegisterContactsRequest(service);
         if (!service.Start()) {
             return 1;
         }
@@ -256,6 +274,9 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
    ShowWindow(hWnd, nCmdShow);
    UpdateWindow(hWnd);
 
+   // A share waiting on us can hand its content over from here on
+   AnnounceChatAppReady();
+
    return TRUE;
 }
 
@@ -270,6 +291,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     {
     case WM_CREATE:
         CreateChatUI(hWnd);
+        InitializeChatEventBus(hWnd);
         
         // Process share target activation after UI is created
         if (g_isRunningWithIdentity)
@@ -306,6 +328,16 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             return (INT_PTR)hBrushSurface;
         }
         
+    case WM_DRAWITEM:
+        {
+            const DRAWITEMSTRUCT* drawItem = (const DRAWITEMSTRUCT*)lParam;
+            if (drawItem->CtlID == IDC_SHARED_FILES_LIST) {
+                DrawSharedFileItem(drawItem);
+                return TRUE;
+            }
+        }
+        break;
+        
     case WM_PAINT:
         {
             PAINTSTRUCT ps;
@@ -347,6 +379,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             case IDC_SHARE_FILE_BUTTON:
                 ShareFile();
                 break;
+            case IDM_SHARE_FOLDER:
+                ShareFolder();
+                break;
             case IDC_SHARED_FILES_LIST:
                 if (wmEvent == LBN_DBLCLK) {
                     int selectedFile = (int)::SendMessage(hSharedFilesList, LB_GETCURSEL, 0, 0);
@@ -377,7 +412,13 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         break;
         
     case WM_TIMER:
-        ProcessAutoReply(hWnd, (int)wParam);
+        if (wParam == IDT_CHAT_SCHEDULER) {
+            ProcessChatTimer(hWnd);
+        }
+        break;
+        
+    case WM_APP_CHAT_EVENTS:
+        DrainChatEvents();
         break;
         
     case WM_KEYDOWN:
@@ -393,6 +434,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         break;
         
     case WM_DESTROY:
+        ShutdownChatEventBus();
+        ShutdownSharedFilePipeline();
         CleanupModernUI();
         PostQuitMessage(0);
         break;
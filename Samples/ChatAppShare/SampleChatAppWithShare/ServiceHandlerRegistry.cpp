@@ -0,0 +1,35 @@
+#include "ServiceHandlerRegistry.h"
+#include <mutex>
+
+void ServiceHandlerRegistry::Register(const std::string& verb, Handler handler)
+{
+    auto shared = std::make_shared<const Handler>(std::move(handler));
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_handlers[verb] = std::move(shared);
+}
+
+void ServiceHandlerRegistry::Unregister(const std::string& verb)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_handlers.erase(verb);
+}
+
+bool ServiceHandlerRegistry::Dispatch(const std::string& request, std::string& response) const
+{
+    size_t space = request.find(' ');
+    std::string verb = request.substr(0, space);
+
+    std::shared_ptr<const Handler> handler;
+    {
+        // Only the lookup is under the lock, so a slow handler never holds up Register
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto found = m_handlers.find(verb);
+        if (found == m_handlers.end())
+            return false;
+        handler = found->second;
+    }
+
+    std::string argument = space == std::string::npos ? std::string() : request.substr(space + 1);
+    (*handler)(argument, response);
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// Request handlers of the background service, by verb.
+//
+// A request is its verb, optionally followed by a space and an argument, and
+// the handler is given the argument. Handlers may be added or removed while
+// the service runs; they are called on the service's worker threads, any
+// number at once, and a handler being removed may still finish a call that
+// was already under way.
+class ServiceHandlerRegistry
+{
+public:
+    typedef std::function<void(const std::string& argument, std::string& response)> Handler;
+
+    void Register(const std::string& verb, Handler handler);
+    void Unregister(const std::string& verb);
+
+    // False if no handler takes the request's verb; response is left alone
+    bool Dispatch(const std::string& request, std::string& response) const;
+
+private:
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, std::shared_ptr<const Handler>> m_handlers;
+};
@@ -0,0 +1,68 @@
+#include "ServiceMetrics.h"
+
+LatencyHistogram::LatencyHistogram()
+{
+    for (auto& count : m_counts)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::Record(uint64_t microseconds)
+{
+    size_t bucket = 0;
+    while (microseconds != 0 && bucket < BUCKET_COUNT - 1)
+    {
+        microseconds >>= 1;
+        bucket++;
+    }
+    m_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Snapshot(Counts& counts) const
+{
+    for (size_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        counts[i] = m_counts[i].load(std::memory_order_relaxed);
+    }
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t bucket)
+{
+    return bucket == 0 ? 0 : ((uint64_t)1 << bucket) - 1;
+}
+
+uint64_t LatencyHistogram::Percentile(const Counts& counts, double fraction)
+{
+    uint64_t total = 0;
+    for (uint64_t count : counts)
+    {
+        total += count;
+    }
+    if (total == 0)
+        return 0;
+
+    uint64_t rank = (uint64_t)(fraction * (double)total);
+    if (rank >= total)
+        rank = total - 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        seen += counts[i];
+        if (seen > rank)
+            return BucketUpperBound(i);
+    }
+    return BucketUpperBound(BUCKET_COUNT - 1);
+}
+
+std::string FormatServiceMetrics(const ServiceMetrics& metrics)
+{
+    return "queued=" + std::to_string(metrics.queueDepth) +
+        " inflight=" + std::to_string(metrics.inFlight) +
+        " completed=" + std::to_string(metrics.completed) +
+        " rejected=" + std::to_string(metrics.rejected) +
+        " p50<=" + std::to_string(LatencyHistogram::Percentile(metrics.latency, 0.50)) + "us" +
+        " p99<=" + std::to_string(LatencyHistogram::Percentile(metrics.latency, 0.99)) + "us" +
+        " max<=" + std::to_string(LatencyHistogram::Percentile(metrics.latency, 1.0)) + "us";
+}
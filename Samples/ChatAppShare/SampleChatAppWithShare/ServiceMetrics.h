@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Latency histogram with power-of-two buckets of microseconds: bucket 0 holds
+// zero, bucket i holds [2^(i-1), 2^i). Recording is one relaxed increment, so
+// any number of threads can share one without a lock.
+class LatencyHistogram
+{
+public:
+    static const size_t BUCKET_COUNT = 40;
+    typedef std::array<uint64_t, BUCKET_COUNT> Counts;
+
+    LatencyHistogram();
+
+    void Record(uint64_t microseconds);
+    void Snapshot(Counts& counts) const;
+
+    static uint64_t BucketUpperBound(size_t bucket);
+
+    // Upper bound of the bucket the given fraction (0..1) of samples falls under
+    static uint64_t Percentile(const Counts& counts, double fraction);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_counts;
+};
+
+// What a ServiceServer reports about its request dispatch
+struct ServiceMetrics
+{
+    size_t queueDepth;      // requests waiting for a worker
+    size_t inFlight;        // requests a handler is working on
+    uint64_t completed;
+    uint64_t rejected;      // turned away because the queue was full
+    LatencyHistogram::Counts latency;   // receipt to reply, microseconds
+};
+
+// One line for logs and the metrics request: counters and p50/p99/max latency
+std::string FormatServiceMetrics(const ServiceMetrics& metrics);
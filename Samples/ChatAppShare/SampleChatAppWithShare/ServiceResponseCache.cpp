@@ -0,0 +1,203 @@
+#include "ServiceResponseCache.h"
+#include <exception>
+
+// Generations of every topic in the process, shared by all caches
+static std::mutex s_topicsMutex;
+static std::unordered_map<std::string, std::shared_ptr<std::atomic<uint64_t>>> s_topics;
+
+ServiceResponseCache::ServiceResponseCache(size_t maxEntries)
+    : m_maxEntries(maxEntries > 0 ? maxEntries : 1), m_clearGeneration(0), m_hits(0), m_misses(0), m_coalesced(0)
+{
+}
+
+std::shared_ptr<std::atomic<uint64_t>> ServiceResponseCache::TopicGeneration(const std::string& topic)
+{
+    std::lock_guard<std::mutex> lock(s_topicsMutex);
+    auto& generation = s_topics[topic];
+    if (!generation)
+        generation = std::make_shared<std::atomic<uint64_t>>(0);
+    return generation;
+}
+
+void ServiceResponseCache::InvalidateTopic(const std::string& topic)
+{
+    TopicGeneration(topic)->fetch_add(1, std::memory_order_release);
+}
+
+void ServiceResponseCache::SetPolicy(const std::string& verb, std::chrono::milliseconds ttl, const std::string& topic)
+{
+    Policy policy{ ttl, topic.empty() ? nullptr : TopicGeneration(topic) };
+    std::unique_lock<std::shared_mutex> lock(m_policiesMutex);
+    m_policies[verb] = std::move(policy);
+}
+
+void ServiceResponseCache::ClearPolicy(const std::string& verb)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(m_policiesMutex);
+        m_policies.erase(verb);
+    }
+    Clear();
+}
+
+bool ServiceResponseCache::IsFresh(const Entry& entry, uint64_t topicGeneration, Clock::time_point now) const
+{
+    return entry.response && now < entry.expires &&
+        entry.topicGeneration == topicGeneration && entry.clearGeneration == m_clearGeneration;
+}
+
+void ServiceResponseCache::Get(const std::string& request, std::string& response, const Compute& compute)
+{
+    Policy policy;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_policiesMutex);
+        auto found = m_policies.find(request.substr(0, request.find(' ')));
+        if (found == m_policies.end())
+        {
+            lock.unlock();
+            compute(response);
+            return;
+        }
+        policy = found->second;
+    }
+
+    std::shared_ptr<Flight> flight;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            uint64_t topicGeneration = policy.topicGeneration ? policy.topicGeneration->load(std::memory_order_acquire) : 0;
+            Clock::time_point now = Clock::now();
+
+            auto found = m_entries.find(request);
+            if (found == m_entries.end())
+            {
+                if (m_entries.size() >= m_maxEntries)
+                    MakeRoom(now);
+                found = m_entries.emplace(request, Entry()).first;
+            }
+            Entry& entry = found->second;
+
+            if (IsFresh(entry, topicGeneration, now))
+            {
+                m_hits++;
+                response = *entry.response;
+                return;
+            }
+
+            // Join a computation of the same data, not one started before it changed
+            if (entry.flight && entry.topicGeneration == topicGeneration && entry.clearGeneration == m_clearGeneration)
+            {
+                std::shared_ptr<Flight> joined = entry.flight;
+                m_coalesced++;
+                m_flightLanded.wait(lock, [&joined]() { return joined->done; });
+                if (joined->response)
+                {
+                    response = *joined->response;
+                    return;
+                }
+                continue;   // it threw; try again, most likely as the one computing
+            }
+
+            flight = std::make_shared<Flight>();
+            entry.flight = flight;
+            entry.response.reset();
+            entry.topicGeneration = topicGeneration;
+            entry.clearGeneration = m_clearGeneration;
+            m_misses++;
+            break;
+        }
+    }
+
+    // The reply is tagged with the generation read before computing, so if the
+    // topic is invalidated meanwhile it is already stale when it is stored
+    std::shared_ptr<const std::string> result;
+    std::exception_ptr failure;
+    try
+    {
+        compute(response);
+        result = std::make_shared<const std::string>(response);
+    }
+    catch (...)
+    {
+        // Waiters wake to a null result and retry; nothing is stored
+        failure = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        flight->done = true;
+        flight->response = result;
+
+        // A newer computation or a Clear may have replaced this one meanwhile
+        auto found = m_entries.find(request);
+        if (found != m_entries.end() && found->second.flight == flight)
+        {
+            Entry& entry = found->second;
+            entry.flight.reset();
+            if (result && policy.ttl.count() > 0)
+            {
+                entry.response = result;
+                entry.expires = Clock::now() + policy.ttl;
+            }
+            else
+            {
+                m_entries.erase(found);
+            }
+        }
+    }
+    m_flightLanded.notify_all();
+
+    if (failure)
+        std::rethrow_exception(failure);
+}
+
+void ServiceResponseCache::MakeRoom(Clock::time_point now)
+{
+    // Drop what has expired, and if that is not enough the entry closest to expiring
+    auto soonest = m_entries.end();
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        if (it->second.flight)
+        {
+            ++it;
+        }
+        else if (!(now < it->second.expires) || it->second.clearGeneration != m_clearGeneration)
+        {
+            it = m_entries.erase(it);
+        }
+        else
+        {
+            if (soonest == m_entries.end() || it->second.expires < soonest->second.expires)
+                soonest = it;
+            ++it;
+        }
+    }
+
+    if (m_entries.size() >= m_maxEntries && soonest != m_entries.end())
+        m_entries.erase(soonest);
+}
+
+void ServiceResponseCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_clearGeneration++;
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        if (it->second.flight)
+        {
+            it->second.response.reset();
+            ++it;
+        }
+        else
+        {
+            it = m_entries.erase(it);
+        }
+    }
+}
+
+ServiceResponseCache::Stats ServiceResponseCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return Stats{ m_hits, m_misses, m_coalesced, m_entries.size() };
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// Replies of the background service, cached by the whole request (verb and
+// argument) for the verbs that have a policy.
+//
+// A policy gives a verb a time to live and, optionally, the topic of data its
+// replies are built from. Invalidating a topic drops every reply built from
+// it; that costs a lookup and an atomic increment, so the chat model can do it
+// on every change from the UI thread. Identical requests that miss at the
+// same time share one computation: the first caller runs it and the rest wait
+// for its result. Verbs without a policy go straight to the handler.
+class ServiceResponseCache
+{
+public:
+    typedef std::function<void(std::string& response)> Compute;
+
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t coalesced;     // waited for an identical request already being computed
+        size_t entries;
+    };
+
+    explicit ServiceResponseCache(size_t maxEntries = 1024);
+
+    ServiceResponseCache(const ServiceResponseCache&) = delete;
+    ServiceResponseCache& operator=(const ServiceResponseCache&) = delete;
+
+    // A zero ttl still coalesces concurrent requests but keeps nothing afterwards
+    void SetPolicy(const std::string& verb, std::chrono::milliseconds ttl, const std::string& topic = std::string());
+    void ClearPolicy(const std::string& verb);
+
+    // The cached reply to request, or the one compute produces
+    void Get(const std::string& request, std::string& response, const Compute& compute);
+
+    // Replies built from topic are stale from now on, in every cache in the process
+    static void InvalidateTopic(const std::string& topic);
+
+    void Clear();
+    Stats GetStats() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Policy
+    {
+        std::chrono::milliseconds ttl;
+        std::shared_ptr<std::atomic<uint64_t>> topicGeneration;     // null if no topic
+    };
+
+    // One computation in progress; callers of the same request wait on it
+    struct Flight
+    {
+        bool done = false;
+        std::shared_ptr<const std::string> response;
+    };
+
+    struct Entry
+    {
+        std::shared_ptr<const std::string> response;    // null while the first flight is running
+        Clock::time_point expires;
+        uint64_t topicGeneration;
+        uint64_t clearGeneration;
+        std::shared_ptr<Flight> flight;                 // set while a computation is running
+    };
+
+    bool IsFresh(const Entry& entry, uint64_t topicGeneration, Clock::time_point now) const;
+    void MakeRoom(Clock::time_point now);
+
+    static std::shared_ptr<std::atomic<uint64_t>> TopicGeneration(const std::string& topic);
+
+    size_t m_maxEntries;
+
+    mutable std::shared_mutex m_policiesMutex;
+    std::unordered_map<std::string, Policy> m_policies;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_flightLanded;
+    std::unordered_map<std::string, Entry> m_entries;
+    uint64_t m_clearGeneration;
+    uint64_t m_hits;
+    uint64_t m_misses;
+    uint64_t m_coalesced;
+};
@@ -0,0 +1,817 @@
+#include "ServiceServer.h"
+#include <chrono>
+#include <cstring>
+#include <deque>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+ServiceServer::ServiceServer(const std::string& endpoint, ServiceRequestHandler handler)
+    : m_endpoint(endpoint), m_handler(std::move(handler)), m_state(ServiceState::Stopped),
+    m_queued(0), m_inFlight(0), m_completed(0), m_rejected(0),
+#ifdef _WIN32
+    m_completionPort(nullptr), m_pendingIo(0)
+#else
+    m_epoll(-1), m_listener(-1), m_wakeEvent(-1), m_nextConnectionId(0)
+#endif
+{
+}
+
+ServiceServer::~ServiceServer()
+{
+    Stop();
+}
+
+static uint64_t NowMicroseconds()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ServiceServer::RunHandler(const std::string& request, std::string& response, uint64_t receivedAt)
+{
+    m_inFlight++;
+    m_handler(request, response);
+    m_inFlight--;
+    m_completed++;
+    m_latency.Record(NowMicroseconds() - receivedAt);
+}
+
+bool ServiceServer::SubmitRequest(WorkerPool::Job job)
+{
+    m_queued++;
+    bool accepted = m_workers->TrySubmit([this, job = std::move(job)]() {
+        m_queued--;
+        job();
+    });
+    if (!accepted)
+    {
+        m_queued--;
+        m_rejected++;
+    }
+    return accepted;
+}
+
+ServiceMetrics ServiceServer::GetMetrics() const
+{
+    ServiceMetrics metrics;
+    metrics.queueDepth = m_queued;
+    metrics.inFlight = m_inFlight;
+    metrics.completed = m_completed;
+    metrics.rejected = m_rejected;
+    m_latency.Snapshot(metrics.latency);
+    return metrics;
+}
+
+#ifdef _WIN32
+
+// One listening pipe instance. It has at most one operation in flight, so only
+// the thread that dequeued its last completion ever touches it.
+struct ServiceServer::PipeInstance
+{
+    enum class State { Connecting, Reading, Writing, Dispatching };
+
+    OVERLAPPED overlapped;
+    HANDLE pipe;
+    State state;
+    std::string message;                // transport message read so far
+    FrameDecoder decoder;
+    std::vector<FrameMessage> requests;
+    std::vector<EncodedFrame> frames;
+    std::deque<std::string> output;     // response frames, one per WriteFile
+    char buffer[4096];
+
+    // While Dispatching, workers append replies under this lock; the one that
+    // brings outstanding to zero hands the instance back to the I/O threads
+    std::mutex outputLock;
+    size_t outstanding = 0;
+    bool recycleAfterDispatch = false;  // the batch broke the protocol; drop the client once it is done
+};
+
+bool ServiceServer::Start(size_t instanceCount, size_t threadCount, size_t workerCount, size_t queueCapacity)
+{
+    ServiceState expected = ServiceState::Stopped;
+    if (!m_state.compare_exchange_strong(expected, ServiceState::Starting))
+        return false;
+    if (instanceCount == 0) instanceCount = 1;
+    if (threadCount == 0) threadCount = 1;
+
+    m_completionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, (DWORD)threadCount);
+    if (!m_completionPort)
+    {
+        m_state = ServiceState::Stopped;
+        return false;
+    }
+
+    for (size_t i = 0; i < instanceCount; i++)
+    {
+        // Only the first instance may create the pipe name, so nobody can squat on it
+        DWORD openMode = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (i == 0 ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+        HANDLE pipe = CreateNamedPipeA(m_endpoint.c_str(), openMode,
+            PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            PIPE_UNLIMITED_INSTANCES, 4096, 4096, 0, nullptr);
+        if (pipe == INVALID_HANDLE_VALUE)
+            break;
+
+        auto instance = std::make_unique<PipeInstance>();
+        instance->pipe = pipe;
+        if (!CreateIoCompletionPort(pipe, m_completionPort, 0, 0))
+        {
+            CloseHandle(pipe);
+            break;
+        }
+        m_instances.push_back(std::move(instance));
+    }
+
+    if (m_instances.empty())
+    {
+        CloseHandle(m_completionPort);
+        m_completionPort = nullptr;
+        m_state = ServiceState::Stopped;
+        return false;
+    }
+
+    if (workerCount > 0)
+        m_workers = std::make_unique<WorkerPool>(workerCount, queueCapacity);
+
+    m_state = ServiceState::Running;
+    for (size_t i = 0; i < threadCount; i++)
+    {
+        m_threads.emplace_back(&ServiceServer::CompletionLoop, this);
+    }
+    for (auto& instance : m_instances)
+    {
+        BeginConnect(*instance);
+    }
+    return true;
+}
+
+void ServiceServer::Stop()
+{
+    ServiceState expected = ServiceState::Running;
+    if (!m_state.compare_exchange_strong(expected, ServiceState::Stopping))
+        return;
+
+    // Cancel until every outstanding operation has come back through the port;
+    // an operation issued while stopping began is caught by the next pass
+    while (m_pendingIo > 0)
+    {
+        for (auto& instance : m_instances)
+        {
+            CancelIoEx(instance->pipe, nullptr);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    for (size_t i = 0; i < m_threads.size(); i++)
+    {
+        PostQueuedCompletionStatus(m_completionPort, 0, 0, nullptr);
+    }
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+    m_threads.clear();
+
+    // Only now that no I/O thread can submit more: requests already queued
+    // still run against their instances, and their hand-backs go to a port
+    // nobody reads any more
+    if (m_workers)
+    {
+        m_workers->Shutdown();
+        m_workers.reset();
+    }
+
+    for (auto& instance : m_instances)
+    {
+        CloseHandle(instance->pipe);
+    }
+    m_instances.clear();
+    CloseHandle(m_completionPort);
+    m_completionPort = nullptr;
+    m_state = ServiceState::Stopped;
+}
+
+void ServiceServer::CompletionLoop()
+{
+    while (true)
+    {
+        DWORD bytes = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* overlapped = nullptr;
+        BOOL succeeded = GetQueuedCompletionStatus(m_completionPort, &bytes, &key, &overlapped, INFINITE);
+        DWORD error = succeeded ? ERROR_SUCCESS : GetLastError();
+
+        // A packet without an OVERLAPPED is Stop telling this thread to exit
+        if (!overlapped)
+            return;
+
+        PipeInstance& instance = *CONTAINING_RECORD(overlapped, PipeInstance, overlapped);
+        OnCompletion(instance, succeeded != FALSE, error, bytes);
+        m_pendingIo--;
+    }
+}
+
+void ServiceServer::OnCompletion(PipeInstance& instance, bool succeeded, unsigned long error, unsigned long bytes)
+{
+    if (IsStopping())
+        return;
+
+    switch (instance.state)
+    {
+    case PipeInstance::State::Connecting:
+        if (succeeded)
+            BeginRead(instance);
+        else
+            Recycle(instance);
+        break;
+
+    case PipeInstance::State::Reading:
+        // A message larger than the buffer arrives in pieces, the last with success
+        if (succeeded || error == ERROR_MORE_DATA)
+            instance.message.append(instance.buffer, bytes);
+
+        if (instance.message.size() > MAX_MESSAGE_SIZE)
+        {
+            Recycle(instance);
+        }
+        else if (succeeded)
+        {
+            if (!OnMessage(instance))
+                Recycle(instance);
+            else if (instance.state == PipeInstance::State::Dispatching)
+                ;                       // the last worker to finish picks it up again
+            else if (!instance.output.empty())
+                BeginWrite(instance);
+            else
+                BeginRead(instance);    // the rest of a multi-frame request
+        }
+        else if (error == ERROR_MORE_DATA)
+        {
+            BeginRead(instance);
+        }
+        else
+        {
+            Recycle(instance);      // client went away
+        }
+        break;
+
+    case PipeInstance::State::Writing:
+        if (!succeeded)
+        {
+            Recycle(instance);
+            break;
+        }
+
+        BufferPool::Shared().Release(std::move(instance.output.front()));
+        instance.output.pop_front();
+
+        // Stay connected for the client's next request
+        if (!instance.output.empty())
+            BeginWrite(instance);
+        else
+            BeginRead(instance);
+        break;
+
+    case PipeInstance::State::Dispatching:
+        // Posted by the worker that finished the last request of a batch
+        if (instance.recycleAfterDispatch)
+            Recycle(instance);
+        else if (!instance.output.empty())
+            BeginWrite(instance);
+        else
+            BeginRead(instance);
+        break;
+    }
+}
+
+bool ServiceServer::OnMessage(PipeInstance& instance)
+{
+    bool accepted = instance.decoder.Feed(instance.message.data(), instance.message.size(), instance.requests);
+    instance.message.clear();
+
+    BufferPool& pool = BufferPool::Shared();
+    uint64_t receivedAt = NowMicroseconds();
+
+    // This thread holds one count until every request is handed out, so no
+    // worker can hand the instance back while the batch is still being queued
+    instance.outstanding = 1;
+    for (FrameMessage& request : instance.requests)
+    {
+        if (request.type != FrameType::Request)
+            accepted = false;
+
+        if (accepted && m_workers)
+        {
+            {
+                std::lock_guard<std::mutex> lock(instance.outputLock);
+                instance.outstanding++;
+            }
+            uint64_t requestId = request.requestId;
+            bool queued = SubmitRequest([this, &instance, requestId, receivedAt, payload = std::move(request.payload)]() mutable {
+                BufferPool& pool = BufferPool::Shared();
+                std::string response = pool.Acquire();
+                RunHandler(payload, response, receivedAt);
+                pool.Release(std::move(payload));
+
+                bool last;
+                {
+                    std::lock_guard<std::mutex> lock(instance.outputLock);
+                    QueueReply(instance, FrameType::Response, requestId, response);
+                    last = --instance.outstanding == 0;
+                }
+                pool.Release(std::move(response));
+
+                if (last)
+                {
+                    m_pendingIo++;
+                    PostQueuedCompletionStatus(m_completionPort, 0, 0, &instance.overlapped);
+                }
+            });
+            if (!queued)
+            {
+                std::lock_guard<std::mutex> lock(instance.outputLock);
+                instance.outstanding--;
+                QueueReply(instance, FrameType::Error, requestId, SERVICE_BUSY_RESPONSE);
+            }
+        }
+        else if (accepted)
+        {
+            std::string response = pool.Acquire();
+            RunHandler(request.payload, response, receivedAt);
+            QueueReply(instance, FrameType::Response, request.requestId, response);
+            pool.Release(std::move(response));
+        }
+        pool.Release(std::move(request.payload));
+    }
+    instance.requests.clear();
+
+    std::lock_guard<std::mutex> lock(instance.outputLock);
+    if (--instance.outstanding != 0)
+    {
+        instance.state = PipeInstance::State::Dispatching;
+        instance.recycleAfterDispatch = !accepted;
+        ZeroMemory(&instance.overlapped, sizeof(instance.overlapped));
+        return true;
+    }
+    return accepted;
+}
+
+void ServiceServer::QueueReply(PipeInstance& instance, FrameType type, uint64_t requestId, const std::string& payload)
+{
+    // Each frame becomes one pipe message
+    BufferPool& pool = BufferPool::Shared();
+    EncodeMessage(type, requestId, payload.size(), instance.frames);
+    for (const EncodedFrame& frame : instance.frames)
+    {
+        std::string bytes = pool.Acquire();
+        AppendFrame(frame, payload, bytes);
+        instance.output.push_back(std::move(bytes));
+    }
+}
+
+void ServiceServer::BeginConnect(PipeInstance& instance)
+{
+    instance.state = PipeInstance::State::Connecting;
+    instance.recycleAfterDispatch = false;
+    instance.message.clear();
+    instance.decoder.Reset();
+    instance.output.clear();
+    ZeroMemory(&instance.overlapped, sizeof(instance.overlapped));
+
+    m_pendingIo++;
+    if (!ConnectNamedPipe(instance.pipe, &instance.overlapped))
+    {
+        DWORD error = GetLastError();
+        if (error == ERROR_IO_PENDING)
+            return;
+
+        m_pendingIo--;
+        if (error == ERROR_PIPE_CONNECTED)
+        {
+            // The client beat us to it and no completion will be queued
+            BeginRead(instance);
+        }
+        else if (error == ERROR_NO_DATA)
+        {
+            // ...and has already gone again
+            Recycle(instance);
+        }
+    }
+}
+
+void ServiceServer::BeginRead(PipeInstance& instance)
+{
+    instance.state = PipeInstance::State::Reading;
+    ZeroMemory(&instance.overlapped, sizeof(instance.overlapped));
+
+    // Success and ERROR_MORE_DATA both still queue a completion
+    m_pendingIo++;
+    if (!ReadFile(instance.pipe, instance.buffer, sizeof(instance.buffer), nullptr, &instance.overlapped))
+    {
+        DWORD error = GetLastError();
+        if (error != ERROR_IO_PENDING && error != ERROR_MORE_DATA)
+        {
+            m_pendingIo--;
+            Recycle(instance);
+        }
+    }
+}
+
+void ServiceServer::BeginWrite(PipeInstance& instance)
+{
+    instance.state = PipeInstance::State::Writing;
+    ZeroMemory(&instance.overlapped, sizeof(instance.overlapped));
+
+    m_pendingIo++;
+    const std::string& frame = instance.output.front();
+    if (!WriteFile(instance.pipe, frame.data(), (DWORD)frame.size(), nullptr, &instance.overlapped) &&
+        GetLastError() != ERROR_IO_PENDING)
+    {
+        m_pendingIo--;
+        Recycle(instance);
+    }
+}
+
+void ServiceServer::Recycle(PipeInstance& instance)
+{
+    if (IsStopping())
+        return;
+
+    // Reuse the instance for the next client rather than recreating the pipe
+    DisconnectNamedPipe(instance.pipe);
+    BeginConnect(instance);
+}
+
+#else
+
+// A response waiting to go out, one frame per send
+struct OutgoingMessage
+{
+    std::string payload;
+    std::vector<EncodedFrame> frames;
+    size_t nextFrame;
+};
+
+// Replies a client may leave untaken before its requests stop being read; reading
+// resumes once it has caught up to half of that
+static const size_t MAX_QUEUED_REPLIES = 256;
+
+// A connected client and the responses it has not been able to take yet
+struct ServiceServer::Connection
+{
+    Connection(int clientSocket, uint64_t connectionId)
+        : socket(clientSocket), id(connectionId), watchingOutput(false), readingPaused(false) {}
+
+    int socket;
+    uint64_t id;
+    FrameDecoder decoder;
+    std::deque<OutgoingMessage> output;
+    bool watchingOutput;    // EPOLLOUT is armed
+    bool readingPaused;     // EPOLLIN is not armed while output is over the cap
+};
+
+bool ServiceServer::Start(size_t instanceCount, size_t threadCount, size_t workerCount, size_t queueCapacity)
+{
+    (void)instanceCount;
+    (void)threadCount;      // one event loop is plenty for a local service
+    ServiceState expected = ServiceState::Stopped;
+    if (!m_state.compare_exchange_strong(expected, ServiceState::Starting))
+        return false;
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (m_endpoint.size() >= sizeof(address.sun_path))
+    {
+        m_state = ServiceState::Stopped;
+        return false;
+    }
+    memcpy(address.sun_path, m_endpoint.c_str(), m_endpoint.size() + 1);
+
+    m_listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    unlink(m_endpoint.c_str());
+
+    epoll_event listenEvent = {};
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.fd = m_listener;
+    epoll_event wakeEvent = {};
+    wakeEvent.events = EPOLLIN;
+    wakeEvent.data.fd = m_wakeEvent;
+
+    if (m_listener < 0 || m_epoll < 0 || m_wakeEvent < 0 ||
+        bind(m_listener, (sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(m_listener, SOMAXCONN) != 0 ||
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_listener, &listenEvent) != 0 ||
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeEvent, &wakeEvent) != 0)
+    {
+        if (m_listener >= 0) close(m_listener);
+        if (m_epoll >= 0) close(m_epoll);
+        if (m_wakeEvent >= 0) close(m_wakeEvent);
+        m_listener = m_epoll = m_wakeEvent = -1;
+        m_state = ServiceState::Stopped;
+        return false;
+    }
+
+    if (workerCount > 0)
+        m_workers = std::make_unique<WorkerPool>(workerCount, queueCapacity);
+
+    m_state = ServiceState::Running;
+    m_threads.emplace_back(&ServiceServer::EventLoop, this);
+    return true;
+}
+
+void ServiceServer::Stop()
+{
+    ServiceState expected = ServiceState::Running;
+    if (!m_state.compare_exchange_strong(expected, ServiceState::Stopping))
+        return;
+
+    // The wake event breaks the loop out of epoll_wait now that it is stopping
+    uint64_t one = 1;
+    ssize_t ignored = write(m_wakeEvent, &one, sizeof(one));
+    (void)ignored;
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+    m_threads.clear();
+
+    // With the loop gone nothing submits any more. Requests already queued
+    // still run; their replies are dropped below.
+    if (m_workers)
+    {
+        m_workers->Shutdown();
+        m_workers.reset();
+    }
+
+    for (auto& connection : m_connections)
+    {
+        if (connection)
+            close(connection->socket);
+    }
+    m_connections.clear();
+    for (CompletedReply& reply : m_replies)
+    {
+        BufferPool::Shared().Release(std::move(reply.payload));
+    }
+    m_replies.clear();
+    close(m_listener);
+    close(m_wakeEvent);
+    close(m_epoll);
+    unlink(m_endpoint.c_str());
+    m_listener = m_epoll = m_wakeEvent = -1;
+    m_state = ServiceState::Stopped;
+}
+
+void ServiceServer::EventLoop()
+{
+    epoll_event events[64];
+    while (!IsStopping())
+    {
+        int count = epoll_wait(m_epoll, events, 64, -1);
+        for (int i = 0; i < count; i++)
+        {
+            int fd = events[i].data.fd;
+            if (fd == m_wakeEvent)
+            {
+                if (IsStopping())
+                    return;
+                SendCompletedReplies();
+                continue;
+            }
+
+            if (fd == m_listener)
+            {
+                int client;
+                while ((client = accept4(m_listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+                {
+                    epoll_event event = {};
+                    event.events = EPOLLIN | EPOLLRDHUP;
+                    event.data.fd = client;
+                    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, client, &event) != 0)
+                    {
+                        close(client);
+                        continue;
+                    }
+                    if ((size_t)client >= m_connections.size())
+                        m_connections.resize((size_t)client + 1);
+                    m_connections[client].reset(new Connection(client, ++m_nextConnectionId));
+                }
+                continue;
+            }
+
+            if ((size_t)fd >= m_connections.size() || !m_connections[fd])
+                continue;
+            Connection& connection = *m_connections[fd];
+
+            if (events[i].events & EPOLLOUT)
+            {
+                if (!FlushOutput(connection))
+                    continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            {
+                OnReadable(connection);
+            }
+        }
+    }
+}
+
+void ServiceServer::OnReadable(Connection& connection)
+{
+    static thread_local std::vector<char> buffer(MAX_MESSAGE_SIZE);
+    static thread_local std::vector<FrameMessage> requests;
+
+    while (true)
+    {
+        // MSG_TRUNC reports the real size, so oversized messages are caught
+        ssize_t length = recv(connection.socket, buffer.data(), buffer.size(), MSG_TRUNC);
+        if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (length <= 0 || (size_t)length > buffer.size() ||
+            !connection.decoder.Feed(buffer.data(), (size_t)length, requests))
+        {
+            requests.clear();
+            CloseConnection(connection.socket);
+            return;
+        }
+
+        if (requests.empty())
+            continue;       // the rest of a multi-frame request is still coming
+
+        QueueResponses(connection, requests);
+        if (!FlushOutput(connection) || connection.readingPaused)
+            return;     // the rest waits in the socket until the client takes its replies
+    }
+}
+
+void ServiceServer::QueueResponses(Connection& connection, std::vector<FrameMessage>& requests)
+{
+    BufferPool& pool = BufferPool::Shared();
+    uint64_t receivedAt = NowMicroseconds();
+    for (FrameMessage& request : requests)
+    {
+        if (request.type != FrameType::Request)
+        {
+            pool.Release(std::move(request.payload));
+            continue;
+        }
+
+        if (m_workers)
+        {
+            // The reply comes back through PostReply, in whatever order the workers finish
+            int socket = connection.socket;
+            uint64_t connectionId = connection.id;
+            uint64_t requestId = request.requestId;
+            bool queued = SubmitRequest([this, socket, connectionId, requestId, receivedAt, payload = std::move(request.payload)]() mutable {
+                BufferPool& pool = BufferPool::Shared();
+                CompletedReply reply{ socket, connectionId, requestId, pool.Acquire() };
+                RunHandler(payload, reply.payload, receivedAt);
+                pool.Release(std::move(payload));
+                PostReply(std::move(reply));
+            });
+            if (!queued)
+            {
+                connection.output.push_back(OutgoingMessage{ pool.Acquire(), {}, 0 });
+                OutgoingMessage& busy = connection.output.back();
+                busy.payload = SERVICE_BUSY_RESPONSE;
+                EncodeMessage(FrameType::Error, requestId, busy.payload.size(), busy.frames);
+            }
+        }
+        else
+        {
+            // Keep replies in order behind anything the client has not taken yet
+            connection.output.push_back(OutgoingMessage{ pool.Acquire(), {}, 0 });
+            OutgoingMessage& response = connection.output.back();
+            RunHandler(request.payload, response.payload, receivedAt);
+            EncodeMessage(FrameType::Response, request.requestId, response.payload.size(), response.frames);
+        }
+        pool.Release(std::move(request.payload));
+    }
+    requests.clear();
+}
+
+void ServiceServer::PostReply(CompletedReply reply)
+{
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(m_repliesMutex);
+        wasEmpty = m_replies.empty();
+        m_replies.push_back(std::move(reply));
+    }
+
+    // One wakeup per batch: the loop takes everything queued when it wakes
+    if (wasEmpty)
+    {
+        uint64_t one = 1;
+        ssize_t ignored = write(m_wakeEvent, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void ServiceServer::SendCompletedReplies()
+{
+    uint64_t count;
+    ssize_t ignored = read(m_wakeEvent, &count, sizeof(count));
+    (void)ignored;
+
+    static thread_local std::vector<CompletedReply> replies;
+    {
+        std::lock_guard<std::mutex> lock(m_repliesMutex);
+        replies.swap(m_replies);
+    }
+
+    for (CompletedReply& reply : replies)
+    {
+        Connection* connection = (size_t)reply.socket < m_connections.size() ? m_connections[reply.socket].get() : nullptr;
+        if (!connection || connection->id != reply.connectionId)
+        {
+            // The client left while its request was being handled
+            BufferPool::Shared().Release(std::move(reply.payload));
+            continue;
+        }
+
+        connection->output.push_back(OutgoingMessage{ std::move(reply.payload), {}, 0 });
+        OutgoingMessage& response = connection->output.back();
+        EncodeMessage(FrameType::Response, reply.requestId, response.payload.size(), response.frames);
+        FlushOutput(*connection);
+    }
+    replies.clear();
+}
+
+bool ServiceServer::FlushOutput(Connection& connection)
+{
+    bool blocked = false;
+    while (!connection.output.empty() && !blocked)
+    {
+        OutgoingMessage& message = connection.output.front();
+        while (message.nextFrame < message.frames.size())
+        {
+            // Header and payload go out together straight from where they are
+            const EncodedFrame& frame = message.frames[message.nextFrame];
+            iovec parts[2];
+            parts[0].iov_base = (void*)frame.header;
+            parts[0].iov_len = FRAME_HEADER_SIZE;
+            parts[1].iov_base = (void*)(message.payload.data() + frame.payloadOffset);
+            parts[1].iov_len = frame.payloadLength;
+
+            msghdr header = {};
+            header.msg_iov = parts;
+            header.msg_iovlen = 2;
+            ssize_t sent = sendmsg(connection.socket, &header, MSG_NOSIGNAL);
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                blocked = true;
+                break;
+            }
+            if (sent < 0)
+            {
+                CloseConnection(connection.socket);
+                return false;
+            }
+            message.nextFrame++;
+        }
+
+        if (!blocked)
+        {
+            BufferPool::Shared().Release(std::move(message.payload));
+            connection.output.pop_front();
+        }
+    }
+
+    // Only wait for writability while the client is behind, and stop taking
+    // requests from it while it is far behind
+    size_t queued = connection.output.size();
+    bool paused = connection.readingPaused ? queued > MAX_QUEUED_REPLIES / 2 : queued >= MAX_QUEUED_REPLIES;
+    if (blocked != connection.watchingOutput || paused != connection.readingPaused)
+    {
+        epoll_event event = {};
+        event.events = (paused ? 0u : (uint32_t)(EPOLLIN | EPOLLRDHUP)) | (blocked ? (uint32_t)EPOLLOUT : 0u);
+        event.data.fd = connection.socket;
+        epoll_ctl(m_epoll, EPOLL_CTL_MOD, connection.socket, &event);
+        connection.watchingOutput = blocked;
+        connection.readingPaused = paused;
+    }
+    return true;
+}
+
+void ServiceServer::CloseConnection(int socket)
+{
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, socket, nullptr);
+    close(socket);
+    m_connections[socket].reset();
+}
+
+#endif
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FrameCodec.h"
+#include "ServiceMetrics.h"
+#include "WorkerPool.h"
+
+// Produces the reply payload for one request payload
+typedef std::function<void(const std::string& request, std::string& response)> ServiceRequestHandler;
+
+// Start and Stop move the server through these with compare-and-swap, so
+// racing calls cannot both act and IsRunning is safe from any thread
+enum class ServiceState
+{
+    Stopped,
+    Starting,
+    Running,
+    Stopping,
+};
+
+// Error payload sent instead of a reply when the work queue is full
+static const char* const SERVICE_BUSY_RESPONSE = "SERVICE_BUSY";
+
+// Message server behind the background service.
+//
+// On Windows it keeps a pool of overlapped named-pipe instances in message
+// mode, all driven by one I/O completion port, so clients never see
+// ERROR_PIPE_BUSY while an instance is free and a slow client does not hold
+// up the others. Elsewhere the same handler is served from a Unix-domain
+// SOCK_SEQPACKET socket on an epoll loop, which keeps message boundaries the
+// way a message-mode pipe does. Either way a connection may carry any number
+// of requests. Requests and replies are FrameCodec messages, one frame per
+// transport message, so a payload of any size fits through in pieces.
+//
+// The I/O threads only accept, read and write. Handlers run on a worker pool
+// behind a bounded queue, so a slow handler holds up neither new connections
+// nor other clients; when the queue is full the request gets an Error frame
+// with SERVICE_BUSY_RESPONSE rather than waiting.
+class ServiceServer
+{
+public:
+    ServiceServer(const std::string& endpoint, ServiceRequestHandler handler);
+    ~ServiceServer();
+
+    ServiceServer(const ServiceServer&) = delete;
+    ServiceServer& operator=(const ServiceServer&) = delete;
+
+    // instanceCount pipe instances are listening at once (ignored for sockets).
+    // With no workers the handler runs on the I/O threads instead.
+    bool Start(size_t instanceCount, size_t threadCount, size_t workerCount = 0, size_t queueCapacity = 0);
+    void Stop();
+    bool IsRunning() const { return m_state == ServiceState::Running; }
+
+    ServiceMetrics GetMetrics() const;
+
+    // Largest transport message: one full frame
+    static const size_t MAX_MESSAGE_SIZE = FRAME_HEADER_SIZE + MAX_FRAME_PAYLOAD;
+
+private:
+    bool IsStopping() const { return m_state == ServiceState::Stopping; }
+
+    // Runs the handler for one request and accounts for it
+    void RunHandler(const std::string& request, std::string& response, uint64_t receivedAt);
+
+    // Queues a handler call for the workers; false, counted as rejected, if the queue is full
+    bool SubmitRequest(WorkerPool::Job job);
+
+    std::string m_endpoint;
+    ServiceRequestHandler m_handler;
+    std::atomic<ServiceState> m_state;
+    std::vector<std::thread> m_threads;
+    std::unique_ptr<WorkerPool> m_workers;
+
+    std::atomic<size_t> m_queued;
+    std::atomic<size_t> m_inFlight;
+    std::atomic<uint64_t> m_completed;
+    std::atomic<uint64_t> m_rejected;
+    LatencyHistogram m_latency;
+
+#ifdef _WIN32
+    struct PipeInstance;
+
+    void CompletionLoop();
+    void BeginConnect(PipeInstance& instance);
+    void BeginRead(PipeInstance& instance);
+    void BeginWrite(PipeInstance& instance);
+    void Recycle(PipeInstance& instance);
+    void OnCompletion(PipeInstance& instance, bool succeeded, unsigned long error, unsigned long bytes);
+    bool OnMessage(PipeInstance& instance);
+    void QueueReply(PipeInstance& instance, FrameType type, uint64_t requestId, const std::string& payload);
+
+    void* m_completionPort;
+    std::vector<std::unique_ptr<PipeInstance>> m_instances;
+    std::atomic<int> m_pendingIo;       // operations whose completion has not been dequeued
+#else
+    struct Connection;
+
+    // A reply a worker finished, waiting for the event loop to send it
+    struct CompletedReply
+    {
+        int socket;
+        uint64_t connectionId;      // the socket number may have been reused since
+        uint64_t requestId;
+        std::string payload;
+    };
+
+    void EventLoop();
+    void OnReadable(Connection& connection);
+    void QueueResponses(Connection& connection, std::vector<FrameMessage>& requests);
+    bool FlushOutput(Connection& connection);
+    void CloseConnection(int socket);
+    void PostReply(CompletedReply reply);
+    void SendCompletedReplies();
+
+    int m_epoll;
+    int m_listener;
+    int m_wakeEvent;
+    std::vector<std::unique_ptr<Connection>> m_connections;     // indexed by socket
+    uint64_t m_nextConnectionId;
+
+    std::mutex m_repliesMutex;
+    std::vector<CompletedReply> m_replies;      // m_wakeEvent is signalled when this fills
+#endif
+};
@@ -0,0 +1,6 @@
+#pragma once
+
+// Cache topics the chat model invalidates when it changes. Kept apart from
+// BackgroundService.h so the model can name a topic without pulling in the
+// service itself.
+static const char SERVICE_TOPIC_CONTACTS[] = "contacts";    // contact list, presence and conversations
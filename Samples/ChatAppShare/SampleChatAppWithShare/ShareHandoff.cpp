@@ -0,0 +1,186 @@
+#include "ShareHandoff.h"
+#include <chrono>
+
+static const size_t HANDOFF_HEADER_SIZE = 16;
+static const uint8_t HANDOFF_FLAG_OUTGOING = 1 << 0;
+static const int PUSH_RETRY_INTERVAL_MS = 5;
+
+static void PutUint32(std::string& out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out.push_back((char)(uint8_t)(value >> (8 * i)));
+    }
+}
+
+static uint32_t GetUint32(const uint8_t* in)
+{
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static void PutUnit(std::string& out, uint32_t unit)
+{
+    out.push_back((char)(uint8_t)unit);
+    out.push_back((char)(uint8_t)(unit >> 8));
+}
+
+// wchar_t is UTF-16 on Windows and UTF-32 elsewhere; the record is always UTF-16
+static size_t Utf16Length(const std::wstring& text)
+{
+    size_t units = text.size();
+    if (sizeof(wchar_t) > 2)
+    {
+        for (wchar_t c : text)
+        {
+            if ((uint32_t)c > 0xFFFF)
+                units++;
+        }
+    }
+    return units;
+}
+
+static void PutUtf16(std::string& out, const std::wstring& text)
+{
+    for (wchar_t c : text)
+    {
+        uint32_t codePoint = (uint32_t)c;
+        if (sizeof(wchar_t) > 2 && codePoint > 0xFFFF)
+        {
+            codePoint -= 0x10000;
+            PutUnit(out, 0xD800 | (codePoint >> 10));
+            PutUnit(out, 0xDC00 | (codePoint & 0x3FF));
+        }
+        else
+        {
+            PutUnit(out, codePoint);
+        }
+    }
+}
+
+static void GetUtf16(const uint8_t* in, size_t units, std::wstring& text)
+{
+    text.clear();
+    text.reserve(units);
+    for (size_t i = 0; i < units; i++)
+    {
+        uint32_t unit = (uint32_t)in[2 * i] | (uint32_t)in[2 * i + 1] << 8;
+        if (sizeof(wchar_t) > 2 && unit >= 0xD800 && unit < 0xDC00 && i + 1 < units)
+        {
+            uint32_t low = (uint32_t)in[2 * i + 2] | (uint32_t)in[2 * i + 3] << 8;
+            if (low >= 0xDC00 && low < 0xE000)
+            {
+                unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                i++;
+            }
+        }
+        text.push_back((wchar_t)unit);
+    }
+}
+
+void EncodeShareHandoff(const ShareHandoffItem& item, std::string& out)
+{
+    size_t textUnits = Utf16Length(item.text);
+    size_t nameUnits = Utf16Length(item.fileName);
+
+    out.clear();
+    out.reserve(HANDOFF_HEADER_SIZE + 2 * (textUnits + nameUnits));
+    out.push_back((char)item.type);
+    out.push_back((char)(item.isOutgoing ? HANDOFF_FLAG_OUTGOING : 0));
+    out.append(2, '\0');
+    PutUint32(out, (uint32_t)item.contactIndex);
+    PutUint32(out, (uint32_t)textUnits);
+    PutUint32(out, (uint32_t)nameUnits);
+    PutUtf16(out, item.text);
+    PutUtf16(out, item.fileName);
+}
+
+bool DecodeShareHandoff(const uint8_t* data, size_t length, ShareHandoffItem& item)
+{
+    if (length < HANDOFF_HEADER_SIZE)
+        return false;
+
+    ShareHandoffType type = (ShareHandoffType)data[0];
+    if (type != ShareHandoffType::Message && type != ShareHandoffType::File)
+        return false;
+
+    uint64_t textUnits = GetUint32(data + 8);
+    uint64_t nameUnits = GetUint32(data + 12);
+    if (HANDOFF_HEADER_SIZE + 2 * (textUnits + nameUnits) != length)
+        return false;
+
+    item.type = type;
+    item.isOutgoing = (data[1] & HANDOFF_FLAG_OUTGOING) != 0;
+    item.contactIndex = (int32_t)GetUint32(data + 4);
+    GetUtf16(data + HANDOFF_HEADER_SIZE, (size_t)textUnits, item.text);
+    GetUtf16(data + HANDOFF_HEADER_SIZE + 2 * textUnits, (size_t)nameUnits, item.fileName);
+    return true;
+}
+
+bool PushShareHandoff(SharedMemoryRing& ring, const ShareHandoffItem& item, int timeoutMs)
+{
+    std::string record;
+    EncodeShareHandoff(item, record);
+    if (record.size() > ring.MaxRecordSize())
+        return false;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!ring.TryPush(record.data(), record.size()))
+    {
+        // Full: the consumer is behind, give it a moment to drain
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(PUSH_RETRY_INTERVAL_MS));
+    }
+    return true;
+}
+
+ShareHandoffInbox::ShareHandoffInbox()
+    : m_stopping(false)
+{
+}
+
+ShareHandoffInbox::~ShareHandoffInbox()
+{
+    Stop();
+}
+
+bool ShareHandoffInbox::Start(const std::string& name, size_t capacity, ItemHandler handler)
+{
+    if (m_thread.joinable())
+        return false;
+    if (!m_ring.Create(name, capacity))
+        return false;
+
+    m_handler = std::move(handler);
+    m_stopping = false;
+    m_thread = std::thread(&ShareHandoffInbox::Run, this);
+    return true;
+}
+
+void ShareHandoffInbox::Stop()
+{
+    if (!m_thread.joinable())
+        return;
+
+    m_stopping = true;
+    m_ring.Wake();
+    m_thread.join();
+    m_ring.Close();
+}
+
+void ShareHandoffInbox::Run()
+{
+    ShareHandoffItem item;
+    auto deliver = [&](const uint8_t* data, size_t length) {
+        if (DecodeShareHandoff(data, length, item))
+            m_handler(std::move(item));
+    };
+
+    while (!m_stopping)
+    {
+        while (m_ring.TryPop(deliver))
+        {
+        }
+        m_ring.Wait(-1);
+    }
+}
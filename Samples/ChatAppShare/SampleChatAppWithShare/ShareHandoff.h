@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include "SharedMemoryRing.h"
+
+// Hand-off of shared content from the share-target process to the running
+// chat app. The chat app owns a SharedMemoryRing under SHARE_HANDOFF_RING_NAME
+// for as long as its window is up; ShareApp opens it, pushes one record per
+// item and exits, and the chat app turns each record into a chat event.
+// Once its window is shown the chat app raises an AppReadySignal under the
+// same name, which is what ShareApp waits on after launching it.
+
+static const char* const SHARE_HANDOFF_RING_NAME = "SampleChatAppWithShare.ShareHandoff";
+static const size_t SHARE_HANDOFF_RING_CAPACITY = 1024 * 1024;
+static const int SHARE_HANDOFF_READY_TIMEOUT_MS = 10000;
+
+enum class ShareHandoffType : uint8_t
+{
+    Message = 1,    // text = message body
+    File = 2,       // text = full path, fileName = display name
+};
+
+struct ShareHandoffItem
+{
+    ShareHandoffType type;
+    int32_t contactIndex;
+    bool isOutgoing;
+    std::wstring text;
+    std::wstring fileName;
+};
+
+// Record layout, little-endian, strings as UTF-16 code units:
+//
+//   u8 type | u8 flags | u16 reserved | i32 contact | u32 text units | u32 name units | text | name
+void EncodeShareHandoff(const ShareHandoffItem& item, std::string& out);
+
+// False if the record is truncated or of an unknown type
+bool DecodeShareHandoff(const uint8_t* data, size_t length, ShareHandoffItem& item);
+
+// Producer side. Waits up to timeoutMs for room while the ring is full.
+bool PushShareHandoff(SharedMemoryRing& ring, const ShareHandoffItem& item, int timeoutMs);
+
+// Consumer side: creates the ring and drains it on a thread of its own,
+// handing every item that decodes to the handler on that thread
+class ShareHandoffInbox
+{
+public:
+    typedef std::function<void(ShareHandoffItem&& item)> ItemHandler;
+
+    ShareHandoffInbox();
+    ~ShareHandoffInbox();
+
+    ShareHandoffInbox(const ShareHandoffInbox&) = delete;
+    ShareHandoffInbox& operator=(const ShareHandoffInbox&) = delete;
+
+    bool Start(const std::string& name, size_t capacity, ItemHandler handler);
+    void Stop();
+
+private:
+    void Run();
+
+    SharedMemoryRing m_ring;
+    ItemHandler m_handler;
+    std::atomic<bool> m_stopping;
+    std::thread m_thread;
+};
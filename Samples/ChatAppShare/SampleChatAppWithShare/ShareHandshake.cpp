@@ -0,0 +1,78 @@
+#include "ShareHandshake.h"
+#include <utility>
+
+ShareHandshake::ShareHandshake(Steps steps, int timeoutMs)
+    : m_steps(std::move(steps))
+    , m_state(ShareHandshakeState::Idle)
+    , m_launched(false)
+    , m_start(Clock::now())
+    , m_deadline(m_start + std::chrono::milliseconds(timeoutMs))
+{
+}
+
+bool ShareHandshake::IsFinished() const
+{
+    return m_state == ShareHandshakeState::Ready ||
+        m_state == ShareHandshakeState::LaunchFailed ||
+        m_state == ShareHandshakeState::TimedOut;
+}
+
+int ShareHandshake::ElapsedMs() const
+{
+    return (int)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_start).count();
+}
+
+ShareHandshakeState ShareHandshake::Advance()
+{
+    switch (m_state)
+    {
+    case ShareHandshakeState::Idle:
+        m_state = ShareHandshakeState::Probing;
+        break;
+
+    case ShareHandshakeState::Probing:
+        m_state = m_steps.waitForReady(0) ? ShareHandshakeState::Ready : ShareHandshakeState::Launching;
+        break;
+
+    case ShareHandshakeState::Launching:
+        m_launched = m_steps.launch();
+        m_state = m_launched ? ShareHandshakeState::AwaitingReady : ShareHandshakeState::LaunchFailed;
+        break;
+
+    case ShareHandshakeState::AwaitingReady:
+    {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(m_deadline - Clock::now()).count();
+        bool ready = m_steps.waitForReady(remaining > 0 ? (int)remaining : 0);
+        m_state = ready ? ShareHandshakeState::Ready : ShareHandshakeState::TimedOut;
+        break;
+    }
+
+    default:
+        break;
+    }
+    return m_state;
+}
+
+ShareHandshakeState ShareHandshake::Run()
+{
+    while (!IsFinished())
+    {
+        Advance();
+    }
+    return m_state;
+}
+
+const char* ShareHandshakeStateName(ShareHandshakeState state)
+{
+    switch (state)
+    {
+    case ShareHandshakeState::Idle: return "Idle";
+    case ShareHandshakeState::Probing: return "Probing";
+    case ShareHandshakeState::Launching: return "Launching";
+    case ShareHandshakeState::AwaitingReady: return "AwaitingReady";
+    case ShareHandshakeState::Ready: return "Ready";
+    case ShareHandshakeState::LaunchFailed: return "LaunchFailed";
+    case ShareHandshakeState::TimedOut: return "TimedOut";
+    }
+    return "Unknown";
+}
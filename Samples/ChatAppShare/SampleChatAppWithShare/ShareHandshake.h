@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+
+// The share target's side of getting the chat app ready to take a hand-off.
+//
+// It first looks whether the app has already announced it is ready. If not,
+// it launches the app and blocks on the announcement, so a share waits for as
+// long as the app takes to come up and no longer. The steps that touch the
+// system are passed in, which keeps the sequence itself free of platform code.
+enum class ShareHandshakeState
+{
+    Idle,
+    Probing,        // is the app already up?
+    Launching,
+    AwaitingReady,  // launched, waiting for the announcement
+    Ready,
+    LaunchFailed,
+    TimedOut,
+};
+
+class ShareHandshake
+{
+public:
+    struct Steps
+    {
+        std::function<bool()> launch;
+        std::function<bool(int timeoutMs)> waitForReady;    // zero timeout only looks
+    };
+
+    // The whole handshake, launch included, has timeoutMs from construction
+    ShareHandshake(Steps steps, int timeoutMs);
+
+    // Takes one transition and returns the state it led to
+    ShareHandshakeState Advance();
+
+    // Advances until Ready, LaunchFailed or TimedOut
+    ShareHandshakeState Run();
+
+    ShareHandshakeState State() const { return m_state; }
+    bool IsFinished() const;
+    bool Launched() const { return m_launched; }
+    int ElapsedMs() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Steps m_steps;
+    ShareHandshakeState m_state;
+    bool m_launched;
+    Clock::time_point m_start;
+    Clock::time_point m_deadline;
+};
+
+const char* ShareHandshakeStateName(ShareHandshakeState state);
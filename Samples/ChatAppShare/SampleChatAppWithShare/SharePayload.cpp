@@ -0,0 +1,182 @@
+#include "SharePayload.h"
+#include <utility>
+
+#ifdef _WIN32
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Foundation.Collections.h>
+#include <winrt/Windows.Storage.h>
+#include <winrt/Windows.Storage.Streams.h>
+#endif
+
+void DeferredSharedFormat::Defer(Loader loader)
+{
+    m_loader = std::move(loader);
+    m_bytes.clear();
+    m_state = SharedFormatState::Deferred;
+}
+
+const std::vector<uint8_t>* DeferredSharedFormat::Get()
+{
+    if (m_state == SharedFormatState::Deferred)
+    {
+        bool loaded = false;
+        try
+        {
+            loaded = m_loader(m_bytes);
+        }
+        catch (...)
+        {
+            loaded = false;
+        }
+        m_loader = nullptr;
+        m_state = loaded ? SharedFormatState::Ready : SharedFormatState::Failed;
+    }
+    return m_state == SharedFormatState::Ready ? &m_bytes : nullptr;
+}
+
+SharePayloadDescription DescribeSharePayload(const SharePayload& payload)
+{
+    SharePayloadDescription description;
+    description.summary = L"Shared Content";
+
+    if (payload.text.IsReady())
+        description.items.push_back(L"Text: " + payload.text.value);
+    else if (payload.text.state == SharedFormatState::Failed)
+        description.items.push_back(L"Text: [Error retrieving text]");
+
+    if (payload.webLink.IsReady())
+        description.items.push_back(L"Web Link: " + payload.webLink.value);
+    else if (payload.webLink.state == SharedFormatState::Failed)
+        description.items.push_back(L"Web Link: [Error retrieving web link]");
+
+    // Offered is enough to mention it; the pixels are not needed for that
+    if (payload.bitmap.State() == SharedFormatState::Failed)
+        description.items.push_back(L"Image: [Error retrieving image]");
+    else if (payload.bitmap.State() != SharedFormatState::Absent)
+        description.items.push_back(L"Image/Bitmap content");
+
+    if (payload.storageItems.IsReady())
+    {
+        const auto& files = payload.storageItems.value;
+        if (files.size() == 1)
+            description.summary = files[0].name;
+        else if (files.size() > 1)
+            description.summary = L"Multiple Files (" + std::to_wstring(files.size()) + L")";
+
+        std::wstring filesInfo = std::to_wstring(files.size()) + L" file(s)";
+        for (const auto& file : files)
+        {
+            filesInfo += L"\n  - " + file.name;
+        }
+        description.items.push_back(filesInfo);
+    }
+    else if (payload.storageItems.state == SharedFormatState::Failed)
+    {
+        description.items.push_back(L"Files: [Error retrieving files]");
+    }
+
+    if (description.items.empty())
+        description.items.push_back(L"Unknown content type");
+    return description;
+}
+
+const wchar_t* SharedFormatStateName(SharedFormatState state)
+{
+    switch (state)
+    {
+    case SharedFormatState::Absent: return L"Absent";
+    case SharedFormatState::Deferred: return L"Deferred";
+    case SharedFormatState::Ready: return L"Ready";
+    case SharedFormatState::Failed: return L"Failed";
+    }
+    return L"Unknown";
+}
+
+#ifdef _WIN32
+
+namespace DataTransfer = winrt::Windows::ApplicationModel::DataTransfer;
+
+// Starts fetching one format if the view offers it; a request that throws fails the field at once
+template <typename T, typename Start>
+static auto StartFetch(const DataTransfer::DataPackageView& data, const winrt::hstring& format, SharedFormat<T>& field, Start start)
+    -> decltype(start())
+{
+    if (!data.Contains(format))
+        return nullptr;
+
+    try
+    {
+        return start();
+    }
+    catch (...)
+    {
+        field.state = SharedFormatState::Failed;
+        return nullptr;
+    }
+}
+
+template <typename T, typename Operation, typename Convert>
+static void FinishFetch(const Operation& operation, SharedFormat<T>& field, Convert convert)
+{
+    if (!operation)
+        return;
+
+    try
+    {
+        // Into a copy first, so a conversion that throws halfway leaves the field empty
+        T value{};
+        convert(operation.get(), value);
+        field.value = std::move(value);
+        field.state = SharedFormatState::Ready;
+    }
+    catch (...)
+    {
+        field.state = SharedFormatState::Failed;
+    }
+}
+
+SharePayload ReadSharePayload(const DataTransfer::DataPackageView& data)
+{
+    using namespace winrt::Windows::Foundation;
+    using namespace winrt::Windows::Storage;
+
+    SharePayload payload;
+
+    // Every Get*Async call sets its fetch going, so they all proceed while the first one is waited for
+    auto text = StartFetch(data, DataTransfer::StandardDataFormats::Text(), payload.text,
+        [&]() { return data.GetTextAsync(); });
+    auto webLink = StartFetch(data, DataTransfer::StandardDataFormats::WebLink(), payload.webLink,
+        [&]() { return data.GetWebLinkAsync(); });
+    auto storageItems = StartFetch(data, DataTransfer::StandardDataFormats::StorageItems(), payload.storageItems,
+        [&]() { return data.GetStorageItemsAsync(); });
+
+    // The source renders the bitmap on request, so it is not asked for until it is used
+    if (data.Contains(DataTransfer::StandardDataFormats::Bitmap()))
+    {
+        payload.bitmap.Defer([data](std::vector<uint8_t>& bytes) {
+            auto stream = data.GetBitmapAsync().get().OpenReadAsync().get();
+            uint32_t size = (uint32_t)stream.Size();
+            Streams::Buffer buffer(size);
+            auto read = stream.ReadAsync(buffer, size, Streams::InputStreamOptions::None).get();
+            bytes.assign(read.data(), read.data() + read.Length());
+            return true;
+        });
+    }
+
+    FinishFetch(text, payload.text, [](const winrt::hstring& value, std::wstring& out) {
+        out = value.c_str();
+    });
+    FinishFetch(webLink, payload.webLink, [](const Uri& value, std::wstring& out) {
+        out = value.ToString().c_str();
+    });
+    FinishFetch(storageItems, payload.storageItems, [](const Collections::IVectorView<IStorageItem>& items, std::vector<SharedStorageItem>& out) {
+        for (const auto& item : items)
+        {
+            out.push_back({ item.Name().c_str(), item.Path().c_str() });
+        }
+    });
+
+    return payload;
+}
+
+#endif
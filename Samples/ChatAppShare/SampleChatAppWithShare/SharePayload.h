@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <winrt/Windows.ApplicationModel.DataTransfer.h>
+#endif
+
+// What another app shared with us, one field per data format, each fetched
+// from the share source exactly once.
+//
+// Cheap formats are fetched up front, all at the same time. Formats that are
+// expensive to produce and that the share may never use (the bitmap) are only
+// remembered as offered, and fetched the first time something asks for them.
+
+enum class SharedFormatState
+{
+    Absent,     // not offered
+    Deferred,   // offered, not fetched yet
+    Ready,
+    Failed,
+};
+
+template <typename T>
+struct SharedFormat
+{
+    SharedFormatState state = SharedFormatState::Absent;
+    T value{};
+
+    bool IsReady() const { return state == SharedFormatState::Ready; }
+};
+
+struct SharedStorageItem
+{
+    std::wstring name;
+    std::wstring path;      // empty for items that are not files on disk
+};
+
+// A format fetched on first use. The loader runs at most once, and a loader
+// that throws counts as having failed.
+class DeferredSharedFormat
+{
+public:
+    typedef std::function<bool(std::vector<uint8_t>& bytes)> Loader;
+
+    void Defer(Loader loader);
+    SharedFormatState State() const { return m_state; }
+
+    // The fetched bytes, or null if the format is absent or could not be fetched
+    const std::vector<uint8_t>* Get();
+
+private:
+    SharedFormatState m_state = SharedFormatState::Absent;
+    Loader m_loader;
+    std::vector<uint8_t> m_bytes;
+};
+
+struct SharePayload
+{
+    SharedFormat<std::wstring> text;
+    SharedFormat<std::wstring> webLink;
+    SharedFormat<std::vector<SharedStorageItem>> storageItems;
+    DeferredSharedFormat bitmap;
+};
+
+// How the share target presents a payload: a title for the contact picker
+// and one chat line per format
+struct SharePayloadDescription
+{
+    std::wstring summary;
+    std::vector<std::wstring> items;
+};
+
+SharePayloadDescription DescribeSharePayload(const SharePayload& payload);
+
+const wchar_t* SharedFormatStateName(SharedFormatState state);
+
+#ifdef _WIN32
+// Requests every cheap format the view offers before waiting for any of them
+SharePayload ReadSharePayload(const winrt::Windows::ApplicationModel::DataTransfer::DataPackageView& data);
+#endif
@@ -4,6 +4,7 @@
 #include "ChatManager.h"
 #include "ChatModels.h"
 #include "FileManager.h"
+#include "SharePayload.h"
 #include "framework.h"
 #include <sstream>
 
@@ -105,107 +106,16 @@ bool ShareTargetManager::ProcessActivationArgs()
             auto shareOperation = shareArgs.ShareOperation();
             auto data = shareOperation.Data();
 
-            // Extract shared content information for the contact selection dialog
-            std::wstring sharedContentSummary = L"Shared Content";
-            std::wstring sharedFiles;
-            bool hasFiles = false;
+            // Fetch every offered format once, all at the same time; the bitmap only if it is used
+            SharePayload payload = ReadSharePayload(data);
+            SharePayloadDescription description = DescribeSharePayload(payload);
+            std::wstring sharedContentSummary = description.summary;
+            const std::vector<std::wstring>& sharedItems = description.items;
             
-            // Collect information about what's being shared
-            std::vector<std::wstring> sharedItems;
-            
-            // Check for different data formats
-            if (data.Contains(winrt::Windows::ApplicationModel::DataTransfer::StandardDataFormats::Text()))
-            {
-                try
-                {
-                    auto textAsync = data.GetTextAsync();
-                    auto text = textAsync.get();
-                    sharedItems.push_back(L"Text: " + std::wstring(text.c_str()));
-                    LogShareInfo(L"Received shared text.");
-                }
-                catch (...)
-                {
-                    sharedItems.push_back(L"Text: [Error retrieving text]");
-                    LogShareError(L"Error retrieving shared text.");
-                }
-            }
-
-            if (data.Contains(winrt::Windows::ApplicationModel::DataTransfer::StandardDataFormats::WebLink()))
-            {
-                try
-                {
-                    auto webLinkAsync = data.GetWebLinkAsync();
-                    auto webLink = webLinkAsync.get();
-                    sharedItems.push_back(L"Web Link: " + std::wstring(webLink.ToString().c_str()));
-                    LogShareInfo(L"Received shared web link.");
-                }
-                catch (...)
-                {
-                    sharedItems.push_back(L"Web Link: [Error retrieving web link]");
-                    LogShareError(L"Error retrieving shared web link.");
-                }
-            }
-
-            if (data.Contains(winrt::Windows::ApplicationModel::DataTransfer::StandardDataFormats::Bitmap()))
-            {
-                try
-                {
-                    auto bitmapAsync = data.GetBitmapAsync();
-                    auto bitmapRef = bitmapAsync.get();
-                    sharedItems.push_back(L"Image/Bitmap content");
-                    LogShareInfo(L"Received shared bitmap.");
-                }
-                catch (...)
-                {
-                    sharedItems.push_back(L"Image: [Error retrieving image]");
-                    LogShareError(L"Error retrieving shared bitmap.");
-                }
-            }
-
-            if (data.Contains(winrt::Windows::ApplicationModel::DataTransfer::StandardDataFormats::StorageItems()))
-            {
-                try
-                {
-                    auto storageItemsAsync = data.GetStorageItemsAsync();
-                    auto storageItems = storageItemsAsync.get();
-                    
-                    hasFiles = true;
-                    std::wstring filesInfo = std::to_wstring(storageItems.Size()) + L" file(s)";
-                    
-                    if (storageItems.Size() == 1)
-                    {
-                        auto item = storageItems.GetAt(0);
-                        sharedFiles = item.Name().c_str();
-                        sharedContentSummary = sharedFiles;
-                    }
-                    else if (storageItems.Size() > 1)
-                    {
-                        sharedFiles = L"Multiple Files (" + std::to_wstring(storageItems.Size()) + L")";
-                        sharedContentSummary = sharedFiles;
-                    }
-                    
-                    for (uint32_t i = 0; i < storageItems.Size(); i++)
-                    {
-                        auto item = storageItems.GetAt(i);
-                        filesInfo += L"\n  - " + std::wstring(item.Name().c_str());
-                    }
-                    
-                    sharedItems.push_back(filesInfo);
-                    LogShareInfo(L"Received shared files.");
-                }
-                catch (...)
-                {
-                    sharedItems.push_back(L"Files: [Error retrieving files]");
-                    LogShareError(L"Error retrieving shared files.");
-                }
-            }
-
-            // If no specific content type found, use generic description
-            if (sharedItems.empty())
-            {
-                sharedContentSummary = L"Shared Content";
-                sharedItems.push_back(L"Unknown content type");
-            }
+            LogShareInfo(std::wstring(L"Shared payload - text: ") + SharedFormatStateName(payload.text.state) +
+                       L", web link: " + SharedFormatStateName(payload.webLink.state) +
+                       L", bitmap: " + SharedFormatStateName(payload.bitmap.State()) +
+                       L", files: " + SharedFormatStateName(payload.storageItems.state));
 
             // Get the main window handle for dialog parent
             HWND hMainWindow = GetActiveWindow();
@@ -243,8 +153,7 @@ bool ShareTargetManager::ProcessActivationArgs()
                     // Add the custom share message if provided
                     if (!result.shareMessage.empty())
                     {
-                        std::wstring formattedShareMessage = L"You: " + result.shareMessage + L" ??";
-                        selectedContact.messages.push_back(formattedShareMessage);
+                        selectedContact.messages.push_back(MakeChatMessage(SENDER_SELF, result.shareMessage + L" ??", MESSAGE_FLAG_OUTGOING));
                         LogShareInfo(L"Added share message: " + result.shareMessage);
                     }
                     
@@ -252,44 +161,33 @@ bool ShareTargetManager::ProcessActivationArgs()
                     for (const auto& item : sharedItems)
                     {
                         std::wstring shareMsg = L"?? Received via Share: " + item;
-                        std::wstring formattedMessage = selectedContact.name + L": " + shareMsg;
-                        selectedContact.messages.push_back(formattedMessage);
+                        selectedContact.messages.push_back(MakeChatMessage(selectedContact.senderId, shareMsg, MESSAGE_FLAG_NONE));
                         LogShareInfo(L"Added shared content message: " + shareMsg);
                     }
                     
                     // Update the last message preview for this contact
                     if (!sharedItems.empty())
                     {
-                        std::wstring lastMsg = L"?? Received via Share: " + sharedItems[0];
-                        selectedContact.lastMessage = lastMsg.length() > 50 ? lastMsg.substr(0, 47) + L"..." : lastMsg;
+                        selectedContact.lastMessage = L"?? Received via Share: " + sharedItems[0];
                     }
+                    MarkContactChanged(result.contactIndex);
+                    PublishContactSnapshot();
                     
                     // If files were shared, add them to the contact's shared files list
-                    if (hasFiles && data.Contains(winrt::Windows::ApplicationModel::DataTransfer::StandardDataFormats::StorageItems()))
+                    for (const auto& item : payload.storageItems.value)
                     {
-                        try
-                        {
-                            auto storageItemsAsync = data.GetStorageItemsAsync();
-                            auto storageItems = storageItemsAsync.get();
-                            
-                            for (uint32_t i = 0; i < storageItems.Size(); i++)
-                            {
-                                auto item = storageItems.GetAt(i);
-                                
-                                // Create shared file entry
-                                SharedFile newFile;
-                                newFile.fileName = item.Name().c_str();
-                                newFile.filePath = item.Path().c_str(); // Get full path if available
-                                newFile.sharedBy = L"External Share";
-                                GetSystemTime(&newFile.timeShared);
-                                
-                                selectedContact.sharedFiles.push_back(newFile);
-                                LogShareInfo(L"Added shared file: " + newFile.fileName);
-                            }
-                        }
-                        catch (...)
+                        // Create shared file entry
+                        SharedFile newFile;
+                        newFile.fileName = item.name;
+                        newFile.filePath = item.path; // Empty for items that are not files on disk
+                        newFile.sharedBy = L"External Share";
+                        newFile.timeShared = CurrentSharedFileTime();
+                        newFile.contentHash = 0;
+                        
+                        if (selectedContact.sharedFiles.Add(newFile))
                         {
-                            LogShareError(L"Error adding shared files to contact.");
+                            ProcessSharedFileAsync(result.contactIndex, newFile.filePath);
+                            LogShareInfo(L"Added shared file: " + newFile.fileName);
                         }
                     }
                     
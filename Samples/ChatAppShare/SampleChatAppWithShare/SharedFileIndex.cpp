@@ -0,0 +1,145 @@
+#include "SharedFileIndex.h"
+#include <algorithm>
+#include <cwctype>
+
+std::wstring SharedFileIndex::NormalizePath(const std::wstring& filePath)
+{
+    std::wstring normalized(filePath);
+    for (auto& ch : normalized)
+    {
+        ch = ch == L'/' ? L'\\' : (wchar_t)std::towlower(ch);
+    }
+    return normalized;
+}
+
+bool SharedFileIndex::Add(const SharedFile& file)
+{
+    std::wstring pathKey = NormalizePath(file.filePath);
+    if (m_byPath.count(pathKey))
+        return false;
+    if (file.contentHash != 0 && m_byContentHash.count(file.contentHash))
+        return false;
+
+    uint32_t id = (uint32_t)m_files.size();
+    m_files.push_back(file);
+    m_mergedInto.push_back(id);
+    m_byPath.emplace(std::move(pathKey), id);
+    if (file.contentHash != 0)
+    {
+        m_byContentHash.emplace(file.contentHash, id);
+    }
+
+    // Shares almost always arrive in time order, so this is usually an append
+    if (m_order.empty() || m_files[m_order.back()].timeShared <= file.timeShared)
+    {
+        m_order.push_back(id);
+    }
+    else
+    {
+        auto position = std::upper_bound(m_order.begin(), m_order.end(), file.timeShared,
+            [this](uint64_t time, uint32_t other) { return time < m_files[other].timeShared; });
+        m_order.insert(position, id);
+    }
+    return true;
+}
+
+SharedFileUpdate SharedFileIndex::SetContentHash(const std::wstring& filePath, uint64_t contentHash)
+{
+    auto it = m_byPath.find(NormalizePath(filePath));
+    if (it == m_byPath.end())
+        return SharedFileUpdate::NotFound;
+
+    uint32_t id = Resolve(it->second);
+    SharedFile& file = m_files[id];
+    if (file.contentHash == contentHash)
+        return SharedFileUpdate::Updated;
+
+    if (file.contentHash != 0)
+    {
+        auto previous = m_byContentHash.find(file.contentHash);
+        if (previous != m_byContentHash.end() && previous->second == id)
+            m_byContentHash.erase(previous);
+    }
+
+    file.contentHash = contentHash;
+    if (contentHash == 0)
+        return SharedFileUpdate::Updated;
+
+    auto existing = m_byContentHash.emplace(contentHash, id);
+    if (existing.second)
+        return SharedFileUpdate::Updated;
+
+    // Same content under another path: the one shared first stays
+    uint32_t other = existing.first->second;
+    if (m_files[other].timeShared <= file.timeShared)
+    {
+        Merge(id, other);
+    }
+    else
+    {
+        existing.first->second = id;
+        Merge(other, id);
+    }
+    return SharedFileUpdate::Merged;
+}
+
+SharedFileUpdate SharedFileIndex::SetMetadata(const std::wstring& filePath, const std::shared_ptr<const FileMetadata>& metadata)
+{
+    if (!metadata)
+        return SharedFileUpdate::NotFound;
+
+    SharedFileUpdate update = SetContentHash(filePath, metadata->contentHash);
+    if (update == SharedFileUpdate::NotFound)
+        return update;
+
+    // After a merge the path leads to the entry that stayed; the content is the same
+    SharedFile& file = m_files[Resolve(m_byPath[NormalizePath(filePath)])];
+    if (update == SharedFileUpdate::Updated || !file.metadata)
+        file.metadata = metadata;
+    return update;
+}
+
+uint32_t SharedFileIndex::Resolve(uint32_t id)
+{
+    uint32_t listed = id;
+    while (m_mergedInto[listed] != listed)
+    {
+        listed = m_mergedInto[listed];
+    }
+
+    // Point the whole chain straight at the listed slot, so the next lookup takes one step
+    while (m_mergedInto[id] != listed)
+    {
+        uint32_t next = m_mergedInto[id];
+        m_mergedInto[id] = listed;
+        id = next;
+    }
+    return listed;
+}
+
+void SharedFileIndex::Merge(uint32_t removed, uint32_t kept)
+{
+    // Entries with the same time are in arrival order, so search just that run
+    uint64_t timeShared = m_files[removed].timeShared;
+    auto first = std::lower_bound(m_order.begin(), m_order.end(), timeShared,
+        [this](uint32_t other, uint64_t time) { return m_files[other].timeShared < time; });
+    m_order.erase(std::find(first, m_order.end(), removed));
+    m_mergedInto[removed] = kept;
+
+    // Only the slot stays behind; let go of its thumbnail
+    m_files[removed].metadata.reset();
+}
+
+bool SharedFileIndex::ContainsPath(const std::wstring& filePath) const
+{
+    return m_byPath.count(NormalizePath(filePath)) != 0;
+}
+
+void SharedFileIndex::Clear()
+{
+    m_files.clear();
+    m_mergedInto.clear();
+    m_order.clear();
+    m_byPath.clear();
+    m_byContentHash.clear();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FileMetadata.h"
+
+struct SharedFile {
+    std::wstring fileName;
+    std::wstring filePath;
+    std::wstring sharedBy;
+    uint64_t timeShared;    // UTC, 100 ns ticks since 1601 (FILETIME)
+    uint64_t contentHash;   // 0 until stored; also the id of its ChunkStore manifest
+    std::shared_ptr<const FileMetadata> metadata;   // null until the pipeline has run
+};
+
+// What a late content hash did to the index
+enum class SharedFileUpdate
+{
+    NotFound,       // the path is not in the index
+    Updated,        // the entry changed in place
+    Merged,         // it matched another entry and the later of the two was folded into the earlier
+};
+
+// Files shared with one contact, ordered by the time they were shared.
+//
+// A file is only listed once: a second share of the same path (compared the way
+// Windows does, ignoring case and slash direction) or of identical content is
+// dropped. Content is usually only known after the file was added, so a hash
+// that turns up later merges the two entries then. Entries are addressed by
+// position, oldest first, so a virtual list can pull just the rows it is showing.
+class SharedFileIndex
+{
+public:
+    // False if the file was already in the index
+    bool Add(const SharedFile& file);
+
+    // Record the content hash once it is known. If another entry already has
+    // that content, the later-shared one is removed and its path kept as an
+    // alias of the earlier, so Size() drops by one and positions shift.
+    SharedFileUpdate SetContentHash(const std::wstring& filePath, uint64_t contentHash);
+
+    // Attach pipeline results, including the content hash
+    SharedFileUpdate SetMetadata(const std::wstring& filePath, const std::shared_ptr<const FileMetadata>& metadata);
+
+    bool ContainsPath(const std::wstring& filePath) const;
+
+    size_t Size() const { return m_order.size(); }
+    bool Empty() const { return m_order.empty(); }
+
+    // Entry at 'position' in timeShared order
+    const SharedFile& At(size_t position) const { return m_files[m_order[position]]; }
+
+    void Clear();
+
+private:
+    static std::wstring NormalizePath(const std::wstring& filePath);
+
+    // The listed slot a path's slot now stands for, following merges
+    uint32_t Resolve(uint32_t id);
+
+    // Drop 'removed' from the listing and forward its paths to 'kept'
+    void Merge(uint32_t removed, uint32_t kept);
+
+    std::vector<SharedFile> m_files;    // arrival order, never reordered; merged-away slots stay unlisted
+    std::vector<uint32_t> m_mergedInto; // per slot: itself while listed, else the slot it was merged into
+    std::vector<uint32_t> m_order;      // indices into m_files sorted by timeShared
+    std::unordered_map<std::wstring, uint32_t> m_byPath;    // to the slot first added under the path
+    std::unordered_map<uint64_t, uint32_t> m_byContentHash;
+};
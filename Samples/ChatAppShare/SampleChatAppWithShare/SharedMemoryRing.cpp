@@ -0,0 +1,444 @@
+#include "SharedMemoryRing.h"
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const uint32_t RING_MAGIC = 0x474E5253;     // "SRNG"
+static const uint32_t RING_VERSION = 1;
+
+// Every record starts with an 8-byte header whose first word is its state:
+// zero while the space is free or still being written, otherwise the length
+// with RECORD_COMMITTED set. A padding record fills the space left at the end
+// of the ring when the next record does not fit there.
+static const size_t RECORD_HEADER_SIZE = 8;
+static const size_t RECORD_ALIGNMENT = 8;
+static const uint32_t RECORD_COMMITTED = 0x80000000u;
+static const uint32_t RECORD_PADDING = 0x40000000u;
+static const uint32_t RECORD_LENGTH_MASK = 0x3FFFFFFFu;
+
+static const size_t MIN_CAPACITY = 4096;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+    "the ring's atomics live in shared memory and cannot fall back to a lock");
+
+// Start of the mapping; the record space follows it. The cursors count bytes
+// from the ring's creation and are only reduced modulo the capacity on use.
+struct SharedMemoryRing::RingHeader
+{
+    std::atomic<uint32_t> magic;        // stored last by the creator
+    uint32_t version;
+    uint64_t capacity;
+
+    alignas(64) std::atomic<uint64_t> reserve;     // producers: end of the claimed space
+    alignas(64) std::atomic<uint64_t> consume;     // consumer: start of the unread space
+    alignas(64) std::atomic<uint32_t> sequence;    // bumped on every publish; the futex word
+    std::atomic<uint32_t> consumerSleeping;
+    std::atomic<uint32_t> wakePending;     // Wake was called; latched until Wait sees it
+};
+
+static size_t AlignRecord(size_t size)
+{
+    return (size + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+}
+
+static std::atomic<uint32_t>* RecordState(uint8_t* record)
+{
+    return reinterpret_cast<std::atomic<uint32_t>*>(record);
+}
+
+SharedMemoryRing::SharedMemoryRing()
+    : m_header(nullptr), m_data(nullptr), m_capacity(0), m_mappingSize(0)
+#ifdef _WIN32
+    , m_mapping(nullptr), m_event(nullptr)
+#else
+    , m_file(-1)
+#endif
+{
+}
+
+SharedMemoryRing::~SharedMemoryRing()
+{
+    Close();
+}
+
+bool SharedMemoryRing::Create(const std::string& name, size_t capacity)
+{
+    Close();
+
+    size_t rounded = MIN_CAPACITY;
+    while (rounded < capacity && rounded <= RECORD_LENGTH_MASK)
+        rounded <<= 1;
+
+    m_name = name;
+    if (!MapRegion(sizeof(RingHeader) + rounded, true))
+    {
+        Close();
+        return false;
+    }
+
+    // The mapping starts out zeroed, which is also the empty state of every record
+    m_header = new (m_header) RingHeader();
+    m_header->version = RING_VERSION;
+    m_header->capacity = rounded;
+    m_header->reserve.store(0, std::memory_order_relaxed);
+    m_header->consume.store(0, std::memory_order_relaxed);
+    m_header->sequence.store(0, std::memory_order_relaxed);
+    m_header->consumerSleeping.store(0, std::memory_order_relaxed);
+    m_header->wakePending.store(0, std::memory_order_relaxed);
+    m_header->magic.store(RING_MAGIC, std::memory_order_release);
+
+    m_capacity = rounded;
+    return true;
+}
+
+bool SharedMemoryRing::Open(const std::string& name)
+{
+    Close();
+
+    m_name = name;
+    if (!MapRegion(0, false) || m_mappingSize < sizeof(RingHeader) ||
+        m_header->magic.load(std::memory_order_acquire) != RING_MAGIC ||
+        m_header->version != RING_VERSION ||
+        m_header->capacity > m_mappingSize - sizeof(RingHeader) ||
+        (m_header->capacity & (m_header->capacity - 1)) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    m_capacity = (size_t)m_header->capacity;
+    return true;
+}
+
+size_t SharedMemoryRing::MaxRecordSize() const
+{
+    // Half the ring, so a record always fits once the padding before it is skipped
+    return m_capacity / 2 - RECORD_HEADER_SIZE;
+}
+
+bool SharedMemoryRing::TryPush(const void* data, size_t length)
+{
+    if (!m_header || length > MaxRecordSize())
+        return false;
+
+    const size_t recordSize = AlignRecord(RECORD_HEADER_SIZE + length);
+    uint64_t position = m_header->reserve.load(std::memory_order_relaxed);
+    size_t padding;
+    for (;;)
+    {
+        size_t offset = (size_t)(position & (m_capacity - 1));
+        size_t roomToEnd = m_capacity - offset;
+        padding = recordSize > roomToEnd ? roomToEnd : 0;
+
+        uint64_t consumed = m_header->consume.load(std::memory_order_acquire);
+        if (consumed > position)
+        {
+            // Our view of the reserve cursor is older than the consumer's progress
+            position = m_header->reserve.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (position + padding + recordSize - consumed > m_capacity)
+            return false;
+
+        if (m_header->reserve.compare_exchange_weak(position, position + padding + recordSize,
+                std::memory_order_relaxed, std::memory_order_relaxed))
+            break;
+    }
+
+    if (padding)
+    {
+        uint8_t* pad = m_data + (position & (m_capacity - 1));
+        RecordState(pad)->store(RECORD_COMMITTED | RECORD_PADDING | (uint32_t)padding, std::memory_order_release);
+        position += padding;
+    }
+
+    uint8_t* record = m_data + (position & (m_capacity - 1));
+    if (length)
+        memcpy(record + RECORD_HEADER_SIZE, data, length);
+    RecordState(record)->store(RECORD_COMMITTED | (uint32_t)length, std::memory_order_release);
+
+    // Pairs with the fence in Wait: either the consumer sees this record before
+    // it sleeps, or this sees that it is asleep
+    m_header->sequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_header->consumerSleeping.load(std::memory_order_relaxed))
+        Signal();
+    return true;
+}
+
+bool SharedMemoryRing::HasRecord() const
+{
+    uint64_t position = m_header->consume.load(std::memory_order_relaxed);
+    uint8_t* record = m_data + (position & (m_capacity - 1));
+    return (RecordState(record)->load(std::memory_order_acquire) & RECORD_COMMITTED) != 0;
+}
+
+bool SharedMemoryRing::TryPop(const RecordReader& reader)
+{
+    if (!m_header)
+        return false;
+
+    for (;;)
+    {
+        uint64_t position = m_header->consume.load(std::memory_order_relaxed);
+        uint8_t* record = m_data + (position & (m_capacity - 1));
+        uint32_t state = RecordState(record)->load(std::memory_order_acquire);
+        if (!(state & RECORD_COMMITTED))
+            return false;
+
+        size_t length = state & RECORD_LENGTH_MASK;
+        bool isPadding = (state & RECORD_PADDING) != 0;
+        size_t span = isPadding ? length : AlignRecord(RECORD_HEADER_SIZE + length);
+
+        if (!isPadding)
+            reader(record + RECORD_HEADER_SIZE, length);
+
+        // Later records may start anywhere in this space, so none of it may
+        // still look like a published header when producers get it back
+        memset(record, 0, span);
+        m_header->consume.store(position + span, std::memory_order_release);
+
+        if (!isPadding)
+            return true;
+    }
+}
+
+void SharedMemoryRing::Wait(int timeoutMs)
+{
+    if (!m_header)
+        return;
+
+#ifndef _WIN32
+    uint32_t sequence = m_header->sequence.load(std::memory_order_relaxed);
+#endif
+    m_header->consumerSleeping.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (!HasRecord() && !m_header->wakePending.exchange(0, std::memory_order_acquire))
+    {
+#ifdef _WIN32
+        WaitForSingleObject((HANDLE)m_event, timeoutMs < 0 ? INFINITE : (DWORD)timeoutMs);
+#else
+        timespec timeout;
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = (long)(timeoutMs % 1000) * 1000000;
+        // Returns at once if a producer has bumped the sequence since it was read
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_header->sequence), FUTEX_WAIT, sequence,
+            timeoutMs < 0 ? nullptr : &timeout, nullptr, 0);
+#endif
+    }
+
+    m_header->consumerSleeping.store(0, std::memory_order_relaxed);
+}
+
+void SharedMemoryRing::Wake()
+{
+    if (!m_header)
+        return;
+
+    m_header->wakePending.store(1, std::memory_order_release);
+    m_header->sequence.fetch_add(1, std::memory_order_seq_cst);
+    Signal();
+}
+
+#ifdef _WIN32
+
+static std::wstring ObjectName(const std::string& name, const wchar_t* suffix)
+{
+    // Session-local, so every process of the signed-in user sees the same objects
+    return L"Local\\" + std::wstring(name.begin(), name.end()) + suffix;
+}
+
+bool SharedMemoryRing::MapRegion(size_t size, bool create)
+{
+    std::wstring mappingName = ObjectName(m_name, L"");
+    std::wstring eventName = ObjectName(m_name, L".Signal");
+
+    if (create)
+    {
+        m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            (DWORD)((uint64_t)size >> 32), (DWORD)size, mappingName.c_str());
+        if (!m_mapping || GetLastError() == ERROR_ALREADY_EXISTS)
+            return false;   // another consumer already owns this ring
+        m_event = CreateEventW(nullptr, FALSE, FALSE, eventName.c_str());
+    }
+    else
+    {
+        m_mapping = OpenFileMappingW(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, mappingName.c_str());
+        if (!m_mapping)
+            return false;
+        m_event = OpenEventW(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, eventName.c_str());
+    }
+    if (!m_event)
+        return false;
+
+    void* view = MapViewOfFile((HANDLE)m_mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size);
+    if (!view)
+        return false;
+
+    MEMORY_BASIC_INFORMATION info;
+    if (!VirtualQuery(view, &info, sizeof(info)))
+    {
+        UnmapViewOfFile(view);
+        return false;
+    }
+
+    m_header = static_cast<RingHeader*>(view);
+    m_data = static_cast<uint8_t*>(view) + sizeof(RingHeader);
+    m_mappingSize = create ? size : info.RegionSize;
+    return true;
+}
+
+void SharedMemoryRing::Signal()
+{
+    if (m_event)
+        SetEvent((HANDLE)m_event);
+}
+
+void SharedMemoryRing::Close()
+{
+    if (m_header)
+        UnmapViewOfFile(m_header);
+    if (m_event)
+        CloseHandle((HANDLE)m_event);
+    if (m_mapping)
+        CloseHandle((HANDLE)m_mapping);
+
+    m_header = nullptr;
+    m_data = nullptr;
+    m_event = nullptr;
+    m_mapping = nullptr;
+    m_capacity = 0;
+    m_mappingSize = 0;
+}
+
+#else
+
+// A consumer locks its segment before giving it a size and keeps it locked
+// until it has removed the name again, so a segment with a size that nobody
+// has locked outlived a consumer that crashed and may be replaced. One that is
+// locked, or still empty because its creator is just setting it up, belongs to
+// a live consumer, and creating the ring fails as CreateFileMapping does on
+// Windows.
+static bool RemoveAbandonedSegment(const std::string& path)
+{
+    int fd = shm_open(path.c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return errno == ENOENT;     // removed meanwhile, so the name is free
+
+    struct stat info;
+    bool abandoned = fstat(fd, &info) == 0 && info.st_size > 0 && flock(fd, LOCK_EX | LOCK_NB) == 0;
+    if (abandoned)
+        shm_unlink(path.c_str());
+    close(fd);
+    return abandoned;
+}
+
+static int CreateSegment(const std::string& path, size_t size)
+{
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0)
+        {
+            if (flock(fd, LOCK_EX | LOCK_NB) != 0 || ftruncate(fd, (off_t)size) != 0)
+            {
+                shm_unlink(path.c_str());
+                close(fd);
+                return -1;
+            }
+            return fd;
+        }
+        if (errno != EEXIST || !RemoveAbandonedSegment(path))
+            return -1;
+    }
+    return -1;
+}
+
+bool SharedMemoryRing::MapRegion(size_t size, bool create)
+{
+    std::string path = "/" + m_name;
+    int fd;
+    if (create)
+    {
+        fd = CreateSegment(path, size);
+        if (fd < 0)
+            return false;
+    }
+    else
+    {
+        fd = shm_open(path.c_str(), O_RDWR, 0);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            close(fd);
+            return false;
+        }
+        size = (size_t)info.st_size;
+    }
+
+    void* view = size ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (view == MAP_FAILED)
+    {
+        if (create)
+            shm_unlink(path.c_str());
+        close(fd);
+        return false;
+    }
+
+    // The owner's descriptor holds the lock; a producer has no use for its own
+    if (create)
+        m_file = fd;
+    else
+        close(fd);
+
+    m_header = static_cast<RingHeader*>(view);
+    m_data = static_cast<uint8_t*>(view) + sizeof(RingHeader);
+    m_mappingSize = size;
+    return true;
+}
+
+void SharedMemoryRing::Signal()
+{
+    // Shared rather than private: the waiter is in another process
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_header->sequence), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void SharedMemoryRing::Close()
+{
+    if (m_header)
+        munmap(m_header, m_mappingSize);
+
+    // The name goes before the lock, so nobody can take it over in between
+    // and have it removed from under them
+    if (m_file >= 0)
+    {
+        shm_unlink(("/" + m_name).c_str());
+        close(m_file);
+    }
+
+    m_header = nullptr;
+    m_file = -1;
+    m_data = nullptr;
+    m_capacity = 0;
+    m_mappingSize = 0;
+}
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Byte ring in a named shared-memory mapping, for passing records between
+// processes without a trip through the kernel for each one.
+//
+// One process creates the ring and is its only consumer; any number of
+// producers, in any process, open it by name and push. A producer claims room
+// by moving a shared reserve cursor forward with compare-and-swap, copies its
+// record straight into the mapping and publishes it by storing the record's
+// header word last, so producers never wait on each other while they copy.
+// The consumer reads records in place and zeroes the space before handing it
+// back. Wakeups go through a named auto-reset event on Windows and a futex on
+// a shared sequence word elsewhere, and are only paid for while the consumer
+// is actually asleep.
+//
+// A producer that dies between reserving and publishing stalls the ring at its
+// record, so producers should not do anything that can fail in between.
+class SharedMemoryRing
+{
+public:
+    // Called with a record where it lies in the mapping; valid only during the call
+    typedef std::function<void(const uint8_t* data, size_t length)> RecordReader;
+
+    SharedMemoryRing();
+    ~SharedMemoryRing();
+
+    SharedMemoryRing(const SharedMemoryRing&) = delete;
+    SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+    // Consumer side. capacity is rounded up to a power of two. Fails while
+    // another consumer, in this process or any other, owns a ring by that name.
+    bool Create(const std::string& name, size_t capacity);
+
+    // Producer side; false if no process has created the ring
+    bool Open(const std::string& name);
+
+    void Close();
+    bool IsOpen() const { return m_header != nullptr; }
+
+    // False if the ring is full or the record is longer than MaxRecordSize()
+    bool TryPush(const void* data, size_t length);
+
+    // Consumer only. Hands the next record to reader; false if none is ready.
+    bool TryPop(const RecordReader& reader);
+
+    // Consumer only. Sleeps until a record may be ready, Wake is called or
+    // timeoutMs passes (a negative timeout waits for ever).
+    void Wait(int timeoutMs);
+
+    // Wakes the consumer from Wait even if nothing was pushed
+    void Wake();
+
+    size_t MaxRecordSize() const;
+
+private:
+    struct RingHeader;
+
+    bool MapRegion(size_t size, bool create);
+    bool HasRecord() const;
+    void Signal();
+
+    std::string m_name;
+    RingHeader* m_header;
+    uint8_t* m_data;
+    size_t m_capacity;
+    size_t m_mappingSize;
+
+#ifdef _WIN32
+    void* m_mapping;
+    void* m_event;
+#else
+    int m_file;     // owner only: the segment, kept locked for as long as it is owned
+#endif
+};
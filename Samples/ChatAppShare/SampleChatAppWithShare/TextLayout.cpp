@@ -0,0 +1,196 @@
+#include "TextLayout.h"
+#include <algorithm>
+#include <cstdint>
+
+static bool IsLowSurrogate(wchar_t ch)
+{
+    return ch >= 0xDC00 && ch <= 0xDFFF;
+}
+
+GlyphAdvanceCache::GlyphAdvanceCache(MeasureFunction measure)
+    : m_measure(std::move(measure)), m_pages(0x10000 / PAGE_SIZE)
+{
+}
+
+int GlyphAdvanceCache::Advance(wchar_t ch)
+{
+    size_t pageIndex = (size_t)(uint16_t)ch >> PAGE_BITS;
+    std::unique_ptr<int[]>& page = m_pages[pageIndex];
+    if (!page)
+    {
+        page.reset(new int[PAGE_SIZE]());
+        wchar_t first = (wchar_t)(pageIndex << PAGE_BITS);
+        if (m_measure)
+            m_measure(first, (wchar_t)(first + PAGE_SIZE - 1), page.get());
+    }
+    return page[(uint16_t)ch & (PAGE_SIZE - 1)];
+}
+
+int GlyphAdvanceCache::Measure(const std::wstring& text)
+{
+    int width = 0;
+    for (wchar_t ch : text)
+    {
+        width += Advance(ch);
+    }
+    return width;
+}
+
+void GlyphAdvanceCache::Clear()
+{
+    for (auto& page : m_pages)
+    {
+        page.reset();
+    }
+}
+
+TextLayout::TextLayout(GlyphAdvanceCache& advances, const std::wstring& text)
+    : m_text(text)
+{
+    m_prefixWidths.resize(text.size() + 1);
+    m_prefixWidths[0] = 0;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        m_prefixWidths[i + 1] = m_prefixWidths[i] + advances.Advance(text[i]);
+    }
+}
+
+size_t TextLayout::FitCount(int maxWidth) const
+{
+    if (maxWidth <= 0)
+        return 0;
+
+    auto it = std::upper_bound(m_prefixWidths.begin(), m_prefixWidths.end(), maxWidth);
+    size_t count = (size_t)(it - m_prefixWidths.begin()) - 1;
+
+    // Never split a surrogate pair
+    if (count > 0 && count < m_text.size() && IsLowSurrogate(m_text[count]))
+        count--;
+    return count;
+}
+
+const std::wstring& TextLayout::Ellipsize(int maxWidth, const std::wstring& ellipsis, int ellipsisWidth) const
+{
+    if (maxWidth == m_ellipsizedWidth)
+        return m_ellipsized;
+
+    m_ellipsizedWidth = maxWidth;
+    if (Width() <= maxWidth)
+    {
+        m_ellipsized = m_text;
+        return m_ellipsized;
+    }
+
+    size_t count = FitCount(maxWidth - ellipsisWidth);
+    while (count > 0 && m_text[count - 1] == L' ')
+    {
+        count--;
+    }
+    m_ellipsized.assign(m_text, 0, count);
+    m_ellipsized += ellipsis;
+    return m_ellipsized;
+}
+
+void TextLayout::Wrap(int maxWidth, std::vector<Line>& lines) const
+{
+    size_t length = m_text.size();
+    size_t begin = 0;
+
+    while (begin < length)
+    {
+        size_t hardBreak = m_text.find(L'\n', begin);
+        size_t limit = hardBreak == std::wstring::npos ? length : hardBreak;
+
+        // Longest run from 'begin' that fits
+        auto first = m_prefixWidths.begin() + begin + 1;
+        auto last = m_prefixWidths.begin() + limit + 1;
+        size_t end = (size_t)(std::upper_bound(first, last, m_prefixWidths[begin] + maxWidth) - m_prefixWidths.begin()) - 1;
+
+        size_t next;
+        if (end >= limit)
+        {
+            end = limit;
+            next = hardBreak == std::wstring::npos ? length : hardBreak + 1;
+        }
+        else
+        {
+            // Break after the last space that fits; split the word if there is none
+            size_t breakAt = end;
+            while (breakAt > begin && m_text[breakAt] != L' ')
+            {
+                breakAt--;
+            }
+
+            if (breakAt > begin)
+            {
+                end = breakAt;
+            }
+            else if (end == begin)
+            {
+                end = begin + 1;
+                if (end < limit && IsLowSurrogate(m_text[end]))
+                    end++;
+            }
+            else if (IsLowSurrogate(m_text[end]))
+            {
+                // Never split a surrogate pair, and never leave a line empty
+                if (end - 1 > begin)
+                    end--;
+                else
+                    end = begin + 2;
+            }
+
+            next = end;
+            while (next < limit && m_text[next] == L' ')
+            {
+                next++;
+            }
+        }
+
+        size_t lineEnd = end;
+        while (lineEnd > begin && m_text[lineEnd - 1] == L' ')
+        {
+            lineEnd--;
+        }
+        lines.push_back(Line{ begin, lineEnd - begin, RangeWidth(begin, lineEnd) });
+        begin = next;
+    }
+}
+
+TextLayoutCache::TextLayoutCache(GlyphAdvanceCache::MeasureFunction measure, size_t maxEntries)
+    : m_advances(std::move(measure)), m_maxEntries(maxEntries), m_ellipsis(L"...")
+{
+}
+
+const TextLayout& TextLayoutCache::Layout(const std::wstring& text)
+{
+    auto it = m_layouts.find(text);
+    if (it != m_layouts.end())
+        return *it->second;
+
+    if (m_layouts.size() >= m_maxEntries)
+    {
+        m_layouts.clear();
+    }
+
+    std::unique_ptr<TextLayout> layout(new TextLayout(m_advances, text));
+    const TextLayout& result = *layout;
+    m_layouts.emplace(text, std::move(layout));
+    return result;
+}
+
+const std::wstring& TextLayoutCache::Ellipsize(const std::wstring& text, int maxWidth)
+{
+    if (m_ellipsisWidth < 0)
+    {
+        m_ellipsisWidth = m_advances.Measure(m_ellipsis);
+    }
+    return Layout(text).Ellipsize(maxWidth, m_ellipsis, m_ellipsisWidth);
+}
+
+void TextLayoutCache::Clear()
+{
+    m_layouts.clear();
+    m_advances.Clear();
+    m_ellipsisWidth = -1;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Advance widths of one font, measured 256 code units at a time on first use.
+// The measure function fills 'advances' for every code unit in [first, last].
+class GlyphAdvanceCache
+{
+public:
+    typedef std::function<void(wchar_t first, wchar_t last, int* advances)> MeasureFunction;
+
+    explicit GlyphAdvanceCache(MeasureFunction measure);
+
+    int Advance(wchar_t ch);
+    int Measure(const std::wstring& text);
+
+    // Forget everything, e.g. after the font changes
+    void Clear();
+
+private:
+    static const int PAGE_BITS = 8;
+    static const int PAGE_SIZE = 1 << PAGE_BITS;
+
+    MeasureFunction m_measure;
+    std::vector<std::unique_ptr<int[]>> m_pages;
+};
+
+// Pixel layout of one string in one font.
+//
+// Widths of every prefix are computed once, so truncating or wrapping at any
+// width afterwards is a binary search instead of another round of measuring.
+class TextLayout
+{
+public:
+    struct Line
+    {
+        size_t begin;
+        size_t length;
+        int width;
+    };
+
+    TextLayout(GlyphAdvanceCache& advances, const std::wstring& text);
+
+    const std::wstring& Text() const { return m_text; }
+    int Width() const { return m_prefixWidths.back(); }
+
+    // Number of leading code units that fit in 'maxWidth' pixels
+    size_t FitCount(int maxWidth) const;
+
+    // The whole text if it fits, otherwise the longest prefix that fits together
+    // with the ellipsis. Remembers the last answer, so repaints at the same width are free.
+    const std::wstring& Ellipsize(int maxWidth, const std::wstring& ellipsis, int ellipsisWidth) const;
+
+    // Greedy word wrap; '\n' forces a break and words wider than a line are split
+    void Wrap(int maxWidth, std::vector<Line>& lines) const;
+
+private:
+    int RangeWidth(size_t begin, size_t end) const { return m_prefixWidths[end] - m_prefixWidths[begin]; }
+
+    std::wstring m_text;
+    std::vector<int> m_prefixWidths;    // m_prefixWidths[i] = width of the first i code units
+
+    mutable int m_ellipsizedWidth = -1;
+    mutable std::wstring m_ellipsized;
+};
+
+// Layouts for one font, keyed by text and shared by every paint.
+// The cache is dropped wholesale once it grows past 'maxEntries'.
+class TextLayoutCache
+{
+public:
+    explicit TextLayoutCache(GlyphAdvanceCache::MeasureFunction measure, size_t maxEntries = 1024);
+
+    const TextLayout& Layout(const std::wstring& text);
+
+    // 'text' truncated with "..." to fit in 'maxWidth' pixels
+    const std::wstring& Ellipsize(const std::wstring& text, int maxWidth);
+
+    void Clear();
+
+    size_t Count() const { return m_layouts.size(); }
+
+private:
+    GlyphAdvanceCache m_advances;
+    std::unordered_map<std::wstring, std::unique_ptr<TextLayout>> m_layouts;
+    size_t m_maxEntries;
+    std::wstring m_ellipsis;
+    int m_ellipsisWidth = -1;
+};
@@ -0,0 +1,272 @@
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel(uint64_t startTimeMs, uint32_t tickMs)
+    : m_startTimeMs(startTimeMs)
+    , m_tickMs(tickMs ? tickMs : 1)
+    , m_currentTick(0)
+    , m_pendingCount(0)
+    , m_slotHeads(ROOT_SLOTS + LEVEL_SLOTS * (LEVEL_COUNT - 1), NIL)
+{
+}
+
+int32_t TimerWheel::SlotIndex(int level, uint32_t slotInLevel)
+{
+    if (level == 0)
+        return (int32_t)slotInLevel;
+    return (int32_t)(ROOT_SLOTS + (level - 1) * LEVEL_SLOTS + slotInLevel);
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(uint64_t key, uint32_t delayMs, uint32_t payload)
+{
+    // Round up so an event never fires early, and always land at least one tick
+    // ahead so a callback that reschedules itself cannot spin inside Advance
+    uint64_t delayTicks = ((uint64_t)delayMs + m_tickMs - 1) / m_tickMs;
+    if (delayTicks == 0)
+        delayTicks = 1;
+
+    int32_t index = AllocateNode();
+    Node& node = m_nodes[index];
+    node.expiryTick = m_currentTick + delayTicks;
+    node.key = key;
+    node.payload = payload;
+
+    InsertNode(index);
+    LinkToKey(index);
+    m_pendingCount++;
+
+    return ((uint64_t)node.generation << 32) | (uint32_t)(index + 1);
+}
+
+bool TimerWheel::Cancel(TimerId id)
+{
+    int32_t index = (int32_t)(uint32_t)(id & 0xFFFFFFFFu) - 1;
+    uint32_t generation = (uint32_t)(id >> 32);
+
+    if (index < 0 || index >= (int32_t)m_nodes.size())
+        return false;
+
+    Node& node = m_nodes[index];
+    if (node.slot == NIL || node.generation != generation)
+        return false;
+
+    UnlinkFromSlot(index);
+    UnlinkFromKey(index);
+    ReleaseNode(index);
+    m_pendingCount--;
+    return true;
+}
+
+size_t TimerWheel::CancelKey(uint64_t key)
+{
+    auto it = m_keyHeads.find(key);
+    if (it == m_keyHeads.end())
+        return 0;
+
+    size_t cancelled = 0;
+    int32_t index = it->second;
+    m_keyHeads.erase(it);
+
+    while (index != NIL)
+    {
+        int32_t next = m_nodes[index].keyNext;
+        UnlinkFromSlot(index);
+        ReleaseNode(index);
+        m_pendingCount--;
+        cancelled++;
+        index = next;
+    }
+
+    return cancelled;
+}
+
+size_t TimerWheel::PendingCountForKey(uint64_t key) const
+{
+    auto it = m_keyHeads.find(key);
+    if (it == m_keyHeads.end())
+        return 0;
+
+    size_t count = 0;
+    for (int32_t index = it->second; index != NIL; index = m_nodes[index].keyNext)
+    {
+        count++;
+    }
+    return count;
+}
+
+size_t TimerWheel::Advance(uint64_t nowMs, const ExpiredCallback& onExpired)
+{
+    if (nowMs < m_startTimeMs)
+        return 0;
+
+    uint64_t targetTick = (nowMs - m_startTimeMs) / m_tickMs;
+    size_t fired = 0;
+
+    while (m_currentTick < targetTick)
+    {
+        // Nothing pending means nothing can cascade or fire; jump straight ahead
+        if (m_pendingCount == 0)
+        {
+            m_currentTick = targetTick;
+            break;
+        }
+
+        m_currentTick++;
+
+        // Pull the next block of each outer level down whenever the level below wraps
+        if ((m_currentTick & (ROOT_SLOTS - 1)) == 0)
+        {
+            for (int level = 1; level < LEVEL_COUNT; level++)
+            {
+                Cascade(level);
+
+                int shift = ROOT_BITS + LEVEL_BITS * (level - 1);
+                if (((m_currentTick >> shift) & (LEVEL_SLOTS - 1)) != 0)
+                    break;
+            }
+        }
+
+        int32_t slot = SlotIndex(0, (uint32_t)(m_currentTick & (ROOT_SLOTS - 1)));
+        while (m_slotHeads[slot] != NIL)
+        {
+            int32_t index = m_slotHeads[slot];
+            uint64_t key = m_nodes[index].key;
+            uint32_t payload = m_nodes[index].payload;
+
+            UnlinkFromSlot(index);
+            UnlinkFromKey(index);
+            ReleaseNode(index);
+            m_pendingCount--;
+            fired++;
+
+            // The node is already recycled, so the callback may freely schedule or cancel
+            if (onExpired)
+                onExpired(key, payload);
+        }
+    }
+
+    return fired;
+}
+
+void TimerWheel::Cascade(int level)
+{
+    int shift = ROOT_BITS + LEVEL_BITS * (level - 1);
+    int32_t slot = SlotIndex(level, (uint32_t)((m_currentTick >> shift) & (LEVEL_SLOTS - 1)));
+
+    int32_t index = m_slotHeads[slot];
+    m_slotHeads[slot] = NIL;
+
+    while (index != NIL)
+    {
+        int32_t next = m_nodes[index].next;
+        InsertNode(index);
+        index = next;
+    }
+}
+
+void TimerWheel::InsertNode(int32_t index)
+{
+    Node& node = m_nodes[index];
+    uint64_t delta = node.expiryTick > m_currentTick ? node.expiryTick - m_currentTick : 0;
+
+    // Timers beyond the wheel's span park in the outermost level and are
+    // re-filed on each cascade until they come within range
+    uint64_t placement = delta < MAX_SPAN ? node.expiryTick : m_currentTick + MAX_SPAN - 1;
+
+    int32_t slot;
+    if (delta < ROOT_SLOTS)
+    {
+        slot = SlotIndex(0, (uint32_t)(placement & (ROOT_SLOTS - 1)));
+    }
+    else
+    {
+        int level = 1;
+        while (level < LEVEL_COUNT - 1 && delta >= (1ull << (ROOT_BITS + LEVEL_BITS * level)))
+        {
+            level++;
+        }
+        int shift = ROOT_BITS + LEVEL_BITS * (level - 1);
+        slot = SlotIndex(level, (uint32_t)((placement >> shift) & (LEVEL_SLOTS - 1)));
+    }
+
+    node.slot = slot;
+    node.prev = NIL;
+    node.next = m_slotHeads[slot];
+    if (node.next != NIL)
+        m_nodes[node.next].prev = index;
+    m_slotHeads[slot] = index;
+}
+
+void TimerWheel::UnlinkFromSlot(int32_t index)
+{
+    Node& node = m_nodes[index];
+    if (node.prev != NIL)
+        m_nodes[node.prev].next = node.next;
+    else
+        m_slotHeads[node.slot] = node.next;
+
+    if (node.next != NIL)
+        m_nodes[node.next].prev = node.prev;
+
+    node.prev = node.next = NIL;
+}
+
+void TimerWheel::LinkToKey(int32_t index)
+{
+    Node& node = m_nodes[index];
+    auto result = m_keyHeads.emplace(node.key, index);
+
+    node.keyPrev = NIL;
+    node.keyNext = NIL;
+    if (!result.second)
+    {
+        int32_t head = result.first->second;
+        node.keyNext = head;
+        m_nodes[head].keyPrev = index;
+        result.first->second = index;
+    }
+}
+
+void TimerWheel::UnlinkFromKey(int32_t index)
+{
+    Node& node = m_nodes[index];
+    if (node.keyPrev != NIL)
+    {
+        m_nodes[node.keyPrev].keyNext = node.keyNext;
+    }
+    else if (node.keyNext != NIL)
+    {
+        m_keyHeads[node.key] = node.keyNext;
+    }
+    else
+    {
+        m_keyHeads.erase(node.key);
+    }
+
+    if (node.keyNext != NIL)
+        m_nodes[node.keyNext].keyPrev = node.keyPrev;
+
+    node.keyPrev = node.keyNext = NIL;
+}
+
+int32_t TimerWheel::AllocateNode()
+{
+    if (!m_freeNodes.empty())
+    {
+        int32_t index = m_freeNodes.back();
+        m_freeNodes.pop_back();
+        return index;
+    }
+
+    Node node = {};
+    node.prev = node.next = node.keyPrev = node.keyNext = node.slot = NIL;
+    m_nodes.push_back(node);
+    return (int32_t)m_nodes.size() - 1;
+}
+
+void TimerWheel::ReleaseNode(int32_t index)
+{
+    Node& node = m_nodes[index];
+    node.slot = NIL;
+    node.generation++;  // invalidates any outstanding TimerId for this node
+    m_freeNodes.push_back(index);
+}
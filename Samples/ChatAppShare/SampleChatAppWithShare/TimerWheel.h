@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Hierarchical timer wheel for delayed chat events (auto-replies, etc.)
+//
+// The wheel has no clock of its own: the owner feeds it the current time in
+// milliseconds through Advance(), so a single WM_TIMER tick drives every pending
+// event in the app and a virtual clock can drive it anywhere else.
+// Schedule and Cancel are O(1); timers live in a pooled node array so millions
+// of pending events do not cost one heap allocation each.
+class TimerWheel
+{
+public:
+    // Opaque handle returned by Schedule. 0 is never a valid id.
+    typedef uint64_t TimerId;
+
+    // Invoked for every expired timer with the key and payload it was scheduled with
+    typedef std::function<void(uint64_t key, uint32_t payload)> ExpiredCallback;
+
+    explicit TimerWheel(uint64_t startTimeMs = 0, uint32_t tickMs = 10);
+
+    // Schedule an event for 'key' to fire 'delayMs' after the wheel's current time
+    TimerId Schedule(uint64_t key, uint32_t delayMs, uint32_t payload);
+
+    // Cancel a single timer. Returns false if it already fired or was cancelled.
+    bool Cancel(TimerId id);
+
+    // Cancel every pending timer scheduled for 'key'. Returns the number cancelled.
+    size_t CancelKey(uint64_t key);
+
+    // Move the wheel forward to 'nowMs' and fire everything that expired on the way.
+    // Returns the number of callbacks invoked.
+    size_t Advance(uint64_t nowMs, const ExpiredCallback& onExpired);
+
+    size_t PendingCount() const { return m_pendingCount; }
+    size_t PendingCountForKey(uint64_t key) const;
+    uint64_t CurrentTimeMs() const { return m_startTimeMs + m_currentTick * m_tickMs; }
+
+private:
+    static constexpr int LEVEL_COUNT = 4;
+    static constexpr int ROOT_BITS = 8;     // 256 slots of one tick each
+    static constexpr int LEVEL_BITS = 6;    // 64 slots per outer level
+    static constexpr uint32_t ROOT_SLOTS = 1u << ROOT_BITS;
+    static constexpr uint32_t LEVEL_SLOTS = 1u << LEVEL_BITS;
+    static constexpr uint64_t MAX_SPAN = 1ull << (ROOT_BITS + LEVEL_BITS * (LEVEL_COUNT - 1));
+    static constexpr int32_t NIL = -1;
+
+    struct Node
+    {
+        uint64_t expiryTick;
+        uint64_t key;
+        uint32_t payload;
+        uint32_t generation;
+        int32_t prev;           // slot list links
+        int32_t next;
+        int32_t keyPrev;        // per-key list links
+        int32_t keyNext;
+        int32_t slot;           // index into m_slotHeads, NIL when free
+    };
+
+    int32_t AllocateNode();
+    void ReleaseNode(int32_t index);
+    void InsertNode(int32_t index);
+    void UnlinkFromSlot(int32_t index);
+    void LinkToKey(int32_t index);
+    void UnlinkFromKey(int32_t index);
+    void Cascade(int level);
+    static int32_t SlotIndex(int level, uint32_t slotInLevel);
+
+    uint64_t m_startTimeMs;
+    uint32_t m_tickMs;
+    uint64_t m_currentTick;
+    size_t m_pendingCount;
+
+    std::vector<Node> m_nodes;
+    std::vector<int32_t> m_freeNodes;
+    std::vector<int32_t> m_slotHeads;
+    std::unordered_map<uint64_t, int32_t> m_keyHeads;
+};
@@ -16,8 +16,25 @@
 #define COLOR_HOVER          RGB(248, 249, 250)    // Hover background
 #define COLOR_CHAT_BUBBLE_OUT RGB(0, 123, 255)     // Outgoing message
 #define COLOR_CHAT_BUBBLE_IN  RGB(233, 236, 239)   // Incoming message
+#define COLOR_PRESENCE_ONLINE  RGB(34, 197, 94)   // Avatar ring, online
+#define COLOR_PRESENCE_OFFLINE RGB(156, 163, 175)  // Avatar ring, offline
 
 // UI Constants
 #define MAX_LOADSTRING 100
 #define CONTACT_ITEM_HEIGHT 72
-#define AVATAR_SIZE 40
\ No newline at end of file
+#define AVATAR_SIZE 40
+#define SHARED_FILE_ITEM_HEIGHT 24
+#define SHARED_FILE_THUMBNAIL_SIZE 20
+#define FILE_PIPELINE_QUEUE_CAPACITY 4096
+#define SHARE_DIALOG_BUFFER_CHARS 65536     // Multi-select file dialog result
+#define SHARE_BATCH_MAX_FILES 2000          // Kept below the pipeline queue capacity
+#define ROW_CACHE_BUDGET_BYTES (4 * 1024 * 1024)    // Pre-rendered contact rows
+
+// Chat scheduler
+#define IDT_CHAT_SCHEDULER 1
+#define CHAT_SCHEDULER_TICK_MS 50
+#define AUTO_REPLY_DELAY_MS 2000
+#define PRESENCE_COALESCE_MS 250
+
+// Posted to the main window when background threads queue chat events
+#define WM_APP_CHAT_EVENTS (WM_APP + 1)
\ No newline at end of file
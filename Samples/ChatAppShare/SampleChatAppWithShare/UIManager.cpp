@@ -4,6 +4,7 @@
 #include "ChatModels.h"
 #include "FileManager.h"
 #include "WindowProcs.h"
+#include "ChatLayout.h"
 #include <commctrl.h>
 
 #pragma comment(lib, "comctl32.lib")
@@ -19,6 +20,12 @@ HWND hSendButton = nullptr;
 HWND hContactName = nullptr;
 HWND hShareFileButton = nullptr;
 HWND hSharedFilesList = nullptr;
+HWND hSharedFilesHeader = nullptr;
+
+// Solved child rectangles per client size
+static ChatLayoutCache s_chatLayout;
+static int s_layoutWidth = -1;
+static int s_layoutHeight = -1;
 
 void CreateChatUI(HWND hWnd)
 {
@@ -27,6 +34,9 @@ void CreateChatUI(HWND hWnd)
     
     int width = rect.right - rect.left;
     int height = rect.bottom - rect.top;
+    const ChatLayoutRects& layout = s_chatLayout.Get(width, height);
+    s_layoutWidth = width;
+    s_layoutHeight = height;
     
     // Set window background to modern color
     SetClassLongPtr(hWnd, GCLP_HBRBACKGROUND, (LONG_PTR)hBrushBackground);
@@ -36,7 +46,8 @@ void CreateChatUI(HWND hWnd)
         WS_EX_CLIENTEDGE,
         L"LISTBOX", NULL,
         WS_CHILD | WS_VISIBLE | WS_VSCROLL | LBS_NOTIFY | LBS_OWNERDRAWFIXED,
-        20, 20, 280, height - 40,
+        layout[LAYOUT_CONTACTS_LIST].x, layout[LAYOUT_CONTACTS_LIST].y,
+        layout[LAYOUT_CONTACTS_LIST].width, layout[LAYOUT_CONTACTS_LIST].height,
         hWnd, (HMENU)IDC_CONTACTS_LIST, hInst, NULL);
     
     // Set custom item height for contact list
@@ -45,7 +56,8 @@ void CreateChatUI(HWND hWnd)
     // Create contact name label with modern styling
     hContactName = CreateWindow(L"STATIC", L"Select a contact to start chatting",
         WS_CHILD | WS_VISIBLE | SS_LEFT,
-        320, 20, 300, 30,
+        layout[LAYOUT_CONTACT_NAME].x, layout[LAYOUT_CONTACT_NAME].y,
+        layout[LAYOUT_CONTACT_NAME].width, layout[LAYOUT_CONTACT_NAME].height,
         hWnd, (HMENU)IDC_CONTACT_NAME, hInst, NULL);
     
     // Create chat display area with modern styling
@@ -53,40 +65,47 @@ void CreateChatUI(HWND hWnd)
         WS_EX_CLIENTEDGE,
         L"EDIT", NULL,
         WS_CHILD | WS_VISIBLE | WS_VSCROLL | ES_MULTILINE | ES_READONLY | ES_AUTOVSCROLL,
-        320, 60, width - 600, height - 280,
+        layout[LAYOUT_CHAT_DISPLAY].x, layout[LAYOUT_CHAT_DISPLAY].y,
+        layout[LAYOUT_CHAT_DISPLAY].width, layout[LAYOUT_CHAT_DISPLAY].height,
         hWnd, (HMENU)IDC_CHAT_DISPLAY, hInst, NULL);
     
     // Create shared files section header
-    CreateWindow(L"STATIC", L"Shared Files",
+    hSharedFilesHeader = CreateWindow(L"STATIC", L"Shared Files",
         WS_CHILD | WS_VISIBLE | SS_LEFT,
-        width - 260, 20, 120, 30,
+        layout[LAYOUT_SHARED_FILES_HEADER].x, layout[LAYOUT_SHARED_FILES_HEADER].y,
+        layout[LAYOUT_SHARED_FILES_HEADER].width, layout[LAYOUT_SHARED_FILES_HEADER].height,
         hWnd, NULL, hInst, NULL);
         
     // Create shared files list with modern styling
     hSharedFilesList = CreateWindowEx(
         WS_EX_CLIENTEDGE,
         L"LISTBOX", NULL,
-        WS_CHILD | WS_VISIBLE | WS_VSCROLL | LBS_NOTIFY,
-        width - 260, 60, 240, height - 280,
+        WS_CHILD | WS_VISIBLE | WS_VSCROLL | LBS_NOTIFY | LBS_OWNERDRAWFIXED | LBS_NODATA,
+        layout[LAYOUT_SHARED_FILES_LIST].x, layout[LAYOUT_SHARED_FILES_LIST].y,
+        layout[LAYOUT_SHARED_FILES_LIST].width, layout[LAYOUT_SHARED_FILES_LIST].height,
         hWnd, (HMENU)IDC_SHARED_FILES_LIST, hInst, NULL);
+    ::SendMessage(hSharedFilesList, LB_SETITEMHEIGHT, 0, SHARED_FILE_ITEM_HEIGHT);
     
     // Create message input with placeholder styling
     hMessageInput = CreateWindowEx(
         WS_EX_CLIENTEDGE,
         L"EDIT", NULL,
         WS_CHILD | WS_VISIBLE | ES_MULTILINE | ES_AUTOVSCROLL,
-        320, height - 200, width - 600, 60,
+        layout[LAYOUT_MESSAGE_INPUT].x, layout[LAYOUT_MESSAGE_INPUT].y,
+        layout[LAYOUT_MESSAGE_INPUT].width, layout[LAYOUT_MESSAGE_INPUT].height,
         hWnd, (HMENU)IDC_MESSAGE_INPUT, hInst, NULL);
     
     // Create modern styled buttons
     hSendButton = CreateWindow(L"BUTTON", L"Send",
         WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON | BS_OWNERDRAW,
-        320, height - 130, 100, 45,
+        layout[LAYOUT_SEND_BUTTON].x, layout[LAYOUT_SEND_BUTTON].y,
+        layout[LAYOUT_SEND_BUTTON].width, layout[LAYOUT_SEND_BUTTON].height,
         hWnd, (HMENU)IDC_SEND_BUTTON, hInst, NULL);
     
     hShareFileButton = CreateWindow(L"BUTTON", L"Share File",
         WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON | BS_OWNERDRAW,
-        440, height - 130, 120, 45,
+        layout[LAYOUT_SHARE_FILE_BUTTON].x, layout[LAYOUT_SHARE_FILE_BUTTON].y,
+        layout[LAYOUT_SHARE_FILE_BUTTON].width, layout[LAYOUT_SHARE_FILE_BUTTON].height,
         hWnd, (HMENU)IDC_SHARE_FILE_BUTTON, hInst, NULL);
     
     // Populate contacts list
@@ -114,23 +133,36 @@ void ResizeChatUI(HWND hWnd)
     int width = rect.right - rect.left;
     int height = rect.bottom - rect.top;
     
-    if (hContactsList) {
-        SetWindowPos(hContactsList, NULL, 20, 20, 280, height - 40, SWP_NOZORDER);
-    }
-    if (hChatDisplay) {
-        SetWindowPos(hChatDisplay, NULL, 320, 60, width - 600, height - 280, SWP_NOZORDER);
-    }
-    if (hSharedFilesList) {
-        SetWindowPos(hSharedFilesList, NULL, width - 260, 60, 240, height - 280, SWP_NOZORDER);
-    }
-    if (hMessageInput) {
-        SetWindowPos(hMessageInput, NULL, 320, height - 200, width - 600, 60, SWP_NOZORDER);
-    }
-    if (hSendButton) {
-        SetWindowPos(hSendButton, NULL, 320, height - 130, 100, 45, SWP_NOZORDER);
+    // WM_SIZE also arrives on restore and activation with an unchanged size
+    if (width == s_layoutWidth && height == s_layoutHeight) return;
+    s_layoutWidth = width;
+    s_layoutHeight = height;
+    
+    const ChatLayoutRects& layout = s_chatLayout.Get(width, height);
+    HWND controls[LAYOUT_SLOT_COUNT] = {};
+    controls[LAYOUT_CONTACTS_LIST] = hContactsList;
+    controls[LAYOUT_CONTACT_NAME] = hContactName;
+    controls[LAYOUT_CHAT_DISPLAY] = hChatDisplay;
+    controls[LAYOUT_SHARED_FILES_HEADER] = hSharedFilesHeader;
+    controls[LAYOUT_SHARED_FILES_LIST] = hSharedFilesList;
+    controls[LAYOUT_MESSAGE_INPUT] = hMessageInput;
+    controls[LAYOUT_SEND_BUTTON] = hSendButton;
+    controls[LAYOUT_SHARE_FILE_BUTTON] = hShareFileButton;
+    
+    // Move everything in one batch so the window repaints once, not once per control
+    HDWP hdwp = BeginDeferWindowPos(LAYOUT_SLOT_COUNT);
+    for (int slot = 0; slot < LAYOUT_SLOT_COUNT; slot++) {
+        if (!controls[slot]) continue;
+        
+        const LayoutRect& r = layout[slot];
+        if (hdwp) {
+            hdwp = DeferWindowPos(hdwp, controls[slot], NULL, r.x, r.y, r.width, r.height, SWP_NOZORDER | SWP_NOACTIVATE);
+        } else {
+            SetWindowPos(controls[slot], NULL, r.x, r.y, r.width, r.height, SWP_NOZORDER | SWP_NOACTIVATE);
+        }
     }
-    if (hShareFileButton) {
-        SetWindowPos(hShareFileButton, NULL, 440, height - 130, 120, 45, SWP_NOZORDER);
+    if (hdwp) {
+        EndDeferWindowPos(hdwp);
     }
 }
 
@@ -10,6 +10,7 @@ extern HWND hSendButton;
 extern HWND hContactName;
 extern HWND hShareFileButton;
 extern HWND hSharedFilesList;
+extern HWND hSharedFilesHeader;
 
 // UI management functions
 void CreateChatUI(HWND hWnd);
@@ -3,6 +3,7 @@
 #include "ModernUI.h"
 #include "ChatModels.h"
 #include "UIManager.h"
+#include "ContactListView.h"
 
 // External declarations for UI window handles
 extern HWND hSendButton;
@@ -108,7 +109,7 @@ LRESULT CALLBACK ModernListBoxProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lP
             int actualContactIndex = topIndex + clickedVisiblePos;
             
             // Ensure the clicked contact is valid
-            if (actualContactIndex >= 0 && actualContactIndex < (int)contacts.size())
+            if (AcquireContactSnapshot()->IsValidIndex(actualContactIndex))
             {
                 // Set the correct selection in the listbox
                 ::SendMessage(hWnd, LB_SETCURSEL, actualContactIndex, 0);
@@ -123,45 +124,28 @@ LRESULT CALLBACK ModernListBoxProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lP
         }
         break;
         
+    case WM_ERASEBKGND:
+        if (hWnd == hContactsList)
+        {
+            // Every pixel comes from the back buffer; erasing first only flickers
+            return 1;
+        }
+        break;
+        
     case WM_PAINT:
         if (hWnd == hContactsList)
         {
-            PAINTSTRUCT ps;
-            HDC hdc = BeginPaint(hWnd, &ps);
-            
-            RECT clientRect;
-            GetClientRect(hWnd, &clientRect);
-            
-            // Fill background
-            FillRect(hdc, &clientRect, hBrushSurface);
-            
-            int itemCount = (int)contacts.size();
-            int selectedIndex = (int)::SendMessage(hWnd, LB_GETCURSEL, 0, 0);
-            
-            // Get the first visible item index to handle scrolling correctly
-            int topIndex = (int)::SendMessage(hWnd, LB_GETTOPINDEX, 0, 0);
-            
-            // Calculate how many items can be visible
-            int visibleItemCount = (clientRect.bottom / CONTACT_ITEM_HEIGHT) + 1;
-            
-            // Draw only the visible items
-            for (int visiblePos = 0; visiblePos < visibleItemCount; visiblePos++)
-            {
-                int actualIndex = topIndex + visiblePos;
-                
-                // Stop if we've reached the end of the contact list
-                if (actualIndex >= itemCount) break;
-                
-                RECT itemRect = {0, visiblePos * CONTACT_ITEM_HEIGHT, clientRect.right, (visiblePos + 1) * CONTACT_ITEM_HEIGHT};
-                
-                // Draw the contact that should be visible at this position
-                DrawContactItem(hdc, itemRect, contacts[actualIndex], actualIndex == selectedIndex);
-            }
-            
-            EndPaint(hWnd, &ps);
+            PaintContactList(hWnd);
             return 0;
         }
         break;
+        
+    case WM_DESTROY:
+        if (hWnd == hContactsList)
+        {
+            ReleaseContactListView();
+        }
+        break;
     }
     
     return CallWindowProc(originalListBoxProc, hWnd, msg, wParam, lParam);
@@ -0,0 +1,103 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(size_t threadCount, size_t queueCapacity)
+    : m_capacity(queueCapacity > 0 ? queueCapacity : 1), m_stopping(false)
+{
+    if (threadCount == 0)
+        threadCount = 1;
+
+    m_threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++)
+    {
+        m_threads.emplace_back(&WorkerPool::WorkerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    Shutdown();
+}
+
+bool WorkerPool::Submit(Job job)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_spaceAvailable.wait(lock, [this]() { return m_stopping || m_jobs.size() < m_capacity; });
+    if (m_stopping)
+        return false;
+
+    m_jobs.push_back(std::move(job));
+    lock.unlock();
+    m_jobAvailable.notify_one();
+    return true;
+}
+
+bool WorkerPool::TrySubmit(Job job)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_stopping || m_jobs.size() >= m_capacity)
+        return false;
+
+    m_jobs.push_back(std::move(job));
+    lock.unlock();
+    m_jobAvailable.notify_one();
+    return true;
+}
+
+void WorkerPool::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping && m_threads.empty())
+            return;
+        m_stopping = true;
+    }
+    m_jobAvailable.notify_all();
+    m_spaceAvailable.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+    m_threads.clear();
+}
+
+size_t WorkerPool::CancelPending()
+{
+    size_t dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        dropped = m_jobs.size();
+        m_jobs.clear();
+    }
+    m_spaceAvailable.notify_all();
+    return dropped;
+}
+
+size_t WorkerPool::Pending() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.size();
+}
+
+void WorkerPool::WorkerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobAvailable.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+
+            // Drain what was accepted before stopping
+            if (m_jobs.empty())
+                return;
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        m_spaceAvailable.notify_one();
+
+        job();
+    }
+}
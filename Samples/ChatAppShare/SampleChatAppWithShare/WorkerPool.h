@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads draining a bounded job queue.
+//
+// Submit blocks while the queue is full, which pushes back on whoever is
+// producing work faster than it can be done; TrySubmit never blocks. Shutdown
+// lets queued jobs finish, then joins the threads.
+class WorkerPool
+{
+public:
+    typedef std::function<void()> Job;
+
+    WorkerPool(size_t threadCount, size_t queueCapacity);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // False once the pool is shutting down
+    bool Submit(Job job);
+    bool TrySubmit(Job job);
+
+    void Shutdown();
+
+    // Drop jobs that have not started yet; returns how many were dropped
+    size_t CancelPending();
+
+    size_t Pending() const;
+    size_t ThreadCount() const { return m_threads.size(); }
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> m_threads;
+    std::deque<Job> m_jobs;
+    size_t m_capacity;
+    bool m_stopping;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_jobAvailable;
+    std::condition_variable m_spaceAvailable;
+};
@@ -0,0 +1,107 @@
+#include "HdrHistogram.h"
+#include <algorithm>
+
+// 128 buckets for values below 128, then 64 per power of two above that
+static const int SUB_BUCKET_BITS = 7;
+static const uint64_t SUB_BUCKET_COUNT = 1ull << SUB_BUCKET_BITS;
+static const int SUB_BUCKET_HALF_BITS = SUB_BUCKET_BITS - 1;
+static const size_t BUCKET_SLOTS = ((64 - SUB_BUCKET_BITS) << SUB_BUCKET_HALF_BITS) + SUB_BUCKET_COUNT;
+
+static int HighestBit(uint64_t value)
+{
+    int bit = 0;
+    while (value >>= 1)
+    {
+        bit++;
+    }
+    return bit;
+}
+
+HdrHistogram::HdrHistogram()
+    : m_counts(BUCKET_SLOTS, 0), m_total(0), m_min(UINT64_MAX), m_max(0)
+{
+}
+
+size_t HdrHistogram::IndexOf(uint64_t value)
+{
+    // shift is how many low bits a value of this magnitude loses
+    int shift = HighestBit(value | (SUB_BUCKET_COUNT - 1)) - SUB_BUCKET_HALF_BITS;
+    return ((size_t)shift << SUB_BUCKET_HALF_BITS) + (size_t)(value >> shift);
+}
+
+uint64_t HdrHistogram::LowestEquivalent(size_t index)
+{
+    if (index < SUB_BUCKET_COUNT)
+        return index;
+
+    int shift = (int)(index >> SUB_BUCKET_HALF_BITS) - 1;
+    uint64_t subBucket = index - ((size_t)shift << SUB_BUCKET_HALF_BITS);
+    return subBucket << shift;
+}
+
+uint64_t HdrHistogram::HighestEquivalent(size_t index)
+{
+    if (index + 1 >= BUCKET_SLOTS)
+        return UINT64_MAX;
+    return LowestEquivalent(index + 1) - 1;
+}
+
+void HdrHistogram::Record(uint64_t value)
+{
+    m_counts[IndexOf(value)]++;
+    m_total++;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+}
+
+void HdrHistogram::Merge(const HdrHistogram& other)
+{
+    for (size_t i = 0; i < BUCKET_SLOTS; i++)
+    {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_total += other.m_total;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+void HdrHistogram::Reset()
+{
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_total = 0;
+    m_min = UINT64_MAX;
+    m_max = 0;
+}
+
+double HdrHistogram::Mean() const
+{
+    if (m_total == 0)
+        return 0;
+
+    double sum = 0;
+    for (size_t i = 0; i < BUCKET_SLOTS; i++)
+    {
+        if (m_counts[i])
+            sum += (double)m_counts[i] * ((double)LowestEquivalent(i) + (double)HighestEquivalent(i)) / 2;
+    }
+    return sum / (double)m_total;
+}
+
+uint64_t HdrHistogram::ValueAtPercentile(double percentile) const
+{
+    if (m_total == 0)
+        return 0;
+
+    // The sample at this rank, counting from one, is the one asked for
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)m_total + 0.5);
+    rank = std::max<uint64_t>(1, std::min(rank, m_total));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_SLOTS; i++)
+    {
+        seen += m_counts[i];
+        if (seen >= rank)
+            return std::min(HighestEquivalent(i), m_max);
+    }
+    return m_max;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Log-linear histogram in the style of HdrHistogram: each power-of-two range
+// of values is split into 64 linear sub-buckets, so any recorded value is
+// reported to within 1/64 (about 1.6%) of itself, from 1 up to 2^63, in a
+// fixed 30 KB of counts. Recording is an index computation and an increment;
+// it is not thread-safe, so give each thread its own and Merge them.
+class HdrHistogram
+{
+public:
+    HdrHistogram();
+
+    void Record(uint64_t value);
+    void Merge(const HdrHistogram& other);
+    void Reset();
+
+    uint64_t Count() const { return m_total; }
+    uint64_t Min() const { return m_total ? m_min : 0; }
+    uint64_t Max() const { return m_max; }
+    double Mean() const;
+
+    // Highest value equivalent to the one at the given percentile (0..100)
+    uint64_t ValueAtPercentile(double percentile) const;
+
+private:
+    static size_t IndexOf(uint64_t value);
+    static uint64_t LowestEquivalent(size_t index);
+    static uint64_t HighestEquivalent(size_t index);
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_total;
+    uint64_t m_min;
+    uint64_t m_max;
+};
@@ -0,0 +1,280 @@
+// ServiceLoadGen.cpp : Open-loop load generator for the HelloWorld background service.
+//
+// Drives a number of clients, each on its own connection, at a fixed total
+// request rate. Requests go out on a schedule that does not wait for replies,
+// and each round trip is timed from when its request was due rather than when
+// it was actually sent, so a stalled service shows up as the queueing delay
+// every client behind it would have seen (no coordinated omission).
+//
+// With --one-shot each request instead connects, waits for its reply and
+// disconnects, as the client did before it kept its connection open. A client
+// then has one request outstanding at a time, and whatever the service or the
+// connection setup cannot keep up with shows as latency against the schedule.
+
+#include "../SampleChatAppWithShare/BackgroundService.h"
+#include "../ShareApp/HelloWorldClient.h"
+#include "HdrHistogram.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct LoadOptions
+{
+    size_t clients = 8;
+    double rate = 10000;            // requests per second, across all clients
+    double durationSeconds = 10;
+    double warmupSeconds = 2;       // run before measuring, excluded from the results
+    double drainSeconds = 5;        // how long to wait for stragglers at the end
+    std::string request = "GET_HELLO_WORLD";
+    std::string endpoint = HelloWorldClient::PIPE_NAME;
+    bool spawnServer = false;
+    bool oneShot = false;           // a connection per request instead of one per client
+    int cacheTtlMs = -1;            // >= 0: the spawned service caches replies to the request's verb
+    double maxP99Microseconds = 0;  // non-zero: fail the run above this
+};
+
+// One connection and its schedule. The histogram and lastReply are written
+// only for replies that arrived, whose callbacks all run on the client's
+// reader thread, or on the sender with --one-shot; failures may be reported
+// from the sender and only count.
+struct ClientRun
+{
+    std::unique_ptr<HelloWorldClient> client;      // null with --one-shot
+    HdrHistogram latency;
+    Clock::time_point lastReply;
+    std::atomic<uint64_t> sent{ 0 };
+    std::atomic<uint64_t> measured{ 0 };        // sent inside the measured window
+    std::atomic<uint64_t> answered{ 0 };        // replies to those, and failures
+    std::atomic<uint64_t> failed{ 0 };
+    std::thread sender;
+};
+
+static void PrintUsage()
+{
+    printf("Usage: ServiceLoadGen [options]\n"
+        "  --clients N        concurrent connections (default 8)\n"
+        "  --rate R           total requests per second (default 10000)\n"
+        "  --duration S       measured seconds (default 10)\n"
+        "  --warmup S         seconds before measuring (default 2)\n"
+        "  --request TEXT     request payload (default GET_HELLO_WORLD)\n"
+        "  --endpoint NAME    pipe name or socket path (default the service's)\n"
+        "  --spawn-server     run the service in this process\n"
+        "  --one-shot         connect for every request, as the old client did\n"
+        "  --cache-ttl-ms MS  with --spawn-server, cache replies to the request's verb\n"
+        "  --max-p99-us US    exit with failure if p99 latency is above this\n");
+}
+
+static bool ParseOptions(int argc, char* argv[], LoadOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string name = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (name == "--spawn-server")
+            options.spawnServer = true;
+        else if (name == "--one-shot")
+            options.oneShot = true;
+        else if (name == "--clients" && hasValue)
+            options.clients = (size_t)strtoul(argv[++i], nullptr, 10);
+        else if (name == "--rate" && hasValue)
+            options.rate = atof(argv[++i]);
+        else if (name == "--duration" && hasValue)
+            options.durationSeconds = atof(argv[++i]);
+        else if (name == "--warmup" && hasValue)
+            options.warmupSeconds = atof(argv[++i]);
+        else if (name == "--request" && hasValue)
+            options.request = argv[++i];
+        else if (name == "--endpoint" && hasValue)
+            options.endpoint = argv[++i];
+        else if (name == "--cache-ttl-ms" && hasValue)
+            options.cacheTtlMs = atoi(argv[++i]);
+        else if (name == "--max-p99-us" && hasValue)
+            options.maxP99Microseconds = atof(argv[++i]);
+        else
+            return false;
+    }
+    return options.clients > 0 && options.rate > 0 && options.durationSeconds > 0 && options.warmupSeconds >= 0;
+}
+
+static void RecordReply(ClientRun& run, Clock::time_point due, bool measured, bool succeeded)
+{
+    if (!measured)
+        return;
+
+    if (succeeded)
+    {
+        run.lastReply = Clock::now();
+        run.latency.Record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(run.lastReply - due).count());
+    }
+    else
+    {
+        run.failed++;
+    }
+    run.answered.fetch_add(1, std::memory_order_release);
+}
+
+static void RunSchedule(ClientRun& run, const LoadOptions& options, Clock::time_point start,
+    Clock::time_point measureFrom, Clock::time_point end)
+{
+    const std::chrono::duration<double> interval(options.clients / options.rate);
+
+    for (uint64_t sequence = 0;; sequence++)
+    {
+        Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(interval * (double)sequence);
+        if (due >= end)
+            break;
+
+        // Behind schedule: send at once and let the latency show it
+        std::this_thread::sleep_until(due);
+
+        bool measured = due >= measureFrom;
+        run.sent++;
+        if (measured)
+            run.measured++;
+
+        if (options.oneShot)
+        {
+            bool succeeded = !HelloWorldClient::RequestOnce(options.endpoint, options.request).empty();
+            RecordReply(run, due, measured, succeeded);
+        }
+        else
+        {
+            run.client->RequestAsync(options.request, [&run, due, measured](bool succeeded, const std::string&) {
+                RecordReply(run, due, measured, succeeded);
+            });
+        }
+    }
+}
+
+static void PrintLatency(const char* label, uint64_t nanoseconds)
+{
+    printf("  %-7s %10.1f us\n", label, nanoseconds / 1000.0);
+}
+
+int main(int argc, char* argv[])
+{
+    LoadOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    std::unique_ptr<HelloWorldService> service;
+    if (options.spawnServer)
+    {
+        service = std::make_unique<HelloWorldService>();
+        if (options.cacheTtlMs >= 0)
+            service->Cache().SetPolicy(options.request.substr(0, options.request.find(' ')), std::chrono::milliseconds(options.cacheTtlMs));
+        if (!service->Start())
+            return 1;
+        options.endpoint = PIPE_NAME;
+    }
+
+    std::vector<std::unique_ptr<ClientRun>> runs;
+    for (size_t i = 0; i < options.clients; i++)
+    {
+        runs.push_back(std::make_unique<ClientRun>());
+        if (!options.oneShot)
+            runs.back()->client = std::make_unique<HelloWorldClient>(options.endpoint);
+    }
+
+    printf("%zu %s clients, %.0f req/s target, %.1f s warm-up, %.1f s measured, request \"%s\"\n",
+        options.clients, options.oneShot ? "one-shot" : "persistent", options.rate, options.warmupSeconds,
+        options.durationSeconds, options.request.c_str());
+
+    // Clients start a fraction of an interval apart so they do not send in lockstep
+    Clock::time_point start = Clock::now() + std::chrono::milliseconds(100);
+    Clock::time_point measureFrom = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.warmupSeconds));
+    Clock::time_point end = measureFrom + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.durationSeconds));
+    const std::chrono::duration<double> stagger(1.0 / options.rate);
+
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        Clock::time_point clientStart = start + std::chrono::duration_cast<Clock::duration>(stagger * (double)i);
+        runs[i]->sender = std::thread(RunSchedule, std::ref(*runs[i]), std::cref(options), clientStart, measureFrom, end);
+    }
+    for (auto& run : runs)
+    {
+        run->sender.join();
+    }
+
+    // Wait for the last replies, but not for ever if the service is stuck
+    Clock::time_point drainDeadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.drainSeconds));
+    uint64_t unanswered;
+    do
+    {
+        unanswered = 0;
+        for (auto& run : runs)
+        {
+            unanswered += run->measured - run->answered.load(std::memory_order_acquire);
+        }
+        if (unanswered)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    } while (unanswered && Clock::now() < drainDeadline);
+
+    // Histograms are only safe to read once their client is done with them
+    std::string serverMetrics;
+    if (!unanswered)
+    {
+        HelloWorldClient metricsClient(options.endpoint);
+        serverMetrics = metricsClient.Request(SERVICE_METRICS_REQUEST);
+    }
+
+    HdrHistogram latency;
+    Clock::time_point lastReply = end;
+    uint64_t sent = 0, measured = 0, failed = 0;
+    for (auto& run : runs)
+    {
+        sent += run->sent;
+        measured += run->measured;
+        failed += run->failed;
+        if (!unanswered)
+        {
+            latency.Merge(run->latency);
+            lastReply = std::max(lastReply, run->lastReply);
+        }
+    }
+
+    // Over capacity the replies trail the schedule, and the rate they came back at is what was sustained
+    double elapsedSeconds = std::chrono::duration<double>(lastReply - measureFrom).count();
+
+    printf("sent %llu, measured %llu, completed %llu, failed %llu, unanswered %llu\n",
+        (unsigned long long)sent, (unsigned long long)measured, (unsigned long long)latency.Count(),
+        (unsigned long long)failed, (unsigned long long)unanswered);
+    printf("throughput %.0f req/s\n", latency.Count() / elapsedSeconds);
+    printf("round-trip latency from scheduled send:\n");
+    PrintLatency("min", latency.Min());
+    PrintLatency("p50", latency.ValueAtPercentile(50));
+    PrintLatency("p90", latency.ValueAtPercentile(90));
+    PrintLatency("p99", latency.ValueAtPercentile(99));
+    PrintLatency("p99.9", latency.ValueAtPercentile(99.9));
+    PrintLatency("max", latency.Max());
+    printf("  %-7s %10.1f us\n", "mean", latency.Mean() / 1000.0);
+    if (!serverMetrics.empty() && serverMetrics != UNKNOWN_REQUEST_RESPONSE)
+        printf("server: %s\n", serverMetrics.c_str());
+
+    // Stop the clients before the service so they do not chase a restart
+    runs.clear();
+    if (service)
+        service->Stop();
+
+    if (failed || unanswered || latency.Count() == 0)
+        return 1;
+    if (options.maxP99Microseconds > 0 && latency.ValueAtPercentile(99) / 1000.0 > options.maxP99Microseconds)
+    {
+        printf("p99 above the %.1f us limit\n", options.maxP99Microseconds);
+        return 1;
+    }
+    return 0;
+}
@@ -1,67 +1,489 @@
 #include "HelloWorldClient.h"
-#include <iostream>
+#include <chrono>
 #include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
+#ifdef _WIN32
 const std::string HelloWorldClient::PIPE_NAME = "\\\\.\\pipe\\HelloWorldService";
+#else
+const std::string HelloWorldClient::PIPE_NAME = "/tmp/HelloWorldService.sock";
+#endif
 
-std::string HelloWorldClient::GetHelloWorld() {
-    HANDLE hPipe;
-    char buffer[1024];
-    DWORD bytesRead, bytesWritten;
-    
-    // Try to open the named pipe
-    while (true) {
-        hPipe = CreateFileA(
-            PIPE_NAME.c_str(),
-            GENERIC_READ | GENERIC_WRITE,
-            0,
-            nullptr,
-            OPEN_EXISTING,
-            0,
-            nullptr
-        );
+/**
+ * One open channel to the service, in message mode with one frame per message.
+ * The reader thread may be blocked in Read while another thread writes; writers
+ * take turns on the connection's own lock.
+ */
+class HelloWorldClient::Connection {
+public:
+    ~Connection() {
+#ifdef _WIN32
+        if (m_pipe != INVALID_HANDLE_VALUE) CloseHandle(m_pipe);
+        if (m_readEvent) CloseHandle(m_readEvent);
+        if (m_writeEvent) CloseHandle(m_writeEvent);
+        if (m_interruptEvent) CloseHandle(m_interruptEvent);
+#else
+        if (m_socket >= 0) close(m_socket);
+#endif
+    }
+
+    bool Open(const std::string& endpoint) {
+#ifdef _WIN32
+        while (true) {
+            // Overlapped, so a write does not queue behind the reader's pending read
+            m_pipe = CreateFileA(endpoint.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+            if (m_pipe != INVALID_HANDLE_VALUE) {
+                break;
+            }
+
+            if (GetLastError() != ERROR_PIPE_BUSY) {
+                std::cerr << "Could not open pipe. Error: " << GetLastError() << std::endl;
+                return false;
+            }
+
+            // All pipe instances are busy, wait a bit
+            if (!WaitNamedPipeA(endpoint.c_str(), TIMEOUT_MS)) {
+                std::cerr << "Could not open pipe: timeout after " << TIMEOUT_MS << "ms." << std::endl;
+                return false;
+            }
+        }
+
+        // Set pipe to message-read mode
+        DWORD dwMode = PIPE_READMODE_MESSAGE;
+        if (!SetNamedPipeHandleState(m_pipe, &dwMode, nullptr, nullptr)) {
+            std::cerr << "SetNamedPipeHandleState failed. Error: " << GetLastError() << std::endl;
+            return false;
+        }
+
+        m_readEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        m_writeEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        m_interruptEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        return m_readEvent && m_writeEvent && m_interruptEvent;
+#else
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (endpoint.size() >= sizeof(address.sun_path)) {
+            return false;
+        }
+        memcpy(address.sun_path, endpoint.c_str(), endpoint.size() + 1);
+
+        m_socket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        return m_socket >= 0 && connect(m_socket, (sockaddr*)&address, sizeof(address)) == 0;
+#endif
+    }
+
+    bool WriteRequest(uint64_t requestId, const std::string& request) {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        EncodeMessage(FrameType::Request, requestId, request.size(), m_frames);
+        for (const EncodedFrame& frame : m_frames) {
+#ifdef _WIN32
+            // Pipes have no gather write; copy header and payload into one pooled buffer
+            m_frameBuffer.clear();
+            AppendFrame(frame, request, m_frameBuffer);
+            OVERLAPPED overlapped = {};
+            overlapped.hEvent = m_writeEvent;
+            DWORD bytesWritten = 0;
+            if (!WriteFile(m_pipe, m_frameBuffer.data(), static_cast<DWORD>(m_frameBuffer.size()), nullptr, &overlapped) &&
+                GetLastError() != ERROR_IO_PENDING) {
+                return false;
+            }
+
+            // A service that stopped reading must not hold the writer once the connection is dropped
+            HANDLE events[] = { m_writeEvent, m_interruptEvent };
+            if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0) {
+                CancelIoEx(m_pipe, &overlapped);
+                GetOverlappedResult(m_pipe, &overlapped, &bytesWritten, TRUE);
+                return false;
+            }
+            if (!GetOverlappedResult(m_pipe, &overlapped, &bytesWritten, TRUE) || bytesWritten != m_frameBuffer.size()) {
+                return false;
+            }
+#else
+            iovec parts[2];
+            parts[0].iov_base = (void*)frame.header;
+            parts[0].iov_len = FRAME_HEADER_SIZE;
+            parts[1].iov_base = (void*)(request.data() + frame.payloadOffset);
+            parts[1].iov_len = frame.payloadLength;
+            msghdr header = {};
+            header.msg_iov = parts;
+            header.msg_iovlen = 2;
+            if (sendmsg(m_socket, &header, MSG_NOSIGNAL) != (ssize_t)(FRAME_HEADER_SIZE + frame.payloadLength)) {
+                return false;
+            }
+#endif
+        }
+        return true;
+    }
 
-        if (hPipe != INVALID_HANDLE_VALUE) {
-            break;
+    /**
+     * Wait for the next complete reply or replies
+     */
+    bool ReadMessages(std::vector<FrameMessage>& messages) {
+        while (messages.empty()) {
+            if (!Read(m_message) || !m_decoder.Feed(m_message.data(), m_message.size(), messages)) {
+                return false;
+            }
         }
+        return true;
+    }
+
+    // Wake a Read or WriteRequest blocked on this connection
+    void Interrupt() {
+#ifdef _WIN32
+        SetEvent(m_interruptEvent);
+#else
+        shutdown(m_socket, SHUT_RDWR);
+#endif
+    }
+
+private:
+    bool Read(std::string& message) {
+        message.clear();
+#ifdef _WIN32
+        char buffer[4096];
+        while (true) {
+            OVERLAPPED overlapped = {};
+            overlapped.hEvent = m_readEvent;
+            DWORD bytesRead = 0;
+            BOOL succeeded = ReadFile(m_pipe, buffer, sizeof(buffer), nullptr, &overlapped);
+            if (!succeeded && GetLastError() != ERROR_IO_PENDING && GetLastError() != ERROR_MORE_DATA) {
+                return false;
+            }
+
+            // Stay interruptible even if Interrupt ran before this read was issued
+            HANDLE events[] = { m_readEvent, m_interruptEvent };
+            if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0) {
+                CancelIoEx(m_pipe, &overlapped);
+                GetOverlappedResult(m_pipe, &overlapped, &bytesRead, TRUE);
+                return false;
+            }
+            succeeded = GetOverlappedResult(m_pipe, &overlapped, &bytesRead, TRUE);
+            DWORD error = succeeded ? ERROR_SUCCESS : GetLastError();
+            if (!succeeded && error != ERROR_MORE_DATA) {
+                return false;
+            }
 
-        if (GetLastError() != ERROR_PIPE_BUSY) {
-            std::cerr << "Could not open pipe. Error: " << GetLastError() << std::endl;
-            return "";
+            // A long reply arrives in pieces; the last one completes normally
+            message.append(buffer, bytesRead);
+            if (succeeded) {
+                return true;
+            }
         }
+#else
+        static thread_local std::vector<char> buffer(FRAME_HEADER_SIZE + MAX_FRAME_PAYLOAD);
+        ssize_t length = recv(m_socket, buffer.data(), buffer.size(), MSG_TRUNC);
+        if (length <= 0 || (size_t)length > buffer.size()) {
+            return false;
+        }
+        message.assign(buffer.data(), (size_t)length);
+        return true;
+#endif
+    }
+
+    FrameDecoder m_decoder;
+    std::string m_message;                  // only the reader thread reads
+    std::mutex m_writeMutex;
+    std::vector<EncodedFrame> m_frames;     // under m_writeMutex
+#ifdef _WIN32
+    std::string m_frameBuffer;              // under m_writeMutex
+    HANDLE m_pipe = INVALID_HANDLE_VALUE;
+    HANDLE m_readEvent = nullptr;
+    HANDLE m_writeEvent = nullptr;
+    HANDLE m_interruptEvent = nullptr;
+#else
+    int m_socket = -1;
+#endif
+};
 
-        // All pipe instances are busy, wait a bit
-        if (!WaitNamedPipeA(PIPE_NAME.c_str(), TIMEOUT_MS)) {
-            std::cerr << "Could not open pipe: timeout after " << TIMEOUT_MS << "ms." << std::endl;
-            return "";
+HelloWorldClient::HelloWorldClient(const std::string& endpoint)
+    : m_endpoint(endpoint), m_connectionGeneration(0), m_nextRequestId(1), m_stopping(false) {
+    m_reader = std::thread(&HelloWorldClient::ReaderLoop, this);
+}
+
+HelloWorldClient::~HelloWorldClient() {
+    std::unordered_map<uint64_t, PendingRequest> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        if (m_connection) {
+            m_connection->Interrupt();
         }
+        abandoned.swap(m_pending);
+    }
+    m_connectionChanged.notify_all();
+    m_reader.join();
+    if (m_resender.joinable()) {
+        m_resender.join();
     }
 
-    // Set pipe to message-read mode
-    DWORD dwMode = PIPE_READMODE_MESSAGE;
-    if (!SetNamedPipeHandleState(hPipe, &dwMode, nullptr, nullptr)) {
-        std::cerr << "SetNamedPipeHandleState failed. Error: " << GetLastError() << std::endl;
-        CloseHandle(hPipe);
+    for (auto& entry : abandoned) {
+        entry.second.callback(false, std::string());
+    }
+}
+
+HelloWorldClient& HelloWorldClient::Shared() {
+    static HelloWorldClient client;
+    return client;
+}
+
+std::string HelloWorldClient::GetHelloWorld() {
+    std::string response = Shared().Request("GET_HELLO_WORLD");
+    if (response.empty()) {
+        std::cerr << "No response from the HelloWorld service." << std::endl;
+    }
+    return response;
+}
+
+std::string HelloWorldClient::Request(const std::string& request) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> reply = promise->get_future();
+    uint64_t requestId = Send(request, [promise](bool succeeded, const std::string& response) {
+        promise->set_value(succeeded ? response : std::string());
+    });
+    if (reply.wait_for(std::chrono::milliseconds(REQUEST_TIMEOUT_MS)) != std::future_status::ready) {
+        // Given up on: a late reply is dropped and a reconnect does not resend it
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.erase(requestId);
         return "";
     }
+    return reply.get();
+}
+
+std::future<std::string> HelloWorldClient::RequestAsync(const std::string& request) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> reply = promise->get_future();
+    RequestAsync(request, [promise](bool succeeded, const std::string& response) {
+        promise->set_value(succeeded ? response : std::string());
+    });
+    return reply;
+}
+
+void HelloWorldClient::RequestAsync(const std::string& request, ResponseCallback callback) {
+    Send(request, std::move(callback));
+}
 
-    // Send a request message to the pipe server
-    const char* message = "GET_HELLO_WORLD";
-    if (!WriteFile(hPipe, message, static_cast<DWORD>(strlen(message)), &bytesWritten, nullptr)) {
-        std::cerr << "WriteFile to pipe failed. Error: " << GetLastError() << std::endl;
-        CloseHandle(hPipe);
+std::string HelloWorldClient::RequestOnce(const std::string& endpoint, const std::string& request) {
+    Connection connection;
+    std::vector<FrameMessage> messages;
+    if (!connection.Open(endpoint) || !connection.WriteRequest(1, request) || !connection.ReadMessages(messages)) {
         return "";
     }
 
-    // Read the response from the server
-    if (ReadFile(hPipe, buffer, sizeof(buffer) - 1, &bytesRead, nullptr)) {
-        buffer[bytesRead] = '\0';
-        CloseHandle(hPipe);
-        return std::string(buffer);
+    FrameMessage& reply = messages.front();
+    std::string response = reply.type == FrameType::Response ? reply.payload : std::string();
+    for (FrameMessage& message : messages) {
+        BufferPool::Shared().Release(std::move(message.payload));
     }
-    else {
-        std::cerr << "ReadFile from pipe failed. Error: " << GetLastError() << std::endl;
-        CloseHandle(hPipe);
-        return "";
+    return response;
+}
+
+/**
+ * Registers the request and writes it, connecting first if need be.
+ * @return The request's id, or 0 if it failed at once
+ */
+uint64_t HelloWorldClient::Send(const std::string& request, ResponseCallback callback) {
+    uint64_t requestId;
+    std::shared_ptr<Connection> connection;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_stopping) {
+            lock.unlock();
+            callback(false, std::string());
+            return 0;
+        }
+
+        requestId = m_nextRequestId++;
+        PendingRequest& pending = m_pending[requestId];
+        pending.request = request;
+        pending.callback = std::move(callback);
+        connection = m_connection;
+        pending.sentOn = m_connectionGeneration;
+    }
+
+    // Written outside m_mutex, so the reader never waits behind a blocked write
+    if (!connection || !connection->WriteRequest(requestId, request)) {
+        SendAfterFailure(requestId, request, connection);
+    }
+    return requestId;
+}
+
+void HelloWorldClient::SendAfterFailure(uint64_t requestId, const std::string& request,
+    const std::shared_ptr<Connection>& failed) {
+    std::shared_ptr<Connection> connection;
+    RequestList outstanding;
+    {
+        std::lock_guard<std::mutex> connecting(m_connectMutex);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_pending.find(requestId);
+            if (m_stopping || it == m_pending.end()) {
+                return;     // answered, given up on, or failed by the destructor
+            }
+            if (failed && m_connection == failed) {
+                DropConnectionLocked(failed);
+            }
+
+            // Someone else reconnected meanwhile, and may already be resending it
+            connection = m_connection;
+            if (connection) {
+                if (it->second.sentOn == m_connectionGeneration) {
+                    return;
+                }
+                it->second.sentOn = m_connectionGeneration;
+                outstanding.emplace_back(requestId, request);
+            }
+        }
+
+        // Connecting resends everything outstanding, this request included
+        if (!connection && !Reconnect(connection, outstanding)) {
+            FailPending();
+            return;
+        }
+    }
+
+    Resend(connection, outstanding);
+}
+
+/**
+ * Opens a new connection and makes it current before anything is resent, so
+ * the reader is already taking replies while the outstanding requests go out
+ * again; a service that stops reading from a client that leaves its replies
+ * unread would otherwise block the resend for ever. Called with
+ * m_connectMutex held and m_mutex not held.
+ * @param outstanding Receives the requests to pass to Resend
+ */
+bool HelloWorldClient::Reconnect(std::shared_ptr<Connection>& connection, RequestList& outstanding) {
+    connection = std::make_shared<Connection>();
+    if (!connection->Open(m_endpoint)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping) {
+        return false;
+    }
+    m_connection = connection;
+    m_connectionGeneration++;
+    for (auto& entry : m_pending) {
+        entry.second.sentOn = m_connectionGeneration;
+        outstanding.emplace_back(entry.first, entry.second.request);
+    }
+    m_connectionChanged.notify_all();
+    return true;
+}
+
+/**
+ * Writes requests to a connection that is already current. Called with
+ * neither lock held.
+ */
+void HelloWorldClient::Resend(const std::shared_ptr<Connection>& connection, const RequestList& requests) {
+    for (const auto& entry : requests) {
+        if (!connection->WriteRequest(entry.first, entry.second)) {
+            // The reader sees the connection fail and reconnects again
+            connection->Interrupt();
+            return;
+        }
+    }
+}
+
+void HelloWorldClient::DropConnectionLocked(const std::shared_ptr<Connection>& connection) {
+    // The reader still holds a reference and closes it once its Read fails
+    connection->Interrupt();
+    if (m_connection == connection) {
+        m_connection.reset();
+    }
+}
+
+void HelloWorldClient::FailPending() {
+    std::unordered_map<uint64_t, PendingRequest> failed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        failed.swap(m_pending);
+    }
+    for (auto& entry : failed) {
+        entry.second.callback(false, std::string());
+    }
+}
+
+void HelloWorldClient::ReaderLoop() {
+    while (true) {
+        std::shared_ptr<Connection> connection;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_connectionChanged.wait(lock, [this]() { return m_stopping || m_connection; });
+            if (m_stopping) {
+                return;
+            }
+            connection = m_connection;
+        }
+
+        std::vector<FrameMessage> messages;
+        while (connection->ReadMessages(messages)) {
+            for (FrameMessage& message : messages) {
+                Dispatch(message);
+            }
+            messages.clear();
+        }
+
+        std::shared_ptr<Connection> replacement;
+        RequestList outstanding;
+        {
+            std::lock_guard<std::mutex> connecting(m_connectMutex);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_stopping) {
+                    return;
+                }
+                if (m_connection != connection) {
+                    continue;       // already replaced by a writer
+                }
+
+                // The service went away under us: requests still outstanding go out again
+                DropConnectionLocked(connection);
+                if (m_pending.empty()) {
+                    continue;
+                }
+            }
+            if (!Reconnect(replacement, outstanding)) {
+                FailPending();
+                continue;
+            }
+        }
+
+        // This thread has to get back to reading before the resend can finish.
+        // An earlier resender is done or failing: its connection was dropped.
+        if (m_resender.joinable()) {
+            m_resender.join();
+        }
+        m_resender = std::thread(&HelloWorldClient::Resend, this, replacement, std::move(outstanding));
+    }
+}
+
+void HelloWorldClient::Dispatch(FrameMessage& message) {
+    ResponseCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pending.find(message.requestId);
+        if (it != m_pending.end()) {
+            callback = std::move(it->second.callback);
+            m_pending.erase(it);
+        }
+    }
+
+    // No callback means a duplicate reply after a resend
+    if (callback) {
+        callback(message.type == FrameType::Response, message.payload);
     }
-}
\ No newline at end of file
+    BufferPool::Shared().Release(std::move(message.payload));
+}
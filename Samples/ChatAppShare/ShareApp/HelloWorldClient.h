@@ -1,25 +1,116 @@
 #pragma once
-#include <windows.h>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../SampleChatAppWithShare/FrameCodec.h"
 
 /**
- * HelloWorldClient - A simple client class to communicate with the HelloWorld background service
- * 
+ * HelloWorldClient - A client for the HelloWorld background service
+ *
+ * One connection is kept open and shared by every request. Requests are
+ * framed with an id (see FrameCodec.h) and written without waiting for earlier
+ * replies, so any number can be outstanding at once; a reader thread matches
+ * each reply to its request by id. If the connection drops, the client
+ * reconnects and resends whatever was still outstanding.
+ *
  * Usage:
  *   std::string response = HelloWorldClient::GetHelloWorld();
  *   if (!response.empty()) {
  *       // Use the response
  *   }
+ *
+ *   std::future<std::string> reply = HelloWorldClient::Shared().RequestAsync("GET_HELLO_WORLD");
  */
 class HelloWorldClient {
 public:
+    /**
+     * Called with the reply, or with succeeded == false if the service could not be reached
+     */
+    typedef std::function<void(bool succeeded, const std::string& response)> ResponseCallback;
+
+    explicit HelloWorldClient(const std::string& endpoint = PIPE_NAME);
+    ~HelloWorldClient();
+
+    HelloWorldClient(const HelloWorldClient&) = delete;
+    HelloWorldClient& operator=(const HelloWorldClient&) = delete;
+
     /**
      * Connects to the HelloWorld background service and requests "Hello world"
      * @return The response from the service, or empty string if failed
      */
     static std::string GetHelloWorld();
 
-private:
+    /**
+     * The process-wide client GetHelloWorld uses
+     */
+    static HelloWorldClient& Shared();
+
+    /**
+     * Send a request without waiting for its reply. The future holds an empty
+     * string if the service could not be reached.
+     */
+    std::future<std::string> RequestAsync(const std::string& request);
+    void RequestAsync(const std::string& request, ResponseCallback callback);
+
+    /**
+     * Send a request and wait up to REQUEST_TIMEOUT_MS for the reply
+     * @return The response, or empty string if failed
+     */
+    std::string Request(const std::string& request);
+
+    /**
+     * Connect, send one request, read its reply and disconnect, the way
+     * GetHelloWorld used to on every call. Kept as the baseline the shared
+     * connection is measured against (ServiceLoadGen --one-shot).
+     * @return The response, or empty string if failed
+     */
+    static std::string RequestOnce(const std::string& endpoint, const std::string& request);
+
     static const std::string PIPE_NAME;
-    static const int TIMEOUT_MS = 20000; // 20 seconds
-};
\ No newline at end of file
+    static const int TIMEOUT_MS = 20000; // 20 seconds to find a free pipe instance
+    static constexpr int REQUEST_TIMEOUT_MS = 5000;
+
+private:
+    class Connection;
+
+    struct PendingRequest {
+        std::string request;        // kept for a resend after reconnecting
+        ResponseCallback callback;
+        uint64_t sentOn = 0;        // generation of the connection it was last written to
+    };
+
+    typedef std::vector<std::pair<uint64_t, std::string>> RequestList;
+
+    uint64_t Send(const std::string& request, ResponseCallback callback);
+    void SendAfterFailure(uint64_t requestId, const std::string& request, const std::shared_ptr<Connection>& failed);
+    bool Reconnect(std::shared_ptr<Connection>& connection, RequestList& outstanding);
+    void Resend(const std::shared_ptr<Connection>& connection, const RequestList& requests);
+    void DropConnectionLocked(const std::shared_ptr<Connection>& connection);
+    void FailPending();
+    void ReaderLoop();
+    void Dispatch(FrameMessage& message);
+
+    std::string m_endpoint;
+
+    // Held while opening a connection and making it current, never during a
+    // write, so m_mutex is only ever held briefly
+    std::mutex m_connectMutex;
+
+    std::mutex m_mutex;
+    std::condition_variable m_connectionChanged;
+    std::shared_ptr<Connection> m_connection;
+    uint64_t m_connectionGeneration;
+    std::unordered_map<uint64_t, PendingRequest> m_pending;
+    uint64_t m_nextRequestId;
+    bool m_stopping;
+    std::thread m_reader;
+    std::thread m_resender;     // resends for a connection the reader reopened
+};
@@ -4,6 +4,10 @@
 #include "ChatManager.h"
 #include "ChatModels.h"
 #include "FileManager.h"
+#include "../SampleChatAppWithShare/SharePayload.h"
+#include "../SampleChatAppWithShare/AppReadySignal.h"
+#include "../SampleChatAppWithShare/ProcessIdentityCache.h"
+#include "../SampleChatAppWithShare/ShareHandshake.h"
 #include "framework.h"
 #include <sstream>
 
@@ -98,107 +102,16 @@ bool ShareTargetManager::ProcessActivationArgs()
             auto shareOperation = shareArgs.ShareOperation();
             auto data = shareOperation.Data();
 
-            // Extract shared content information for the contact selection dialog
-            std::wstring sharedContentSummary = L"Shared Content";
-            std::wstring sharedFiles;
-            bool hasFiles = false;
+            // Fetch every offered format once, all at the same time; the bitmap only if it is used
+            SharePayload payload = ReadSharePayload(data);
+            SharePayloadDescription description = DescribeSharePayload(payload);
+            std::wstring sharedContentSummary = description.summary;
+            const std::vector<std::wstring>& sharedItems = description.items;
             
-            // Collect information about what's being shared
-            std::vector<std::wstring> sharedItems;
-            
-            // Check for different data formats
-            if (data.Contains(winrt::Windows::ApplicationModel::DataTransfer::StandardDataFormats::Text()))
-            {
-                try
-                {
-                    auto textAsync = data.GetTextAsync();
-                    auto text = textAsync.get();
-                    sharedItems.push_back(L"Text: " + std::wstring(text.c_str()));
-                    LogShareInfo(L"Received shared text.");
-                }
-                catch (...)
-                {
-                    sharedItems.push_back(L"Text: [Error retrieving text]");
-                    LogShareError(L"Error retrieving shared text.");
-                }
-            }
-
-            if (data.Contains(winrt::Windows::ApplicationModel::DataTransfer::StandardDataFormats::WebLink()))
-            {
-                try
-                {
-                    auto webLinkAsync = data.GetWebLinkAsync();
-                    auto webLink = webLinkAsync.get();
-                    sharedItems.push_back(L"Web Link: " + std::wstring(webLink.ToString().c_str()));
-                    LogShareInfo(L"Received shared web link.");
-                }
-                catch (...)
-                {
-                    sharedItems.push_back(L"Web Link: [Error retrieving web link]");
-                    LogShareError(L"Error retrieving shared web link.");
-                }
-            }
-
-            if (data.Contains(winrt::Windows::ApplicationModel::DataTransfer::StandardDataFormats::Bitmap()))
-            {
-                try
-                {
-                    auto bitmapAsync = data.GetBitmapAsync();
-                    auto bitmapRef = bitmapAsync.get();
-                    sharedItems.push_back(L"Image/Bitmap content");
-                    LogShareInfo(L"Received shared bitmap.");
-                }
-                catch (...)
-                {
-                    sharedItems.push_back(L"Image: [Error retrieving image]");
-                    LogShareError(L"Error retrieving shared bitmap.");
-                }
-            }
-
-            if (data.Contains(winrt::Windows::ApplicationModel::DataTransfer::StandardDataFormats::StorageItems()))
-            {
-                try
-                {
-                    auto storageItemsAsync = data.GetStorageItemsAsync();
-                    auto storageItems = storageItemsAsync.get();
-                    
-                    hasFiles = true;
-                    std::wstring filesInfo = std::to_wstring(storageItems.Size()) + L" file(s)";
-                    
-                    if (storageItems.Size() == 1)
-                    {
-                        auto item = storageItems.GetAt(0);
-                        sharedFiles = item.Name().c_str();
-                        sharedContentSummary = sharedFiles;
-                    }
-                    else if (storageItems.Size() > 1)
-                    {
-                        sharedFiles = L"Multiple Files (" + std::to_wstring(storageItems.Size()) + L")";
-                        sharedContentSummary = sharedFiles;
-                    }
-                    
-                    for (uint32_t i = 0; i < storageItems.Size(); i++)
-                    {
-                        auto item = storageItems.GetAt(i);
-                        filesInfo += L"\n  - " + std::wstring(item.Name().c_str());
-                    }
-                    
-                    sharedItems.push_back(filesInfo);
-                    LogShareInfo(L"Received shared files.");
-                }
-                catch (...)
-                {
-                    sharedItems.push_back(L"Files: [Error retrieving files]");
-                    LogShareError(L"Error retrieving shared files.");
-                }
-            }
-
-            // If no specific content type found, use generic description
-            if (sharedItems.empty())
-            {
-                sharedContentSummary = L"Shared Content";
-                sharedItems.push_back(L"Unknown content type");
-            }
+            LogShareInfo(std::wstring(L"Shared payload - text: ") + SharedFormatStateName(payload.text.state) +
+                       L", web link: " + SharedFormatStateName(payload.webLink.state) +
+                       L", bitmap: " + SharedFormatStateName(payload.bitmap.State()) +
+                       L", files: " + SharedFormatStateName(payload.storageItems.state));
 
             // Get the main window handle for dialog parent - try to find or launch SampleChatAppWithShare first
             HWND hMainWindow = FindOrLaunchPackageApplication(L"SampleChatAppWithShare.exe");
@@ -253,11 +166,15 @@ bool ShareTargetManager::ProcessActivationArgs()
                     // Add messages directly to the selected contact instead of relying on selectedContactIndex
                     Contact& selectedContact = contacts[result.contactIndex];
                     
+                    // The same content, for the chat app that is actually showing this contact
+                    std::vector<ShareHandoffItem> handoff;
+                    
                     // Add the custom share message if provided
                     if (!result.shareMessage.empty())
                     {
                         std::wstring formattedShareMessage = L"You: " + result.shareMessage + L" ??";
                         selectedContact.messages.push_back(formattedShareMessage);
+                        handoff.push_back({ ShareHandoffType::Message, result.contactIndex, true, result.shareMessage, std::wstring() });
                         LogShareInfo(L"Added share message: " + result.shareMessage);
                     }
                     
@@ -267,6 +184,7 @@ bool ShareTargetManager::ProcessActivationArgs()
                         std::wstring shareMsg = L"?? Received via Share: " + item;
                         std::wstring formattedMessage = selectedContact.name + L": " + shareMsg;
                         selectedContact.messages.push_back(formattedMessage);
+                        handoff.push_back({ ShareHandoffType::Message, result.contactIndex, false, shareMsg, std::wstring() });
                         LogShareInfo(L"Added shared content message: " + shareMsg);
                     }
                     
@@ -277,36 +195,26 @@ bool ShareTargetManager::ProcessActivationArgs()
                         selectedContact.lastMessage = lastMsg.length() > 50 ? lastMsg.substr(0, 47) + L"..." : lastMsg;
                     }
                     
-                    // [TODO] Store path somewhere for main application to pick.
                     // If files were shared, add them to the contact's shared files list
-                    if (hasFiles && data.Contains(winrt::Windows::ApplicationModel::DataTransfer::StandardDataFormats::StorageItems()))
+                    for (const auto& item : payload.storageItems.value)
                     {
-                        try
-                        {
-                            auto storageItemsAsync = data.GetStorageItemsAsync();
-                            auto storageItems = storageItemsAsync.get();
-                            
-                            for (uint32_t i = 0; i < storageItems.Size(); i++)
-                            {
-                                auto item = storageItems.GetAt(i);
-                                
-                                // Create shared file entry
-                                SharedFile newFile;
-                                newFile.fileName = item.Name().c_str();
-                                newFile.filePath = item.Path().c_str(); // Get full path if available
-                                newFile.sharedBy = L"External Share";
-                                GetSystemTime(&newFile.timeShared);
-                                
-                                selectedContact.sharedFiles.push_back(newFile);
-                                LogShareInfo(L"Added shared file: " + newFile.fileName);
-                            }
-                        }
-                        catch (...)
+                        // Create shared file entry
+                        SharedFile newFile;
+                        newFile.fileName = item.name;
+                        newFile.filePath = item.path; // Empty for items that are not files on disk
+                        newFile.sharedBy = L"External Share";
+                        GetSystemTime(&newFile.timeShared);
+                        
+                        selectedContact.sharedFiles.push_back(newFile);
+                        if (!newFile.filePath.empty())
                         {
-                            LogShareError(L"Error adding shared files to contact.");
+                            handoff.push_back({ ShareHandoffType::File, result.contactIndex, true, newFile.filePath, newFile.fileName });
                         }
+                        LogShareInfo(L"Added shared file: " + newFile.fileName);
                     }
                     
+                    HandOffToChatApp(handoff);
+                    
                     // Show success message and exit the application
                     std::wstring successMsg = L"Content has been shared successfully with " + contacts[result.contactIndex].name + L"!\n\nThe application will now close.";
                     MessageBoxW(hMainWindow, successMsg.c_str(), L"Sharing Complete", MB_OK | MB_ICONINFORMATION);
@@ -438,6 +346,13 @@ void ShareTargetManager::LogShareError(const std::wstring& error)
     OutputDebugStringW(logMessage.c_str());
 }
 
+// Our package family and that of every running process, resolved once and refreshed incrementally
+static ProcessIdentityCache& PackageProcessIdentities()
+{
+    static ProcessIdentityCache identities(CreateProcessIdentitySource());
+    return identities;
+}
+
 // Helper function to get all processes in the same package using proper Package Manager APIs
 std::vector<DWORD> ShareTargetManager::GetPackageProcesses()
 {
@@ -451,58 +366,23 @@ std::vector<DWORD> ShareTargetManager::GetPackageProcesses()
     
     try
     {
-        // Get the current package family name first
-        UINT32 currentPackageFamilyNameLength = 0;
-        LONG result = GetCurrentPackageFamilyName(&currentPackageFamilyNameLength, nullptr);
-        
-        if (result != ERROR_INSUFFICIENT_BUFFER)
+        ProcessIdentityCache& identities = PackageProcessIdentities();
+        std::wstring currentPackageFamilyName = identities.CurrentFamily();
+        if (currentPackageFamilyName.empty())
         {
-            LogShareError(L"Failed to get current package family name length: " + std::to_wstring(result));
+            LogShareError(L"Failed to get current package family name");
             return packageProcesses;
         }
         
-        std::wstring currentPackageFamilyName(currentPackageFamilyNameLength, L'\0');
-        result = GetCurrentPackageFamilyName(&currentPackageFamilyNameLength, currentPackageFamilyName.data());
-        
-        if (result != ERROR_SUCCESS)
-        {
-            LogShareError(L"Failed to get current package family name: " + std::to_wstring(result));
-            return packageProcesses;
-        }
-        
-        // Remove null terminator that GetCurrentPackageFamilyName includes in the length
-        if (!currentPackageFamilyName.empty() && currentPackageFamilyName.back() == L'\0')
+        for (uint32_t processId : identities.ProcessesInCurrentFamily())
         {
-            currentPackageFamilyName.pop_back();
+            packageProcesses.push_back(processId);
+            LogShareInfo(L"Found package process (PID: " + std::to_wstring(processId) + L")");
         }
         
-        LogShareInfo(L"Current package family name: " + currentPackageFamilyName);
-        
-        // Enumerate all processes and check their package family names
-        HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-        if (hSnapshot == INVALID_HANDLE_VALUE)
-        {
-            LogShareError(L"Failed to create process snapshot");
-            return packageProcesses;
-        }
-
-        PROCESSENTRY32W processEntry = {};
-        processEntry.dwSize = sizeof(PROCESSENTRY32W);
-
-        if (Process32FirstW(hSnapshot, &processEntry))
-        {
-            do
-            {
-                if (IsProcessInSamePackage(processEntry.th32ProcessID, currentPackageFamilyName))
-                {
-                    packageProcesses.push_back(processEntry.th32ProcessID);
-                    LogShareInfo(L"Found package process: " + std::wstring(processEntry.szExeFile) + 
-                               L" (PID: " + std::to_wstring(processEntry.th32ProcessID) + L")");
-                }
-            } while (Process32NextW(hSnapshot, &processEntry));
-        }
-
-        CloseHandle(hSnapshot);
+        ProcessIdentityCache::Stats stats = identities.GetStats();
+        LogShareInfo(L"Package " + currentPackageFamilyName + L": " + std::to_wstring(stats.entries) + L" processes known, " +
+                   std::to_wstring(stats.queries) + L" looked up in " + std::to_wstring(stats.refreshes) + L" refreshes");
     }
     catch (...)
     {
@@ -515,87 +395,17 @@ std::vector<DWORD> ShareTargetManager::GetPackageProcesses()
 
 // Helper function to check if a process is in the same package using proper Package Manager APIs
 bool ShareTargetManager::IsProcessInSamePackage(DWORD processId)
-{
-    if (!g_isRunningWithIdentity)
-        return false;
-
-    // Get the current package family name first
-    UINT32 currentPackageFamilyNameLength = 0;
-    LONG result = GetCurrentPackageFamilyName(&currentPackageFamilyNameLength, nullptr);
-    if (result != ERROR_INSUFFICIENT_BUFFER)
-        return false;
-        
-    std::wstring currentPackageFamilyName(currentPackageFamilyNameLength, L'\0');
-    result = GetCurrentPackageFamilyName(&currentPackageFamilyNameLength, currentPackageFamilyName.data());
-    if (result != ERROR_SUCCESS)
-        return false;
-        
-    // Remove null terminator
-    if (!currentPackageFamilyName.empty() && currentPackageFamilyName.back() == L'\0')
-    {
-        currentPackageFamilyName.pop_back();
-    }
-
-    return IsProcessInSamePackage(processId, currentPackageFamilyName);
-}
-
-// Overloaded helper function to check if a process is in the same package
-bool ShareTargetManager::IsProcessInSamePackage(DWORD processId, const std::wstring& targetPackageFamilyName)
 {
     if (!g_isRunningWithIdentity)
         return false;
 
     try
     {
-        // Open the target process to get its package information
-        HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
-        if (hProcess == NULL)
-        {
-            // Process might not be accessible or may have exited
-            return false;
-        }
-
-        // Get the package family name for the target process
-        UINT32 packageFamilyNameLength = 0;
-        LONG result = GetPackageFamilyName(hProcess, &packageFamilyNameLength, nullptr);
-        
-        if (result == APPMODEL_ERROR_NO_PACKAGE)
-        {
-            // Process is not packaged
-            CloseHandle(hProcess);
-            return false;
-        }
-        
-        if (result != ERROR_INSUFFICIENT_BUFFER)
-        {
-            CloseHandle(hProcess);
-            return false;
-        }
-        
-        std::wstring processPackageFamilyName(packageFamilyNameLength, L'\0');
-        result = GetPackageFamilyName(hProcess, &packageFamilyNameLength, processPackageFamilyName.data());
-        
-        CloseHandle(hProcess);
-        
-        if (result != ERROR_SUCCESS)
-        {
-            return false;
-        }
-        
-        // Remove null terminator
-        if (!processPackageFamilyName.empty() && processPackageFamilyName.back() == L'\0')
-        {
-            processPackageFamilyName.pop_back();
-        }
-        
-        // Compare package family names
-        bool isSamePackage = (processPackageFamilyName == targetPackageFamilyName);
-        
+        bool isSamePackage = PackageProcessIdentities().IsInCurrentFamily(processId);
         if (isSamePackage)
         {
-            LogShareInfo(L"Process " + std::to_wstring(processId) + L" is in the same package: " + processPackageFamilyName);
+            LogShareInfo(L"Process " + std::to_wstring(processId) + L" is in the same package");
         }
-        
         return isSamePackage;
     }
     catch (...)
@@ -715,63 +525,70 @@ bool ShareTargetManager::LaunchPackageApplication(const std::wstring& appExecuta
     }
 }
 
-// Helper function to wait for the application window to appear
-HWND ShareTargetManager::WaitForApplicationWindow(const std::wstring& windowTitle, DWORD timeoutMs)
+// Main function to find or launch the package application
+HWND ShareTargetManager::FindOrLaunchPackageApplication(const std::wstring& appExecutableName)
 {
-    LogShareInfo(L"Waiting for application window: " + windowTitle + L" (timeout: " + std::to_wstring(timeoutMs) + L"ms)");
-
-    DWORD startTime = GetTickCount();
-    HWND hWnd = NULL;
+    LogShareInfo(L"FindOrLaunchPackageApplication called for: " + appExecutableName);
 
-    while ((GetTickCount() - startTime) < timeoutMs)
+    // The chat app raises this once its window is shown and its hand-off ring is up
+    AppReadySignal readySignal;
+    if (!readySignal.Open(SHARE_HANDOFF_RING_NAME))
     {
-        hWnd = FindPackageApplicationWindow(windowTitle);
-        if (hWnd)
-        {
-            LogShareInfo(L"Application window found after " + std::to_wstring(GetTickCount() - startTime) + L"ms");
-            return hWnd;
-        }
+        LogShareError(L"Could not open the Chat Application ready signal (Error: " + std::to_wstring(GetLastError()) + L")");
+        return NULL;
+    }
+
+    ShareHandshake handshake({
+        [&]() { return LaunchPackageApplication(appExecutableName); },
+        [&](int timeoutMs) { return readySignal.Wait(timeoutMs); },
+    }, SHARE_HANDOFF_READY_TIMEOUT_MS);
+
+    ShareHandshakeState state = handshake.Run();
+    std::string stateName = ShareHandshakeStateName(state);
+    LogShareInfo(L"Chat Application handshake ended in " + std::wstring(stateName.begin(), stateName.end()) +
+        L" after " + std::to_wstring(handshake.ElapsedMs()) + L"ms" + (handshake.Launched() ? L" (launched)" : L""));
 
-        Sleep(250); // Check every 250ms
+    if (state != ShareHandshakeState::Ready)
+    {
+        LogShareError(state == ShareHandshakeState::TimedOut ? L"Application launched but never reported ready" : L"Failed to launch application");
+        return NULL;
     }
 
-    LogShareError(L"Timeout waiting for application window");
-    return NULL;
+    // Ready means the window is already shown, so one look is enough
+    HWND hWnd = FindPackageApplicationWindow(L"Chat Application");
+    if (!hWnd)
+    {
+        LogShareError(L"Chat Application reported ready but its window was not found");
+    }
+    return hWnd;
 }
 
-// Main function to find or launch the package application
-HWND ShareTargetManager::FindOrLaunchPackageApplication(const std::wstring& appExecutableName)
+bool ShareTargetManager::HandOffToChatApp(const std::vector<ShareHandoffItem>& items)
 {
-    LogShareInfo(L"FindOrLaunchPackageApplication called for: " + appExecutableName);
+    if (items.empty())
+        return true;
 
-    // First try to find an existing window
-    HWND hWnd = FindPackageApplicationWindow(L"Chat Application");
-    if (hWnd)
+    // The chat app creates the ring when its window comes up, so this fails only if it is not running
+    SharedMemoryRing ring;
+    if (!ring.Open(SHARE_HANDOFF_RING_NAME))
     {
-        LogShareInfo(L"Found existing Chat Application window");
-        return hWnd;
+        LogShareError(L"Chat Application is not running; shared content was not handed over");
+        return false;
     }
 
-    // If not found, try to launch the application
-    LogShareInfo(L"Chat Application not found, attempting to launch");
-    if (LaunchPackageApplication(appExecutableName))
+    size_t delivered = 0;
+    for (const auto& item : items)
     {
-        // Wait for the application window to appear
-        hWnd = WaitForApplicationWindow(L"Chat Application", 10000);
-        if (hWnd)
+        if (PushShareHandoff(ring, item, 2000))
         {
-            LogShareInfo(L"Successfully launched and found Chat Application window");
-            return hWnd;
+            delivered++;
         }
         else
         {
-            LogShareError(L"Application launched but window not found");
+            LogShareError(L"Could not hand over shared item: " + item.text);
         }
     }
-    else
-    {
-        LogShareError(L"Failed to launch application");
-    }
 
-    return NULL;
-}
\ No newline at end of file
+    LogShareInfo(L"Handed " + std::to_wstring(delivered) + L" of " + std::to_wstring(items.size()) + L" shared items to the Chat Application");
+    return delivered == items.size();
+}
@@ -6,6 +6,7 @@
 #include <tlhelp32.h>
 #include <shellapi.h>
 #include <appmodel.h>
+#include "../SampleChatAppWithShare/ShareHandoff.h"
 
 #pragma comment(lib, "shell32.lib")
 
@@ -36,12 +37,13 @@ private:
     // Package application discovery and launch helpers using proper Package Manager APIs
     static std::vector<DWORD> GetPackageProcesses();
     static bool IsProcessInSamePackage(DWORD processId);
-    static bool IsProcessInSamePackage(DWORD processId, const std::wstring& targetPackageFamilyName);
     static HWND FindPackageApplicationWindow(const std::wstring& windowTitle);
     static bool LaunchPackageApplication(const std::wstring& appExecutableName);
-    static HWND WaitForApplicationWindow(const std::wstring& windowTitle, DWORD timeoutMs = 10000);
     static HWND FindOrLaunchPackageApplication(const std::wstring& appExecutableName);
     
+    // Pass shared content to the running chat app through its hand-off ring
+    static bool HandOffToChatApp(const std::vector<ShareHandoffItem>& items);
+    
 private:
     static bool s_initialized;
     static bool s_shareTargetSupported;
@@ -0,0 +1,124 @@
+// ChatEventQueueTest.cpp : Stress test for MpscQueue, the chat event queue.
+//
+// Sixteen producers push as fast as they can while one consumer drains only
+// when woken, the way the UI thread does on WM_APP_CHAT_EVENTS. A lost wakeup
+// shows up as the consumer waiting forever, so it gives up after a few seconds
+// and the run fails. Every item must arrive exactly once and in order per
+// producer. A second run has the wake callback fail now and then, as
+// PostMessage does when the window's queue is full.
+
+#include "../SampleChatAppWithShare/ChatEventQueue.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static const uint32_t PRODUCER_COUNT = 16;
+static const uint32_t ITEMS_PER_PRODUCER = 200000;
+
+struct StressItem
+{
+    uint32_t producer;
+    uint32_t sequence;
+};
+
+// failEvery: every Nth wake reports failure (0 = never)
+static void RunStress(uint32_t failEvery)
+{
+    MpscQueue<StressItem> queue;
+
+    std::mutex mutex;
+    std::condition_variable woken;
+    bool wakePosted = false;
+    std::atomic<uint32_t> failingEvery{ failEvery };
+    std::atomic<uint64_t> wakeAttempts{ 0 };
+
+    queue.SetWakeCallback([&]() {
+        uint64_t attempt = ++wakeAttempts;
+        uint32_t every = failingEvery.load();
+        if (every != 0 && attempt % every == 0)
+            return false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            wakePosted = true;
+        }
+        woken.notify_one();
+        return true;
+    });
+
+    // The last item comes from the main thread once the producers are done
+    const uint64_t total = (uint64_t)PRODUCER_COUNT * ITEMS_PER_PRODUCER + 1;
+    std::vector<uint32_t> nextSequence(PRODUCER_COUNT + 1, 0);
+    uint64_t received = 0;
+    uint64_t drains = 0;
+    bool outOfOrder = false;
+    bool lostWakeup = false;
+
+    std::thread consumer([&]() {
+        while (received < total)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (!woken.wait_for(lock, std::chrono::seconds(5), [&]() { return wakePosted; }))
+                {
+                    lostWakeup = true;
+                    return;
+                }
+                wakePosted = false;
+            }
+
+            drains++;
+            queue.Drain([&](StressItem&& item) {
+                if (item.sequence != nextSequence[item.producer])
+                    outOfOrder = true;
+                nextSequence[item.producer] = item.sequence + 1;
+                received++;
+            });
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (uint32_t producer = 0; producer < PRODUCER_COUNT; producer++)
+    {
+        producers.emplace_back([&queue, producer]() {
+            for (uint32_t sequence = 0; sequence < ITEMS_PER_PRODUCER; sequence++)
+            {
+                queue.Push(StressItem{ producer, sequence });
+            }
+        });
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+
+    // A failed wake earlier must not stop this one from getting through
+    failingEvery = 0;
+    queue.Push(StressItem{ PRODUCER_COUNT, 0 });
+    consumer.join();
+
+    printf("fail every %u: %llu items, %llu wake attempts, %llu drains\n", failEvery,
+        (unsigned long long)received, (unsigned long long)wakeAttempts.load(), (unsigned long long)drains);
+
+    CHECK(!lostWakeup);
+    CHECK(!outOfOrder);
+    CHECK(received == total);
+    CHECK(queue.IsEmpty());
+    for (uint32_t producer = 0; producer < PRODUCER_COUNT; producer++)
+    {
+        CHECK(nextSequence[producer] == ITEMS_PER_PRODUCER);
+    }
+
+    // Pushes that find a wakeup already pending do not post another
+    CHECK(wakeAttempts.load() < total);
+}
+
+int main()
+{
+    RunStress(0);
+    RunStress(3);
+    return TestExitCode("ChatEventQueueTest");
+}
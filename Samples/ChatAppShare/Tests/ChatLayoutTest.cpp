@@ -0,0 +1,85 @@
+// ChatLayoutTest.cpp : SolveChatLayout against the arithmetic CreateChatUI and
+// ResizeChatUI used before the rule table, over a range of client sizes, and
+// the per-size cache in front of it.
+
+#include "../SampleChatAppWithShare/ChatLayout.h"
+#include "TestCheck.h"
+
+static int NotNegative(int value)
+{
+    return value > 0 ? value : 0;
+}
+
+// The positions the window procedures computed by hand. Sizes that went
+// negative on a tiny window are now zero, which is the one intended change.
+static void BaselineLayout(int width, int height, ChatLayoutRects& rects)
+{
+    rects[LAYOUT_CONTACTS_LIST] = LayoutRect{ 20, 20, 280, NotNegative(height - 40) };
+    rects[LAYOUT_CONTACT_NAME] = LayoutRect{ 320, 20, 300, 30 };
+    rects[LAYOUT_CHAT_DISPLAY] = LayoutRect{ 320, 60, NotNegative(width - 600), NotNegative(height - 280) };
+    rects[LAYOUT_SHARED_FILES_HEADER] = LayoutRect{ width - 260, 20, 120, 30 };
+    rects[LAYOUT_SHARED_FILES_LIST] = LayoutRect{ width - 260, 60, 240, NotNegative(height - 280) };
+    rects[LAYOUT_MESSAGE_INPUT] = LayoutRect{ 320, height - 200, NotNegative(width - 600), 60 };
+    rects[LAYOUT_SEND_BUTTON] = LayoutRect{ 320, height - 130, 100, 45 };
+    rects[LAYOUT_SHARE_FILE_BUTTON] = LayoutRect{ 440, height - 130, 120, 45 };
+}
+
+static void TestMatchesBaseline()
+{
+    int compared = 0;
+    int mismatched = 0;
+    for (int width = 0; width <= 2600; width += 13)
+    {
+        for (int height = 0; height <= 1600; height += 11)
+        {
+            ChatLayoutRects solved;
+            ChatLayoutRects baseline;
+            SolveChatLayout(width, height, solved);
+            BaselineLayout(width, height, baseline);
+            for (int slot = 0; slot < LAYOUT_SLOT_COUNT; slot++)
+            {
+                if (solved[slot] != baseline[slot] && mismatched++ == 0)
+                    printf("first mismatch: slot %d at %dx%d\n", slot, width, height);
+            }
+            compared++;
+        }
+    }
+    CHECK(compared == 201 * 146);
+    CHECK(mismatched == 0);
+
+    // The size the window opens at, spelled out
+    ChatLayoutRects rects;
+    SolveChatLayout(1200, 800, rects);
+    CHECK(rects[LAYOUT_CHAT_DISPLAY] == (LayoutRect{ 320, 60, 600, 520 }));
+    CHECK(rects[LAYOUT_SHARED_FILES_LIST] == (LayoutRect{ 940, 60, 240, 520 }));
+    CHECK(rects[LAYOUT_SEND_BUTTON] == (LayoutRect{ 320, 670, 100, 45 }));
+}
+
+static void TestCache()
+{
+    ChatLayoutCache cache(3);
+    const ChatLayoutRects& first = cache.Get(1200, 800);
+    CHECK(&cache.Get(1200, 800) == &first);
+    CHECK(cache.Count() == 1);
+
+    // Width and height are both part of the key
+    ChatLayoutRects swapped;
+    SolveChatLayout(800, 1200, swapped);
+    CHECK(cache.Get(800, 1200) == swapped);
+    CHECK(cache.Count() == 2);
+
+    // Full: dropped wholesale before the next new size
+    cache.Get(640, 480);
+    CHECK(cache.Count() == 3);
+    ChatLayoutRects expected;
+    SolveChatLayout(1024, 768, expected);
+    CHECK(cache.Get(1024, 768) == expected);
+    CHECK(cache.Count() == 1);
+}
+
+int main()
+{
+    TestMatchesBaseline();
+    TestCache();
+    return TestExitCode("ChatLayoutTest");
+}
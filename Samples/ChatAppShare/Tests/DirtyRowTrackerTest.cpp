@@ -0,0 +1,151 @@
+// DirtyRowTrackerTest.cpp : Unit tests for DirtyRowTracker, which decides which
+// rows of the double-buffered contact list are re-rendered on a paint.
+
+#include "../SampleChatAppWithShare/DirtyRowTracker.h"
+#include "TestCheck.h"
+
+static const int SLOTS = 8;
+
+// Paint every slot the way ContactListView does: items top..top+SLOTS-1, all at
+// 'revision', none selected. Returns how many slots needed it.
+static int PaintAll(DirtyRowTracker& tracker, uint64_t revision, int itemCount = 1000)
+{
+    int painted = 0;
+    for (int slot = 0; slot < tracker.SlotCount(); slot++)
+    {
+        int item = tracker.TopIndex() + slot;
+        if (item >= itemCount)
+            item = DirtyRowTracker::NO_ITEM;
+        if (tracker.NeedsRepaint(slot, item, revision, false))
+        {
+            tracker.MarkPainted(slot, item, revision, false);
+            painted++;
+        }
+    }
+    return painted;
+}
+
+static void TestMarkPainted()
+{
+    DirtyRowTracker tracker;
+    tracker.Resize(SLOTS);
+
+    // Nothing is valid before the first paint, empty slots included
+    CHECK(tracker.NeedsRepaint(0, 0, 1, false));
+    CHECK(tracker.NeedsRepaint(SLOTS - 1, DirtyRowTracker::NO_ITEM, 0, false));
+    CHECK(PaintAll(tracker, 1) == SLOTS);
+    CHECK(PaintAll(tracker, 1) == 0);
+
+    // Any difference from what the slot shows makes it dirty
+    CHECK(!tracker.NeedsRepaint(3, 3, 1, false));
+    CHECK(tracker.NeedsRepaint(3, 3, 2, false));
+    CHECK(tracker.NeedsRepaint(3, 3, 1, true));
+    CHECK(tracker.NeedsRepaint(3, 4, 1, false));
+    CHECK(tracker.NeedsRepaint(3, DirtyRowTracker::NO_ITEM, 0, false));
+
+    tracker.MarkPainted(3, 3, 1, true);
+    CHECK(!tracker.NeedsRepaint(3, 3, 1, true));
+    CHECK(tracker.NeedsRepaint(3, 3, 1, false));
+
+    // An empty slot stays clean whatever revision it is asked about
+    DirtyRowTracker shortList;
+    shortList.Resize(SLOTS);
+    CHECK(PaintAll(shortList, 1, 2) == SLOTS);
+    CHECK(!shortList.NeedsRepaint(5, DirtyRowTracker::NO_ITEM, 7, true));
+
+    // Slots outside the buffer are ignored
+    CHECK(!tracker.NeedsRepaint(-1, 0, 1, false));
+    CHECK(!tracker.NeedsRepaint(SLOTS, 0, 1, false));
+    tracker.MarkPainted(SLOTS, 0, 1, false);
+    tracker.MarkPainted(-1, 0, 1, false);
+}
+
+static void TestInvalidationsCoalesce()
+{
+    DirtyRowTracker tracker;
+    tracker.Resize(SLOTS);
+    PaintAll(tracker, 1);
+
+    // Several invalidations of one row before a paint cost one repaint
+    tracker.Invalidate(2);
+    tracker.Invalidate(2);
+    tracker.Invalidate(2);
+    tracker.Invalidate(5);
+    CHECK(PaintAll(tracker, 1) == 2);
+    CHECK(PaintAll(tracker, 1) == 0);
+
+    // So do several model revisions: only the latest is compared
+    tracker.Invalidate(5);
+    CHECK(PaintAll(tracker, 4) == SLOTS);
+    CHECK(PaintAll(tracker, 4) == 0);
+
+    // Rows out of view are not tracked
+    tracker.Invalidate(-1);
+    tracker.Invalidate(SLOTS);
+    tracker.Invalidate(500);
+    CHECK(PaintAll(tracker, 4) == 0);
+
+    tracker.InvalidateAll();
+    CHECK(PaintAll(tracker, 4) == SLOTS);
+}
+
+static void TestScrollShift()
+{
+    DirtyRowTracker tracker;
+    tracker.Resize(SLOTS);
+    PaintAll(tracker, 1);
+
+    // Down by three: content moves up, three new rows at the bottom
+    CHECK(tracker.Scroll(3) == 3);
+    CHECK(tracker.TopIndex() == 3);
+    CHECK(!tracker.NeedsRepaint(0, 3, 1, false));
+    CHECK(!tracker.NeedsRepaint(SLOTS - 4, SLOTS - 1, 1, false));
+    CHECK(tracker.NeedsRepaint(SLOTS - 3, SLOTS, 1, false));
+    CHECK(tracker.SlotForItem(3) == 0);
+    CHECK(tracker.SlotForItem(2) == -1);
+    CHECK(tracker.SlotForItem(3 + SLOTS) == -1);
+    CHECK(PaintAll(tracker, 1) == 3);
+
+    // Back up by two: content moves down, two new rows at the top
+    CHECK(tracker.Scroll(1) == -2);
+    CHECK(tracker.NeedsRepaint(0, 1, 1, false));
+    CHECK(tracker.NeedsRepaint(1, 2, 1, false));
+    CHECK(!tracker.NeedsRepaint(2, 3, 1, false));
+    CHECK(!tracker.NeedsRepaint(SLOTS - 1, SLOTS, 1, false));
+    CHECK(PaintAll(tracker, 1) == 2);
+
+    // An invalidation follows its row across a scroll
+    tracker.Invalidate(6);
+    CHECK(tracker.Scroll(2) == 1);
+    CHECK(tracker.SlotForItem(6) == 4);
+    CHECK(tracker.NeedsRepaint(4, 6, 1, false));
+    CHECK(PaintAll(tracker, 1) == 2);
+
+    // Not moving is not a scroll
+    CHECK(tracker.Scroll(2) == 0);
+    CHECK(PaintAll(tracker, 1) == 0);
+
+    // Nothing on screen survives a page or more: no shift, all dirty
+    CHECK(tracker.Scroll(2 + SLOTS) == 0);
+    CHECK(PaintAll(tracker, 1) == SLOTS);
+    CHECK(tracker.Scroll(2) == 0);
+    CHECK(PaintAll(tracker, 1) == SLOTS);
+    CHECK(tracker.Scroll(2 + SLOTS - 1) == SLOTS - 1);
+    CHECK(PaintAll(tracker, 1) == SLOTS - 1);
+
+    // Resizing forgets everything
+    tracker.Resize(SLOTS * 2);
+    CHECK(tracker.SlotCount() == SLOTS * 2);
+    CHECK(PaintAll(tracker, 1) == SLOTS * 2);
+    tracker.Resize(-1);
+    CHECK(tracker.SlotCount() == 0);
+    CHECK(tracker.Scroll(0) == 0);
+}
+
+int main()
+{
+    TestMarkPainted();
+    TestInvalidationsCoalesce();
+    TestScrollShift();
+    return TestExitCode("DirtyRowTrackerTest");
+}
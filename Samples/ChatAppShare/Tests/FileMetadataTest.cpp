@@ -0,0 +1,270 @@
+// FileMetadataTest.cpp : what the shared-files panel works out about a file:
+// the magic-byte table behind SniffMimeType, thumbnail sizing, DownscaleBgra
+// against a plain scalar box filter, and FileMetadataCache shared by threads.
+
+#include "../SampleChatAppWithShare/FileMetadata.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <thread>
+
+static const char* Sniff(const char* bytes, size_t length)
+{
+    return SniffMimeType((const uint8_t*)bytes, length);
+}
+
+static void TestSniffMimeType()
+{
+    struct Sample
+    {
+        const char* bytes;
+        size_t length;
+        const char* mimeType;
+    };
+    const Sample samples[] =
+    {
+        { "\x89PNG\r\n\x1a\n\0\0\0\rIHDR", 16, "image/png" },
+        { "\xFF\xD8\xFF\xE0\0\x10JFIF", 10, "image/jpeg" },
+        { "GIF87a", 6, "image/gif" },
+        { "GIF89a\x01\0", 8, "image/gif" },
+        { "II*\0\x08\0\0\0", 8, "image/tiff" },
+        { "MM\0*\0\0\0\x08", 8, "image/tiff" },
+        { "RIFF\x24\0\0\0WEBPVP8 ", 16, "image/webp" },
+        { "%PDF-1.7\n", 9, "application/pdf" },
+        { "PK\x03\x04\x14\0", 6, "application/zip" },
+        { "\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1", 8, "application/x-ole-storage" },
+        { "\x1F\x8B\x08\0", 4, "application/gzip" },
+        { "7z\xBC\xAF\x27\x1C\0\x04", 8, "application/x-7z-compressed" },
+        { "MZ\x90\0", 4, "application/vnd.microsoft.portable-executable" },
+        { "\0\0\0\x20" "ftypisom", 12, "video/mp4" },
+        { "ID3\x04\0", 5, "audio/mpeg" },
+        { "\xEF\xBB\xBFhello", 8, "text/plain" },
+        { "\xFF\xFEh\0", 4, "text/plain" },
+        { "hello world", 11, "application/octet-stream" },
+    };
+    for (const Sample& sample : samples)
+    {
+        const char* mimeType = Sniff(sample.bytes, sample.length);
+        CHECK(strcmp(mimeType, sample.mimeType) == 0);
+        if (strcmp(mimeType, sample.mimeType) != 0)
+            printf("  %s sniffed as %s\n", sample.mimeType, mimeType);
+    }
+
+    // Too short for the signature, or nothing at all
+    CHECK(strcmp(Sniff("\x89PNG", 4), "application/octet-stream") == 0);
+    CHECK(strcmp(Sniff("RIFF\x24\0\0\0WEB", 11), "application/octet-stream") == 0);
+    CHECK(strcmp(Sniff("", 0), "application/octet-stream") == 0);
+
+    // "BM" alone is a bitmap only if a plausible header size follows at offset 14
+    uint8_t bitmap[MIME_SNIFF_LENGTH] = { 'B', 'M' };
+    bitmap[14] = 40;    // BITMAPINFOHEADER
+    CHECK(strcmp(SniffMimeType(bitmap, sizeof(bitmap)), "image/bmp") == 0);
+    bitmap[14] = 12;    // BITMAPCOREHEADER, the smallest there is
+    CHECK(strcmp(SniffMimeType(bitmap, sizeof(bitmap)), "image/bmp") == 0);
+    bitmap[14] = 0;
+    CHECK(strcmp(SniffMimeType(bitmap, sizeof(bitmap)), "application/octet-stream") == 0);
+    bitmap[14] = 11;
+    CHECK(strcmp(SniffMimeType(bitmap, sizeof(bitmap)), "application/octet-stream") == 0);
+
+    // Without offset 14 there is nothing to go on but the letters
+    CHECK(strcmp(SniffMimeType(bitmap, 14), "image/bmp") == 0);
+
+    CHECK(IsImageMimeType("image/png"));
+    CHECK(IsImageMimeType(Sniff("GIF89a", 6)));
+    CHECK(!IsImageMimeType("application/pdf"));
+    CHECK(!IsImageMimeType(Sniff("hello", 5)));
+}
+
+static void TestFitThumbnailSize()
+{
+    int width = -1;
+    int height = -1;
+
+    // Already small enough: unchanged, never enlarged
+    FitThumbnailSize(64, 48, 96, width, height);
+    CHECK(width == 64 && height == 48);
+    FitThumbnailSize(96, 96, 96, width, height);
+    CHECK(width == 96 && height == 96);
+
+    // The long side becomes maxSize, the other keeps the ratio rounding down
+    FitThumbnailSize(1920, 1080, 96, width, height);
+    CHECK(width == 96 && height == 54);
+    FitThumbnailSize(1080, 1920, 96, width, height);
+    CHECK(width == 54 && height == 96);
+    FitThumbnailSize(1000, 999, 96, width, height);
+    CHECK(width == 96 && height == 95);
+
+    // A sliver keeps at least one pixel
+    FitThumbnailSize(100000, 3, 96, width, height);
+    CHECK(width == 96 && height == 1);
+    FitThumbnailSize(1, 100000, 96, width, height);
+    CHECK(width == 1 && height == 96);
+
+    // Large enough to overflow 32-bit products
+    FitThumbnailSize(2000000000, 1500000000, 256, width, height);
+    CHECK(width == 256 && height == 192);
+
+    // Nothing to fit
+    FitThumbnailSize(0, 100, 96, width, height);
+    CHECK(width == 0 && height == 0);
+    FitThumbnailSize(100, -5, 96, width, height);
+    CHECK(width == 0 && height == 0);
+    FitThumbnailSize(100, 100, 0, width, height);
+    CHECK(width == 0 && height == 0);
+}
+
+// The box filter DownscaleBgra documents, one channel and one pixel at a time
+static void ReferenceDownscale(const uint32_t* source, int sourceWidth, int sourceHeight, size_t sourceStride,
+    uint32_t* destination, int destinationWidth, int destinationHeight)
+{
+    for (int dy = 0; dy < destinationHeight; dy++)
+    {
+        int y0 = (int)((int64_t)dy * sourceHeight / destinationHeight);
+        int y1 = std::max(y0 + 1, (int)((int64_t)(dy + 1) * sourceHeight / destinationHeight));
+        for (int dx = 0; dx < destinationWidth; dx++)
+        {
+            int x0 = (int)((int64_t)dx * sourceWidth / destinationWidth);
+            int x1 = std::max(x0 + 1, (int)((int64_t)(dx + 1) * sourceWidth / destinationWidth));
+            uint32_t count = (uint32_t)((x1 - x0) * (y1 - y0));
+
+            uint32_t pixel = 0;
+            for (int shift = 0; shift < 32; shift += 8)
+            {
+                uint32_t sum = 0;
+                for (int y = y0; y < y1; y++)
+                {
+                    for (int x = x0; x < x1; x++)
+                    {
+                        sum += (source[(size_t)y * sourceStride + x] >> shift) & 0xFF;
+                    }
+                }
+                pixel |= ((sum + count / 2) / count) << shift;
+            }
+            destination[(size_t)dy * destinationWidth + dx] = pixel;
+        }
+    }
+}
+
+static void TestDownscale()
+{
+    // Two by two into one: each channel averaged, rounding half up
+    const uint32_t square[4] = { 0xFF000000, 0xFF0000FF, 0xFF00FF00, 0x80FFFFFF };
+    uint32_t pixel = 0;
+    DownscaleBgra(square, 2, 2, 2, &pixel, 1, 1);
+    CHECK(pixel == 0xDF408080);
+
+    // Same size: a copy, wherever the rows start
+    std::vector<uint32_t> padded(5 * 3, 0xDEADBEEF);
+    for (int y = 0; y < 3; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            padded[y * 5 + x] = 0x01020304u * (uint32_t)(y * 4 + x + 1);
+        }
+    }
+    std::vector<uint32_t> copy(4 * 3);
+    DownscaleBgra(padded.data(), 4, 3, 5, copy.data(), 4, 3);
+    for (int y = 0; y < 3; y++)
+    {
+        CHECK(memcmp(&copy[y * 4], &padded[y * 5], 4 * sizeof(uint32_t)) == 0);
+    }
+
+    // Random pixels at odd sizes and strides, down and slightly up
+    std::mt19937 random(38);
+    int mismatched = 0;
+    for (int round = 0; round < 300; round++)
+    {
+        int sourceWidth = 1 + (int)(random() % 300);
+        int sourceHeight = 1 + (int)(random() % 300);
+        size_t stride = (size_t)sourceWidth + random() % 9;
+        int destinationWidth = 1 + (int)(random() % std::min(sourceWidth + 4, 97));
+        int destinationHeight = 1 + (int)(random() % std::min(sourceHeight + 4, 97));
+
+        std::vector<uint32_t> source(stride * sourceHeight);
+        for (auto& value : source)
+        {
+            value = (uint32_t)random();
+        }
+        std::vector<uint32_t> actual(destinationWidth * destinationHeight);
+        std::vector<uint32_t> expected(actual.size());
+        DownscaleBgra(source.data(), sourceWidth, sourceHeight, stride, actual.data(), destinationWidth, destinationHeight);
+        ReferenceDownscale(source.data(), sourceWidth, sourceHeight, stride, expected.data(), destinationWidth, destinationHeight);
+        if (actual != expected)
+            mismatched++;
+    }
+    CHECK(mismatched == 0);
+
+    // A whole photo of saturated pixels into a thumbnail: no channel overflows into the next
+    std::vector<uint32_t> white(4000 * 3000, 0xFFFFFFFF);
+    std::vector<uint32_t> thumbnail(96 * 72);
+    DownscaleBgra(white.data(), 4000, 3000, 4000, thumbnail.data(), 96, 72);
+    CHECK(std::all_of(thumbnail.begin(), thumbnail.end(), [](uint32_t value) { return value == 0xFFFFFFFF; }));
+}
+
+static std::shared_ptr<const FileMetadata> MakeMetadata(uint64_t contentHash, uint64_t size)
+{
+    auto metadata = std::make_shared<FileMetadata>();
+    metadata->size = size;
+    metadata->contentHash = contentHash;
+    metadata->mimeType = "application/octet-stream";
+    metadata->thumbnailWidth = 0;
+    metadata->thumbnailHeight = 0;
+    return metadata;
+}
+
+static void TestMetadataCache()
+{
+    FileMetadataCache cache;
+    CHECK(!cache.Find(1));
+    CHECK(!cache.FindBySource(L"C:\\a.txt|3|100"));
+
+    auto first = MakeMetadata(1, 3);
+    cache.Insert(first, L"C:\\a.txt|3|100");
+    CHECK(cache.Find(1) == first);
+    CHECK(cache.FindBySource(L"C:\\a.txt|3|100") == first);
+
+    // A copy of the same content under another name shares the entry
+    cache.Insert(cache.Find(1), L"C:\\copy of a.txt|3|200");
+    CHECK(cache.FindBySource(L"C:\\copy of a.txt|3|200") == first);
+    CHECK(cache.Count() == 1);
+
+    // No source key: found by hash only
+    auto second = MakeMetadata(2, 5);
+    cache.Insert(second, L"");
+    CHECK(cache.Find(2) == second);
+    CHECK(!cache.FindBySource(L""));
+    CHECK(cache.Count() == 2);
+
+    // Workers inserting and looking up at once
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&cache, t]() {
+            for (uint64_t i = 0; i < 2000; i++)
+            {
+                uint64_t hash = 100 + i;
+                std::wstring source = L"file" + std::to_wstring(i) + L"|" + std::to_wstring(t);
+                if (!cache.Find(hash))
+                    cache.Insert(MakeMetadata(hash, i), source);
+                else
+                    cache.Insert(cache.Find(hash), source);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    CHECK(cache.Count() == 2 + 2000);
+    CHECK(cache.FindBySource(L"file1999|3") && cache.FindBySource(L"file1999|3")->contentHash == 2099);
+}
+
+int main()
+{
+    TestSniffMimeType();
+    TestFitThumbnailSize();
+    TestDownscale();
+    TestMetadataCache();
+    return TestExitCode("FileMetadataTest");
+}
@@ -0,0 +1,177 @@
+// FileTransferTest.cpp : FileTransferEngine between two ChunkStores over a
+// loopback TCP connection.
+//
+// A first transfer sends every chunk, a repeat sends none, a transfer cut off
+// partway resumes without resending what arrived, and an offer whose id does
+// not match its content is refused without recording a manifest.
+
+#include "../SampleChatAppWithShare/FileTransfer.h"
+#include "TestCheck.h"
+#include <arpa/inet.h>
+#include <fstream>
+#include <netinet/in.h>
+#include <random>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// Both ends of a connection through 127.0.0.1
+static bool ConnectLoopback(int& client, int& server)
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bool connected = listener >= 0 &&
+        bind(listener, (sockaddr*)&address, sizeof(address)) == 0 &&
+        listen(listener, 1) == 0 &&
+        getsockname(listener, (sockaddr*)&address, &length) == 0 &&
+        (client = socket(AF_INET, SOCK_STREAM, 0)) >= 0 &&
+        connect(client, (sockaddr*)&address, sizeof(address)) == 0 &&
+        (server = accept(listener, nullptr, nullptr)) >= 0;
+    if (listener >= 0)
+        close(listener);
+    return connected;
+}
+
+struct TransferResult
+{
+    bool sent = false;
+    bool received = false;
+    TransferStats sendStats = {};
+    TransferStats receiveStats = {};
+    ChunkManifest manifest = {};
+};
+
+// 'stopAfter' chunks into the transfer the sender drops the connection (0 = never)
+static TransferResult Transfer(ChunkStore& from, ChunkStore& to, const fs::path& filePath,
+    const ChunkManifest& manifest, uint32_t stopAfter = 0)
+{
+    TransferResult result;
+    int sender = -1;
+    int receiver = -1;
+    if (!ConnectLoopback(sender, receiver))
+    {
+        CHECK(!"loopback connection failed");
+        return result;
+    }
+
+    std::thread receiving([&]() {
+        FileTransferEngine engine(to);
+        result.received = engine.Receive(receiver, result.manifest, result.receiveStats);
+        shutdown(receiver, SHUT_RDWR);
+    });
+
+    FileTransferEngine engine(from);
+    result.sent = engine.Send(sender, filePath, manifest, result.sendStats, [&](const TransferStats& stats) {
+        if (stopAfter != 0 && stats.chunksSent == stopAfter)
+            shutdown(sender, SHUT_RDWR);
+    });
+    shutdown(sender, SHUT_RDWR);
+    receiving.join();
+
+    close(sender);
+    close(receiver);
+    return result;
+}
+
+static fs::path WriteRandomFile(const fs::path& path, size_t size, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::vector<char> data(size);
+    for (char& byte : data)
+    {
+        byte = (char)random();
+    }
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(data.data(), (std::streamsize)data.size());
+    return path;
+}
+
+static bool SameContent(const fs::path& a, const fs::path& b)
+{
+    std::ifstream first(a, std::ios::binary);
+    std::ifstream second(b, std::ios::binary);
+    std::string left((std::istreambuf_iterator<char>(first)), std::istreambuf_iterator<char>());
+    std::string right((std::istreambuf_iterator<char>(second)), std::istreambuf_iterator<char>());
+    return !left.empty() && left == right;
+}
+
+int main()
+{
+    fs::path directory = fs::temp_directory_path() / ("FileTransferTest-" + std::to_string(getpid()));
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    ChunkStore sender(directory / "sender");
+    ChunkStore receiver(directory / "receiver");
+
+    // Full: the receiver has nothing, so every chunk crosses
+    fs::path first = WriteRandomFile(directory / "first.bin", 3 * 1024 * 1024 + 123, 1);
+    ChunkManifest firstManifest;
+    CHECK(sender.Ingest(first, firstManifest));
+    CHECK(firstManifest.chunks.size() > 64);
+
+    TransferResult full = Transfer(sender, receiver, first, firstManifest);
+    CHECK(full.sent && full.received);
+    CHECK(full.manifest.id == firstManifest.id);
+    CHECK(full.sendStats.chunksSent == firstManifest.chunks.size());
+    CHECK(full.sendStats.chunksSkipped == 0);
+    CHECK(full.sendStats.bytesSent == firstManifest.fileSize);
+    CHECK(full.receiveStats.chunksSent == full.sendStats.chunksSent);
+    CHECK(receiver.HasManifest(firstManifest.id));
+    CHECK(receiver.Restore(full.manifest, directory / "first.out"));
+    CHECK(SameContent(first, directory / "first.out"));
+
+    // Repeat: nothing left to send
+    TransferResult repeat = Transfer(sender, receiver, first, firstManifest);
+    CHECK(repeat.sent && repeat.received);
+    CHECK(repeat.sendStats.chunksSent == 0);
+    CHECK(repeat.sendStats.chunksSkipped == firstManifest.chunks.size());
+    CHECK(repeat.sendStats.bytesSkipped == firstManifest.fileSize);
+
+    // Resumed: cut off partway, then finished without resending what arrived
+    fs::path second = WriteRandomFile(directory / "second.bin", 2 * 1024 * 1024, 2);
+    ChunkManifest secondManifest;
+    CHECK(sender.Ingest(second, secondManifest));
+    uint32_t secondCount = (uint32_t)secondManifest.chunks.size();
+
+    TransferResult cut = Transfer(sender, receiver, second, secondManifest, secondCount / 2);
+    CHECK(!cut.sent && !cut.received);
+    CHECK(!receiver.HasManifest(secondManifest.id));
+
+    // The receiver stored each chunk it was handed before acknowledging it
+    uint32_t arrived = 0;
+    for (const ChunkRef& chunk : secondManifest.chunks)
+    {
+        arrived += receiver.HasChunk(chunk) ? 1 : 0;
+    }
+    CHECK(arrived > 0 && arrived < secondCount);
+
+    TransferResult resumed = Transfer(sender, receiver, second, secondManifest);
+    CHECK(resumed.sent && resumed.received);
+    CHECK(resumed.sendStats.chunksSkipped == arrived);
+    CHECK(resumed.sendStats.chunksSent == secondCount - arrived);
+    CHECK(receiver.Restore(resumed.manifest, directory / "second.out"));
+    CHECK(SameContent(second, directory / "second.out"));
+
+    // Forged: real chunks under another file's id are refused
+    ChunkManifest forged = secondManifest;
+    forged.id = firstManifest.id ^ 0x5A5A;
+    TransferResult refused = Transfer(sender, receiver, second, forged);
+    CHECK(!refused.sent && !refused.received);
+    CHECK(!receiver.HasManifest(forged.id));
+
+    // Chunks that do not add up to the file size are refused before any cross
+    ChunkManifest truncated = firstManifest;
+    truncated.fileSize++;
+    TransferResult mismatched = Transfer(sender, receiver, first, truncated);
+    CHECK(!mismatched.sent && !mismatched.received);
+    CHECK(mismatched.sendStats.chunksSent == 0);
+
+    fs::remove_all(directory);
+    return TestExitCode("FileTransferTest");
+}
@@ -0,0 +1,279 @@
+// FrameCodecTest.cpp : Round-trip, rejection and fuzz tests for FrameCodec, the
+// framing of the background service protocol, and a round-trip benchmark.
+//
+// Round trips encode messages of every size class and feed the bytes to a
+// FrameDecoder split at random points, the way a stream transport may deliver
+// them. The fuzz pass mutates valid streams and feeds random bytes; the decoder
+// must never crash, never hand out a message over MAX_MESSAGE_PAYLOAD, and stay
+// failed once it has failed. Build with -fsanitize=address,undefined to have it
+// catch memory errors as well.
+//
+// Usage: FrameCodecTest [fuzz iterations (default 20000)]
+
+#include "../SampleChatAppWithShare/FrameCodec.h"
+#include "TestCheck.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+static std::mt19937_64 s_random(0xF7A3E);
+
+static size_t RandomBelow(size_t bound)
+{
+    return bound ? (size_t)(s_random() % bound) : 0;
+}
+
+static std::string RandomPayload(size_t length)
+{
+    std::string payload(length, '\0');
+    for (size_t i = 0; i < length; i += 8)
+    {
+        uint64_t bits = s_random();
+        memcpy(&payload[i], &bits, std::min<size_t>(8, length - i));
+    }
+    return payload;
+}
+
+static std::string EncodeToBytes(FrameType type, uint64_t requestId, const std::string& payload)
+{
+    std::vector<EncodedFrame> frames;
+    EncodeMessage(type, requestId, payload.size(), frames);
+    std::string bytes;
+    for (const EncodedFrame& frame : frames)
+    {
+        AppendFrame(frame, payload, bytes);
+    }
+    return bytes;
+}
+
+static std::string Header(uint32_t length, uint8_t version, uint8_t type, uint16_t flags, uint64_t requestId)
+{
+    FrameHeader header{ length, version, (FrameType)type, flags, requestId };
+    uint8_t bytes[FRAME_HEADER_SIZE];
+    EncodeFrameHeader(header, bytes);
+    return std::string((const char*)bytes, FRAME_HEADER_SIZE);
+}
+
+// Feed 'bytes' in pieces of random length (1 byte at most when 'tiny')
+static bool FeedSplit(FrameDecoder& decoder, const std::string& bytes, std::vector<FrameMessage>& messages, bool tiny)
+{
+    size_t offset = 0;
+    while (offset < bytes.size())
+    {
+        size_t piece = tiny ? 1 : 1 + RandomBelow(std::min<size_t>(bytes.size() - offset, 3 * MAX_FRAME_PAYLOAD));
+        piece = std::min(piece, bytes.size() - offset);
+        if (!decoder.Feed(bytes.data() + offset, piece, messages))
+            return false;
+        offset += piece;
+    }
+    return true;
+}
+
+static void TestHeader()
+{
+    FrameHeader header{ 1234, FRAME_VERSION, FrameType::Error, FRAME_FLAG_MORE, 0x0102030405060708ull };
+    uint8_t bytes[FRAME_HEADER_SIZE];
+    EncodeFrameHeader(header, bytes);
+
+    // Little-endian on the wire whatever the host is
+    CHECK(bytes[0] == 0xD2 && bytes[1] == 0x04 && bytes[2] == 0 && bytes[3] == 0);
+    CHECK(bytes[4] == FRAME_VERSION && bytes[5] == (uint8_t)FrameType::Error);
+    CHECK(bytes[6] == FRAME_FLAG_MORE && bytes[7] == 0);
+    CHECK(bytes[8] == 0x08 && bytes[15] == 0x01);
+
+    FrameHeader decoded;
+    CHECK(DecodeFrameHeader(bytes, decoded));
+    CHECK(decoded.length == header.length && decoded.type == header.type);
+    CHECK(decoded.flags == header.flags && decoded.requestId == header.requestId);
+}
+
+static void TestRoundTrip()
+{
+    const size_t sizes[] = { 0, 1, 100, MAX_FRAME_PAYLOAD - 1, MAX_FRAME_PAYLOAD, MAX_FRAME_PAYLOAD + 1,
+        3 * MAX_FRAME_PAYLOAD, 200 * 1024 + 17, MAX_MESSAGE_PAYLOAD };
+
+    for (size_t size : sizes)
+    {
+        std::vector<EncodedFrame> frames;
+        EncodeMessage(FrameType::Response, 7, size, frames);
+        CHECK(frames.size() == (size == 0 ? 1 : (size + MAX_FRAME_PAYLOAD - 1) / MAX_FRAME_PAYLOAD));
+
+        // Several messages back to back, split every which way
+        std::string stream;
+        std::vector<std::string> payloads;
+        for (uint64_t id = 1; id <= 3; id++)
+        {
+            payloads.push_back(RandomPayload(size));
+            stream += EncodeToBytes(id == 2 ? FrameType::Error : FrameType::Request, id, payloads.back());
+        }
+
+        for (int pass = 0; pass < 3; pass++)
+        {
+            bool tiny = pass == 2 && size <= 4 * MAX_FRAME_PAYLOAD;
+            FrameDecoder decoder;
+            std::vector<FrameMessage> messages;
+            CHECK(pass == 0 ? decoder.Feed(stream.data(), stream.size(), messages) : FeedSplit(decoder, stream, messages, tiny));
+            CHECK(messages.size() == 3);
+            CHECK(decoder.Buffered() == 0);
+            for (size_t i = 0; i < messages.size() && i < 3; i++)
+            {
+                CHECK(messages[i].requestId == i + 1);
+                CHECK(messages[i].type == (i == 1 ? FrameType::Error : FrameType::Request));
+                CHECK(messages[i].payload == payloads[i]);
+            }
+        }
+    }
+}
+
+static void TestRejects()
+{
+    std::string good = EncodeToBytes(FrameType::Request, 1, "hello");
+
+    struct Case
+    {
+        const char* name;
+        std::string bytes;
+    };
+    const Case cases[] = {
+        { "version", Header(0, FRAME_VERSION + 1, 1, 0, 1) },
+        { "type 0", Header(0, FRAME_VERSION, 0, 0, 1) },
+        { "type 4", Header(0, FRAME_VERSION, 4, 0, 1) },
+        { "flags", Header(0, FRAME_VERSION, 1, 2, 1) },
+        { "frame length", Header((uint32_t)MAX_FRAME_PAYLOAD + 1, FRAME_VERSION, 1, 0, 1) },
+        { "other id", Header(1, FRAME_VERSION, 1, FRAME_FLAG_MORE, 1) + "x" + Header(1, FRAME_VERSION, 1, 0, 2) + "y" },
+        { "other type", Header(1, FRAME_VERSION, 1, FRAME_FLAG_MORE, 1) + "x" + Header(1, FRAME_VERSION, 2, 0, 1) + "y" },
+    };
+
+    for (const Case& test : cases)
+    {
+        for (int split = 0; split < 2; split++)
+        {
+            FrameDecoder decoder;
+            std::vector<FrameMessage> messages;
+            bool accepted = split ? FeedSplit(decoder, test.bytes, messages, true) : decoder.Feed(test.bytes.data(), test.bytes.size(), messages);
+            if (accepted)
+                fprintf(stderr, "accepted: %s\n", test.name);
+            CHECK(!accepted);
+            CHECK(messages.empty());
+
+            // Failed stays failed until reset
+            CHECK(!decoder.Feed(good.data(), good.size(), messages));
+            decoder.Reset();
+            CHECK(decoder.Feed(good.data(), good.size(), messages));
+            CHECK(messages.size() == 1);
+        }
+    }
+
+    // One frame more than a whole message may hold
+    FrameDecoder decoder;
+    std::vector<FrameMessage> messages;
+    std::string frame = Header((uint32_t)MAX_FRAME_PAYLOAD, FRAME_VERSION, 1, FRAME_FLAG_MORE, 9) + std::string(MAX_FRAME_PAYLOAD, 'z');
+    bool accepted = true;
+    for (size_t sent = 0; sent <= MAX_MESSAGE_PAYLOAD && accepted; sent += MAX_FRAME_PAYLOAD)
+    {
+        accepted = decoder.Feed(frame.data(), frame.size(), messages);
+    }
+    CHECK(!accepted);
+    CHECK(messages.empty());
+}
+
+static void Fuzz(size_t iterations)
+{
+    size_t survived = 0;
+    for (size_t i = 0; i < iterations; i++)
+    {
+        std::string stream;
+        if (i % 8 == 0)
+        {
+            stream = RandomPayload(RandomBelow(4 * FRAME_HEADER_SIZE));
+        }
+        else
+        {
+            size_t count = 1 + RandomBelow(3);
+            for (size_t m = 0; m < count; m++)
+            {
+                stream += EncodeToBytes((FrameType)(1 + RandomBelow(3)), s_random(), RandomPayload(RandomBelow(3 * MAX_FRAME_PAYLOAD)));
+            }
+
+            // Flip bytes, with a bias toward headers, and sometimes cut or splice
+            size_t flips = 1 + RandomBelow(4);
+            for (size_t f = 0; f < flips; f++)
+            {
+                size_t at = RandomBelow(2) ? RandomBelow(std::min(stream.size(), FRAME_HEADER_SIZE)) : RandomBelow(stream.size());
+                stream[at] = (char)s_random();
+            }
+            if (RandomBelow(4) == 0)
+                stream.resize(RandomBelow(stream.size()));
+            if (RandomBelow(4) == 0)
+                stream.insert(RandomBelow(stream.size() + 1), RandomPayload(1 + RandomBelow(32)));
+        }
+
+        FrameDecoder decoder;
+        std::vector<FrameMessage> messages;
+        bool accepted = FeedSplit(decoder, stream, messages, false);
+        for (const FrameMessage& message : messages)
+        {
+            CHECK(message.payload.size() <= MAX_MESSAGE_PAYLOAD);
+            CHECK(message.type >= FrameType::Request && message.type <= FrameType::Error);
+        }
+        if (!accepted)
+        {
+            CHECK(!decoder.Feed("", 0, messages));
+        }
+        else
+        {
+            survived++;
+            CHECK(decoder.Buffered() <= stream.size());
+        }
+    }
+    printf("fuzz: %zu streams, %zu accepted\n", iterations, survived);
+}
+
+static void Benchmark()
+{
+    const size_t sizes[] = { 64, 4 * 1024, 256 * 1024 };
+    for (size_t size : sizes)
+    {
+        std::string payload = RandomPayload(size);
+        std::vector<EncodedFrame> frames;
+        std::string bytes;
+        std::vector<FrameMessage> messages;
+        FrameDecoder decoder;
+
+        size_t rounds = std::max<size_t>(1000, (256u << 20) / (size + FRAME_HEADER_SIZE));
+        size_t decoded = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; round++)
+        {
+            EncodeMessage(FrameType::Request, round, payload.size(), frames);
+            bytes.clear();
+            for (const EncodedFrame& frame : frames)
+            {
+                AppendFrame(frame, payload, bytes);
+            }
+            decoder.Feed(bytes.data(), bytes.size(), messages);
+            for (FrameMessage& message : messages)
+            {
+                decoded += message.payload.size();
+                BufferPool::Shared().Release(std::move(message.payload));
+            }
+            messages.clear();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        CHECK(decoded == rounds * size);
+        printf("round trip %7zu B: %10.0f msg/s  %8.1f MB/s\n", size, rounds / seconds, decoded / seconds / (1024.0 * 1024.0));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t iterations = argc > 1 ? (size_t)strtoul(argv[1], nullptr, 10) : 20000;
+
+    TestHeader();
+    TestRoundTrip();
+    TestRejects();
+    Fuzz(iterations);
+    Benchmark();
+    return TestExitCode("FrameCodecTest");
+}
@@ -0,0 +1,177 @@
+// PresenceEngineTest.cpp : PresenceEngine on a virtual clock: reports held
+// for the coalescing window, repeated reports for one contact collapsing into
+// one delta, flaps that cancel out, and deltas carrying only changed fields.
+
+#include "../SampleChatAppWithShare/PresenceEngine.h"
+#include "TestCheck.h"
+#include <algorithm>
+
+static const uint32_t WINDOW_MS = 250;
+
+static PresenceEngine MakeEngine(size_t contacts)
+{
+    PresenceEngine engine(WINDOW_MS);
+    engine.Reset(contacts);
+    for (size_t i = 0; i < contacts; i++)
+    {
+        engine.Track((int)i, false, L"Offline");
+    }
+    return engine;
+}
+
+static void TestWindow()
+{
+    PresenceEngine engine = MakeEngine(3);
+    std::vector<PresenceDelta> deltas;
+    CHECK(engine.CoalesceWindowMs() == WINDOW_MS);
+
+    // Matches what is committed: nothing to do
+    engine.Update(0, false, L"Offline", 1000);
+    CHECK(!engine.HasPending());
+
+    // Held until the window from the first report has passed
+    engine.Update(0, true, L"Available", 1000);
+    CHECK(engine.HasPending());
+    CHECK(engine.Flush(1000, deltas) == 0);
+    CHECK(engine.Flush(1000 + WINDOW_MS - 1, deltas) == 0);
+    CHECK(deltas.empty());
+    CHECK(engine.Flush(1000 + WINDOW_MS, deltas) == 1);
+    CHECK(!engine.HasPending());
+    CHECK(deltas.size() == 1 && deltas[0].contactIndex == 0);
+
+    // Committed now, so the same report again is nothing new
+    engine.Update(0, true, L"Available", 2000);
+    CHECK(!engine.HasPending());
+
+    // Each contact has its own window; Flush appends to what is already there
+    engine.Update(1, true, L"Busy", 3000);
+    engine.Update(2, true, L"Away", 3100);
+    CHECK(engine.Flush(3000 + WINDOW_MS, deltas) == 1);
+    CHECK(deltas.size() == 2 && deltas[1].contactIndex == 1);
+    CHECK(engine.HasPending());
+    CHECK(engine.Flush(3100 + WINDOW_MS, deltas) == 1);
+    CHECK(deltas.size() == 3 && deltas[2].contactIndex == 2);
+
+    // Contacts that are not tracked are ignored
+    engine.Update(-1, true, L"Available", 4000);
+    engine.Update(3, true, L"Available", 4000);
+    CHECK(!engine.HasPending());
+
+    // Reset forgets anything pending
+    engine.Update(0, false, L"Offline", 5000);
+    CHECK(engine.HasPending());
+    engine.Reset(3);
+    CHECK(!engine.HasPending());
+    CHECK(engine.Flush(10000, deltas) == 0);
+
+    // No window: committed on the next Flush
+    PresenceEngine immediate(0);
+    immediate.Reset(1);
+    immediate.Track(0, false, L"Offline");
+    immediate.Update(0, true, L"Available", 100);
+    deltas.clear();
+    CHECK(immediate.Flush(100, deltas) == 1);
+}
+
+static void TestRepeatedUpdates()
+{
+    PresenceEngine engine = MakeEngine(1);
+    std::vector<PresenceDelta> deltas;
+
+    // Many reports inside one window: one delta, carrying the last
+    engine.Update(0, true, L"Available", 0);
+    engine.Update(0, true, L"Busy", 50);
+    engine.Update(0, true, L"In a meeting", 100);
+    engine.Update(0, true, L"Away", 200);
+    CHECK(engine.Flush(WINDOW_MS, deltas) == 1);
+    CHECK(deltas.size() == 1 && deltas[0].isOnline && deltas[0].status == L"Away");
+
+    // Flapping back to the committed state inside the window: no delta at all
+    deltas.clear();
+    engine.Update(0, false, L"Offline", 1000);
+    engine.Update(0, true, L"Available", 1050);
+    engine.Update(0, true, L"Away", 1100);
+    CHECK(engine.Flush(1000 + WINDOW_MS, deltas) == 0);
+    CHECK(deltas.empty());
+    CHECK(!engine.HasPending());
+
+    // A contact that never settles is still committed once per window, measured
+    // from its first report rather than pushed back by each new one: reports
+    // every 20 ms from 2000 are committed at 2260, 2540 and 2820
+    size_t committed = 0;
+    for (uint64_t now = 2000; now < 3000; now += 20)
+    {
+        engine.Update(0, true, L"Typing " + std::to_wstring(now), now);
+        committed += engine.Flush(now, deltas);
+    }
+    CHECK(committed == 3);
+    CHECK(deltas.size() == 3 && deltas[2].status == L"Typing 2820");
+    CHECK(engine.HasPending());
+    CHECK(engine.Flush(2840 + WINDOW_MS, deltas) == 1);
+    CHECK(!deltas.empty() && deltas.back().status == L"Typing 2980");
+
+    // Thousands of contacts churning: never more than one delta each per Flush
+    const int contacts = 5000;
+    PresenceEngine busy = MakeEngine(contacts);
+    for (int round = 0; round < 20; round++)
+    {
+        for (int i = 0; i < contacts; i++)
+        {
+            busy.Update(i, round % 2 == 0, round % 3 == 0 ? L"Busy" : L"Available", (uint64_t)round);
+        }
+    }
+    deltas.clear();
+    CHECK(busy.Flush(WINDOW_MS, deltas) == (size_t)contacts);
+    std::vector<int> seen(contacts, 0);
+    for (const PresenceDelta& delta : deltas)
+    {
+        seen[delta.contactIndex]++;
+    }
+    CHECK(std::count(seen.begin(), seen.end(), 1) == contacts);
+}
+
+static void TestFieldDeltas()
+{
+    PresenceEngine engine = MakeEngine(1);
+    std::vector<PresenceDelta> deltas;
+
+    // Both fields changed
+    engine.Update(0, true, L"Available", 0);
+    engine.Flush(WINDOW_MS, deltas);
+    CHECK(deltas.size() == 1);
+    CHECK(deltas[0].changedFields == (PRESENCE_FIELD_ONLINE | PRESENCE_FIELD_STATUS));
+    CHECK(deltas[0].isOnline && deltas[0].status == L"Available");
+
+    // Status only
+    deltas.clear();
+    engine.Update(0, true, L"Busy", 1000);
+    engine.Flush(1000 + WINDOW_MS, deltas);
+    CHECK(deltas.size() == 1);
+    CHECK(deltas[0].changedFields == PRESENCE_FIELD_STATUS);
+    CHECK(deltas[0].isOnline && deltas[0].status == L"Busy");
+
+    // Online only: the status is not sent again
+    deltas.clear();
+    engine.Update(0, false, L"Busy", 2000);
+    engine.Flush(2000 + WINDOW_MS, deltas);
+    CHECK(deltas.size() == 1);
+    CHECK(deltas[0].changedFields == PRESENCE_FIELD_ONLINE);
+    CHECK(!deltas[0].isOnline && deltas[0].status.empty());
+
+    // Compared against what was committed, not against the reports in between
+    deltas.clear();
+    engine.Update(0, true, L"Busy", 3000);
+    engine.Update(0, false, L"Away", 3100);
+    engine.Flush(3000 + WINDOW_MS, deltas);
+    CHECK(deltas.size() == 1);
+    CHECK(deltas[0].changedFields == PRESENCE_FIELD_STATUS);
+    CHECK(!deltas[0].isOnline && deltas[0].status == L"Away");
+}
+
+int main()
+{
+    TestWindow();
+    TestRepeatedUpdates();
+    TestFieldDeltas();
+    return TestExitCode("PresenceEngineTest");
+}
@@ -0,0 +1,201 @@
+// ProcessIdentityCacheTest.cpp : ProcessIdentityCache over a fake process table.
+
+#include "../SampleChatAppWithShare/ProcessIdentityCache.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <map>
+#include <thread>
+
+static const wchar_t* OUR_FAMILY = L"Contoso.Chat_8wekyb3d8bbwe";
+
+// A process table the test edits directly, counting what the cache asks of it
+class FakeProcessSource : public ProcessIdentitySource
+{
+public:
+    struct Process
+    {
+        uint64_t instance;
+        Identity identity;
+        std::wstring family;
+    };
+
+    std::wstring currentFamily = OUR_FAMILY;
+    std::map<uint32_t, Process> processes;
+    int familyLookups = 0;
+    int listings = 0;
+    std::map<uint32_t, int> queries;
+
+    bool CurrentFamily(std::wstring& family) override
+    {
+        familyLookups++;
+        family = currentFamily;
+        return !currentFamily.empty();
+    }
+
+    bool ListProcesses(std::vector<ProcessEntry>& entries) override
+    {
+        listings++;
+        for (const auto& process : processes)
+        {
+            entries.push_back(ProcessEntry{ process.first, process.second.instance });
+        }
+        return true;
+    }
+
+    Identity QueryFamily(uint32_t pid, std::wstring& family) override
+    {
+        queries[pid]++;
+        auto found = processes.find(pid);
+        if (found == processes.end())
+            return Identity::Inaccessible;
+        if (found->second.identity == Identity::Packaged)
+            family = found->second.family;
+        return found->second.identity;
+    }
+};
+
+// The cache owns its source; the test keeps a pointer to look inside
+static ProcessIdentityCache MakeCache(FakeProcessSource*& source, std::chrono::milliseconds maxAge = std::chrono::hours(1))
+{
+    source = new FakeProcessSource();
+    source->processes[10] = { 1, ProcessIdentitySource::Identity::Packaged, OUR_FAMILY };
+    source->processes[20] = { 1, ProcessIdentitySource::Identity::Packaged, L"Fabrikam.Other_1234" };
+    source->processes[30] = { 1, ProcessIdentitySource::Identity::Unpackaged, L"" };
+    source->processes[40] = { 1, ProcessIdentitySource::Identity::Inaccessible, L"" };
+    return ProcessIdentityCache(std::unique_ptr<ProcessIdentitySource>(source), maxAge);
+}
+
+static bool Contains(const std::vector<uint32_t>& pids, uint32_t pid)
+{
+    return std::find(pids.begin(), pids.end(), pid) != pids.end();
+}
+
+static void TestLookups()
+{
+    FakeProcessSource* source;
+    ProcessIdentityCache cache = MakeCache(source);
+
+    CHECK(cache.CurrentFamily() == OUR_FAMILY);
+    CHECK(cache.IsInCurrentFamily(10));
+    CHECK(!cache.IsInCurrentFamily(20));
+    CHECK(!cache.IsInCurrentFamily(30));
+    CHECK(!cache.IsInCurrentFamily(40));
+
+    std::vector<uint32_t> ours = cache.ProcessesInCurrentFamily();
+    CHECK(ours.size() == 1 && Contains(ours, 10));
+
+    // Our own family is asked for once, each process once
+    CHECK(source->familyLookups == 1);
+    for (const auto& queried : source->queries)
+    {
+        CHECK(queried.second == 1);
+    }
+    CHECK(cache.GetStats().queries == 4);
+    CHECK(cache.GetStats().entries == 4);
+}
+
+static void TestNegativeEntries()
+{
+    FakeProcessSource* source;
+    ProcessIdentityCache cache = MakeCache(source);
+
+    for (int i = 0; i < 5; i++)
+    {
+        cache.Refresh();
+        CHECK(!cache.IsInCurrentFamily(30));
+        CHECK(!cache.IsInCurrentFamily(40));
+    }
+
+    // Unpackaged and inaccessible processes are remembered as such, not asked about again
+    CHECK(source->queries[30] == 1);
+    CHECK(source->queries[40] == 1);
+    CHECK(cache.GetStats().queries == 4);
+}
+
+static void TestPidReuse()
+{
+    FakeProcessSource* source;
+    ProcessIdentityCache cache = MakeCache(source);
+    CHECK(!cache.IsInCurrentFamily(30));
+
+    // PID 30 exits and the number goes to a new process of our package
+    source->processes[30] = { 2, ProcessIdentitySource::Identity::Packaged, OUR_FAMILY };
+    cache.Refresh();
+    CHECK(cache.IsInCurrentFamily(30));
+    CHECK(source->queries[30] == 2);
+
+    // And the other way round
+    source->processes[10] = { 7, ProcessIdentitySource::Identity::Unpackaged, L"" };
+    cache.Refresh();
+    CHECK(!cache.IsInCurrentFamily(10));
+    CHECK(source->queries[10] == 2);
+
+    std::vector<uint32_t> ours = cache.ProcessesInCurrentFamily();
+    CHECK(ours.size() == 1 && Contains(ours, 30));
+}
+
+static void TestDropOnExit()
+{
+    FakeProcessSource* source;
+    ProcessIdentityCache cache = MakeCache(source);
+    cache.Refresh();
+    CHECK(cache.GetStats().entries == 4);
+
+    source->processes.erase(10);
+    source->processes.erase(30);
+    cache.Refresh();
+    CHECK(cache.GetStats().entries == 2);
+    CHECK(!cache.IsInCurrentFamily(10));
+    CHECK(cache.ProcessesInCurrentFamily().empty());
+
+    // A process that started after the last listing is found by listing again
+    int listings = source->listings;
+    source->processes[50] = { 1, ProcessIdentitySource::Identity::Packaged, OUR_FAMILY };
+    CHECK(cache.IsInCurrentFamily(50));
+    CHECK(source->listings == listings + 1);
+}
+
+static void TestMaxAge()
+{
+    FakeProcessSource* source;
+    ProcessIdentityCache cache = MakeCache(source, std::chrono::milliseconds(50));
+
+    CHECK(cache.IsInCurrentFamily(10));
+    int listings = source->listings;
+
+    // A known PID with a young listing is answered from the cache
+    CHECK(cache.IsInCurrentFamily(10));
+    CHECK(!cache.IsInCurrentFamily(20));
+    CHECK(source->listings == listings);
+
+    // Once the listing is old, an exit is noticed
+    source->processes.erase(10);
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    CHECK(!cache.IsInCurrentFamily(10));
+    CHECK(source->listings == listings + 1);
+}
+
+static void TestUnpackagedCaller()
+{
+    FakeProcessSource* source;
+    ProcessIdentityCache cache = MakeCache(source);
+    source->currentFamily.clear();
+
+    // Without a package of our own nothing can be in it, and nothing is listed to find out
+    CHECK(cache.CurrentFamily().empty());
+    CHECK(!cache.IsInCurrentFamily(10));
+    CHECK(cache.ProcessesInCurrentFamily().empty());
+    CHECK(source->listings == 0);
+    CHECK(source->familyLookups == 1);
+}
+
+int main()
+{
+    TestLookups();
+    TestNegativeEntries();
+    TestPidReuse();
+    TestDropOnExit();
+    TestMaxAge();
+    TestUnpackagedCaller();
+    return TestExitCode("ProcessIdentityCacheTest");
+}
@@ -0,0 +1,161 @@
+// RowCacheTest.cpp : RowCache, the pre-rendered contact row cache, under the
+// budget the contact list gives it: eviction and byte accounting, and the hit
+// rate of a scrolling workload.
+
+#include "../SampleChatAppWithShare/RowCache.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <set>
+
+// The contact list's values (UIConstants.h, which needs windows.h)
+static const size_t ROW_CACHE_BUDGET_BYTES = 4 * 1024 * 1024;
+static const int CONTACT_ITEM_HEIGHT = 72;
+static const int LIST_WIDTH = 300;
+static const size_t ROW_BYTES = (size_t)LIST_WIDTH * CONTACT_ITEM_HEIGHT * 4;   // 32 bpp, as ContactListView inserts them
+
+// Images are just numbers here; the release function records which went
+struct ReleaseLog
+{
+    std::multiset<uintptr_t> released;
+
+    RowCache::ReleaseFunction Function()
+    {
+        return [this](void* image) { released.insert((uintptr_t)image); };
+    }
+};
+
+static void* Image(uintptr_t id)
+{
+    return (void*)id;
+}
+
+static void TestEviction()
+{
+    ReleaseLog log;
+    RowCache cache(ROW_CACHE_BUDGET_BYTES, log.Function());
+    const size_t fits = ROW_CACHE_BUDGET_BYTES / ROW_BYTES;
+
+    for (uintptr_t key = 1; key <= fits; key++)
+    {
+        cache.Insert(key, Image(key), ROW_BYTES);
+    }
+    CHECK(cache.Count() == fits);
+    CHECK(cache.Bytes() == fits * ROW_BYTES);
+    CHECK(log.released.empty());
+
+    // Touch the oldest entry; the next insert evicts the one after it instead
+    CHECK(cache.Find(1) == Image(1));
+    cache.Insert(1000, Image(1000), ROW_BYTES);
+    CHECK(cache.Count() == fits);
+    CHECK(cache.Bytes() <= ROW_CACHE_BUDGET_BYTES);
+    CHECK(log.released.count(2) == 1);
+    CHECK(cache.Find(2) == nullptr);
+    CHECK(cache.Find(1) == Image(1));
+
+    // Re-rendering a row under the same key replaces and releases the old image
+    cache.Insert(1, Image(2000), ROW_BYTES);
+    CHECK(log.released.count(1) == 1);
+    CHECK(cache.Find(1) == Image(2000));
+    CHECK(cache.Count() == fits);
+    CHECK(cache.Bytes() == fits * ROW_BYTES);
+
+    // A row wider than the whole budget pushes everything else out but stays itself
+    cache.Insert(3000, Image(3000), ROW_CACHE_BUDGET_BYTES * 2);
+    CHECK(cache.Count() == 1);
+    CHECK(cache.Find(3000) == Image(3000));
+    cache.Insert(3001, Image(3001), ROW_BYTES);
+    CHECK(cache.Find(3000) == nullptr);
+    CHECK(cache.Count() == 1);
+
+    // Every image inserted is released exactly once, by eviction, Clear or the destructor
+    cache.Clear();
+    CHECK(cache.Count() == 0 && cache.Bytes() == 0);
+    CHECK(log.released.size() == fits + 4);
+    for (uintptr_t id : log.released)
+    {
+        CHECK(log.released.count(id) == 1);
+    }
+
+    {
+        RowCache scoped(ROW_CACHE_BUDGET_BYTES, log.Function());
+        scoped.Insert(1, Image(4000), ROW_BYTES);
+    }
+    CHECK(log.released.count(4000) == 1);
+}
+
+// Scroll a list of 'contacts' rows 'visible' at a time, bouncing between the
+// top and 'span' rows down, and look every visible row up as a paint would.
+// Selection moves now and then, which changes two rows' hashes.
+static double ScrollHitRate(int contacts, int visible, int span, int steps)
+{
+    RowCache cache(ROW_CACHE_BUDGET_BYTES, nullptr);
+    int top = 0;
+    int direction = 1;
+    int selected = 0;
+    uint64_t peak = 0;
+
+    for (int step = 0; step < steps; step++)
+    {
+        if (step % 50 == 0)
+            selected = (selected + 7) % contacts;
+
+        for (int row = top; row < top + visible && row < contacts; row++)
+        {
+            std::wstring name = L"Contact " + std::to_wstring(row);
+            uint64_t key = HashContactRow(name, L"Available", L"See you tomorrow", row == selected, row % 3 != 0,
+                LIST_WIDTH, CONTACT_ITEM_HEIGHT);
+            if (!cache.Find(key))
+                cache.Insert(key, Image((uintptr_t)key | 1), ROW_BYTES);
+            peak = std::max<uint64_t>(peak, cache.Bytes());
+        }
+
+        top += direction;
+        if (top <= 0 || top + visible >= std::min(span, contacts))
+            direction = -direction;
+    }
+
+    CHECK(peak <= ROW_CACHE_BUDGET_BYTES);
+    return (double)cache.Hits() / (double)(cache.Hits() + cache.Misses());
+}
+
+static void TestHitRate()
+{
+    const int visible = 10;
+    const size_t fits = ROW_CACHE_BUDGET_BYTES / ROW_BYTES;
+
+    // Scrolling back and forth over fewer rows than the budget holds: only
+    // first paints and selection changes miss
+    double local = ScrollHitRate(5000, visible, (int)fits - 4, 2000);
+
+    // Sweeping the whole list: rows come back only after being evicted
+    double sweep = ScrollHitRate(5000, visible, 5000, 2000);
+
+    printf("row %zu bytes, %zu rows fit in %zu KB\n", ROW_BYTES, fits, ROW_CACHE_BUDGET_BYTES / 1024);
+    printf("hit rate scrolling within %zu rows: %.1f%%\n", fits - 4, local * 100.0);
+    printf("hit rate sweeping 5000 rows:      %.1f%%\n", sweep * 100.0);
+
+    CHECK(fits >= 40);
+    CHECK(local > 0.95);
+    CHECK(sweep > 0.85);    // each step brings one new row into view
+}
+
+static void TestRowHash()
+{
+    uint64_t base = HashContactRow(L"Alice", L"Online", L"hi", false, true, LIST_WIDTH, CONTACT_ITEM_HEIGHT);
+    CHECK(base == HashContactRow(L"Alice", L"Online", L"hi", false, true, LIST_WIDTH, CONTACT_ITEM_HEIGHT));
+    CHECK(base != HashContactRow(L"Alice", L"Online", L"hi", true, true, LIST_WIDTH, CONTACT_ITEM_HEIGHT));
+    CHECK(base != HashContactRow(L"Alice", L"Online", L"hi", false, false, LIST_WIDTH, CONTACT_ITEM_HEIGHT));
+    CHECK(base != HashContactRow(L"Alice", L"Online", L"hi", false, true, LIST_WIDTH + 1, CONTACT_ITEM_HEIGHT));
+    CHECK(base != HashContactRow(L"Alice", L"Online", L"hi!", false, true, LIST_WIDTH, CONTACT_ITEM_HEIGHT));
+
+    // Text moving between fields is a different row
+    CHECK(HashContactRow(L"ab", L"c", L"", false, false, 1, 1) != HashContactRow(L"a", L"bc", L"", false, false, 1, 1));
+}
+
+int main()
+{
+    TestEviction();
+    TestHitRate();
+    TestRowHash();
+    return TestExitCode("RowCacheTest");
+}
@@ -0,0 +1,286 @@
+// ServiceResponseCacheTest.cpp : ServiceResponseCache, the background
+// service's reply cache: identical requests in flight sharing one compute,
+// time to live, topic invalidation (also while a compute is running), a
+// compute that throws, and eviction when the cache is full.
+
+#include "../SampleChatAppWithShare/ServiceResponseCache.h"
+#include "TestCheck.h"
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using std::chrono::milliseconds;
+
+// Polls until condition holds or a few seconds pass, so a broken cache fails
+// the check instead of hanging the test
+template <typename Condition>
+static bool WaitFor(Condition condition)
+{
+    for (int i = 0; i < 5000; i++)
+    {
+        if (condition())
+            return true;
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    return condition();
+}
+
+// A compute that counts its calls and answers with its call number
+struct Counter
+{
+    std::atomic<int> calls{ 0 };
+
+    ServiceResponseCache::Compute Compute()
+    {
+        return [this](std::string& response) { response = "reply " + std::to_string(++calls); };
+    }
+};
+
+static std::string Get(ServiceResponseCache& cache, const std::string& request, const ServiceResponseCache::Compute& compute)
+{
+    std::string response;
+    cache.Get(request, response, compute);
+    return response;
+}
+
+static void TestWithoutPolicy()
+{
+    ServiceResponseCache cache;
+    Counter counter;
+    CHECK(Get(cache, "GET_HELLO_WORLD", counter.Compute()) == "reply 1");
+    CHECK(Get(cache, "GET_HELLO_WORLD", counter.Compute()) == "reply 2");
+
+    ServiceResponseCache::Stats stats = cache.GetStats();
+    CHECK(stats.hits == 0 && stats.misses == 0 && stats.entries == 0);
+
+    // Cached once a policy is set, and only for its verb; the argument is part of the key
+    cache.SetPolicy("GET_HISTORY", milliseconds(60000));
+    CHECK(Get(cache, "GET_HISTORY 1", counter.Compute()) == "reply 3");
+    CHECK(Get(cache, "GET_HISTORY 1", counter.Compute()) == "reply 3");
+    CHECK(Get(cache, "GET_HISTORY 2", counter.Compute()) == "reply 4");
+    CHECK(Get(cache, "GET_HELLO_WORLD", counter.Compute()) == "reply 5");
+
+    stats = cache.GetStats();
+    CHECK(stats.hits == 1 && stats.misses == 2 && stats.entries == 2);
+
+    // Without the policy again, nothing is kept
+    cache.ClearPolicy("GET_HISTORY");
+    CHECK(Get(cache, "GET_HISTORY 1", counter.Compute()) == "reply 6");
+    CHECK(cache.GetStats().entries == 0);
+}
+
+// Sixteen identical requests arrive while the first is still computing; the
+// compute is held until all of them are waiting on it
+static void TestCoalescing()
+{
+    const int callers = 16;
+    ServiceResponseCache cache;
+    cache.SetPolicy("GET_CONTACTS", milliseconds(60000));
+
+    std::atomic<int> calls{ 0 };
+    auto compute = [&](std::string& response) {
+        calls++;
+        WaitFor([&]() { return cache.GetStats().coalesced == callers - 1; });
+        response = "contacts";
+    };
+
+    std::vector<std::string> responses(callers);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < callers; i++)
+    {
+        threads.emplace_back([&, i]() { cache.Get("GET_CONTACTS", responses[i], compute); });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    CHECK(calls == 1);
+    for (const auto& response : responses)
+    {
+        CHECK(response == "contacts");
+    }
+    ServiceResponseCache::Stats stats = cache.GetStats();
+    CHECK(stats.misses == 1 && stats.coalesced == callers - 1 && stats.hits == 0);
+
+    // Landed, so the next one is a plain hit
+    std::string response;
+    cache.Get("GET_CONTACTS", response, compute);
+    CHECK(response == "contacts" && calls == 1);
+    CHECK(cache.GetStats().hits == 1);
+}
+
+static void TestTimeToLive()
+{
+    ServiceResponseCache cache;
+    Counter counter;
+    cache.SetPolicy("GET_CONTACTS", milliseconds(50));
+
+    CHECK(Get(cache, "GET_CONTACTS", counter.Compute()) == "reply 1");
+    CHECK(Get(cache, "GET_CONTACTS", counter.Compute()) == "reply 1");
+    std::this_thread::sleep_for(milliseconds(80));
+    CHECK(Get(cache, "GET_CONTACTS", counter.Compute()) == "reply 2");
+
+    // A zero time to live keeps nothing once the compute is done
+    cache.SetPolicy("GET_PRESENCE", milliseconds(0));
+    CHECK(Get(cache, "GET_PRESENCE", counter.Compute()) == "reply 3");
+    CHECK(Get(cache, "GET_PRESENCE", counter.Compute()) == "reply 4");
+    CHECK(cache.GetStats().entries == 1);
+
+    // Clear drops everything at once
+    cache.Clear();
+    CHECK(cache.GetStats().entries == 0);
+    CHECK(Get(cache, "GET_CONTACTS", counter.Compute()) == "reply 5");
+}
+
+static void TestInvalidation()
+{
+    ServiceResponseCache cache;
+    ServiceResponseCache other;
+    Counter counter;
+    cache.SetPolicy("GET_CONTACTS", milliseconds(60000), "test.contacts");
+    other.SetPolicy("GET_CONTACTS", milliseconds(60000), "test.contacts");
+    cache.SetPolicy("GET_HISTORY", milliseconds(60000), "test.history");
+
+    CHECK(Get(cache, "GET_CONTACTS", counter.Compute()) == "reply 1");
+    CHECK(Get(other, "GET_CONTACTS", counter.Compute()) == "reply 2");
+    CHECK(Get(cache, "GET_HISTORY", counter.Compute()) == "reply 3");
+
+    // Every cache in the process drops what was built from the topic, and only that
+    ServiceResponseCache::InvalidateTopic("test.contacts");
+    CHECK(Get(cache, "GET_CONTACTS", counter.Compute()) == "reply 4");
+    CHECK(Get(other, "GET_CONTACTS", counter.Compute()) == "reply 5");
+    CHECK(Get(cache, "GET_HISTORY", counter.Compute()) == "reply 3");
+
+    // Invalidated while a compute is running: a request arriving afterwards
+    // does not wait for the old data, and the old reply is never served
+    std::atomic<bool> release{ false };
+    std::atomic<bool> started{ false };
+    auto stale = [&](std::string& response) {
+        started = true;
+        WaitFor([&]() { return release.load(); });
+        response = "before the change";
+    };
+    auto fresh = [](std::string& response) { response = "after the change"; };
+
+    cache.SetPolicy("GET_PRESENCE", milliseconds(60000), "test.presence");
+    std::string first;
+    std::thread slow([&]() { cache.Get("GET_PRESENCE", first, stale); });
+    CHECK(WaitFor([&]() { return started.load(); }));
+
+    ServiceResponseCache::InvalidateTopic("test.presence");
+    std::string second;
+    cache.Get("GET_PRESENCE", second, fresh);
+    CHECK(second == "after the change");
+    CHECK(cache.GetStats().coalesced == 0);
+
+    release = true;
+    slow.join();
+    CHECK(first == "before the change");
+    CHECK(Get(cache, "GET_PRESENCE", fresh) == "after the change");
+    CHECK(Get(cache, "GET_PRESENCE", stale) == "after the change");
+}
+
+// The first compute throws while a second caller waits on it: the first gets
+// the exception, the second computes for itself, and nothing bad is stored
+static void TestThrowingCompute()
+{
+    ServiceResponseCache cache;
+    cache.SetPolicy("GET_CONTACTS", milliseconds(60000));
+
+    std::atomic<int> calls{ 0 };
+    auto failing = [&](std::string&) {
+        calls++;
+        WaitFor([&]() { return cache.GetStats().coalesced == 1; });
+        throw std::runtime_error("handler failed");
+    };
+    auto working = [&](std::string& response) {
+        calls++;
+        response = "contacts";
+    };
+
+    bool threw = false;
+    std::thread first([&]() {
+        std::string response;
+        try
+        {
+            cache.Get("GET_CONTACTS", response, failing);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+    });
+    CHECK(WaitFor([&]() { return calls.load() == 1; }));
+
+    std::string second;
+    cache.Get("GET_CONTACTS", second, working);
+    first.join();
+
+    CHECK(threw);
+    CHECK(second == "contacts");
+    CHECK(calls == 2);
+    CHECK(Get(cache, "GET_CONTACTS", failing) == "contacts");
+    CHECK(calls == 2);
+
+    // Thrown with nobody waiting: the next request simply computes again
+    cache.Clear();
+    bool rethrown = false;
+    try
+    {
+        std::string response;
+        cache.Get("GET_CONTACTS", response, [](std::string&) { throw std::runtime_error("again"); });
+    }
+    catch (const std::runtime_error&)
+    {
+        rethrown = true;
+    }
+    CHECK(rethrown);
+    CHECK(Get(cache, "GET_CONTACTS", working) == "contacts");
+}
+
+static void TestEviction()
+{
+    ServiceResponseCache cache(4);
+    Counter counter;
+    cache.SetPolicy("SHORT", milliseconds(30));
+    cache.SetPolicy("LONG", milliseconds(60000));
+
+    // Full: the entry closest to expiring goes
+    for (int i = 1; i <= 4; i++)
+    {
+        Get(cache, "LONG " + std::to_string(i), counter.Compute());
+    }
+    CHECK(cache.GetStats().entries == 4);
+    Get(cache, "LONG 5", counter.Compute());
+    CHECK(cache.GetStats().entries == 4);
+    CHECK(counter.calls == 5);
+    CHECK(Get(cache, "LONG 2", counter.Compute()) == "reply 2");
+    CHECK(Get(cache, "LONG 5", counter.Compute()) == "reply 5");
+    CHECK(Get(cache, "LONG 1", counter.Compute()) == "reply 6");
+
+    // Expired entries go first, all of them
+    cache.Clear();
+    Get(cache, "SHORT 1", counter.Compute());
+    Get(cache, "SHORT 2", counter.Compute());
+    Get(cache, "LONG 1", counter.Compute());
+    Get(cache, "LONG 2", counter.Compute());
+    std::this_thread::sleep_for(milliseconds(50));
+    Get(cache, "LONG 3", counter.Compute());
+    CHECK(cache.GetStats().entries == 3);
+    int calls = counter.calls;
+    Get(cache, "LONG 1", counter.Compute());
+    Get(cache, "LONG 2", counter.Compute());
+    CHECK(counter.calls == calls);
+}
+
+int main()
+{
+    TestWithoutPolicy();
+    TestCoalescing();
+    TestTimeToLive();
+    TestInvalidation();
+    TestThrowingCompute();
+    TestEviction();
+    return TestExitCode("ServiceResponseCacheTest");
+}
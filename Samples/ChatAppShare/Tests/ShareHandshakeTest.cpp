@@ -0,0 +1,150 @@
+// ShareHandshakeTest.cpp : The share target's handshake with the chat app,
+// driven through fake launch and ready steps.
+
+#include "../SampleChatAppWithShare/ShareHandshake.h"
+#include "TestCheck.h"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records what the handshake asked of the system and answers as told
+struct FakeSteps
+{
+    bool alreadyUp = false;         // the first, zero-timeout look succeeds
+    bool launchSucceeds = true;
+    int readyAfterMs = -1;          // after launching, when the app announces itself (-1: never)
+
+    int launches = 0;
+    std::vector<int> waits;         // timeouts passed to waitForReady
+
+    ShareHandshake::Steps Make()
+    {
+        ShareHandshake::Steps steps;
+        steps.launch = [this]() {
+            launches++;
+            return launchSucceeds;
+        };
+        steps.waitForReady = [this](int timeoutMs) {
+            waits.push_back(timeoutMs);
+            if (timeoutMs == 0)
+                return alreadyUp;
+
+            // Block the way the real ready signal would, up to the timeout
+            bool ready = readyAfterMs >= 0 && readyAfterMs <= timeoutMs;
+            int blockMs = ready ? readyAfterMs : timeoutMs;
+            std::this_thread::sleep_for(std::chrono::milliseconds(blockMs));
+            return ready;
+        };
+        return steps;
+    }
+};
+
+static void TestAlreadyUp()
+{
+    FakeSteps fake;
+    fake.alreadyUp = true;
+    ShareHandshake handshake(fake.Make(), 1000);
+
+    CHECK(handshake.State() == ShareHandshakeState::Idle);
+    CHECK(handshake.Advance() == ShareHandshakeState::Probing);
+    CHECK(handshake.Advance() == ShareHandshakeState::Ready);
+    CHECK(handshake.IsFinished());
+
+    // Found by probing: nothing launched, nothing waited on
+    CHECK(fake.launches == 0);
+    CHECK(!handshake.Launched());
+    CHECK(fake.waits.size() == 1 && fake.waits[0] == 0);
+
+    // Finished is final
+    CHECK(handshake.Advance() == ShareHandshakeState::Ready);
+    CHECK(fake.waits.size() == 1);
+}
+
+static void TestLaunchThenReady()
+{
+    FakeSteps fake;
+    fake.readyAfterMs = 50;
+    ShareHandshake handshake(fake.Make(), 2000);
+
+    CHECK(handshake.Advance() == ShareHandshakeState::Probing);
+    CHECK(handshake.Advance() == ShareHandshakeState::Launching);
+    CHECK(handshake.Advance() == ShareHandshakeState::AwaitingReady);
+    CHECK(handshake.Launched());
+    CHECK(handshake.Advance() == ShareHandshakeState::Ready);
+
+    CHECK(fake.launches == 1);
+    CHECK(fake.waits.size() == 2);
+
+    // The wait gets what is left of the budget, and returns as soon as the app is up
+    CHECK(fake.waits.size() < 2 || (fake.waits[1] > 1500 && fake.waits[1] <= 2000));
+    CHECK(handshake.ElapsedMs() >= 50 && handshake.ElapsedMs() < 1000);
+}
+
+static void TestLaunchFails()
+{
+    FakeSteps fake;
+    fake.launchSucceeds = false;
+    ShareHandshake handshake(fake.Make(), 1000);
+
+    CHECK(handshake.Run() == ShareHandshakeState::LaunchFailed);
+    CHECK(handshake.IsFinished());
+    CHECK(!handshake.Launched());
+    CHECK(fake.launches == 1);
+
+    // No point waiting for an app that never started
+    CHECK(fake.waits.size() == 1);
+}
+
+static void TestTimesOut()
+{
+    FakeSteps fake;
+    ShareHandshake handshake(fake.Make(), 200);
+
+    CHECK(handshake.Run() == ShareHandshakeState::TimedOut);
+    CHECK(handshake.Launched());
+    CHECK(fake.waits.size() == 2);
+    CHECK(handshake.ElapsedMs() >= 150 && handshake.ElapsedMs() < 1000);
+
+    // Ready only after the budget ran out is still a timeout
+    FakeSteps late;
+    late.readyAfterMs = 400;
+    ShareHandshake lateHandshake(late.Make(), 200);
+    CHECK(lateHandshake.Run() == ShareHandshakeState::TimedOut);
+}
+
+static void TestLaunchUsesUpBudget()
+{
+    // A launch that takes longer than the whole budget leaves nothing to wait with
+    FakeSteps fake;
+    fake.readyAfterMs = 0;
+    ShareHandshake::Steps steps = fake.Make();
+    auto launch = steps.launch;
+    steps.launch = [launch]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(120));
+        return launch();
+    };
+    ShareHandshake handshake(steps, 100);
+
+    handshake.Run();
+    CHECK(fake.waits.size() == 2);
+    CHECK(fake.waits.size() < 2 || fake.waits[1] == 0);
+}
+
+static void TestStateNames()
+{
+    CHECK(std::string(ShareHandshakeStateName(ShareHandshakeState::AwaitingReady)) == "AwaitingReady");
+    CHECK(std::string(ShareHandshakeStateName(ShareHandshakeState::TimedOut)) == "TimedOut");
+    CHECK(std::string(ShareHandshakeStateName((ShareHandshakeState)99)) == "Unknown");
+}
+
+int main()
+{
+    TestAlreadyUp();
+    TestLaunchThenReady();
+    TestLaunchFails();
+    TestTimesOut();
+    TestLaunchUsesUpBudget();
+    TestStateNames();
+    return TestExitCode("ShareHandshakeTest");
+}
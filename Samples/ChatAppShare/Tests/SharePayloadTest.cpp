@@ -0,0 +1,129 @@
+// SharePayloadTest.cpp : DeferredSharedFormat and DescribeSharePayload, the
+// portable half of reading what another app shared.
+
+#include "../SampleChatAppWithShare/SharePayload.h"
+#include "TestCheck.h"
+#include <stdexcept>
+
+static bool HasItem(const SharePayloadDescription& description, const std::wstring& item)
+{
+    for (const auto& line : description.items)
+    {
+        if (line == item)
+            return true;
+    }
+    return false;
+}
+
+static void TestDeferredLoadsOnce()
+{
+    DeferredSharedFormat format;
+    CHECK(format.State() == SharedFormatState::Absent);
+    CHECK(format.Get() == nullptr);
+
+    int loads = 0;
+    format.Defer([&loads](std::vector<uint8_t>& bytes) {
+        loads++;
+        bytes = { 1, 2, 3 };
+        return true;
+    });
+    CHECK(format.State() == SharedFormatState::Deferred);
+    CHECK(loads == 0);
+
+    const std::vector<uint8_t>* bytes = format.Get();
+    CHECK(bytes && bytes->size() == 3 && (*bytes)[2] == 3);
+    CHECK(format.State() == SharedFormatState::Ready);
+    CHECK(format.Get() == bytes);
+    CHECK(format.Get() == bytes);
+    CHECK(loads == 1);
+}
+
+static void TestDeferredFailures()
+{
+    // A loader that reports failure, and one that throws, both leave it Failed for good
+    int loads = 0;
+    DeferredSharedFormat refused;
+    refused.Defer([&loads](std::vector<uint8_t>&) {
+        loads++;
+        return false;
+    });
+    CHECK(refused.Get() == nullptr);
+    CHECK(refused.State() == SharedFormatState::Failed);
+    CHECK(refused.Get() == nullptr);
+    CHECK(loads == 1);
+
+    loads = 0;
+    DeferredSharedFormat throwing;
+    throwing.Defer([&loads](std::vector<uint8_t>& bytes) -> bool {
+        loads++;
+        bytes.push_back(9);
+        throw std::runtime_error("source went away");
+    });
+    CHECK(throwing.Get() == nullptr);
+    CHECK(throwing.State() == SharedFormatState::Failed);
+    CHECK(throwing.Get() == nullptr);
+    CHECK(loads == 1);
+
+    // Deferring again starts over, without what the failed load left behind
+    throwing.Defer([](std::vector<uint8_t>& bytes) {
+        bytes.push_back(4);
+        return true;
+    });
+    const std::vector<uint8_t>* bytes = throwing.Get();
+    CHECK(bytes && bytes->size() == 1 && (*bytes)[0] == 4);
+}
+
+static void TestDescribe()
+{
+    SharePayload empty;
+    SharePayloadDescription nothing = DescribeSharePayload(empty);
+    CHECK(nothing.summary == L"Shared Content");
+    CHECK(nothing.items.size() == 1 && nothing.items[0] == L"Unknown content type");
+
+    SharePayload text;
+    text.text = { SharedFormatState::Ready, L"hello" };
+    text.webLink = { SharedFormatState::Failed, L"" };
+    SharePayloadDescription textDescription = DescribeSharePayload(text);
+    CHECK(textDescription.items.size() == 2);
+    CHECK(HasItem(textDescription, L"Text: hello"));
+    CHECK(HasItem(textDescription, L"Web Link: [Error retrieving web link]"));
+
+    // Describing a deferred bitmap mentions it without fetching it
+    SharePayload image;
+    int loads = 0;
+    image.bitmap.Defer([&loads](std::vector<uint8_t>&) {
+        loads++;
+        return true;
+    });
+    SharePayloadDescription imageDescription = DescribeSharePayload(image);
+    CHECK(HasItem(imageDescription, L"Image/Bitmap content"));
+    CHECK(loads == 0);
+    CHECK(image.bitmap.State() == SharedFormatState::Deferred);
+
+    image.bitmap.Defer([](std::vector<uint8_t>&) -> bool { throw 1; });
+    image.bitmap.Get();
+    CHECK(HasItem(DescribeSharePayload(image), L"Image: [Error retrieving image]"));
+
+    SharePayload one;
+    one.storageItems = { SharedFormatState::Ready, { { L"report.pdf", L"C:\\report.pdf" } } };
+    SharePayloadDescription oneDescription = DescribeSharePayload(one);
+    CHECK(oneDescription.summary == L"report.pdf");
+    CHECK(HasItem(oneDescription, L"1 file(s)\n  - report.pdf"));
+
+    SharePayload many;
+    many.storageItems = { SharedFormatState::Ready, { { L"a.txt", L"" }, { L"b.txt", L"" } } };
+    CHECK(DescribeSharePayload(many).summary == L"Multiple Files (2)");
+
+    SharePayload failedFiles;
+    failedFiles.storageItems.state = SharedFormatState::Failed;
+    CHECK(HasItem(DescribeSharePayload(failedFiles), L"Files: [Error retrieving files]"));
+}
+
+int main()
+{
+    TestDeferredLoadsOnce();
+    TestDeferredFailures();
+    TestDescribe();
+    CHECK(std::wstring(SharedFormatStateName(SharedFormatState::Deferred)) == L"Deferred");
+    return TestExitCode("SharePayloadTest");
+}
@@ -0,0 +1,199 @@
+// SharedFileIndexTest.cpp : SharedFileIndex, the shared-files list of one
+// contact: paths compared the way Windows does, identical content listed
+// once, content hashes that arrive late merging entries, timeShared order and
+// paging through it with At(), and how long many late merges take.
+
+#include "../SampleChatAppWithShare/SharedFileIndex.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+typedef std::chrono::steady_clock Clock;
+
+static SharedFile MakeFile(const std::wstring& filePath, uint64_t timeShared, uint64_t contentHash = 0)
+{
+    SharedFile file{};
+    file.filePath = filePath;
+    file.fileName = filePath.substr(filePath.find_last_of(L"\\/") + 1);
+    file.sharedBy = L"You";
+    file.timeShared = timeShared;
+    file.contentHash = contentHash;
+    return file;
+}
+
+static std::shared_ptr<const FileMetadata> MakeMetadata(uint64_t contentHash)
+{
+    auto metadata = std::make_shared<FileMetadata>();
+    metadata->size = 1;
+    metadata->contentHash = contentHash;
+    metadata->mimeType = "text/plain";
+    metadata->thumbnailWidth = 0;
+    metadata->thumbnailHeight = 0;
+    return metadata;
+}
+
+static void TestPaths()
+{
+    SharedFileIndex index;
+    CHECK(index.Empty());
+    CHECK(index.Add(MakeFile(L"C:\\Users\\Me\\Report.docx", 10)));
+
+    // Case and slash direction do not make another file
+    CHECK(!index.Add(MakeFile(L"c:/users/me/REPORT.DOCX", 20)));
+    CHECK(!index.Add(MakeFile(L"C:\\Users/Me\\report.docx", 30)));
+    CHECK(index.ContainsPath(L"C:/USERS/ME/Report.docx"));
+    CHECK(!index.ContainsPath(L"C:\\Users\\Me\\Report.doc"));
+    CHECK(index.Size() == 1);
+
+    // The entry keeps the path as it was first given
+    CHECK(index.At(0).filePath == L"C:\\Users\\Me\\Report.docx");
+
+    // Paths that are not there
+    CHECK(index.SetContentHash(L"C:\\missing.txt", 5) == SharedFileUpdate::NotFound);
+    CHECK(index.SetMetadata(L"C:\\missing.txt", MakeMetadata(5)) == SharedFileUpdate::NotFound);
+    CHECK(index.SetMetadata(L"C:\\Users\\Me\\Report.docx", nullptr) == SharedFileUpdate::NotFound);
+
+    index.Clear();
+    CHECK(index.Empty());
+    CHECK(!index.ContainsPath(L"C:\\Users\\Me\\Report.docx"));
+    CHECK(index.Add(MakeFile(L"C:\\Users\\Me\\Report.docx", 10)));
+}
+
+static void TestContent()
+{
+    SharedFileIndex index;
+
+    // Content already known when added: a copy under another name is dropped
+    CHECK(index.Add(MakeFile(L"C:\\a.png", 10, 0xAA)));
+    CHECK(!index.Add(MakeFile(L"D:\\copy of a.png", 20, 0xAA)));
+    CHECK(!index.ContainsPath(L"D:\\copy of a.png"));
+
+    // Content known later: merged then, the earlier share stays
+    CHECK(index.Add(MakeFile(L"C:\\b.txt", 30)));
+    CHECK(index.Add(MakeFile(L"C:\\c.txt", 40)));
+    CHECK(index.Size() == 3);
+    CHECK(index.SetContentHash(L"C:\\c.txt", 0xCC) == SharedFileUpdate::Updated);
+    CHECK(index.SetContentHash(L"C:\\c.txt", 0xCC) == SharedFileUpdate::Updated);
+    CHECK(index.SetContentHash(L"C:\\b.txt", 0xCC) == SharedFileUpdate::Merged);
+    CHECK(index.Size() == 2);
+    CHECK(index.At(1).filePath == L"C:\\b.txt");
+
+    // Both paths still lead to the entry that stayed
+    CHECK(index.ContainsPath(L"C:\\c.txt"));
+    auto metadata = MakeMetadata(0xCC);
+    CHECK(index.SetMetadata(L"C:\\c.txt", metadata) == SharedFileUpdate::Updated);
+    CHECK(index.At(1).metadata == metadata);
+
+    // The later share learns its content first and still gives way
+    CHECK(index.Add(MakeFile(L"C:\\d.txt", 50)));
+    CHECK(index.Add(MakeFile(L"C:\\e.txt", 60)));
+    CHECK(index.SetMetadata(L"C:\\e.txt", MakeMetadata(0xDD)) == SharedFileUpdate::Updated);
+    CHECK(index.SetMetadata(L"C:\\d.txt", MakeMetadata(0xDD)) == SharedFileUpdate::Merged);
+    CHECK(index.Size() == 3);
+    CHECK(index.At(2).filePath == L"C:\\d.txt");
+    CHECK(index.At(2).contentHash == 0xDD && index.At(2).metadata);
+
+    // A share that was merged into one that is itself merged later still leads to the survivor
+    CHECK(index.Add(MakeFile(L"C:\\f.txt", 70)));
+    CHECK(index.Add(MakeFile(L"C:\\g.txt", 80)));
+    CHECK(index.Add(MakeFile(L"C:\\h.txt", 90)));
+    CHECK(index.SetContentHash(L"C:\\g.txt", 0xEE) == SharedFileUpdate::Updated);
+    CHECK(index.SetContentHash(L"C:\\h.txt", 0xEE) == SharedFileUpdate::Merged);
+    CHECK(index.SetContentHash(L"C:\\f.txt", 0xEE) == SharedFileUpdate::Merged);
+    CHECK(index.Size() == 4);
+    CHECK(index.At(3).filePath == L"C:\\f.txt");
+    auto late = MakeMetadata(0xEE);
+    CHECK(index.SetMetadata(L"C:\\H.TXT", late) == SharedFileUpdate::Updated);
+    CHECK(index.At(3).metadata == late);
+}
+
+static void TestOrder()
+{
+    SharedFileIndex index;
+
+    // Out of order, with ties kept in the order they arrived
+    CHECK(index.Add(MakeFile(L"C:\\3.txt", 300)));
+    CHECK(index.Add(MakeFile(L"C:\\1.txt", 100)));
+    CHECK(index.Add(MakeFile(L"C:\\2a.txt", 200)));
+    CHECK(index.Add(MakeFile(L"C:\\4.txt", 400)));
+    CHECK(index.Add(MakeFile(L"C:\\2b.txt", 200)));
+    const wchar_t* expected[] = { L"C:\\1.txt", L"C:\\2a.txt", L"C:\\2b.txt", L"C:\\3.txt", L"C:\\4.txt" };
+    CHECK(index.Size() == 5);
+    for (size_t i = 0; i < index.Size(); i++)
+    {
+        CHECK(index.At(i).filePath == expected[i]);
+    }
+
+    // Merging one of the ties leaves the other in place and shifts what follows
+    CHECK(index.SetContentHash(L"C:\\2a.txt", 7) == SharedFileUpdate::Updated);
+    CHECK(index.SetContentHash(L"C:\\2b.txt", 7) == SharedFileUpdate::Merged);
+    CHECK(index.Size() == 4);
+    CHECK(index.At(1).filePath == L"C:\\2a.txt");
+    CHECK(index.At(2).filePath == L"C:\\3.txt");
+}
+
+// Thousands of shares in random order, a third of them copies whose content
+// turns up later: paging through At() must show every survivor once, in order
+static void TestPaging()
+{
+    const int files = 30000;
+    const size_t pageSize = 50;
+    SharedFileIndex index;
+    std::mt19937 random(36);
+
+    std::vector<int> numbers(files);
+    for (int i = 0; i < files; i++)
+    {
+        numbers[i] = i;
+    }
+    std::shuffle(numbers.begin(), numbers.end(), random);
+    for (int number : numbers)
+    {
+        uint64_t timeShared = (uint64_t)(number / 3) * 30 + (number % 3 == 0 ? 0 : 10);
+        CHECK(index.Add(MakeFile(L"C:\\Shared\\" + std::to_wstring(number) + L".bin", timeShared)));
+    }
+    CHECK(index.Size() == (size_t)files);
+
+    // 3k+1 turns out to be a copy of 3k, shared later and at the same time as 3k+2
+    Clock::time_point start = Clock::now();
+    size_t merged = 0;
+    for (int number : numbers)
+    {
+        uint64_t hash = 1000000 + (uint64_t)(number % 3 == 1 ? number - 1 : number);
+        if (index.SetContentHash(L"c:/shared/" + std::to_wstring(number) + L".BIN", hash) == SharedFileUpdate::Merged)
+            merged++;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    CHECK(merged == (size_t)files / 3);
+    CHECK(index.Size() == (size_t)(files - files / 3));
+
+    std::vector<bool> seen(files, false);
+    bool ordered = true;
+    uint64_t previousTime = 0;
+    for (size_t page = 0; page * pageSize < index.Size(); page++)
+    {
+        for (size_t position = page * pageSize; position < std::min(index.Size(), (page + 1) * pageSize); position++)
+        {
+            const SharedFile& file = index.At(position);
+            int number = std::stoi(file.fileName);
+            CHECK(number % 3 != 1 && !seen[number]);
+            seen[number] = true;
+            if (file.timeShared < previousTime)
+                ordered = false;
+            previousTime = file.timeShared;
+        }
+    }
+    CHECK(ordered);
+    CHECK(std::count(seen.begin(), seen.end(), true) == files - files / 3);
+    printf("%d shares, %zu late merges: %.0f content hashes/s\n", files, merged, files / seconds);
+}
+
+int main()
+{
+    TestPaths();
+    TestContent();
+    TestOrder();
+    TestPaging();
+    return TestExitCode("SharedFileIndexTest");
+}
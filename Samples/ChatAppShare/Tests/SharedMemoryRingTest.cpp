@@ -0,0 +1,357 @@
+// SharedMemoryRingTest.cpp : SharedMemoryRing on its shm_open backend, with
+// producers in forked processes as ShareApp would be: records wrapping around
+// the end of the ring, a full ring, ordering with several producers, Wait and
+// Wake, and who may create a ring under a name already in use.
+
+#include "../SampleChatAppWithShare/SharedMemoryRing.h"
+#include "TestCheck.h"
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <sched.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static std::string RingName(const char* test)
+{
+    return "SharedMemoryRingTest." + std::to_string(getpid()) + "." + test;
+}
+
+static int ElapsedMs(Clock::time_point since)
+{
+    return (int)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - since).count();
+}
+
+// Runs body in a child process, which exits with its result without running
+// destructors or flushing what it inherited
+template <typename Body>
+static pid_t Fork(Body body)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+        _exit(body());
+    return pid;
+}
+
+static int Join(pid_t pid)
+{
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+        return -1;
+    return WEXITSTATUS(status);
+}
+
+// Records are filled with a pattern derived from their number, so a record
+// overwritten or read from the wrong place shows up
+static std::vector<uint8_t> Record(uint32_t number, size_t length)
+{
+    std::vector<uint8_t> bytes(length);
+    for (size_t i = 0; i < length; i++)
+    {
+        bytes[i] = (uint8_t)(number * 31 + i);
+    }
+    return bytes;
+}
+
+static bool PopRecord(SharedMemoryRing& ring, std::vector<uint8_t>& bytes)
+{
+    return ring.TryPop([&](const uint8_t* data, size_t length) {
+        bytes.assign(data, data + length);
+    });
+}
+
+static void TestCreateAndOpen()
+{
+    std::string name = RingName("open");
+    SharedMemoryRing producer;
+    CHECK(!producer.Open(name));
+
+    SharedMemoryRing consumer;
+    CHECK(consumer.Create(name, 1000));
+    CHECK(consumer.MaxRecordSize() == 4096 / 2 - 8);     // rounded up to the minimum capacity
+    CHECK(producer.Open(name));
+    CHECK(producer.MaxRecordSize() == consumer.MaxRecordSize());
+
+    // Too long for the ring, or nothing at all
+    std::vector<uint8_t> tooLong(consumer.MaxRecordSize() + 1);
+    CHECK(!producer.TryPush(tooLong.data(), tooLong.size()));
+    CHECK(producer.TryPush(nullptr, 0));
+    std::vector<uint8_t> bytes(1);
+    CHECK(PopRecord(consumer, bytes) && bytes.empty());
+    CHECK(!PopRecord(consumer, bytes));
+
+    // The name stays taken while its consumer is alive, in this process or another
+    SharedMemoryRing second;
+    CHECK(!second.Create(name, 4096));
+    pid_t child = Fork([&]() {
+        SharedMemoryRing other;
+        return other.Create(name, 4096) ? 1 : 0;
+    });
+    CHECK(Join(child) == 0);
+
+    // Producers still reach the first consumer
+    uint32_t value = 42;
+    CHECK(producer.TryPush(&value, sizeof(value)));
+    CHECK(PopRecord(consumer, bytes) && bytes.size() == sizeof(value));
+
+    // Closing gives the name up
+    consumer.Close();
+    producer.Close();
+    CHECK(!producer.Open(name));
+    CHECK(second.Create(name, 4096));
+    second.Close();
+
+    // A consumer that dies without closing leaves its segment behind; the next
+    // consumer replaces it rather than failing for good
+    child = Fork([&]() {
+        SharedMemoryRing crashed;
+        if (!crashed.Create(name, 4096))
+            return 1;
+        _exit(0);   // without Close
+    });
+    CHECK(Join(child) == 0);
+    CHECK(producer.Open(name));
+    CHECK(consumer.Create(name, 4096));
+    producer.Close();
+    consumer.Close();
+}
+
+// Records of awkward sizes go round the ring many times, so each position at
+// the end of it is hit and padding records are skipped
+static void TestWrapAround()
+{
+    std::string name = RingName("wrap");
+    SharedMemoryRing consumer;
+    SharedMemoryRing producer;
+    CHECK(consumer.Create(name, 4096));
+    CHECK(producer.Open(name));
+
+    const size_t lengths[] = { 1, 7, 8, 9, 100, 333, 1000, 2040 };
+    uint32_t pushed = 0;
+    uint32_t popped = 0;
+    for (int round = 0; round < 5000; round++)
+    {
+        size_t length = lengths[round % 8];
+        std::vector<uint8_t> record = Record(pushed, length);
+        if (producer.TryPush(record.data(), record.size()))
+            pushed++;
+
+        // Drain every third round, so the ring is often nearly full when it wraps
+        if (round % 3 == 2 || pushed - popped > 3)
+        {
+            std::vector<uint8_t> bytes;
+            while (PopRecord(consumer, bytes))
+            {
+                CHECK(bytes == Record(popped, bytes.size()));
+                popped++;
+            }
+        }
+    }
+
+    std::vector<uint8_t> bytes;
+    while (PopRecord(consumer, bytes))
+    {
+        CHECK(bytes == Record(popped, bytes.size()));
+        popped++;
+    }
+    CHECK(pushed == popped);
+    CHECK(pushed > 4000);
+}
+
+static void TestFull()
+{
+    std::string name = RingName("full");
+    SharedMemoryRing consumer;
+    SharedMemoryRing producer;
+    CHECK(consumer.Create(name, 4096));
+    CHECK(producer.Open(name));
+
+    // 56 bytes of payload make 64-byte records, and 64 of them fill 4 KB exactly
+    std::vector<uint8_t> record(56, 0xAB);
+    int count = 0;
+    while (producer.TryPush(record.data(), record.size()))
+    {
+        count++;
+    }
+    CHECK(count == 64);
+
+    // Nothing fits, not even an empty record, until the consumer frees space
+    CHECK(!producer.TryPush(nullptr, 0));
+    std::vector<uint8_t> bytes;
+    CHECK(PopRecord(consumer, bytes) && bytes == record);
+    CHECK(producer.TryPush(record.data(), record.size()));
+    CHECK(!producer.TryPush(record.data(), record.size()));
+
+    while (PopRecord(consumer, bytes))
+    {
+        count--;
+    }
+    CHECK(count == 0);
+    CHECK(producer.TryPush(record.data(), record.size()));
+}
+
+// Producer processes push numbered records as fast as the ring takes them,
+// while the consumer sleeps in Wait whenever it runs dry. Each producer's
+// records must arrive complete and in the order it pushed them.
+static void TestProducers()
+{
+    const int producers = 4;
+    const uint32_t records = 50000;
+    std::string name = RingName("producers");
+    SharedMemoryRing consumer;
+    CHECK(consumer.Create(name, 16384));
+
+    struct Message
+    {
+        uint32_t producer;
+        uint32_t sequence;
+        uint8_t padding[24];    // uneven sizes, so records wrap at different offsets
+    };
+
+    std::vector<pid_t> children;
+    for (int p = 0; p < producers; p++)
+    {
+        children.push_back(Fork([&, p]() {
+            SharedMemoryRing ring;
+            if (!ring.Open(name))
+                return 1;
+            for (uint32_t sequence = 0; sequence < records; sequence++)
+            {
+                Message message = {};
+                message.producer = (uint32_t)p;
+                message.sequence = sequence;
+                memset(message.padding, (int)(sequence & 0xFF), sizeof(message.padding));
+                size_t length = offsetof(Message, padding) + sequence % (sizeof(message.padding) + 1);
+                while (!ring.TryPush(&message, length))
+                {
+                    sched_yield();
+                }
+            }
+            return 0;
+        }));
+    }
+
+    std::vector<uint32_t> next(producers, 0);
+    uint32_t received = 0;
+    bool intact = true;
+    Clock::time_point start = Clock::now();
+    while (received < producers * records && ElapsedMs(start) < 60000)
+    {
+        bool any = false;
+        while (consumer.TryPop([&](const uint8_t* data, size_t length) {
+            Message message = {};
+            memcpy(&message, data, length < sizeof(message) ? length : sizeof(message));
+            if (message.producer >= (uint32_t)producers || message.sequence != next[message.producer] ||
+                length != offsetof(Message, padding) + message.sequence % (sizeof(message.padding) + 1))
+            {
+                intact = false;
+                return;
+            }
+            for (size_t i = 0; i + offsetof(Message, padding) < length; i++)
+            {
+                if (message.padding[i] != (uint8_t)(message.sequence & 0xFF))
+                    intact = false;
+            }
+            next[message.producer]++;
+        }))
+        {
+            received++;
+            any = true;
+        }
+        if (!any)
+            consumer.Wait(100);
+    }
+    double seconds = ElapsedMs(start) / 1000.0;
+
+    for (pid_t child : children)
+    {
+        CHECK(Join(child) == 0);
+    }
+    CHECK(intact);
+    CHECK(received == producers * records);
+    for (int p = 0; p < producers; p++)
+    {
+        CHECK(next[p] == records);
+    }
+    printf("%d producer processes, %u records: %.0f records/s\n", producers, received,
+        seconds > 0 ? received / seconds : 0.0);
+}
+
+static void TestWaitAndWake()
+{
+    std::string name = RingName("wait");
+    SharedMemoryRing consumer;
+    SharedMemoryRing producer;
+    CHECK(consumer.Create(name, 4096));
+    CHECK(producer.Open(name));
+
+    // Nothing to wait for: the timeout ends it
+    Clock::time_point start = Clock::now();
+    consumer.Wait(50);
+    int waited = ElapsedMs(start);
+    CHECK(waited >= 40 && waited < 2000);
+
+    // A record already there, or a Wake that came first, ends it at once
+    uint32_t value = 1;
+    CHECK(producer.TryPush(&value, sizeof(value)));
+    start = Clock::now();
+    consumer.Wait(-1);
+    CHECK(ElapsedMs(start) < 1000);
+    std::vector<uint8_t> bytes;
+    CHECK(PopRecord(consumer, bytes));
+
+    producer.Wake();
+    start = Clock::now();
+    consumer.Wait(-1);
+    CHECK(ElapsedMs(start) < 1000);
+
+    // The latch is used up: the next Wait sleeps again
+    start = Clock::now();
+    consumer.Wait(50);
+    CHECK(ElapsedMs(start) >= 40);
+
+    // Woken from another thread while asleep
+    std::thread waker([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        consumer.Wake();
+    });
+    start = Clock::now();
+    consumer.Wait(-1);
+    waited = ElapsedMs(start);
+    waker.join();
+    CHECK(waited >= 20 && waited < 5000);
+
+    // Woken by a push from another process while asleep
+    pid_t child = Fork([&]() {
+        SharedMemoryRing ring;
+        if (!ring.Open(name))
+            return 1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint32_t pushed = 2;
+        return ring.TryPush(&pushed, sizeof(pushed)) ? 0 : 1;
+    });
+    start = Clock::now();
+    while (!PopRecord(consumer, bytes) && ElapsedMs(start) < 5000)
+    {
+        consumer.Wait(-1);
+    }
+    CHECK(Join(child) == 0);
+    CHECK(bytes.size() == sizeof(uint32_t) && bytes[0] == 2);
+    CHECK(ElapsedMs(start) < 5000);
+}
+
+int main()
+{
+    TestCreateAndOpen();
+    TestWrapAround();
+    TestFull();
+    TestProducers();
+    TestWaitAndWake();
+    return TestExitCode("SharedMemoryRingTest");
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// Checks for the standalone test drivers in this folder. Each driver is its own
+// program: CHECK reports a failure and carries on, and main returns
+// TestExitCode() so a run with any failure exits non-zero.
+
+#include <cstdio>
+
+static int s_testFailures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            s_testFailures++; \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+static int TestExitCode(const char* name)
+{
+    if (s_testFailures != 0)
+    {
+        printf("%s: %d check(s) failed\n", name, s_testFailures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
@@ -0,0 +1,264 @@
+// TextLayoutTest.cpp : TextLayout and its caches against a fixed-width metric,
+// so every expected width can be worked out by hand: truncation with an
+// ellipsis, word wrap, surrogate pairs and widths too narrow for anything.
+
+#include "../SampleChatAppWithShare/TextLayout.h"
+#include "TestCheck.h"
+#include <random>
+
+static const int ADVANCE = 8;
+
+// Every code unit is ADVANCE pixels wide, as a monospaced font would have it.
+// 'pages' counts how often a 256-unit page had to be measured.
+static GlyphAdvanceCache::MeasureFunction FixedMetric(int* pages = nullptr)
+{
+    return [pages](wchar_t first, wchar_t last, int* advances) {
+        if (pages)
+            (*pages)++;
+        for (int i = 0; i <= (int)(last - first); i++)
+        {
+            advances[i] = ADVANCE;
+        }
+    };
+}
+
+static bool IsHighSurrogate(wchar_t ch)
+{
+    return ch >= 0xD800 && ch <= 0xDBFF;
+}
+
+static bool IsLowSurrogate(wchar_t ch)
+{
+    return ch >= 0xDC00 && ch <= 0xDFFF;
+}
+
+static std::wstring LineText(const TextLayout& layout, const TextLayout::Line& line)
+{
+    return layout.Text().substr(line.begin, line.length);
+}
+
+static void TestAdvanceCache()
+{
+    int pages = 0;
+    GlyphAdvanceCache advances(FixedMetric(&pages));
+
+    CHECK(advances.Measure(L"hello") == 5 * ADVANCE);
+    CHECK(advances.Measure(L"world") == 5 * ADVANCE);
+    CHECK(pages == 1);
+
+    CHECK(advances.Advance((wchar_t)0x4E2D) == ADVANCE);
+    CHECK(advances.Advance((wchar_t)0x4E2E) == ADVANCE);
+    CHECK(pages == 2);
+
+    advances.Clear();
+    CHECK(advances.Measure(L"a") == ADVANCE);
+    CHECK(pages == 3);
+}
+
+static void TestEllipsize()
+{
+    GlyphAdvanceCache advances(FixedMetric());
+    const std::wstring ellipsis = L"...";
+    const int ellipsisWidth = 3 * ADVANCE;
+
+    TextLayout hello(advances, L"Hello world");
+    CHECK(hello.Width() == 11 * ADVANCE);
+    CHECK(hello.FitCount(11 * ADVANCE) == 11);
+    CHECK(hello.FitCount(4 * ADVANCE + ADVANCE - 1) == 4);
+    CHECK(hello.FitCount(0) == 0);
+    CHECK(hello.FitCount(-5) == 0);
+
+    // Fits exactly, so nothing is cut
+    CHECK(hello.Ellipsize(11 * ADVANCE, ellipsis, ellipsisWidth) == L"Hello world");
+
+    // Room for four characters and the ellipsis
+    CHECK(hello.Ellipsize(7 * ADVANCE, ellipsis, ellipsisWidth) == L"Hell...");
+
+    // A cut right after a space does not leave it before the ellipsis
+    CHECK(hello.Ellipsize(9 * ADVANCE, ellipsis, ellipsisWidth) == L"Hello...");
+
+    // The same width again is answered from the remembered result
+    const std::wstring& first = hello.Ellipsize(9 * ADVANCE, ellipsis, ellipsisWidth);
+    const std::wstring& second = hello.Ellipsize(9 * ADVANCE, ellipsis, ellipsisWidth);
+    CHECK(&first == &second);
+
+    // Narrower than the ellipsis itself: the ellipsis alone
+    CHECK(hello.Ellipsize(ellipsisWidth, ellipsis, ellipsisWidth) == L"...");
+    CHECK(hello.Ellipsize(1, ellipsis, ellipsisWidth) == L"...");
+    CHECK(hello.Ellipsize(0, ellipsis, ellipsisWidth) == L"...");
+
+    // A surrogate pair is kept whole or dropped whole
+    TextLayout emoji(advances, L"\xD83D\xDE00\xD83D\xDE01xyz");
+    CHECK(emoji.FitCount(ADVANCE) == 0);
+    CHECK(emoji.FitCount(3 * ADVANCE) == 2);
+    CHECK(emoji.Ellipsize(ellipsisWidth + ADVANCE, ellipsis, ellipsisWidth) == L"...");
+    CHECK(emoji.Ellipsize(ellipsisWidth + 3 * ADVANCE, ellipsis, ellipsisWidth) == L"\xD83D\xDE00...");
+
+    TextLayout empty(advances, L"");
+    CHECK(empty.Width() == 0);
+    CHECK(empty.Ellipsize(0, ellipsis, ellipsisWidth) == L"");
+}
+
+static void TestWrap()
+{
+    GlyphAdvanceCache advances(FixedMetric());
+    std::vector<TextLayout::Line> lines;
+
+    // Breaks at spaces, which belong to neither line
+    TextLayout words(advances, L"hello world foo");
+    words.Wrap(6 * ADVANCE, lines);
+    CHECK(lines.size() == 3);
+    if (lines.size() == 3)
+    {
+        CHECK(LineText(words, lines[0]) == L"hello");
+        CHECK(LineText(words, lines[1]) == L"world");
+        CHECK(LineText(words, lines[2]) == L"foo");
+        CHECK(lines[0].width == 5 * ADVANCE);
+        CHECK(lines[2].begin == 12);
+    }
+
+    // Wide enough for everything: one line
+    lines.clear();
+    words.Wrap(words.Width(), lines);
+    CHECK(lines.size() == 1 && lines[0].length == 15);
+
+    // A word wider than the line is split
+    lines.clear();
+    TextLayout longWord(advances, L"abcdefghij");
+    longWord.Wrap(3 * ADVANCE, lines);
+    CHECK(lines.size() == 4);
+    if (lines.size() == 4)
+    {
+        CHECK(LineText(longWord, lines[0]) == L"abc");
+        CHECK(LineText(longWord, lines[3]) == L"j");
+    }
+
+    // '\n' always breaks, and an empty paragraph is an empty line
+    lines.clear();
+    TextLayout paragraphs(advances, L"ab\n\ncd");
+    paragraphs.Wrap(100 * ADVANCE, lines);
+    CHECK(lines.size() == 3);
+    if (lines.size() == 3)
+    {
+        CHECK(LineText(paragraphs, lines[0]) == L"ab");
+        CHECK(lines[1].length == 0 && lines[1].width == 0);
+        CHECK(LineText(paragraphs, lines[2]) == L"cd");
+    }
+
+    // Narrower than one character: one code point per line
+    lines.clear();
+    TextLayout narrow(advances, L"abc");
+    narrow.Wrap(0, lines);
+    CHECK(lines.size() == 3);
+}
+
+static void TestWrapSurrogates()
+{
+    GlyphAdvanceCache advances(FixedMetric());
+    std::vector<TextLayout::Line> lines;
+
+    // Only the high surrogate fits: the whole pair goes on the line anyway
+    TextLayout emoji(advances, L"\xD83D\xDE00 hello world");
+    emoji.Wrap(10, lines);
+    CHECK(lines.size() == 11);
+    if (!lines.empty())
+    {
+        CHECK(lines[0].begin == 0 && lines[0].length == 2);
+        CHECK(lines[0].width == 2 * ADVANCE);
+    }
+
+    // Too narrow for even one code unit
+    lines.clear();
+    emoji.Wrap(0, lines);
+    CHECK(lines.size() == 11);
+
+    // The pair would be split at the end of a fitting run: it moves to the next line
+    lines.clear();
+    TextLayout split(advances, L"ab\xD83D\xDE00");
+    split.Wrap(3 * ADVANCE, lines);
+    CHECK(lines.size() == 2);
+    if (lines.size() == 2)
+    {
+        CHECK(LineText(split, lines[0]) == L"ab");
+        CHECK(LineText(split, lines[1]) == L"\xD83D\xDE00");
+    }
+}
+
+// Random text, every width: each line makes progress, fits unless it holds a
+// single code point, and never starts or ends inside a surrogate pair
+static void TestWrapRandom()
+{
+    GlyphAdvanceCache advances(FixedMetric());
+    std::mt19937 random(34);
+    const wchar_t pieces[][3] = { L"a", L"b", L" ", L"\n", L"\xD83D\xDE00" };
+
+    for (int round = 0; round < 2000; round++)
+    {
+        std::wstring text;
+        int count = (int)(random() % 40);
+        for (int i = 0; i < count; i++)
+        {
+            text += pieces[random() % 5];
+        }
+
+        TextLayout layout(advances, text);
+        int maxWidth = (int)(random() % (12 * ADVANCE)) - ADVANCE;
+        std::vector<TextLayout::Line> lines;
+        layout.Wrap(maxWidth, lines);
+
+        CHECK(lines.size() <= text.size());
+        size_t previous = 0;
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            const TextLayout::Line& line = lines[i];
+            CHECK(i == 0 || line.begin > previous);
+            CHECK(line.begin + line.length <= text.size());
+            CHECK(line.width == (int)line.length * ADVANCE);
+            CHECK(line.begin >= text.size() || !IsLowSurrogate(text[line.begin]));
+            CHECK(line.length == 0 || !IsHighSurrogate(text[line.begin + line.length - 1]));
+
+            bool single = line.length <= 1 || (line.length == 2 && IsHighSurrogate(text[line.begin]));
+            CHECK(line.width <= maxWidth || single);
+            previous = line.begin;
+        }
+    }
+}
+
+static void TestLayoutCache()
+{
+    int pages = 0;
+    TextLayoutCache cache(FixedMetric(&pages), 4);
+
+    const TextLayout& layout = cache.Layout(L"See you tomorrow!");
+    CHECK(&cache.Layout(L"See you tomorrow!") == &layout);
+    CHECK(cache.Count() == 1);
+
+    CHECK(cache.Ellipsize(L"See you tomorrow!", 10 * ADVANCE) == L"See you...");
+    CHECK(cache.Ellipsize(L"Hi", 10 * ADVANCE) == L"Hi");
+    CHECK(cache.Count() == 2);
+    CHECK(pages == 1);
+
+    // Full: dropped wholesale before the next new layout
+    cache.Layout(L"three");
+    cache.Layout(L"four");
+    CHECK(cache.Count() == 4);
+    cache.Layout(L"five");
+    CHECK(cache.Count() == 1);
+
+    // A font change forgets the widths too
+    cache.Clear();
+    CHECK(cache.Count() == 0);
+    CHECK(cache.Ellipsize(L"Hello world", 7 * ADVANCE) == L"Hell...");
+    CHECK(pages == 2);
+}
+
+int main()
+{
+    TestAdvanceCache();
+    TestEllipsize();
+    TestWrap();
+    TestWrapSurrogates();
+    TestWrapRandom();
+    TestLayoutCache();
+    return TestExitCode("TextLayoutTest");
+}
@@ -0,0 +1,315 @@
+// TimerWheelTest.cpp : TimerWheel on a virtual clock: timers firing on the
+// exact tick across every level boundary and past the wheel's span, zero
+// delays, cancellation, large jumps of the clock, a random schedule against a
+// plain ordered model, and the time a million timers take to insert and fire.
+
+#include "../SampleChatAppWithShare/TimerWheel.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+
+typedef std::chrono::steady_clock Clock;
+
+// Root level 256 ticks, three outer levels of 64 slots each
+static const uint64_t LEVEL1_TICKS = 256;
+static const uint64_t LEVEL2_TICKS = 256 * 64;
+static const uint64_t LEVEL3_TICKS = 256 * 64 * 64;
+static const uint64_t SPAN_TICKS = 256ull * 64 * 64 * 64;
+
+struct Fired
+{
+    uint64_t key;
+    uint32_t payload;
+};
+
+static TimerWheel::ExpiredCallback Collect(std::vector<Fired>& fired)
+{
+    return [&fired](uint64_t key, uint32_t payload) { fired.push_back(Fired{ key, payload }); };
+}
+
+// One timer on a one-millisecond tick must fire on the tick it is due and not
+// the one before
+static bool FiresExactly(uint64_t delayTicks)
+{
+    TimerWheel wheel(0, 1);
+    std::vector<Fired> fired;
+
+    // Start somewhere other than zero, so the timer does not sit on a slot boundary
+    wheel.Advance(1000, nullptr);
+    wheel.Schedule(1, (uint32_t)delayTicks, 7);
+
+    wheel.Advance(1000 + delayTicks - 1, Collect(fired));
+    if (!fired.empty())
+        return false;
+    wheel.Advance(1000 + delayTicks, Collect(fired));
+    return fired.size() == 1 && fired[0].payload == 7 && wheel.PendingCount() == 0;
+}
+
+static void TestCascades()
+{
+    const uint64_t boundaries[] = { LEVEL1_TICKS, LEVEL2_TICKS, LEVEL3_TICKS, SPAN_TICKS };
+    for (uint64_t boundary : boundaries)
+    {
+        CHECK(FiresExactly(boundary - 1));
+        CHECK(FiresExactly(boundary));
+        CHECK(FiresExactly(boundary + 1));
+    }
+    CHECK(FiresExactly(1));
+    CHECK(FiresExactly(3 * LEVEL2_TICKS + 17));
+
+    // Beyond the span the timer is parked and re-filed until it is in range
+    CHECK(FiresExactly(2 * SPAN_TICKS + 5));
+
+    // Timers due on the same tick from different levels all fire on it
+    TimerWheel wheel(0, 1);
+    std::vector<Fired> fired;
+    wheel.Advance(LEVEL2_TICKS - 10, nullptr);
+    wheel.Schedule(1, (uint32_t)(LEVEL2_TICKS + 10), 1);
+    wheel.Advance(LEVEL2_TICKS + 5, nullptr);
+    wheel.Schedule(2, (uint32_t)(LEVEL2_TICKS - 5), 2);
+    wheel.Advance(2 * LEVEL2_TICKS - 1, Collect(fired));
+    CHECK(fired.empty());
+    wheel.Advance(2 * LEVEL2_TICKS, Collect(fired));
+    CHECK(fired.size() == 2);
+}
+
+static void TestZeroDelay()
+{
+    TimerWheel wheel(500, 10);
+    std::vector<Fired> fired;
+
+    // Before the wheel's start nothing moves
+    CHECK(wheel.Advance(100, Collect(fired)) == 0);
+    CHECK(wheel.CurrentTimeMs() == 500);
+
+    // Zero lands on the next tick, never on the current one
+    wheel.Schedule(1, 0, 0);
+    CHECK(wheel.Advance(500, Collect(fired)) == 0);
+    CHECK(wheel.Advance(509, Collect(fired)) == 0);
+    CHECK(wheel.Advance(510, Collect(fired)) == 1);
+
+    // Delays round up to whole ticks
+    wheel.Schedule(2, 1, 0);
+    wheel.Schedule(3, 10, 0);
+    wheel.Schedule(4, 11, 0);
+    CHECK(wheel.Advance(519, Collect(fired)) == 0);
+    CHECK(wheel.Advance(520, Collect(fired)) == 2);
+    CHECK(wheel.Advance(529, Collect(fired)) == 0);
+    CHECK(wheel.Advance(530, Collect(fired)) == 1);
+
+    // A callback that reschedules itself with no delay runs once per tick
+    int runs = 0;
+    TimerWheel::ExpiredCallback again = [&](uint64_t key, uint32_t) {
+        runs++;
+        wheel.Schedule(key, 0, 0);
+    };
+    wheel.Schedule(5, 0, 0);
+    CHECK(wheel.Advance(580, again) == 5);
+    CHECK(runs == 5);
+    CHECK(wheel.PendingCount() == 1);
+}
+
+static void TestCancel()
+{
+    TimerWheel wheel(0, 10);
+    std::vector<Fired> fired;
+
+    TimerWheel::TimerId first = wheel.Schedule(1, 100, 1);
+    TimerWheel::TimerId second = wheel.Schedule(1, 5000, 2);
+    TimerWheel::TimerId third = wheel.Schedule(2, 100, 3);
+    CHECK(first != 0 && second != 0 && third != 0);
+    CHECK(wheel.PendingCount() == 3);
+    CHECK(wheel.PendingCountForKey(1) == 2);
+
+    CHECK(wheel.Cancel(first));
+    CHECK(!wheel.Cancel(first));
+    CHECK(!wheel.Cancel(0));
+    CHECK(!wheel.Cancel(12345678));
+    CHECK(wheel.PendingCountForKey(1) == 1);
+
+    // The freed node is reused; the old id must not reach the new timer
+    TimerWheel::TimerId reused = wheel.Schedule(3, 100, 4);
+    CHECK(!wheel.Cancel(first));
+    CHECK(wheel.PendingCount() == 3);
+
+    wheel.Advance(100, Collect(fired));
+    CHECK(fired.size() == 2);
+    CHECK(!wheel.Cancel(third));
+    CHECK(!wheel.Cancel(reused));
+
+    // By key, including timers in an outer level
+    wheel.Schedule(1, 10, 5);
+    wheel.Schedule(1, 100000, 6);
+    CHECK(wheel.CancelKey(1) == 3);
+    CHECK(wheel.CancelKey(1) == 0);
+    CHECK(!wheel.Cancel(second));
+    CHECK(wheel.PendingCount() == 0);
+    fired.clear();
+    wheel.Advance(10000000, Collect(fired));
+    CHECK(fired.empty());
+
+    // A callback cancelling a timer due on the same tick
+    TimerWheel::TimerId victim = 0;
+    int runs = 0;
+    wheel.Schedule(7, 10, 0);
+    victim = wheel.Schedule(8, 10, 0);
+    TimerWheel::ExpiredCallback cancelOther = [&](uint64_t key, uint32_t) {
+        runs++;
+        if (key == 7)
+            wheel.Cancel(victim);
+        else
+            wheel.CancelKey(7);
+    };
+    CHECK(wheel.Advance(wheel.CurrentTimeMs() + 10, cancelOther) == 1);
+    CHECK(runs == 1);
+    CHECK(wheel.PendingCount() == 0);
+}
+
+static void TestLargeJumps()
+{
+    // An empty wheel jumps without walking the ticks
+    TimerWheel wheel(0, 10);
+    Clock::time_point start = Clock::now();
+    CHECK(wheel.Advance(1000000000000ull, nullptr) == 0);
+    CHECK(wheel.CurrentTimeMs() == 1000000000000ull);
+    CHECK(Clock::now() - start < std::chrono::seconds(1));
+
+    // One jump fires everything that came due, in order of due time
+    std::mt19937 random(26);
+    std::vector<uint32_t> delays;
+    for (int i = 0; i < 20000; i++)
+    {
+        uint32_t delay = random() % 4 == 0 ? (uint32_t)(random() % 800000000) : (uint32_t)(random() % 100000);
+        delays.push_back(delay);
+        wheel.Schedule(i, delay, delay);
+    }
+
+    uint64_t from = wheel.CurrentTimeMs();
+    std::vector<Fired> fired;
+    wheel.Advance(from + 400000000, Collect(fired));
+    size_t due = (size_t)std::count_if(delays.begin(), delays.end(), [](uint32_t delay) { return delay <= 400000000; });
+    CHECK(fired.size() == due);
+    CHECK(wheel.PendingCount() == delays.size() - due);
+
+    bool ordered = true;
+    for (size_t i = 1; i < fired.size(); i++)
+    {
+        // Same tick in any order, otherwise earlier first
+        if ((fired[i].payload + 9) / 10 < (fired[i - 1].payload + 9) / 10)
+            ordered = false;
+    }
+    CHECK(ordered);
+
+    wheel.Advance(from + 800000000, Collect(fired));
+    CHECK(fired.size() == delays.size());
+    CHECK(wheel.PendingCount() == 0);
+}
+
+// Random schedules, cancels and clock steps against a map from due time to
+// timer: every Advance must fire exactly the timers the model has due by then
+static void TestAgainstModel()
+{
+    const uint32_t tickMs = 10;
+    TimerWheel wheel(0, tickMs);
+    std::multimap<uint64_t, uint64_t> model;                      // due time -> key
+    std::map<uint64_t, TimerWheel::TimerId> ids;                  // key -> id
+    std::map<uint64_t, std::multimap<uint64_t, uint64_t>::iterator> entries;
+    std::mt19937 random(126);
+    uint64_t nextKey = 1;
+    bool consistent = true;
+
+    for (int round = 0; round < 200000 && consistent; round++)
+    {
+        uint32_t action = random() % 10;
+        if (action < 6)
+        {
+            uint32_t delay = random() % 3 == 0 ? (uint32_t)(random() % 50000000) : (uint32_t)(random() % 5000);
+            uint64_t ticks = std::max<uint64_t>(1, (delay + tickMs - 1) / tickMs);
+            uint64_t key = nextKey++;
+            ids[key] = wheel.Schedule(key, delay, 0);
+            entries[key] = model.emplace(wheel.CurrentTimeMs() + ticks * tickMs, key);
+        }
+        else if (action < 8 && !ids.empty())
+        {
+            auto it = ids.lower_bound(random() % nextKey);
+            if (it == ids.end())
+                it = ids.begin();
+            if (!wheel.Cancel(it->second))
+                consistent = false;
+            model.erase(entries[it->first]);
+            entries.erase(it->first);
+            ids.erase(it);
+        }
+        else
+        {
+            uint64_t step = random() % 16 == 0 ? random() % 2000000 : random() % 2000;
+            uint64_t now = wheel.CurrentTimeMs() + step;
+            std::vector<uint64_t> expected;
+            while (!model.empty() && model.begin()->first <= now)
+            {
+                expected.push_back(model.begin()->second);
+                entries.erase(model.begin()->second);
+                ids.erase(model.begin()->second);
+                model.erase(model.begin());
+            }
+
+            std::vector<uint64_t> actual;
+            wheel.Advance(now, [&](uint64_t key, uint32_t) { actual.push_back(key); });
+            std::sort(expected.begin(), expected.end());
+            std::sort(actual.begin(), actual.end());
+            if (actual != expected)
+                consistent = false;
+        }
+
+        if (wheel.PendingCount() != model.size())
+            consistent = false;
+    }
+    CHECK(consistent);
+}
+
+// A million timers spread over a minute, as a burst of auto-replies would be
+static void TestMillionTimers()
+{
+    const int count = 1000000;
+    TimerWheel wheel(0, 10);
+    std::mt19937 random(1);
+    std::vector<uint32_t> delays(count);
+    for (auto& delay : delays)
+    {
+        delay = random() % 60000;
+    }
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        wheel.Schedule((uint64_t)i, delays[i], 0);
+    }
+    Clock::time_point scheduled = Clock::now();
+
+    size_t fired = 0;
+    for (uint64_t now = 0; now <= 60000; now += 16)
+    {
+        fired += wheel.Advance(now, [](uint64_t, uint32_t) {});
+    }
+    Clock::time_point done = Clock::now();
+
+    CHECK(fired == (size_t)count);
+    CHECK(wheel.PendingCount() == 0);
+
+    double scheduleNs = std::chrono::duration<double, std::nano>(scheduled - start).count() / count;
+    double fireNs = std::chrono::duration<double, std::nano>(done - scheduled).count() / count;
+    printf("1M timers: %.0f ns per schedule, %.0f ns per fire\n", scheduleNs, fireNs);
+}
+
+int main()
+{
+    TestCascades();
+    TestZeroDelay();
+    TestCancel();
+    TestLargeJumps();
+    TestAgainstModel();
+    TestMillionTimers();
+    return TestExitCode("TimerWheelTest");
+}
@@ -0,0 +1,168 @@
+// WorkerPoolTest.cpp : WorkerPool's bounded queue: TrySubmit refusing when
+// full, Submit blocking until there is room, CancelPending dropping what has
+// not started, and Shutdown finishing what was accepted.
+
+#include "../SampleChatAppWithShare/WorkerPool.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <chrono>
+
+using std::chrono::milliseconds;
+
+// Polls until condition holds or a few seconds pass, so a broken pool fails
+// the check instead of hanging the test
+template <typename Condition>
+static bool WaitFor(Condition condition)
+{
+    for (int i = 0; i < 5000; i++)
+    {
+        if (condition())
+            return true;
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    return condition();
+}
+
+// A job that holds its worker until opened
+class Gate
+{
+public:
+    WorkerPool::Job Job()
+    {
+        return [this]() {
+            m_entered = true;
+            WaitFor([this]() { return m_open.load(); });
+        };
+    }
+
+    bool WaitEntered() { return WaitFor([this]() { return m_entered.load(); }); }
+    void Open() { m_open = true; }
+
+private:
+    std::atomic<bool> m_entered{ false };
+    std::atomic<bool> m_open{ false };
+};
+
+static void TestRunsEverything()
+{
+    std::atomic<int> done{ 0 };
+    {
+        WorkerPool pool(4, 16);
+        CHECK(pool.ThreadCount() == 4);
+
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 8; p++)
+        {
+            producers.emplace_back([&]() {
+                for (int i = 0; i < 10000; i++)
+                {
+                    pool.Submit([&]() { done++; });
+                }
+            });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+    }
+    CHECK(done == 80000);
+
+    // Nothing is clamped to one thread and one queued job
+    WorkerPool tiny(0, 0);
+    CHECK(tiny.ThreadCount() == 1);
+    Gate gate;
+    CHECK(tiny.TrySubmit(gate.Job()));
+    CHECK(gate.WaitEntered());
+    CHECK(tiny.TrySubmit([]() {}));
+    CHECK(!tiny.TrySubmit([]() {}));
+    gate.Open();
+}
+
+static void TestBoundedQueue()
+{
+    WorkerPool pool(1, 2);
+    Gate gate;
+    std::atomic<int> ran{ 0 };
+
+    CHECK(pool.Submit(gate.Job()));
+    CHECK(gate.WaitEntered());
+
+    // The worker is busy: two fit in the queue, the third is refused
+    CHECK(pool.TrySubmit([&]() { ran++; }));
+    CHECK(pool.TrySubmit([&]() { ran++; }));
+    CHECK(!pool.TrySubmit([&]() { ran++; }));
+    CHECK(pool.Pending() == 2);
+
+    // Submit waits for room instead
+    std::atomic<bool> submitted{ false };
+    std::thread blocked([&]() {
+        submitted = pool.Submit([&]() { ran += 10; });
+    });
+    std::this_thread::sleep_for(milliseconds(50));
+    CHECK(!submitted);
+
+    // Dropping what has not started makes room, and the blocked Submit gets in
+    CHECK(pool.CancelPending() == 2);
+    blocked.join();
+    CHECK(submitted);
+    CHECK(pool.Pending() == 1);
+
+    gate.Open();
+    CHECK(WaitFor([&]() { return pool.Pending() == 0 && ran == 10; }));
+    CHECK(pool.CancelPending() == 0);
+    CHECK(ran == 10);
+}
+
+static void TestShutdown()
+{
+    // Jobs accepted before Shutdown all run
+    std::atomic<int> ran{ 0 };
+    WorkerPool pool(2, 100);
+    Gate gate;
+    CHECK(pool.Submit(gate.Job()));
+    for (int i = 0; i < 50; i++)
+    {
+        CHECK(pool.TrySubmit([&]() { ran++; }));
+    }
+
+    std::thread shutdown([&]() { pool.Shutdown(); });
+    CHECK(WaitFor([&]() { return !pool.TrySubmit([]() {}); }));
+    gate.Open();
+    shutdown.join();
+    CHECK(ran == 50);
+    CHECK(pool.Pending() == 0);
+
+    // Closed for good, and shutting down again is harmless
+    CHECK(!pool.Submit([&]() { ran++; }));
+    CHECK(!pool.TrySubmit([&]() { ran++; }));
+    pool.Shutdown();
+    CHECK(ran == 50);
+    CHECK(pool.ThreadCount() == 0);
+
+    // A Submit waiting for room is released by Shutdown, refused
+    WorkerPool full(1, 1);
+    Gate busy;
+    CHECK(full.Submit(busy.Job()));
+    CHECK(busy.WaitEntered());
+    CHECK(full.TrySubmit([]() {}));
+
+    std::atomic<int> result{ -1 };
+    std::thread waiting([&]() { result = full.Submit([]() {}) ? 1 : 0; });
+    std::this_thread::sleep_for(milliseconds(50));
+    CHECK(result == -1);
+
+    std::thread stopping([&]() { full.Shutdown(); });
+    CHECK(WaitFor([&]() { return result != -1; }));
+    CHECK(result == 0);
+    busy.Open();
+    stopping.join();
+    waiting.join();
+}
+
+int main()
+{
+    TestRunsEverything();
+    TestBoundedQueue();
+    TestShutdown();
+    return TestExitCode("WorkerPoolTest");
+}